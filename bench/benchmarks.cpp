@@ -0,0 +1,441 @@
+// Micro-benchmarks for the drawing, decode, parse and flush paths, built by
+// the host CMake project:
+//
+//   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build
+//   build/benchmarks                          # print ns/op, bytes/op, allocs/op
+//   build/benchmarks --compare bench/baseline.txt
+//   build/benchmarks --write bench/baseline.txt
+//
+// --compare fails if a benchmark allocates more than its baseline, or is
+// slower by more than --tolerance percent (default 50; 0 only checks
+// allocations). --quick shortens every run, --filter runs benchmarks whose
+// name contains the given text.
+
+#include "WeatherAnimations.h"
+#include "HostTest.h"
+#include "TestPNG.h"
+
+#include <chrono>
+#include <stdio.h>
+
+using namespace WeatherAnimationsLib;
+
+// Most benchmarks a run can hold, and the longest benchmark name
+#define BENCH_MAX 48
+#define BENCH_NAME_LENGTH 32
+
+struct BenchResult {
+	char name[BENCH_NAME_LENGTH];
+	double nsPerOp;
+	double bytesPerOp;
+	double allocsPerOp;
+};
+
+static BenchResult results[BENCH_MAX];
+static int resultCount = 0;
+static double minimumMillis = 200;
+static const char* filter = nullptr;
+
+// Keeps the compiler from dropping work whose result is otherwise unused
+static volatile uint32_t sink;
+
+// Helper function to time one benchmark. body(iterations) runs the operation
+// that many times; it is called once untimed first so lazy setup is not counted.
+template <typename Body>
+static void bench(const char* name, Body body) {
+	if (filter != nullptr && strstr(name, filter) == nullptr) {
+		return;
+	}
+	body(1);
+
+	typedef std::chrono::steady_clock Clock;
+	uint64_t iterations = 1;
+	double elapsed = 0;
+	uint64_t allocs = 0;
+	uint64_t bytes = 0;
+	while (true) {
+		AllocStats before = getAllocStats();
+		Clock::time_point start = Clock::now();
+		body(iterations);
+		elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+		AllocStats after = getAllocStats();
+		allocs = after.count - before.count;
+		bytes = after.bytes - before.bytes;
+		if (elapsed >= minimumMillis * 1e6 || iterations >= (1ull << 30)) {
+			break;
+		}
+		// Aim a little past the minimum so the next run is usually the last
+		double scale = elapsed > 0 ? minimumMillis * 1.2e6 / elapsed : 100;
+		iterations = (uint64_t)(iterations * (scale < 100 ? (scale > 2 ? scale : 2) : 100));
+	}
+
+	if (resultCount >= BENCH_MAX) {
+		return;
+	}
+	BenchResult& result = results[resultCount++];
+	strncpy(result.name, name, sizeof(result.name) - 1);
+	result.name[sizeof(result.name) - 1] = '\0';
+	result.nsPerOp = elapsed / iterations;
+	result.bytesPerOp = (double)bytes / iterations;
+	result.allocsPerOp = (double)allocs / iterations;
+	printf("%-28s %12.1f %10.1f %10.3f\n", result.name, result.nsPerOp, result.bytesPerOp, result.allocsPerOp);
+	fflush(stdout);
+}
+
+static const char smallWeatherPayload[] =
+	"{\"entity_id\":\"weather.forecast_home\",\"state\":\"rainy\",\"attributes\":{\"temperature\":8.2,"
+	"\"forecast_temp_min\":3.5,\"forecast_temp_max\":9.0,\"is_daytime\":true,\"friendly_name\":\"Home\"},"
+	"\"last_changed\":\"2024-01-01T10:00:00+00:00\"}";
+
+static const char temperaturePayload[] =
+	"{\"entity_id\":\"sensor.indoor_temperature\",\"state\":\"21.5\",\"attributes\":"
+	"{\"unit_of_measurement\":\"\xC2\xB0" "C\",\"device_class\":\"temperature\"}}";
+
+// Hourly forecast entries in the large payload, as older Home Assistant
+// versions put in the weather entity's attributes
+#define BENCH_FORECAST_ENTRIES 48
+
+// Helper function to build a weather payload with a long forecast list ahead
+// of the attributes the parser looks for
+static void makeLargeWeatherPayload(char* payload, size_t size) {
+	size_t length = snprintf(payload, size,
+	                         "{\"entity_id\":\"weather.forecast_home\",\"state\":\"partlycloudy\",\"attributes\":{"
+	                         "\"temperature\":8.2,\"humidity\":81,\"forecast\":[");
+	for (int i = 0; i < BENCH_FORECAST_ENTRIES && length < size; i++) {
+		length += snprintf(payload + length, size - length,
+		                   "%s{\"datetime\":\"2024-01-01T%02d:00:00+00:00\",\"condition\":\"cloudy\","
+		                   "\"temperature\":%d.5,\"templow\":%d.0,\"precipitation\":0.%d,\"wind_speed\":14.4}",
+		                   i == 0 ? "" : ",", i % 24, 5 + i % 7, 2 + i % 5, i % 10);
+	}
+	if (length < size) {
+		snprintf(payload + length, size - length,
+		         "],\"forecast_temp_min\":3.5,\"forecast_temp_max\":9.0,\"is_daytime\":false,"
+		         "\"friendly_name\":\"Home\"},\"last_changed\":\"2024-01-01T10:00:00+00:00\"}");
+	}
+}
+
+static void benchPrimitives() {
+	static uint8_t buffer[ANIMATION_FRAME_BYTES];
+
+	bench("setPixel", [&](uint64_t n) {
+		for (uint64_t i = 0; i < n; i++) {
+			setPixel(i & 127, (i >> 7) & 63, buffer);
+		}
+	});
+	bench("drawLine", [&](uint64_t n) {
+		for (uint64_t i = 0; i < n; i++) {
+			drawLine(0, i & 63, 127, 63 - (i & 63), buffer);
+		}
+	});
+	bench("drawCircle", [&](uint64_t n) {
+		for (uint64_t i = 0; i < n; i++) {
+			drawCircle(64, 32, 8 + (i & 15), buffer);
+		}
+	});
+	bench("fillCircle", [&](uint64_t n) {
+		for (uint64_t i = 0; i < n; i++) {
+			fillCircle(64, 32, 8 + (i & 15), buffer);
+		}
+	});
+	bench("drawRoundRect", [&](uint64_t n) {
+		for (uint64_t i = 0; i < n; i++) {
+			drawRoundRect(10, 10, 100, 40, 6, buffer);
+		}
+	});
+	bench("drawTriangle", [&](uint64_t n) {
+		for (uint64_t i = 0; i < n; i++) {
+			drawTriangle(64, 4, 20, 60, 108, 60, buffer);
+		}
+	});
+	bench("drawCloud", [&](uint64_t n) {
+		for (uint64_t i = 0; i < n; i++) {
+			drawCloud(64, 28, 60, 24, buffer);
+		}
+	});
+	bench("drawRainDrop", [&](uint64_t n) {
+		for (uint64_t i = 0; i < n; i++) {
+			drawRainDrop(20 + (i & 63), 40, buffer);
+		}
+	});
+	bench("drawSnowflake", [&](uint64_t n) {
+		for (uint64_t i = 0; i < n; i++) {
+			drawSnowflake(20 + (i & 63), 40, buffer);
+		}
+	});
+	bench("drawLightning", [&](uint64_t n) {
+		for (uint64_t i = 0; i < n; i++) {
+			drawLightning(64, 20, buffer);
+		}
+	});
+	sink = buffer[0];
+}
+
+static void benchDecode() {
+	static uint8_t png[4096];
+	static uint8_t bitmap[ANIMATION_FRAME_BYTES];
+	size_t pngSize = makeTestPNG(png, sizeof(png), TEST_PNG_STRIPES, 0);
+	if (pngSize == 0) {
+		fprintf(stderr, "benchmarks: cannot encode the test frame\n");
+		exit(1);
+	}
+
+	bench("pngToBitmap_128x64", [&](uint64_t n) {
+		for (uint64_t i = 0; i < n; i++) {
+			pngToBitmap(png, pngSize, bitmap, sizeof(bitmap));
+		}
+	});
+	sink = bitmap[0];
+}
+
+static void benchParse() {
+	static char largePayload[12288];
+	makeLargeWeatherPayload(largePayload, sizeof(largePayload));
+	WeatherSnapshot snapshot;
+	clearWeatherSnapshot(&snapshot);
+	float temperature = 0;
+
+	bench("parseWeather_small", [&](uint64_t n) {
+		for (uint64_t i = 0; i < n; i++) {
+			parseWeatherState(smallWeatherPayload, &snapshot);
+		}
+	});
+	bench("parseWeather_large", [&](uint64_t n) {
+		for (uint64_t i = 0; i < n; i++) {
+			parseWeatherState(largePayload, &snapshot);
+		}
+	});
+	bench("parseTemperature", [&](uint64_t n) {
+		for (uint64_t i = 0; i < n; i++) {
+			parseTemperatureState(temperaturePayload, &temperature);
+		}
+	});
+	sink = (uint32_t)temperature + snapshot.condition[0];
+}
+
+// What WA_PERF_SCOPE adds to every timed stage
+static void benchPerfScope() {
+	bench("perf_scope", [&](uint64_t n) {
+		for (uint64_t i = 0; i < n; i++) {
+			WA_PERF_SCOPE(PERF_RENDER);
+		}
+	});
+	resetPerfStats();
+}
+
+// Discards what it is given, so only the formatting is measured
+class NullPrint : public Print {
+public:
+	size_t write(uint8_t) override {
+		return 1;
+	}
+	size_t write(const uint8_t*, size_t size) override {
+		return size;
+	}
+	using Print::write;
+};
+
+// A log record on the hot path, plus its share of formatting it later
+static void benchLog() {
+	NullPrint sink;
+	logDrain(sink);
+	bench("log_write_drain", [&](uint64_t n) {
+		for (uint64_t i = 0; i < n; i++) {
+			logWrite(WA_LOG_LEVEL_DEBUG, "Frame %u flushed, %u bytes", (uint32_t)i, 1024U);
+			if (logPending() == LOG_RING_RECORDS) {
+				logDrain(sink);
+			}
+		}
+	});
+	logDrain(sink);
+}
+
+static void benchBlit() {
+	generateFallbackAnimations();
+	static uint8_t rotated[ANIMATION_FRAME_BYTES];
+	AnimationFrameStore store;
+	const uint8_t* frame = store.frames(WEATHER_RAIN)[0];
+
+	bench("blit_rotate0", [&](uint64_t n) {
+		for (uint64_t i = 0; i < n; i++) {
+			blitPageBuffer(frame, 128, 64, rotated, OLED_ROTATE_0, OLED_MIRROR_NONE);
+		}
+	});
+	bench("blit_rotate90", [&](uint64_t n) {
+		for (uint64_t i = 0; i < n; i++) {
+			blitPageBuffer(frame, 128, 64, rotated, OLED_ROTATE_90, OLED_MIRROR_NONE);
+		}
+	});
+
+	// Alternate two frames so every flush has changed pages to send
+	OLEDPanel panel;
+	OLEDCanvas* canvas = panel.begin(128, 64, oledI2CConfig(0x3C));
+	const uint8_t* const* frames = store.frames(WEATHER_RAIN);
+	bench("oled_flush_changed", [&](uint64_t n) {
+		for (uint64_t i = 0; i < n; i++) {
+			memcpy(canvas->getBuffer(), frames[i & 1], ANIMATION_FRAME_BYTES);
+			panel.flush();
+		}
+	});
+	bench("oled_flush_unchanged", [&](uint64_t n) {
+		for (uint64_t i = 0; i < n; i++) {
+			panel.flush();
+		}
+	});
+	sink = rotated[0];
+}
+
+// Helper function to time whole frames through tick(): each operation runs
+// the tasks due now (draw, then every flush step) and moves the clock on to
+// the next frame. The TFT screen only changes with the weather, so there
+// every operation asks for a redraw.
+static void benchFrame(const char* name, uint8_t displayType) {
+	// Only the warm-up polls; the next poll is due long after the run ends
+	WeatherDataHub hub("127.0.0.1", "token");
+	hub.setFetchInterval(0x7FFFFFFFUL);
+	WeatherAnimations animations("bench", "bench", "127.0.0.1", "token");
+	animations.setMode(CONTINUOUS_WEATHER);
+	animations.setAnimationMode(ANIMATION_EMBEDDED);
+	animations.begin(displayType, 0x3C, false);
+	animations.setDataHub(&hub);
+
+	applyCondition(animations, "rainy");
+
+	uint32_t now = 0;
+	bench(name, [&](uint64_t n) {
+		for (uint64_t i = 0; i < n; i++) {
+			if (displayType == TFT_DISPLAY) {
+				animations.requestRedraw();
+			}
+			uint32_t next;
+			do {
+				next = animations.tick(now);
+			} while (next == now);
+			now = next;
+		}
+	});
+	animations.setDataHub(nullptr);
+}
+
+// Helper function to load a baseline written by --write
+static int loadBaseline(const char* path, BenchResult* baseline, int capacity) {
+	FILE* file = fopen(path, "r");
+	if (file == nullptr) {
+		return -1;
+	}
+	char line[160];
+	int count = 0;
+	while (count < capacity && fgets(line, sizeof(line), file) != nullptr) {
+		if (line[0] == '#' || line[0] == '\n') {
+			continue;
+		}
+		BenchResult& entry = baseline[count];
+		if (sscanf(line, "%31s %lf %lf %lf", entry.name, &entry.nsPerOp, &entry.bytesPerOp, &entry.allocsPerOp) == 4) {
+			count++;
+		}
+	}
+	fclose(file);
+	return count;
+}
+
+static bool writeBaseline(const char* path) {
+	FILE* file = fopen(path, "w");
+	if (file == nullptr) {
+		return false;
+	}
+	fprintf(file, "# name ns/op bytes/op allocs/op, written by benchmarks --write\n");
+	for (int i = 0; i < resultCount; i++) {
+		fprintf(file, "%s %.1f %.1f %.3f\n", results[i].name, results[i].nsPerOp, results[i].bytesPerOp,
+		        results[i].allocsPerOp);
+	}
+	fclose(file);
+	return true;
+}
+
+// Helper function to compare this run against a baseline; returns the number of regressions
+static int compareBaseline(const BenchResult* baseline, int count, double tolerance) {
+	int regressions = 0;
+	printf("\n%-28s %12s %12s %8s\n", "benchmark", "baseline ns", "ns/op", "change");
+	for (int i = 0; i < resultCount; i++) {
+		const BenchResult& result = results[i];
+		const BenchResult* base = nullptr;
+		for (int j = 0; j < count; j++) {
+			if (strcmp(baseline[j].name, result.name) == 0) {
+				base = &baseline[j];
+				break;
+			}
+		}
+		if (base == nullptr) {
+			printf("%-28s %12s %12.1f %8s\n", result.name, "-", result.nsPerOp, "new");
+			continue;
+		}
+		double change = base->nsPerOp > 0 ? (result.nsPerOp / base->nsPerOp - 1) * 100 : 0;
+		const char* verdict = "";
+		// A fraction of an allocation per op is warm-up noise spread over the run
+		if (result.allocsPerOp > base->allocsPerOp + 0.01 || result.bytesPerOp > base->bytesPerOp + 1) {
+			verdict = "  ALLOCATES MORE";
+			regressions++;
+		} else if (tolerance > 0 && change > tolerance) {
+			verdict = "  SLOWER";
+			regressions++;
+		}
+		printf("%-28s %12.1f %12.1f %+7.0f%%%s\n", result.name, base->nsPerOp, result.nsPerOp, change, verdict);
+	}
+	return regressions;
+}
+
+int main(int argc, char** argv) {
+	const char* comparePath = nullptr;
+	const char* writePath = nullptr;
+	double tolerance = 50;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--quick") == 0) {
+			minimumMillis = 20;
+		} else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc) {
+			comparePath = argv[++i];
+		} else if (strcmp(argv[i], "--write") == 0 && i + 1 < argc) {
+			writePath = argv[++i];
+		} else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+			tolerance = atof(argv[++i]);
+		} else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+			filter = argv[++i];
+		} else {
+			fprintf(stderr, "usage: %s [--quick] [--filter text] [--compare file [--tolerance percent]] [--write file]\n",
+			        argv[0]);
+			return 2;
+		}
+	}
+
+	if (!allocTracking()) {
+		fprintf(stderr, "benchmarks: built without WA_TRACK_ALLOCATIONS, allocations read as 0\n");
+	}
+
+	printf("%-28s %12s %10s %10s\n", "benchmark", "ns/op", "bytes/op", "allocs/op");
+	benchPrimitives();
+	benchDecode();
+	benchParse();
+	benchBlit();
+	benchPerfScope();
+	benchLog();
+	benchFrame("frame_oled", OLED_SSD1306);
+	benchFrame("frame_tft", TFT_DISPLAY);
+
+	if (writePath != nullptr && !writeBaseline(writePath)) {
+		fprintf(stderr, "benchmarks: cannot write %s\n", writePath);
+		return 1;
+	}
+	if (comparePath != nullptr) {
+		BenchResult baseline[BENCH_MAX];
+		int count = loadBaseline(comparePath, baseline, BENCH_MAX);
+		if (count < 0) {
+			fprintf(stderr, "benchmarks: cannot read %s\n", comparePath);
+			return 1;
+		}
+		int regressions = compareBaseline(baseline, count, tolerance);
+		if (regressions != 0) {
+			printf("benchmarks: %d regressions against %s\n", regressions, comparePath);
+			return 1;
+		}
+		printf("benchmarks: no regressions against %s\n", comparePath);
+	}
+	return 0;
+}
@@ -117,25 +117,34 @@ enum DisplayMode {
 DisplayMode currentMode = CURRENT_WEATHER;
 int forecastDay = 0;  // 0 = today, 1 = tomorrow, etc.
 int encoderPos = 0;
-int lastEncoderPos = 0;
 bool displayingDetails = false;
-unsigned long lastUpdateTime = 0;
 const unsigned long updateInterval = 300000; // 5 minutes
 
 // Animation mode flag
 bool onlineAnimationsEnabled = true;
-bool lastAnimModeButtonState = HIGH;
+
+// Buttons and encoder, read from pin interrupts
+InputManager input;
+enum InputId {
+	ENCODER_ROTATION,
+	ENCODER_BUTTON,
+	BACK_BUTTON,
+	MODE_BUTTON,
+	ANIM_MODE_BUTTON
+};
 
 // WeatherAnimations instances for each display
 WeatherAnimations oledWeather(ssid, password, haIP, haToken);
 WeatherAnimations tftWeather(ssid, password, haIP, haToken);
 
+// Polls Home Assistant once for both displays
+WeatherDataHub weatherHub(haIP, haToken);
+
 // Optional: Sensor instance
 // Adafruit_BME280 bme;
 
 // Forward declarations for helper functions
-void handleEncoderRotation();
-void handleButtonPresses();
+void onInput(const InputEvent& event, void* context);
 void updateDisplays();
 void showWeatherDetails();
 void changeMode(DisplayMode newMode);
@@ -158,13 +167,19 @@ void setup() {
 	// Initialize I2C for OLED
 	Wire.begin(OLED_SDA, OLED_SCL);
 	
-	// Initialize input pins
-	pinMode(encoderPUSH, INPUT_PULLUP);
-	pinMode(encoderCLK, INPUT_PULLUP);
-	pinMode(encoderDT, INPUT_PULLUP);
-	pinMode(backButton, INPUT_PULLUP);
-	pinMode(modeButton, INPUT_PULLUP);
-	pinMode(animModeButton, INPUT_PULLUP); // Added for animation mode toggle
+	// Initialize input pins; events arrive in onInput() from oledWeather.tick()
+	input.addEncoder(encoderCLK, encoderDT, ENCODER_ROTATION);
+	input.addButton(encoderPUSH, ENCODER_BUTTON);
+	input.addButton(backButton, BACK_BUTTON);
+	input.addButton(modeButton, MODE_BUTTON);
+	input.addButton(animModeButton, ANIM_MODE_BUTTON); // Added for animation mode toggle
+	oledWeather.setInput(&input, onInput);
+	
+	// Both displays take their weather data from the hub
+	weatherHub.setWeatherEntity(weatherEntity);
+	weatherHub.setFetchInterval(updateInterval);
+	oledWeather.setDataHub(&weatherHub);
+	tftWeather.setDataHub(&weatherHub);
 	
 	// Initialize OLED display
 	oledWeather.begin(OLED_DISPLAY, OLED_ADDRESS, false); // Don't manage WiFi here
@@ -172,10 +187,6 @@ void setup() {
 	// Initialize TFT display
 	tftWeather.begin(TFT_DISPLAY, TFT_CS, TFT_DC, TFT_RST, true); // Manage WiFi here
 	
-	// Set weather entities and animation modes
-	oledWeather.setWeatherEntity(weatherEntity);
-	tftWeather.setWeatherEntity(weatherEntity);
-	
 	// Set animation mode to online by default
 	oledWeather.setAnimationMode(ANIMATION_ONLINE);
 	tftWeather.setAnimationMode(ANIMATION_ONLINE);
@@ -223,35 +234,17 @@ void setup() {
 }
 
 void loop() {
-	// Handle user input
-	handleEncoderRotation();
-	handleButtonPresses();
+	// Poll, draw and flush in small steps; input is handled as soon as it arrives
+	oledWeather.tick(millis());
+	tftWeather.tick(millis());
 	
-	// Update displays based on current mode
+	// Draw mode-specific overlays
 	updateDisplays();
-	
-	// Update weather data at regular intervals
-	if (millis() - lastUpdateTime > updateInterval) {
-		oledWeather.refreshWeatherData();
-		tftWeather.refreshWeatherData();
-		lastUpdateTime = millis();
-	}
-	
-	// Small delay to prevent too frequent updates
-	delay(50);
 }
 
-void handleEncoderRotation() {
-	// Simple encoder reading (actual implementation might need to be more robust)
-	static int lastCLK = HIGH;
-	int currentCLK = digitalRead(encoderCLK);
-	
-	if (currentCLK != lastCLK && currentCLK == LOW) {
-		if (digitalRead(encoderDT) != currentCLK) {
-			encoderPos++;
-		} else {
-			encoderPos--;
-		}
+void onInput(const InputEvent& event, void* context) {
+	if (event.type == INPUT_ROTATED) {
+		encoderPos += event.steps;
 		
 		// Use encoder position based on current mode
 		switch (currentMode) {
@@ -274,98 +267,78 @@ void handleEncoderRotation() {
 				// Navigate settings menu
 				break;
 		}
+		return;
 	}
 	
-	lastCLK = currentCLK;
-}
-
-void handleButtonPresses() {
-	// Read button states
-	static bool lastEncoderPushState = HIGH;
-	static bool lastBackButtonState = HIGH;
-	static bool lastModeButtonState = HIGH;
-	
-	bool encoderPushState = digitalRead(encoderPUSH);
-	bool backButtonState = digitalRead(backButton);
-	bool modeButtonState = digitalRead(modeButton);
-	bool animModeButtonState = digitalRead(animModeButton);
-	
-	// Handle encoder push button (with simple debounce)
-	if (encoderPushState != lastEncoderPushState && encoderPushState == LOW) {
-		// Toggle detailed view based on current mode
-		displayingDetails = !displayingDetails;
-		if (displayingDetails) {
-			showWeatherDetails();
-		}
-	}
-	
-	// Handle back button
-	if (backButtonState != lastBackButtonState && backButtonState == LOW) {
-		// Return to main view from detailed view
-		displayingDetails = false;
+	// Buttons act when pressed, not when released
+	if (event.type != INPUT_PRESSED) {
+		return;
 	}
 	
-	// Handle mode button
-	if (modeButtonState != lastModeButtonState && modeButtonState == LOW) {
-		// Cycle through display modes
-		switch (currentMode) {
-			case CURRENT_WEATHER:
-				changeMode(FORECAST_WEATHER);
-				break;
-				
-			case FORECAST_WEATHER:
-				changeMode(SENSOR_DATA);
-				break;
-				
-			case SENSOR_DATA:
-				changeMode(SETTINGS);
-				break;
-				
-			case SETTINGS:
-				changeMode(CURRENT_WEATHER);
-				break;
+	switch (event.id) {
+		case ENCODER_BUTTON:
+			// Toggle detailed view based on current mode
+			displayingDetails = !displayingDetails;
+			if (displayingDetails) {
+				showWeatherDetails();
+			}
+			break;
+			
+		case BACK_BUTTON:
+			// Return to main view from detailed view
+			displayingDetails = false;
+			break;
+			
+		case MODE_BUTTON:
+			// Cycle through display modes
+			switch (currentMode) {
+				case CURRENT_WEATHER:
+					changeMode(FORECAST_WEATHER);
+					break;
+					
+				case FORECAST_WEATHER:
+					changeMode(SENSOR_DATA);
+					break;
+					
+				case SENSOR_DATA:
+					changeMode(SETTINGS);
+					break;
+					
+				case SETTINGS:
+					changeMode(CURRENT_WEATHER);
+					break;
+			}
+			break;
+			
+		case ANIM_MODE_BUTTON: {
+			// Toggle animation mode
+			onlineAnimationsEnabled = !onlineAnimationsEnabled;
+			
+			// Update animation mode for both displays
+			uint8_t newMode = onlineAnimationsEnabled ? ANIMATION_ONLINE : ANIMATION_STATIC;
+			oledWeather.setAnimationMode(newMode);
+			tftWeather.setAnimationMode(newMode);
+			
+			Serial.print("Animation mode changed to: ");
+			Serial.println(onlineAnimationsEnabled ? "Online/Animated" : "Static");
+			break;
 		}
 	}
 	
-	// Handle animation mode button
-	if (animModeButtonState != lastAnimModeButtonState && animModeButtonState == LOW) {
-		// Toggle animation mode
-		onlineAnimationsEnabled = !onlineAnimationsEnabled;
-		
-		// Update animation mode for both displays
-		uint8_t newMode = onlineAnimationsEnabled ? ANIMATION_ONLINE : ANIMATION_STATIC;
-		oledWeather.setAnimationMode(newMode);
-		tftWeather.setAnimationMode(newMode);
-		
-		Serial.print("Animation mode changed to: ");
-		Serial.println(onlineAnimationsEnabled ? "Online/Animated" : "Static");
-	}
-	
-	// Update button states
-	lastEncoderPushState = encoderPushState;
-	lastBackButtonState = backButtonState;
-	lastModeButtonState = modeButtonState;
-	lastAnimModeButtonState = animModeButtonState;
+	// The OLED redraws straight after this handler; make the TFT follow
+	tftWeather.requestRedraw();
 }
 
 void updateDisplays() {
 	// Update displays based on current mode
 	switch (currentMode) {
 		case CURRENT_WEATHER:
-			// Both displays show current weather
-			if (!displayingDetails) {
-				oledWeather.update();
-				tftWeather.update();
-			}
+			// Both displays show current weather (drawn by tick())
 			break;
 			
 		case FORECAST_WEATHER:
 			// Both displays show forecast for selected day
 			if (!displayingDetails) {
-				// Update displays with current forecast day
-				oledWeather.update();
-				tftWeather.update();
-				
 				// Show day indicator on OLED
 				String dayLabel = "Day: " + String(forecastDay);
 				if (forecastDay == 0) dayLabel += " (Today)";
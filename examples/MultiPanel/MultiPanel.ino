@@ -0,0 +1,66 @@
+/*
+ * Multi-Panel Example for WeatherAnimations Library
+ * 
+ * This example drives two SSD1306 OLED panels on the same I2C bus
+ * (addresses 0x3C and 0x3D). Each panel has its own WeatherAnimations
+ * instance; a shared OLEDBusScheduler sends their updates in turn so
+ * neither panel holds the bus for long.
+ */
+
+#include <WeatherAnimations.h>
+#include <Arduino.h>
+#include <Wire.h>
+
+// WiFi credentials
+const char* ssid = "YourWiFiSSID";
+const char* password = "YourWiFiPassword";
+
+// Home Assistant settings
+const char* haIP = "YourHomeAssistantIP";
+const char* haToken = "YourHomeAssistantToken";
+
+// One instance per panel
+WeatherAnimations forecastPanel(ssid, password, haIP, haToken);
+WeatherAnimations indoorPanel(ssid, password, haIP, haToken);
+
+// Shared bus scheduler
+OLEDBusScheduler oledBus;
+
+unsigned long lastReportTime = 0;
+
+void setup() {
+	Serial.begin(115200);
+	Serial.println("Starting Multi-Panel Example");
+	
+	Wire.begin();
+	
+	// Attach both panels to the bus before begin()
+	forecastPanel.setBusScheduler(&oledBus);
+	indoorPanel.setBusScheduler(&oledBus);
+	
+	// Only the first instance manages Wi-Fi
+	forecastPanel.begin(OLED_SSD1306, 0x3C, true);
+	indoorPanel.begin(OLED_SSD1306, 0x3D, false);
+	
+	forecastPanel.setWeatherEntity("weather.forecast_home");
+	indoorPanel.setWeatherEntity("weather.forecast_home");
+	indoorPanel.setAnimationMode(ANIMATION_STATIC);
+	
+	Serial.println("Setup complete");
+}
+
+void loop() {
+	// Draw both panels, then send what changed
+	forecastPanel.update();
+	indoorPanel.update();
+	oledBus.service();
+	
+	// Report panel frame rates every few seconds
+	if (millis() - lastReportTime > 5000) {
+		lastReportTime = millis();
+		Serial.print("Forecast panel fps: ");
+		Serial.print(forecastPanel.getFrameRate());
+		Serial.print("  Indoor panel fps: ");
+		Serial.println(indoorPanel.getFrameRate());
+	}
+}
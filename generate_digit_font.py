@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+"""
+Digit Font Generator Script
+
+Generates src/WeatherAnimationsDigitFont.h, the page-aligned numeric font
+used by WeatherAnimationsDigits.cpp for temperature values.
+
+Glyph set (in this order): 0-9, minus, point, degree, C, F, space.
+
+Fonts:
+- Small:   5x8, the classic Adafruit GFX glyphs, so it matches print() at size 1
+- Medium:  10x16, the small glyphs pre-scaled 2x
+- Large:   15x24, the small glyphs pre-scaled 3x
+- Segment: 20x40 seven-segment style digits for large temperature readouts
+
+Every glyph is stored in SSD1306 page format: one byte per column per
+8-row page, least significant bit on top, page after page.
+
+Usage:
+python3 generate_digit_font.py
+"""
+
+import os
+
+GLYPHS = "0123456789-.\xb0CF "
+
+# Classic 5x7 columns (LSB = top row) from the Adafruit GFX glcdfont
+CLASSIC = {
+    "0": [0x3E, 0x51, 0x49, 0x45, 0x3E],
+    "1": [0x00, 0x42, 0x7F, 0x40, 0x00],
+    "2": [0x72, 0x49, 0x49, 0x49, 0x46],
+    "3": [0x21, 0x41, 0x49, 0x4D, 0x33],
+    "4": [0x18, 0x14, 0x12, 0x7F, 0x10],
+    "5": [0x27, 0x45, 0x45, 0x45, 0x39],
+    "6": [0x3C, 0x4A, 0x49, 0x49, 0x31],
+    "7": [0x41, 0x21, 0x11, 0x09, 0x07],
+    "8": [0x36, 0x49, 0x49, 0x49, 0x36],
+    "9": [0x46, 0x49, 0x49, 0x29, 0x1E],
+    "-": [0x08, 0x08, 0x08, 0x08, 0x08],
+    ".": [0x00, 0x00, 0x60, 0x60, 0x00],
+    "\xb0": [0x00, 0x06, 0x09, 0x09, 0x06],
+    "C": [0x3E, 0x41, 0x41, 0x41, 0x22],
+    "F": [0x7F, 0x09, 0x09, 0x09, 0x01],
+    " ": [0x00, 0x00, 0x00, 0x00, 0x00],
+}
+
+# Seven-segment layout: a=top, b=top right, c=bottom right, d=bottom,
+# e=bottom left, f=top left, g=middle
+SEGMENTS = {
+    "0": "abcdef", "1": "bc", "2": "abdeg", "3": "abcdg", "4": "bcfg",
+    "5": "acdfg", "6": "acdefg", "7": "abc", "8": "abcdefg", "9": "abcdfg",
+    "-": "g", "C": "adef", "F": "aefg", " ": "",
+}
+
+SEGMENT_WIDTH = 20
+SEGMENT_HEIGHT = 40
+SEGMENT_THICKNESS = 4
+
+
+def classic_pixels(char):
+    """Return the classic glyph as a list of rows of 0/1."""
+    columns = CLASSIC[char]
+    return [[(columns[x] >> y) & 1 for x in range(5)] for y in range(8)]
+
+
+def scale_pixels(pixels, factor):
+    return [[value for value in row for _ in range(factor)] for row in pixels for _ in range(factor)]
+
+
+def segment_pixels(char):
+    """Draw a seven-segment glyph with bevelled segment ends."""
+    w, h, t = SEGMENT_WIDTH, SEGMENT_HEIGHT, SEGMENT_THICKNESS
+    pixels = [[0] * w for _ in range(h)]
+
+    def horizontal(top):
+        for k in range(t):
+            bevel = 1 if k in (0, t - 1) else 0
+            for x in range(t + bevel, w - t - bevel):
+                pixels[top + k][x] = 1
+
+    def vertical(left, top, bottom):
+        for k in range(t):
+            bevel = 1 if k in (0, t - 1) else 0
+            for y in range(top + 1 + bevel, bottom - 1 - bevel):
+                pixels[y][left + k] = 1
+
+    middle = (h - t) // 2
+    segments = {
+        "a": lambda: horizontal(0),
+        "g": lambda: horizontal(middle),
+        "d": lambda: horizontal(h - t),
+        "f": lambda: vertical(0, t - 1, middle + 1),
+        "b": lambda: vertical(w - t, t - 1, middle + 1),
+        "e": lambda: vertical(0, middle + t - 1, h - t + 1),
+        "c": lambda: vertical(w - t, middle + t - 1, h - t + 1),
+    }
+
+    if char == ".":
+        return [[1 if y >= h - t else 0 for x in range(t)] for y in range(h)]
+    if char == "\xb0":
+        size = 2 * t
+        ring = [[0] * size for _ in range(h)]
+        for y in range(size):
+            for x in range(size):
+                dx, dy = x - (size - 1) / 2, y - (size - 1) / 2
+                distance = (dx * dx + dy * dy) ** 0.5
+                if size / 2 - 2.2 <= distance <= size / 2:
+                    ring[y][x] = 1
+        return ring
+
+    for segment in SEGMENTS[char]:
+        segments[segment]()
+    return pixels
+
+
+def to_pages(pixels):
+    """Convert rows of pixels into page-format bytes, page after page."""
+    height = len(pixels)
+    width = len(pixels[0])
+    pages = (height + 7) // 8
+    data = []
+    for page in range(pages):
+        for x in range(width):
+            byte = 0
+            for bit in range(8):
+                y = page * 8 + bit
+                if y < height and pixels[y][x]:
+                    byte |= 1 << bit
+            data.append(byte)
+    return data
+
+
+def build_font(name, render, spacing):
+    glyphs = []
+    bitmap = []
+    pages = None
+    for char in GLYPHS:
+        pixels = render(char)
+        pages = (len(pixels) + 7) // 8
+        glyphs.append((len(bitmap), len(pixels[0])))
+        bitmap.extend(to_pages(pixels))
+    return name, pages, spacing, glyphs, bitmap
+
+
+def format_bytes(data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("    " + ", ".join("0x%02X" % b for b in data[i:i + 16]) + ",")
+    return "\n".join(lines)
+
+
+def main():
+    fonts = [
+        build_font("Small", classic_pixels, 1),
+        build_font("Medium", lambda c: scale_pixels(classic_pixels(c), 2), 2),
+        build_font("Large", lambda c: scale_pixels(classic_pixels(c), 3), 3),
+        build_font("Segment", segment_pixels, 4),
+    ]
+
+    out = []
+    out.append("#ifndef WEATHER_ANIMATIONS_DIGIT_FONT_H")
+    out.append("#define WEATHER_ANIMATIONS_DIGIT_FONT_H")
+    out.append("")
+    out.append("#include <Arduino.h>")
+    out.append("#include \"WeatherAnimationsDigits.h\"")
+    out.append("")
+    out.append("// Generated by generate_digit_font.py - do not edit by hand")
+    out.append("// Glyph order: 0-9, minus, point, degree, C, F, space")
+    out.append("// Bitmaps are in SSD1306 page format, one page after another")
+    for name, pages, spacing, glyphs, bitmap in fonts:
+        out.append("")
+        out.append("const uint8_t digitFont%sBitmap[%d] PROGMEM = {" % (name, len(bitmap)))
+        out.append(format_bytes(bitmap))
+        out.append("};")
+        out.append("")
+        out.append("const WeatherAnimationsLib::DigitGlyph digitFont%sGlyphs[DIGIT_GLYPH_COUNT] PROGMEM = {" % name)
+        for (offset, width), char in zip(glyphs, GLYPHS):
+            label = {"\xb0": "degree", " ": "space"}.get(char, char)
+            out.append("    { %d, %d }, // %s" % (offset, width, label))
+        out.append("};")
+    out.append("")
+    out.append("const WeatherAnimationsLib::DigitFont digitFonts[DIGIT_FONT_COUNT] = {")
+    for name, pages, spacing, glyphs, bitmap in fonts:
+        out.append("    { %d, %d, digitFont%sGlyphs, digitFont%sBitmap }," % (pages, spacing, name, name))
+    out.append("};")
+    out.append("")
+    out.append("#endif // WEATHER_ANIMATIONS_DIGIT_FONT_H")
+
+    path = os.path.join(os.path.dirname(os.path.abspath(__file__)), "src", "WeatherAnimationsDigitFont.h")
+    with open(path, "w") as f:
+        f.write("\n".join(out) + "\n")
+    print("Wrote %s" % path)
+
+    # Preview the seven-segment glyphs
+    if os.environ.get("PREVIEW"):
+        for char in "0123456789-.\xb0CF":
+            for row in segment_pixels(char):
+                print("".join("#" if v else "." for v in row))
+            print()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,456 @@
+#include "MockHomeAssistant.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+MockHomeAssistant::MockHomeAssistant()
+	: _listener(-1), _stop(false), _entityCount(0), _assetCount(0), _jitterState(1), _toggled(0), _requests(0),
+	  _stateRequests(0), _templateRequests(0), _assetRequests(0), _errors(0), _bytesSent(0), _bytesReceived(0) {
+	clearMockHAFaults(&_faults);
+}
+
+MockHomeAssistant::~MockHomeAssistant() {
+	stop();
+}
+
+bool MockHomeAssistant::start(uint16_t port) {
+	if (_listener >= 0) {
+		return true;
+	}
+	int listener = socket(AF_INET, SOCK_STREAM, 0);
+	if (listener < 0) {
+		return false;
+	}
+	int yes = 1;
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+	struct sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 16) != 0) {
+		close(listener);
+		return false;
+	}
+	_listener = listener;
+	_stop = false;
+	_thread = std::thread(&MockHomeAssistant::serve, this);
+	return true;
+}
+
+void MockHomeAssistant::stop() {
+	if (_listener < 0) {
+		return;
+	}
+	_stop = true;
+	_thread.join();
+	close(_listener);
+	_listener = -1;
+}
+
+bool MockHomeAssistant::setState(const char* entityID, const char* json) {
+	if (strlen(entityID) >= MOCK_HA_ENTITY_LENGTH || strlen(json) >= MOCK_HA_STATE_LENGTH) {
+		return false;
+	}
+	std::lock_guard<std::mutex> guard(_lock);
+	Entity* entity = nullptr;
+	for (uint8_t i = 0; i < _entityCount; i++) {
+		if (strcmp(_entities[i].id, entityID) == 0) {
+			entity = &_entities[i];
+		}
+	}
+	if (entity == nullptr) {
+		if (_entityCount >= MOCK_HA_MAX_ENTITIES) {
+			return false;
+		}
+		entity = &_entities[_entityCount++];
+		strcpy(entity->id, entityID);
+	}
+	strcpy(entity->json, json);
+	return true;
+}
+
+bool MockHomeAssistant::setWeather(const char* entityID, const char* condition, float minTemp, float maxTemp,
+                                   bool isDaytime, uint8_t forecastHours) {
+	char json[MOCK_HA_STATE_LENGTH];
+	size_t length = snprintf(json, sizeof(json), "{\"entity_id\":\"%s\",\"state\":\"%s\",\"attributes\":{", entityID,
+	                         condition);
+	if (forecastHours > 0) {
+		length += snprintf(json + length, sizeof(json) - length, "\"temperature\":8.2,\"humidity\":81,\"forecast\":[");
+		for (uint8_t i = 0; i < forecastHours && length < sizeof(json); i++) {
+			length += snprintf(json + length, sizeof(json) - length,
+			                   "%s{\"datetime\":\"2024-01-01T%02d:00:00+00:00\",\"condition\":\"cloudy\","
+			                   "\"temperature\":%d.5,\"templow\":%d.0,\"precipitation\":0.%d,\"wind_speed\":14.4}",
+			                   i == 0 ? "" : ",", i % 24, 5 + i % 7, 2 + i % 5, i % 10);
+		}
+		length += length < sizeof(json) ? snprintf(json + length, sizeof(json) - length, "],") : 0;
+	}
+	if (length >= sizeof(json)) {
+		return false;
+	}
+	int rest = snprintf(json + length, sizeof(json) - length,
+	                    "\"forecast_temp_min\":%.1f,\"forecast_temp_max\":%.1f,\"is_daytime\":%s,"
+	                    "\"friendly_name\":\"Home\"},\"last_changed\":\"2024-01-01T10:00:00+00:00\"}",
+	                    minTemp, maxTemp, isDaytime ? "true" : "false");
+	if (length + rest >= sizeof(json)) {
+		return false;
+	}
+	return setState(entityID, json);
+}
+
+// Conditions toggleWeather() switches between
+static const char* const toggledConditions[] = {"sunny", "rainy"};
+
+bool MockHomeAssistant::setDefaultEntities() {
+	_toggled = 0;
+	return setWeather(MOCK_HA_WEATHER_ENTITY, toggledConditions[0], 3.5f, 9.0f, true) &&
+	       setTemperature(MOCK_HA_INDOOR_ENTITY, 21.5f) && setTemperature(MOCK_HA_OUTDOOR_ENTITY, 8.0f);
+}
+
+bool MockHomeAssistant::toggleWeather() {
+	_toggled ^= 1;
+	return setWeather(MOCK_HA_WEATHER_ENTITY, toggledConditions[_toggled], 3.5f, 9.0f, true);
+}
+
+bool MockHomeAssistant::setTemperature(const char* entityID, float value) {
+	char json[MOCK_HA_STATE_LENGTH];
+	snprintf(json, sizeof(json),
+	         "{\"entity_id\":\"%s\",\"state\":\"%.1f\",\"attributes\":{\"unit_of_measurement\":\"\xC2\xB0" "C\","
+	         "\"device_class\":\"temperature\"}}",
+	         entityID, value);
+	return setState(entityID, json);
+}
+
+bool MockHomeAssistant::setAsset(const char* path, const uint8_t* data, size_t size, const char* contentType) {
+	if (strlen(path) >= MOCK_HA_PATH_LENGTH) {
+		return false;
+	}
+	std::lock_guard<std::mutex> guard(_lock);
+	Asset* asset = nullptr;
+	for (uint8_t i = 0; i < _assetCount; i++) {
+		if (strcmp(_assets[i].path, path) == 0) {
+			asset = &_assets[i];
+		}
+	}
+	if (asset == nullptr) {
+		if (_assetCount >= MOCK_HA_MAX_ASSETS) {
+			return false;
+		}
+		asset = &_assets[_assetCount++];
+		strcpy(asset->path, path);
+	}
+	asset->data = data;
+	asset->size = size;
+	asset->contentType = contentType;
+	return true;
+}
+
+uint32_t MockHomeAssistant::requests() const {
+	return _requests.load();
+}
+
+uint32_t MockHomeAssistant::stateRequests() const {
+	return _stateRequests.load();
+}
+
+uint32_t MockHomeAssistant::templateRequests() const {
+	return _templateRequests.load();
+}
+
+uint32_t MockHomeAssistant::assetRequests() const {
+	return _assetRequests.load();
+}
+
+uint32_t MockHomeAssistant::errors() const {
+	return _errors.load();
+}
+
+uint64_t MockHomeAssistant::bytesSent() const {
+	return _bytesSent.load();
+}
+
+uint64_t MockHomeAssistant::bytesReceived() const {
+	return _bytesReceived.load();
+}
+
+void MockHomeAssistant::serve() {
+	while (!_stop.load()) {
+		struct pollfd pfd = {_listener, POLLIN, 0};
+		if (poll(&pfd, 1, 50) <= 0) {
+			continue;
+		}
+		int fd = accept(_listener, nullptr, nullptr);
+		if (fd < 0) {
+			continue;
+		}
+		serveClient(fd);
+		close(fd);
+	}
+}
+
+// Helper function to answer one request from the tables
+void MockHomeAssistant::serveClient(int fd) {
+	// Headers, then as much of a POST body as Content-Length announces
+	char request[2048];
+	size_t length = 0;
+	size_t wanted = sizeof(request) - 1;
+	while (length < wanted) {
+		ssize_t n = read(fd, request + length, wanted - length);
+		if (n <= 0) {
+			break;
+		}
+		length += n;
+		request[length] = '\0';
+		const char* headersEnd = strstr(request, "\r\n\r\n");
+		if (headersEnd != nullptr) {
+			const char* contentLength = strcasestr(request, "Content-Length:");
+			size_t bodySize = 0;
+			if (contentLength != nullptr && contentLength < headersEnd) {
+				bodySize = strtoul(contentLength + 15, nullptr, 10);
+			}
+			size_t total = headersEnd + 4 - request + bodySize;
+			wanted = total < sizeof(request) - 1 ? total : sizeof(request) - 1;
+		}
+	}
+	request[length] = '\0';
+	_bytesReceived.fetch_add(length);
+
+	// "<method> <path> HTTP/1.x"
+	char path[MOCK_HA_PATH_LENGTH];
+	const char* start = strchr(request, ' ');
+	const char* end = start != nullptr ? strchr(start + 1, ' ') : nullptr;
+	MockHAFaults faults;
+	clearMockHAFaults(&faults);
+	if (end == nullptr || (size_t)(end - start - 1) >= sizeof(path)) {
+		respond(fd, faults, 400, "text/plain", (const uint8_t*)"Bad request", 11);
+		return;
+	}
+	memcpy(path, start + 1, end - start - 1);
+	path[end - start - 1] = '\0';
+	bool isGet = strncmp(request, "GET ", 4) == 0;
+	bool isPost = strncmp(request, "POST ", 5) == 0;
+
+	{
+		std::lock_guard<std::mutex> guard(_lock);
+		if (_faults.pathPrefix == nullptr || strncmp(path, _faults.pathPrefix, strlen(_faults.pathPrefix)) == 0) {
+			faults = _faults;
+		}
+	}
+	if (faults.status != 0) {
+		char body[64];
+		int size = snprintf(body, sizeof(body), "%u: injected", (unsigned)faults.status);
+		respond(fd, faults, faults.status, "text/plain", (const uint8_t*)body, size);
+		return;
+	}
+
+	static const char statesPrefix[] = "/api/states/";
+	if (strncmp(path, "/api/", 5) == 0) {
+		if (strstr(request, "Authorization: Bearer ") == nullptr) {
+			static const char unauthorized[] = "401: Unauthorized";
+			respond(fd, faults, 401, "text/plain", (const uint8_t*)unauthorized, sizeof(unauthorized) - 1);
+			return;
+		}
+		if (isPost && strcmp(path, "/api/template") == 0) {
+			char body[MOCK_HA_TEMPLATE_LENGTH];
+			size_t size = renderTemplate(request, body, sizeof(body));
+			_templateRequests.fetch_add(1);
+			respond(fd, faults, 200, "text/plain; charset=utf-8", (const uint8_t*)body, size);
+			return;
+		}
+		char body[MOCK_HA_STATE_LENGTH];
+		if (isGet && strncmp(path, statesPrefix, sizeof(statesPrefix) - 1) == 0 &&
+		    findState(path + sizeof(statesPrefix) - 1, body, sizeof(body))) {
+			_stateRequests.fetch_add(1);
+			respond(fd, faults, 200, "application/json", (const uint8_t*)body, strlen(body));
+			return;
+		}
+		static const char notFound[] = "{\"message\":\"Entity not found.\"}";
+		respond(fd, faults, 404, "application/json", (const uint8_t*)notFound, sizeof(notFound) - 1);
+		return;
+	}
+
+	// Asset data is never changed, only the table entry pointing at it
+	Asset asset;
+	asset.data = nullptr;
+	if (isGet) {
+		std::lock_guard<std::mutex> guard(_lock);
+		for (uint8_t i = 0; i < _assetCount; i++) {
+			if (strcmp(_assets[i].path, path) == 0) {
+				asset = _assets[i];
+			}
+		}
+	}
+	if (asset.data == nullptr) {
+		static const char notFound[] = "404: Not Found";
+		respond(fd, faults, 404, "text/plain", (const uint8_t*)notFound, sizeof(notFound) - 1);
+		return;
+	}
+	_assetRequests.fetch_add(1);
+	respond(fd, faults, 200, asset.contentType, asset.data, asset.size);
+}
+
+// Helper function to copy an entity's JSON
+bool MockHomeAssistant::findState(const char* entityID, char* json, size_t size) {
+	std::lock_guard<std::mutex> guard(_lock);
+	for (uint8_t i = 0; i < _entityCount; i++) {
+		if (strcmp(_entities[i].id, entityID) == 0) {
+			strncpy(json, _entities[i].json, size - 1);
+			json[size - 1] = '\0';
+			return true;
+		}
+	}
+	return false;
+}
+
+// Helper function to render the template of a POST /api/template body,
+// {"template": "..."}: {{ states('<entity_id>') }} becomes the entity's
+// state, or "unknown"; everything else is copied
+size_t MockHomeAssistant::renderTemplate(const char* request, char* out, size_t size) {
+	size_t length = 0;
+	const char* body = strstr(request, "\r\n\r\n");
+	const char* text = body != nullptr ? strstr(body, "\"template\"") : nullptr;
+	text = text != nullptr ? strchr(text + 10, '"') : nullptr;
+	if (text == nullptr) {
+		return 0;
+	}
+	text++;
+	while (*text != '\0' && *text != '"' && length < size - 1) {
+		if (text[0] == '\\' && text[1] != '\0') {
+			text++;
+			out[length++] = *text == 'n' ? '\n' : *text;
+			text++;
+			continue;
+		}
+		if (strncmp(text, "{{", 2) != 0) {
+			out[length++] = *text++;
+			continue;
+		}
+		const char* close = strstr(text, "}}");
+		const char* call = strstr(text, "states('");
+		const char* quote = call != nullptr ? strchr(call + 8, '\'') : nullptr;
+		if (close == nullptr || quote == nullptr || quote > close) {
+			out[length++] = *text++;
+			continue;
+		}
+		char entityID[MOCK_HA_ENTITY_LENGTH];
+		size_t idLength = quote - call - 8;
+		idLength = idLength < sizeof(entityID) - 1 ? idLength : sizeof(entityID) - 1;
+		memcpy(entityID, call + 8, idLength);
+		entityID[idLength] = '\0';
+
+		// The "state" member of the entity's JSON
+		char json[MOCK_HA_STATE_LENGTH];
+		const char* state = findState(entityID, json, sizeof(json)) ? strstr(json, "\"state\":\"") : nullptr;
+		const char* value = state != nullptr ? state + 9 : "unknown";
+		while (*value != '\0' && *value != '"' && length < size - 1) {
+			out[length++] = *value++;
+		}
+		text = close + 2;
+	}
+	out[length] = '\0';
+	return length;
+}
+
+void MockHomeAssistant::setFaults(const MockHAFaults& faults) {
+	std::lock_guard<std::mutex> guard(_lock);
+	_faults = faults;
+	_jitterState = 1;
+}
+
+void MockHomeAssistant::clearFaults() {
+	std::lock_guard<std::mutex> guard(_lock);
+	clearMockHAFaults(&_faults);
+}
+
+// Helper function for the reason phrase of the statuses the server sends
+static const char* reasonPhrase(int status) {
+	switch (status) {
+		case 200: return "OK";
+		case 400: return "Bad Request";
+		case 401: return "Unauthorized";
+		case 404: return "Not Found";
+		case 500: return "Internal Server Error";
+		case 502: return "Bad Gateway";
+		case 503: return "Service Unavailable";
+		case 504: return "Gateway Timeout";
+		default: return "Error";
+	}
+}
+
+// Helper function to send a status line, headers and body, with the faults
+void MockHomeAssistant::respond(int fd, const MockHAFaults& faults, int status, const char* contentType,
+                                const uint8_t* body, size_t size) {
+	uint32_t wait = faults.latency;
+	if (faults.jitter > 0) {
+		std::lock_guard<std::mutex> guard(_lock);
+		_jitterState = _jitterState * 1103515245UL + 12345;
+		wait += (_jitterState >> 16) % (faults.jitter + 1);
+	}
+	size_t sent = 0;
+	if (wait == 0 || pause(fd, wait)) {
+		char header[256];
+		int headerSize = snprintf(header, sizeof(header),
+		                          "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %u\r\nConnection: close\r\n\r\n",
+		                          status, reasonPhrase(status), contentType, (unsigned)size);
+		// The announced length stays, so a cut body shows as one
+		size_t limit = faults.truncateAfter >= 0 && (size_t)faults.truncateAfter < size ? faults.truncateAfter : size;
+		size_t before = faults.stall > 0 && faults.stallAfter < limit ? faults.stallAfter : limit;
+		if (sendPaced(fd, (const uint8_t*)header, headerSize, faults.bytesPerSecond, &sent) &&
+		    sendPaced(fd, body, before, faults.bytesPerSecond, &sent) && before < limit && pause(fd, faults.stall)) {
+			sendPaced(fd, body + before, limit - before, faults.bytesPerSecond, &sent);
+		}
+	}
+	_requests.fetch_add(1);
+	_bytesSent.fetch_add(sent);
+	if (status >= 400) {
+		_errors.fetch_add(1);
+	}
+}
+
+// Helper function to send at a bandwidth, each 20 ms slice at the end of
+// its 20 ms; false once the client has gone
+bool MockHomeAssistant::sendPaced(int fd, const uint8_t* data, size_t size, uint32_t bytesPerSecond, size_t* sent) {
+	size_t slice = bytesPerSecond > 0 ? (bytesPerSecond + 49) / 50 : size;
+	size_t offset = 0;
+	while (offset < size) {
+		if (bytesPerSecond > 0 && !pause(fd, 20)) {
+			return false;
+		}
+		size_t chunk = size - offset < slice ? size - offset : slice;
+		while (chunk > 0) {
+			ssize_t n = send(fd, data + offset, chunk, MSG_NOSIGNAL);
+			if (n <= 0) {
+				return false;
+			}
+			offset += n;
+			*sent += n;
+			chunk -= n;
+		}
+	}
+	return true;
+}
+
+// Helper function to wait without reading; false if the client closes or the server stops
+bool MockHomeAssistant::pause(int fd, uint32_t ms) {
+	uint32_t waited = 0;
+	while (waited < ms && !_stop.load()) {
+		uint32_t slice = ms - waited < 50 ? ms - waited : 50;
+		struct pollfd pfd = {fd, POLLRDHUP, 0};
+		if (poll(&pfd, 1, slice) > 0 && (pfd.revents & (POLLRDHUP | POLLHUP | POLLERR))) {
+			return false;
+		}
+		waited += slice;
+	}
+	return !_stop.load();
+}
+
+void clearMockHAFaults(MockHAFaults* faults) {
+	memset(faults, 0, sizeof(*faults));
+	faults->truncateAfter = -1;
+}
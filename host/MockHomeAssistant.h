@@ -0,0 +1,134 @@
+#ifndef MOCK_HOME_ASSISTANT_H
+#define MOCK_HOME_ASSISTANT_H
+
+#include <atomic>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <thread>
+
+// Entities and assets one server holds
+#define MOCK_HA_MAX_ENTITIES 8
+#define MOCK_HA_MAX_ASSETS 32
+#define MOCK_HA_ENTITY_LENGTH 64
+#define MOCK_HA_STATE_LENGTH 12288
+#define MOCK_HA_PATH_LENGTH 96
+#define MOCK_HA_TEMPLATE_LENGTH 512
+
+// Entities WeatherAnimations polls unless it is told otherwise
+#define MOCK_HA_WEATHER_ENTITY "weather.forecast"
+#define MOCK_HA_INDOOR_ENTITY "sensor.t_h_sensor_temperature"
+#define MOCK_HA_OUTDOOR_ENTITY "sensor.sam_outside_temperature"
+
+// Faults injected into responses. Cleared, the server answers at once
+// and in full.
+struct MockHAFaults {
+	const char* pathPrefix;   // only requests whose path starts with this; nullptr: all
+	uint32_t latency;         // ms before the status line
+	uint32_t jitter;          // up to this many ms more, from a fixed sequence
+	uint32_t bytesPerSecond;  // response bandwidth; 0: unlimited
+	uint32_t stallAfter;      // slow loris: body bytes sent before the stall
+	uint32_t stall;           // ms the response stalls for, then goes on; 0: none
+	int32_t truncateAfter;    // body bytes sent before closing early; -1: all
+	uint16_t status;          // answer with this HTTP status instead; 0: the real one
+};
+
+void clearMockHAFaults(MockHAFaults* faults);
+
+// A stand-in for Home Assistant on 127.0.0.1, for host tests and tools.
+//
+// Answers GET /api/states/<entity_id> with the JSON last given to
+// setState() (401 without a bearer token, 404 for unknown entities),
+// POST /api/template with the template rendered ({{ states('<entity_id>') }}
+// only), and any other path with the asset registered for it, e.g. PNG
+// animation frames. One connection at a time, closed after each response,
+// as the library's clients ask. setFaults() makes responses slow, late,
+// stalled, cut short or failed, as a busy server or a poor link would.
+//
+// Tables are fixed and requests are answered from stack buffers, so
+// once start() has created its thread the server makes no heap
+// allocations that would show up in the library's counts.
+class MockHomeAssistant {
+public:
+	MockHomeAssistant();
+	~MockHomeAssistant();
+
+	// Listens on 127.0.0.1:port and serves from a thread until stop()
+	bool start(uint16_t port = 8123);
+	void stop();
+
+	// Body served for an entity; replaces the earlier one
+	bool setState(const char* entityID, const char* json);
+	// A weather entity as Home Assistant reports it; forecastHours hourly
+	// forecast entries go ahead of the other attributes, as older Home
+	// Assistant versions send them (about 150 bytes each)
+	bool setWeather(const char* entityID, const char* condition, float minTemp, float maxTemp, bool isDaytime,
+	                uint8_t forecastHours = 0);
+	// A temperature sensor
+	bool setTemperature(const char* entityID, float value);
+
+	// The default entities: sunny from 3.5 to 9.0, 21.5 indoors, 8.0 outdoors
+	bool setDefaultEntities();
+	// Switch the default weather entity between two conditions with
+	// different text on the panel, "sunny" and "rainy"
+	bool toggleWeather();
+
+	// Serves data at path; the data is not copied and must outlive the server
+	bool setAsset(const char* path, const uint8_t* data, size_t size, const char* contentType = "image/png");
+
+	// Applies to requests from the next one on; waits are real time
+	void setFaults(const MockHAFaults& faults);
+	void clearFaults();
+
+	uint32_t requests() const;          // requests answered, whatever the status
+	uint32_t stateRequests() const;     // answered from an entity
+	uint32_t templateRequests() const;  // answered by rendering a template
+	uint32_t assetRequests() const;     // answered from an asset
+	uint32_t errors() const;            // answered with 4xx or 5xx
+	uint64_t bytesSent() const;         // headers and bodies, as far as they were sent
+	uint64_t bytesReceived() const;     // requests, with their bodies
+
+private:
+	struct Entity {
+		char id[MOCK_HA_ENTITY_LENGTH];
+		char json[MOCK_HA_STATE_LENGTH];
+	};
+	struct Asset {
+		char path[MOCK_HA_PATH_LENGTH];
+		const uint8_t* data;
+		size_t size;
+		const char* contentType;
+	};
+
+	void serve();
+	void serveClient(int fd);
+	bool findState(const char* entityID, char* json, size_t size);
+	size_t renderTemplate(const char* request, char* out, size_t size);
+	void respond(int fd, const MockHAFaults& faults, int status, const char* contentType, const uint8_t* body,
+	             size_t size);
+	bool sendPaced(int fd, const uint8_t* data, size_t size, uint32_t bytesPerSecond, size_t* sent);
+	bool pause(int fd, uint32_t ms);
+
+	int _listener;
+	std::thread _thread;
+	std::atomic<bool> _stop;
+
+	mutable std::mutex _lock;  // guards the tables, which tests change while serving
+	Entity _entities[MOCK_HA_MAX_ENTITIES];
+	uint8_t _entityCount;
+	Asset _assets[MOCK_HA_MAX_ASSETS];
+	uint8_t _assetCount;
+	MockHAFaults _faults;
+	uint32_t _jitterState;
+	uint8_t _toggled;  // condition toggleWeather() serves
+
+	std::atomic<uint32_t> _requests;
+	std::atomic<uint32_t> _stateRequests;
+	std::atomic<uint32_t> _templateRequests;
+	std::atomic<uint32_t> _assetRequests;
+	std::atomic<uint32_t> _errors;
+	std::atomic<uint64_t> _bytesSent;
+	std::atomic<uint64_t> _bytesReceived;
+};
+
+#endif // MOCK_HOME_ASSISTANT_H
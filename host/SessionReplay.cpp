@@ -0,0 +1,605 @@
+#include "SessionReplay.h"
+
+#include <algorithm>
+#include <stdio.h>
+
+using namespace WeatherAnimationsLib;
+
+// Helper function to read a varint; false at the end of the data
+static bool getVarint(const uint8_t* data, size_t size, size_t* pos, uint32_t* value) {
+	uint32_t result = 0;
+	for (uint8_t shift = 0; shift < 35; shift += 7) {
+		if (*pos >= size) {
+			return false;
+		}
+		uint8_t byte = data[(*pos)++];
+		result |= (uint32_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			*value = result;
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool getSigned(const uint8_t* data, size_t size, size_t* pos, int32_t* value) {
+	uint32_t zigzag;
+	if (!getVarint(data, size, pos, &zigzag)) {
+		return false;
+	}
+	*value = (int32_t)((zigzag >> 1) ^ (0 - (zigzag & 1)));
+	return true;
+}
+
+SessionReplay::SessionReplay() : _clock(nullptr), _nextConnection(0), _nextFetch(0), _unanswered(0) {
+	memset(&_session, 0, sizeof(_session));
+}
+
+SessionReplay::~SessionReplay() {
+	if (_clock != nullptr) {
+		detach();
+	}
+}
+
+bool SessionReplay::load(const uint8_t* data, size_t size) {
+	_data.assign(data, data + size);
+	memset(&_session, 0, sizeof(_session));
+	_connections.clear();
+	_fetches.clear();
+	_inputs.clear();
+	rewind();
+	if (size < 9 || memcmp(data, RECORD_MAGIC, 4) != 0 || data[4] != RECORD_VERSION) {
+		return false;
+	}
+	_session.start = data[5] | (data[6] << 8) | (data[7] << 16) | ((uint32_t)data[8] << 24);
+
+	data = _data.data();
+	size_t pos = 9;
+	uint32_t time = 0;
+	while (pos < size) {
+		uint8_t type = data[pos++];
+		uint32_t elapsed;
+		if (!getVarint(data, size, &pos, &elapsed)) {
+			return false;
+		}
+		time += elapsed;
+		_session.duration = time;
+
+		switch (type) {
+			case RECORD_BEGIN: {
+				if (pos + 4 > size) {
+					return false;
+				}
+				_session.hasBegin = true;
+				_session.beginTime = time;
+				_session.displayType = data[pos++];
+				_session.mode = data[pos++];
+				_session.animationMode = data[pos++];
+				_session.hub = data[pos++] != 0;
+				if (!getVarint(data, size, &pos, &_session.pollInterval)) {
+					return false;
+				}
+				break;
+			}
+
+			case RECORD_CONNECT: {
+				Connection connection;
+				if (pos >= size) {
+					return false;
+				}
+				connection.time = time;
+				connection.connected = data[pos++] != 0;
+				if (!getVarint(data, size, &pos, &connection.blocked)) {
+					return false;
+				}
+				connection.closes = false;
+				connection.closeTime = 0;
+				_connections.push_back(connection);
+				break;
+			}
+
+			case RECORD_DATA:
+			case RECORD_CLOSE: {
+				uint32_t back;
+				if (!getVarint(data, size, &pos, &back) || back >= _connections.size()) {
+					return false;
+				}
+				Connection& connection = _connections[_connections.size() - 1 - back];
+				if (type == RECORD_CLOSE) {
+					connection.closes = true;
+					connection.closeTime = time;
+					break;
+				}
+				if (pos + 2 > size) {
+					return false;
+				}
+				Chunk chunk;
+				chunk.time = time;
+				chunk.length = data[pos] | (data[pos + 1] << 8);
+				chunk.offset = pos + 2;
+				pos += 2 + chunk.length;
+				if (pos > size) {
+					return false;
+				}
+				connection.chunks.push_back(chunk);
+				_session.bytes += chunk.length;
+				break;
+			}
+
+			case RECORD_FETCH: {
+				Fetch fetch;
+				int32_t status;
+				int32_t contentLength;
+				uint32_t bodySize;
+				if (!getSigned(data, size, &pos, &status) || !getVarint(data, size, &pos, &fetch.blocked) ||
+				    !getSigned(data, size, &pos, &contentLength) || !getVarint(data, size, &pos, &bodySize) ||
+				    pos + bodySize > size) {
+					return false;
+				}
+				fetch.status = status;
+				fetch.contentLength = contentLength;
+				fetch.offset = pos;
+				fetch.size = bodySize;
+				pos += bodySize;
+				_fetches.push_back(fetch);
+				_session.bytes += bodySize;
+				break;
+			}
+
+			case RECORD_INPUT: {
+				Input input;
+				if (pos + 3 > size) {
+					return false;
+				}
+				input.time = time;
+				input.event.type = data[pos++];
+				input.event.id = data[pos++];
+				input.event.steps = (int8_t)data[pos++];
+				if (!getVarint(data, size, &pos, &input.age)) {
+					return false;
+				}
+				_inputs.push_back(input);
+				break;
+			}
+
+			case RECORD_END:
+				pos = size;
+				break;
+
+			default:
+				return false;
+		}
+	}
+	_session.connections = _connections.size();
+	_session.fetches = _fetches.size();
+	_session.inputs = _inputs.size();
+	return true;
+}
+
+bool SessionReplay::loadFile(const char* path) {
+	FILE* file = fopen(path, "rb");
+	if (file == nullptr) {
+		return false;
+	}
+	std::vector<uint8_t> data;
+	uint8_t buffer[4096];
+	size_t count;
+	while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+		data.insert(data.end(), buffer, buffer + count);
+	}
+	fclose(file);
+	return load(data.data(), data.size());
+}
+
+const RecordedSession& SessionReplay::session() const {
+	return _session;
+}
+
+const std::vector<SessionReplay::Screen>& SessionReplay::screens() const {
+	return _screens;
+}
+
+void SessionReplay::rewind() {
+	_channels.clear();
+	_nextConnection = 0;
+	_nextFetch = 0;
+	_unanswered = 0;
+}
+
+void SessionReplay::attach(VirtualClock* clock) {
+	rewind();
+	_clock = clock;
+	WiFi.hostSetNetwork(this);
+}
+
+void SessionReplay::detach() {
+	WiFi.hostSetNetwork(nullptr);
+	_clock = nullptr;
+}
+
+// Helper function to hash what the panel shows (FNV-1a)
+uint32_t SessionReplay::screenHash(uint8_t displayType) const {
+	uint32_t hash = 2166136261UL;
+	if (displayType == TFT_DISPLAY) {
+		TFT_eSPI* tft = TFT_eSPI::lastInstance();
+		for (int32_t y = 0; tft != nullptr && y < tft->height(); y++) {
+			for (int32_t x = 0; x < tft->width(); x++) {
+				uint16_t pixel = tft->readPixel(x, y);
+				hash = (hash ^ (pixel & 0xFF)) * 16777619UL;
+				hash = (hash ^ (pixel >> 8)) * 16777619UL;
+			}
+		}
+		return hash;
+	}
+	Adafruit_SSD1306* oled = Adafruit_SSD1306::lastInstance();
+	if (oled != nullptr) {
+		const uint8_t* buffer = oled->getBuffer();
+		size_t size = (size_t)oled->width() * oled->height() / 8;
+		for (size_t i = 0; i < size; i++) {
+			hash = (hash ^ buffer[i]) * 16777619UL;
+		}
+	}
+	return hash;
+}
+
+bool SessionReplay::run(ReplayProfile* profile, InputHandler handler, void* context) {
+	memset(profile, 0, sizeof(*profile));
+	_screens.clear();
+	if (!_session.hasBegin) {
+		return false;
+	}
+	wl_status_t status = WiFi.status();
+	VirtualClock clock(_session.start + _session.beginTime);
+	attach(&clock);
+	WiFi.hostSetStatus(WL_CONNECTED);
+	resetPerfStats();
+
+	WeatherDataHub hub("replay", "replay");
+	hub.setFetchInterval(_session.pollInterval);
+	hub.setClock(&clock);
+	InputManager input;
+	std::vector<uint32_t> gaps;
+	{
+		WeatherAnimations animations("replay", "replay", "replay", "replay");
+		animations.setClock(&clock);
+		animations.setMode(_session.mode);
+		animations.setAnimationMode(_session.animationMode);
+		animations.setTickBudget(0);
+		animations.setInput(&input, handler, context);
+		if (_session.hub) {
+			animations.setDataHub(&hub);
+		}
+		animations.begin(_session.displayType, 0x3C, false);
+
+		// What begin() drew is the first screen, not a frame of the run
+		bool tft = _session.displayType == TFT_DISPLAY;
+		uint32_t end = _session.start + _session.duration;
+		uint32_t lastCount = animations.getFlushCount();
+		uint32_t busStart = animations.getBusBytes();
+		if (tft) {
+			lastCount = TFT_eSPI::lastInstance() != nullptr ? TFT_eSPI::lastInstance()->pixelsWritten() : 0;
+		}
+		uint32_t lastFrame = 0;
+		uint32_t lastScreen = screenHash(_session.displayType);
+		uint32_t sameTime = 0;
+		size_t nextInput = 0;
+		_screens.push_back({_session.beginTime, lastScreen});
+		while ((int32_t)(clock.millis() - end) < 0) {
+			uint32_t now = clock.millis();
+			while (nextInput < _inputs.size() && (int32_t)(_session.start + _inputs[nextInput].time - now) <= 0) {
+				InputEvent event = _inputs[nextInput].event;
+				event.time = now - _inputs[nextInput].age;
+				input.inject(event);
+				profile->inputs++;
+				nextInput++;
+			}
+
+			uint32_t next = animations.tick(now);
+			profile->ticks++;
+
+			// A frame is a flush of the OLED, or pixels written to the TFT
+			uint32_t count;
+			uint32_t bytes;
+			if (tft) {
+				TFT_eSPI* display = TFT_eSPI::lastInstance();
+				count = display != nullptr ? display->pixelsWritten() : 0;
+				bytes = count >= lastCount ? (count - lastCount) * 2 : count * 2;
+			} else {
+				count = animations.getFlushCount();
+				bytes = animations.getBusBytes() - busStart - profile->busBytes;
+			}
+			if (count != lastCount) {
+				if (profile->frames > 0) {
+					gaps.push_back(now - lastFrame);
+				}
+				profile->frames++;
+				profile->busBytes += bytes;
+				lastFrame = now;
+				lastCount = count;
+				uint32_t hash = screenHash(_session.displayType);
+				if (hash != lastScreen) {
+					_screens.push_back({now - _session.start, hash});
+					lastScreen = hash;
+				}
+			}
+
+			// Work due now runs again at the same time, a few steps per ms
+			if ((int32_t)(next - now) <= 0 && ++sameTime < REPLAY_TICKS_PER_MS) {
+				continue;
+			}
+			sameTime = 0;
+			if ((int32_t)(next - now) <= 0) {
+				next = now + 1;
+			}
+			uint32_t arrival = nextArrival(now);
+			if ((int32_t)(arrival - next) < 0) {
+				next = arrival;
+			}
+			if (nextInput < _inputs.size() && (int32_t)(_session.start + _inputs[nextInput].time - next) < 0) {
+				next = _session.start + _inputs[nextInput].time;
+			}
+			clock.set((int32_t)(next - end) < 0 ? next : end);
+		}
+	}
+
+	profile->duration = _session.duration - _session.beginTime;
+	profile->bytesPerFrame = profile->frames > 0 ? profile->busBytes / profile->frames : 0;
+	if (!gaps.empty()) {
+		std::sort(gaps.begin(), gaps.end());
+		profile->gapP50 = gaps[(gaps.size() - 1) * 50 / 100];
+		profile->gapP99 = gaps[(gaps.size() - 1) * 99 / 100];
+		profile->gapMax = gaps.back();
+	}
+	profile->screens = _screens.size();
+	profile->screenHash = 2166136261UL;
+	for (const Screen& screen : _screens) {
+		profile->screenHash = (profile->screenHash ^ screen.time) * 16777619UL;
+		profile->screenHash = (profile->screenHash ^ screen.hash) * 16777619UL;
+	}
+	profile->connections = _nextConnection;
+	profile->fetches = _nextFetch;
+	profile->unanswered = _unanswered;
+	PerfStats stats = getPerfStats();
+	profile->renderP99 = stats.stages[PERF_RENDER].p99Micros;
+	profile->flushP99 = stats.stages[PERF_FLUSH].p99Micros;
+
+	detach();
+	WiFi.hostSetStatus(status);
+	return true;
+}
+
+int SessionReplay::open(const char* host, uint16_t port, bool http) {
+	(void)host;
+	(void)port;
+	if (_clock == nullptr) {
+		return -1;
+	}
+	Channel channel;
+	channel.open = true;
+	channel.connection = nullptr;
+	channel.chunk = 0;
+	channel.chunkOffset = 0;
+	channel.responseOffset = 0;
+	if (http) {
+		if (_nextFetch >= _fetches.size()) {
+			_unanswered++;
+			return -1;
+		}
+		// A download is answered in full at once; its time was spent blocking
+		const Fetch& fetch = _fetches[_nextFetch++];
+		_clock->advance(fetch.blocked);
+		if (fetch.status <= 0) {
+			return -1;
+		}
+		char header[96];
+		int length = snprintf(header, sizeof(header), "HTTP/1.1 %d Replayed\r\n", fetch.status);
+		if (fetch.contentLength >= 0) {
+			length += snprintf(header + length, sizeof(header) - length, "Content-Length: %ld\r\n", fetch.contentLength);
+		}
+		snprintf(header + length, sizeof(header) - length, "\r\n");
+		channel.response = header;
+		channel.response.append((const char*)_data.data() + fetch.offset, fetch.size);
+	} else {
+		if (_nextConnection >= _connections.size()) {
+			_unanswered++;
+			return -1;
+		}
+		const Connection& connection = _connections[_nextConnection++];
+		_clock->advance(connection.blocked);
+		if (!connection.connected) {
+			return -1;
+		}
+		channel.connection = &connection;
+	}
+	channel.epoch = _clock->millis();
+	_channels.push_back(channel);
+	return (int)_channels.size() - 1;
+}
+
+// Helper function to tell whether something recorded at time (ms from the
+// start) has arrived on channel
+bool SessionReplay::due(const Channel& channel, uint32_t time) const {
+	uint32_t arrival = channel.epoch + (time - channel.connection->time);
+	return (int32_t)(_clock->millis() - arrival) >= 0;
+}
+
+// Helper function to find when the next recorded bytes or close of an open
+// connection arrive, after now
+uint32_t SessionReplay::nextArrival(uint32_t now) const {
+	uint32_t next = now + TICK_MAX_SLEEP;
+	for (const Channel& channel : _channels) {
+		if (!channel.open || channel.connection == nullptr) {
+			continue;
+		}
+		const Connection& connection = *channel.connection;
+		uint32_t time;
+		if (channel.chunk < connection.chunks.size()) {
+			time = connection.chunks[channel.chunk].time;
+		} else if (connection.closes) {
+			time = connection.closeTime;
+		} else {
+			continue;
+		}
+		uint32_t arrival = channel.epoch + (time - connection.time);
+		if ((int32_t)(arrival - now) > 0 && (int32_t)(arrival - next) < 0) {
+			next = arrival;
+		}
+	}
+	return next;
+}
+
+int SessionReplay::available(int handle) {
+	if (_clock == nullptr || handle < 0 || (size_t)handle >= _channels.size() || !_channels[handle].open) {
+		return 0;
+	}
+	const Channel& channel = _channels[handle];
+	if (channel.connection == nullptr) {
+		return (int)(channel.response.size() - channel.responseOffset);
+	}
+	size_t count = 0;
+	const std::vector<Chunk>& chunks = channel.connection->chunks;
+	for (size_t i = channel.chunk; i < chunks.size() && due(channel, chunks[i].time); i++) {
+		count += chunks[i].length - (i == channel.chunk ? channel.chunkOffset : 0);
+	}
+	return (int)count;
+}
+
+int SessionReplay::read(int handle, uint8_t* buf, size_t size) {
+	if (_clock == nullptr || handle < 0 || (size_t)handle >= _channels.size() || !_channels[handle].open) {
+		return -1;
+	}
+	Channel& channel = _channels[handle];
+	if (channel.connection == nullptr) {
+		size_t count = std::min(size, channel.response.size() - channel.responseOffset);
+		memcpy(buf, channel.response.data() + channel.responseOffset, count);
+		channel.responseOffset += count;
+		return (int)count;
+	}
+	size_t count = 0;
+	const std::vector<Chunk>& chunks = channel.connection->chunks;
+	while (count < size && channel.chunk < chunks.size() && due(channel, chunks[channel.chunk].time)) {
+		const Chunk& chunk = chunks[channel.chunk];
+		size_t part = std::min(size - count, chunk.length - channel.chunkOffset);
+		memcpy(buf + count, _data.data() + chunk.offset + channel.chunkOffset, part);
+		count += part;
+		channel.chunkOffset += part;
+		if (channel.chunkOffset == chunk.length) {
+			channel.chunk++;
+			channel.chunkOffset = 0;
+		}
+	}
+	return (int)count;
+}
+
+bool SessionReplay::closed(int handle) {
+	if (_clock == nullptr || handle < 0 || (size_t)handle >= _channels.size() || !_channels[handle].open) {
+		return true;
+	}
+	const Channel& channel = _channels[handle];
+	if (channel.connection == nullptr) {
+		return true;
+	}
+	return channel.connection->closes && due(channel, channel.connection->closeTime);
+}
+
+void SessionReplay::close(int handle) {
+	if (handle >= 0 && (size_t)handle < _channels.size()) {
+		_channels[handle].open = false;
+	}
+}
+
+// How each profile entry is compared
+#define REPLAY_INFO 0     // printed only
+#define REPLAY_GROWTH 1   // any increase is a regression
+#define REPLAY_TIMING 2   // an increase beyond the tolerance is a regression
+
+struct ReplayField {
+	const char* name;
+	uint32_t ReplayProfile::*value;
+	uint8_t check;
+};
+
+static const ReplayField replayFields[] = {
+	{"duration_ms", &ReplayProfile::duration, REPLAY_INFO},
+	{"ticks", &ReplayProfile::ticks, REPLAY_INFO},
+	{"frames", &ReplayProfile::frames, REPLAY_INFO},
+	{"bus_bytes", &ReplayProfile::busBytes, REPLAY_GROWTH},
+	{"bytes_per_frame", &ReplayProfile::bytesPerFrame, REPLAY_GROWTH},
+	{"gap_p50_ms", &ReplayProfile::gapP50, REPLAY_GROWTH},
+	{"gap_p99_ms", &ReplayProfile::gapP99, REPLAY_GROWTH},
+	{"gap_max_ms", &ReplayProfile::gapMax, REPLAY_GROWTH},
+	{"screens", &ReplayProfile::screens, REPLAY_INFO},
+	{"screen_hash", &ReplayProfile::screenHash, REPLAY_INFO},
+	{"connections", &ReplayProfile::connections, REPLAY_INFO},
+	{"fetches", &ReplayProfile::fetches, REPLAY_INFO},
+	{"inputs", &ReplayProfile::inputs, REPLAY_INFO},
+	{"unanswered", &ReplayProfile::unanswered, REPLAY_GROWTH},
+	{"render_p99_us", &ReplayProfile::renderP99, REPLAY_TIMING},
+	{"flush_p99_us", &ReplayProfile::flushP99, REPLAY_TIMING},
+};
+
+#define REPLAY_FIELD_COUNT (sizeof(replayFields) / sizeof(replayFields[0]))
+
+bool writeReplayProfile(const char* path, const ReplayProfile& profile) {
+	FILE* file = fopen(path, "w");
+	if (file == nullptr) {
+		return false;
+	}
+	fprintf(file, "# name value, written by replay_session --write\n");
+	for (size_t i = 0; i < REPLAY_FIELD_COUNT; i++) {
+		fprintf(file, "%s %lu\n", replayFields[i].name, (unsigned long)(profile.*replayFields[i].value));
+	}
+	return fclose(file) == 0;
+}
+
+bool loadReplayProfile(const char* path, ReplayProfile* profile) {
+	FILE* file = fopen(path, "r");
+	if (file == nullptr) {
+		return false;
+	}
+	memset(profile, 0, sizeof(*profile));
+	char line[96];
+	size_t found = 0;
+	while (fgets(line, sizeof(line), file) != nullptr) {
+		char name[32];
+		unsigned long value;
+		if (line[0] == '#' || sscanf(line, "%31s %lu", name, &value) != 2) {
+			continue;
+		}
+		for (size_t i = 0; i < REPLAY_FIELD_COUNT; i++) {
+			if (strcmp(replayFields[i].name, name) == 0) {
+				profile->*replayFields[i].value = (uint32_t)value;
+				found++;
+			}
+		}
+	}
+	fclose(file);
+	return found > 0;
+}
+
+void printReplayProfile(const ReplayProfile& profile) {
+	for (size_t i = 0; i < REPLAY_FIELD_COUNT; i++) {
+		printf("%-16s %10lu\n", replayFields[i].name, (unsigned long)(profile.*replayFields[i].value));
+	}
+}
+
+int compareReplayProfiles(const ReplayProfile& baseline, const ReplayProfile& current, double tolerance) {
+	int regressions = 0;
+	printf("\n%-16s %10s %10s %8s\n", "metric", "baseline", "current", "change");
+	for (size_t i = 0; i < REPLAY_FIELD_COUNT; i++) {
+		const ReplayField& field = replayFields[i];
+		uint32_t base = baseline.*field.value;
+		uint32_t value = current.*field.value;
+		double change = base > 0 ? ((double)value / base - 1) * 100 : 0;
+		const char* verdict = "";
+		if (field.check == REPLAY_GROWTH && value > base) {
+			verdict = "  WORSE";
+			regressions++;
+		} else if (field.check == REPLAY_TIMING && tolerance > 0 && base > 0 && change > tolerance) {
+			verdict = "  SLOWER";
+			regressions++;
+		}
+		printf("%-16s %10lu %10lu %+7.0f%%%s\n", field.name, (unsigned long)base, (unsigned long)value, change, verdict);
+	}
+	return regressions;
+}
@@ -0,0 +1,163 @@
+#ifndef SESSION_REPLAY_H
+#define SESSION_REPLAY_H
+
+#include "WeatherAnimations.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Same-time tick() calls a replay makes while work is due now, before it
+// moves the clock 1 ms on; a request waiting for data keeps asking for now
+#define REPLAY_TICKS_PER_MS 32
+
+// Settings and size of a recording, from its records
+struct RecordedSession {
+	uint32_t start;          // millis() of the recording's clock at recordStart()
+	uint32_t duration;       // ms from the start to the end record
+	bool hasBegin;           // begin() was recorded; the settings below are valid
+	uint32_t beginTime;      // ms from the start to begin()
+	uint8_t displayType;
+	uint8_t mode;
+	uint8_t animationMode;
+	bool hub;
+	uint32_t pollInterval;
+	uint32_t connections;    // Home Assistant connections
+	uint32_t fetches;        // downloads
+	uint32_t inputs;         // input events
+	uint32_t bytes;          // response and download bytes
+};
+
+// What one replay drew. Times are on the replay's VirtualClock, so all but
+// the render and flush timings come out the same on every run and machine.
+struct ReplayProfile {
+	uint32_t duration;       // ms replayed
+	uint32_t ticks;          // tick() calls
+	uint32_t frames;         // frames that reached the panel
+	uint32_t busBytes;       // bytes they sent (TFT: 2 per pixel written)
+	uint32_t bytesPerFrame;
+	uint32_t gapP50;         // ms between frames
+	uint32_t gapP99;
+	uint32_t gapMax;
+	uint32_t screens;        // times the pixels changed
+	uint32_t screenHash;     // FNV-1a of every screen and when it appeared
+	uint32_t connections;    // answered from the recording
+	uint32_t fetches;
+	uint32_t inputs;
+	uint32_t unanswered;     // connections the recording had no answer for
+	uint32_t renderP99;      // microseconds of host CPU, from getPerfStats()
+	uint32_t flushP99;
+};
+
+// Plays a recording made with recordStart() (src/WeatherAnimationsRecorder.h)
+// back into the library on the host.
+//
+// run() sets up a display the way the recording's begin() did and drives
+// it with tick() on a VirtualClock that starts at the recorded time. Home
+// Assistant connections and downloads are answered from the recording in
+// the order they were made, with each response's bytes arriving as many
+// ms after the connection as they did when recorded, and connect() or a
+// download blocking the clock for as long as it did. Input events are
+// injected into an InputManager at the times they were handed to the
+// sketch. The tick budget is one step per tick(), so the same recording
+// draws the same frames at the same virtual times on every run and every
+// machine, and profiles of two versions of the library can be compared.
+class SessionReplay : public HostNetwork {
+public:
+	SessionReplay();
+	~SessionReplay();
+
+	bool load(const uint8_t* data, size_t size);
+	bool loadFile(const char* path);
+
+	const RecordedSession& session() const;
+
+	// Replays the whole session; events go to handler as they would from
+	// WeatherAnimations::setInput(). Returns false without a begin record.
+	bool run(ReplayProfile* profile, InputHandler handler = nullptr, void* context = nullptr);
+
+	// When each screen appeared in the last run, in ms from the start
+	struct Screen {
+		uint32_t time;
+		uint32_t hash;
+	};
+	const std::vector<Screen>& screens() const;
+
+	// Answer connections from the recording on clock without driving a
+	// display, for code under test that makes its own requests
+	void attach(VirtualClock* clock);
+	void detach();
+
+	// HostNetwork
+	int open(const char* host, uint16_t port, bool http) override;
+	int available(int handle) override;
+	int read(int handle, uint8_t* buf, size_t size) override;
+	bool closed(int handle) override;
+	void close(int handle) override;
+
+private:
+	struct Chunk {
+		uint32_t time;       // ms from the start
+		size_t offset;       // into _data
+		size_t length;
+	};
+	struct Connection {
+		uint32_t time;       // ms from the start, once connect() returned
+		bool connected;
+		uint32_t blocked;
+		std::vector<Chunk> chunks;
+		bool closes;
+		uint32_t closeTime;
+	};
+	struct Fetch {
+		int status;
+		uint32_t blocked;
+		long contentLength;
+		size_t offset;
+		size_t size;
+	};
+	struct Input {
+		uint32_t time;
+		InputEvent event;
+		uint32_t age;
+	};
+	struct Channel {
+		bool open;
+		const Connection* connection;  // nullptr for a download
+		uint32_t epoch;                // clock when the replayed connect() returned
+		size_t chunk;
+		size_t chunkOffset;
+		std::string response;          // a download's whole response
+		size_t responseOffset;
+	};
+
+	void rewind();
+	bool due(const Channel& channel, uint32_t time) const;
+	uint32_t nextArrival(uint32_t now) const;
+	uint32_t screenHash(uint8_t displayType) const;
+
+	std::vector<uint8_t> _data;
+	RecordedSession _session;
+	std::vector<Connection> _connections;
+	std::vector<Fetch> _fetches;
+	std::vector<Input> _inputs;
+	std::vector<Channel> _channels;
+	std::vector<Screen> _screens;
+	VirtualClock* _clock;
+	size_t _nextConnection;
+	size_t _nextFetch;
+	uint32_t _unanswered;
+};
+
+// Profiles as text, one "name value" line each, like bench/baseline.txt
+bool writeReplayProfile(const char* path, const ReplayProfile& profile);
+bool loadReplayProfile(const char* path, ReplayProfile* profile);
+void printReplayProfile(const ReplayProfile& profile);
+
+// Prints current against baseline and returns the regressions: any growth
+// of the frame gaps, bus bytes or unanswered connections, and render or
+// flush p99 slower by more than tolerance percent (0 skips the timings)
+int compareReplayProfiles(const ReplayProfile& baseline, const ReplayProfile& current, double tolerance);
+
+#endif // SESSION_REPLAY_H
@@ -0,0 +1,53 @@
+#include "TestPNG.h"
+
+#include <string.h>
+#include <zlib.h>
+
+#define TEST_PNG_WIDTH 128
+#define TEST_PNG_HEIGHT 64
+
+// Helper function to write one chunk at pos: length, type, data and CRC
+static size_t putChunk(uint8_t* png, size_t pos, const char* type, const uint8_t* data, uint32_t length) {
+	uint8_t* start = png + pos;
+	start[0] = length >> 24; start[1] = length >> 16; start[2] = length >> 8; start[3] = length;
+	memcpy(start + 4, type, 4);
+	if (data != nullptr && data != start + 8) {
+		memmove(start + 8, data, length);
+	}
+	uint32_t crc = crc32(0, start + 4, length + 4);
+	start[8 + length] = crc >> 24; start[9 + length] = crc >> 16;
+	start[10 + length] = crc >> 8; start[11 + length] = crc;
+	return pos + 12 + length;
+}
+
+size_t makeTestPNG(uint8_t* png, size_t size, uint8_t pattern, uint8_t value) {
+	// Each line is a filter byte (none) and one grey byte per pixel
+	uint8_t raw[(TEST_PNG_WIDTH + 1) * TEST_PNG_HEIGHT];
+	for (uint32_t y = 0; y < TEST_PNG_HEIGHT; y++) {
+		uint8_t* line = raw + y * (TEST_PNG_WIDTH + 1);
+		line[0] = 0;
+		for (uint32_t x = 0; x < TEST_PNG_WIDTH; x++) {
+			if (pattern == TEST_PNG_SOLID) {
+				line[1 + x] = value;
+			} else {
+				line[1 + x] = ((x + y + value) / 8) % 2 ? 0xFF : 0x00;
+			}
+		}
+	}
+
+	// Signature, IHDR and the IDAT header come first, IDAT's CRC and IEND last
+	if (size < 64) {
+		return 0;
+	}
+	uLongf idatSize = size - 64;
+	if (compress(png + 41, &idatSize, raw, sizeof(raw)) != Z_OK) {
+		return 0;
+	}
+
+	static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+	static const uint8_t ihdr[13] = {0, 0, 0, TEST_PNG_WIDTH, 0, 0, 0, TEST_PNG_HEIGHT, 8, 0, 0, 0, 0};
+	memcpy(png, signature, 8);
+	size_t pos = putChunk(png, 8, "IHDR", ihdr, sizeof(ihdr));
+	pos = putChunk(png, pos, "IDAT", png + 41, idatSize);
+	return putChunk(png, pos, "IEND", nullptr, 0);
+}
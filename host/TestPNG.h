@@ -0,0 +1,16 @@
+#ifndef TEST_PNG_H
+#define TEST_PNG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Patterns makeTestPNG() draws
+#define TEST_PNG_STRIPES 0 // diagonal stripes 8 pixels wide, shifted by value pixels
+#define TEST_PNG_SOLID 1   // every pixel the grey level value
+
+// Writes a 128x64 grayscale PNG of a pattern into png, for the tests, the
+// mock server's assets and the benchmarks; returns its size, or 0 if it
+// does not fit or does not compress
+size_t makeTestPNG(uint8_t* png, size_t size, uint8_t pattern, uint8_t value);
+
+#endif // TEST_PNG_H
@@ -0,0 +1,79 @@
+// Headless renderer for the host build: runs WeatherAnimations unchanged
+// against the display shims and writes what the panel would show for every
+// weather condition to image files.
+//
+//   render_frames [output directory] [oled|tft] [trace file]
+//
+// OLED frames are written as <condition>.pbm (128x64, 1 bit), TFT frames as
+// <condition>.ppm (240x320, RGB). Home Assistant is not needed: each
+// condition is applied as a snapshot, as the data hub would. With a trace
+// file, the whole run is also written there as a Chrome/Perfetto trace.
+
+#include "WeatherAnimations.h"
+#include "HostTest.h"
+
+#include <stdio.h>
+
+static const char* const conditions[] = {"sunny", "cloudy", "rainy", "snowy", "lightning"};
+static const int conditionCount = sizeof(conditions) / sizeof(conditions[0]);
+
+// How long each condition animates before its frame is captured
+#define RENDER_MILLIS 600
+
+// Helper function to run the animation loop for a while
+static void animate(WeatherAnimations& animations, uint32_t duration) {
+	uint32_t start = millis();
+	while (millis() - start < duration) {
+		uint32_t next = animations.tick(millis());
+		while ((int32_t)(millis() - next) < 0 && millis() - start < duration) {
+			delay(1);
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	const char* directory = argc > 1 ? argv[1] : ".";
+	bool tft = argc > 2 && strcmp(argv[2], "tft") == 0;
+	const char* tracePath = argc > 3 ? argv[3] : nullptr;
+	if (tracePath != nullptr && !traceStart(16384)) {
+		fprintf(stderr, "render_frames: cannot allocate the trace ring\n");
+		return 1;
+	}
+
+	// Nothing listens on this address; polls fail fast and leave the snapshots alone
+	WeatherAnimations animations("host", "host", "127.0.0.1", "token");
+	animations.setMode(CONTINUOUS_WEATHER);
+	animations.setAnimationMode(ANIMATION_EMBEDDED);
+	animations.begin(tft ? TFT_DISPLAY : OLED_SSD1306, 0x3C, false);
+
+	int written = 0;
+	for (int i = 0; i < conditionCount; i++) {
+		applyCondition(animations, conditions[i]);
+		animate(animations, RENDER_MILLIS);
+
+		char path[256];
+		bool saved;
+		if (tft) {
+			snprintf(path, sizeof(path), "%s/%s.ppm", directory, conditions[i]);
+			saved = TFT_eSPI::lastInstance() != nullptr && TFT_eSPI::lastInstance()->writePPM(path);
+		} else {
+			snprintf(path, sizeof(path), "%s/%s.pbm", directory, conditions[i]);
+			saved = Adafruit_SSD1306::lastInstance() != nullptr && Adafruit_SSD1306::lastInstance()->writePBM(path);
+		}
+		if (!saved) {
+			fprintf(stderr, "render_frames: cannot write %s\n", path);
+			return 1;
+		}
+		written++;
+	}
+
+	printf("render_frames: %d frames written to %s\n", written, directory);
+	if (tracePath != nullptr) {
+		if (!traceWriteFile(tracePath)) {
+			fprintf(stderr, "render_frames: cannot write %s\n", tracePath);
+			return 1;
+		}
+		printf("render_frames: %u trace events written to %s\n", (unsigned)traceEventCount(), tracePath);
+	}
+	return 0;
+}
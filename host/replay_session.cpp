@@ -0,0 +1,93 @@
+// Replays a recording made with recordStart() and prints what the library
+// drew: frames, bus bytes, the gaps between frames in virtual ms, and the
+// render and flush p99 of the host. Built by the host CMake project:
+//
+//   build/replay_session session.warc
+//   build/replay_session session.warc --write before.txt     # on the old version
+//   build/replay_session session.warc --compare before.txt   # on the new one
+//   build/replay_session session.warc --trace replay.json    # timeline for Perfetto
+//
+// --compare fails if the frame gaps, bus bytes or unanswered connections
+// grew, or render or flush p99 is slower by more than --tolerance percent
+// (default 50; 0 only checks the virtual-time numbers, which are the same
+// on every machine).
+
+#include "SessionReplay.h"
+
+#include <stdio.h>
+
+int main(int argc, char** argv) {
+	const char* recordingPath = nullptr;
+	const char* comparePath = nullptr;
+	const char* writePath = nullptr;
+	const char* tracePath = nullptr;
+	double tolerance = 50;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc) {
+			comparePath = argv[++i];
+		} else if (strcmp(argv[i], "--write") == 0 && i + 1 < argc) {
+			writePath = argv[++i];
+		} else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+			tolerance = atof(argv[++i]);
+		} else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+			tracePath = argv[++i];
+		} else if (argv[i][0] != '-' && recordingPath == nullptr) {
+			recordingPath = argv[i];
+		} else {
+			recordingPath = nullptr;
+			break;
+		}
+	}
+	if (recordingPath == nullptr) {
+		fprintf(stderr, "usage: %s recording [--compare file [--tolerance percent]] [--write file] [--trace file]\n",
+		        argv[0]);
+		return 2;
+	}
+
+	SessionReplay replay;
+	if (!replay.loadFile(recordingPath)) {
+		fprintf(stderr, "replay_session: cannot read %s\n", recordingPath);
+		return 1;
+	}
+	const RecordedSession& session = replay.session();
+	printf("%s: %lu ms, %lu connections, %lu downloads, %lu inputs, %lu bytes received\n", recordingPath,
+	       (unsigned long)session.duration, (unsigned long)session.connections, (unsigned long)session.fetches,
+	       (unsigned long)session.inputs, (unsigned long)session.bytes);
+
+	if (tracePath != nullptr) {
+		traceStart();
+	}
+	ReplayProfile profile;
+	if (!replay.run(&profile)) {
+		fprintf(stderr, "replay_session: %s has no begin() to replay\n", recordingPath);
+		return 1;
+	}
+	if (tracePath != nullptr) {
+		traceStop();
+		if (!traceWriteFile(tracePath)) {
+			fprintf(stderr, "replay_session: cannot write %s\n", tracePath);
+			return 1;
+		}
+		traceRelease();
+	}
+	printReplayProfile(profile);
+
+	if (writePath != nullptr && !writeReplayProfile(writePath, profile)) {
+		fprintf(stderr, "replay_session: cannot write %s\n", writePath);
+		return 1;
+	}
+	if (comparePath != nullptr) {
+		ReplayProfile baseline;
+		if (!loadReplayProfile(comparePath, &baseline)) {
+			fprintf(stderr, "replay_session: cannot read %s\n", comparePath);
+			return 1;
+		}
+		int regressions = compareReplayProfiles(baseline, profile, tolerance);
+		if (regressions != 0) {
+			printf("replay_session: %d regressions against %s\n", regressions, comparePath);
+			return 1;
+		}
+		printf("replay_session: no regressions against %s\n", comparePath);
+	}
+	return 0;
+}
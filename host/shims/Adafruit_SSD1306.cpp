@@ -0,0 +1,123 @@
+#include "Adafruit_SSD1306.h"
+
+static Adafruit_SSD1306* lastDisplay = nullptr;
+
+Adafruit_SSD1306* Adafruit_SSD1306::lastInstance() {
+	return lastDisplay;
+}
+
+Adafruit_SSD1306::Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire* twi, int8_t rst_pin, uint32_t clkDuring, uint32_t clkAfter)
+	: Adafruit_GFX(w, h), buffer(nullptr), _wire(twi ? twi : &Wire), _spi(nullptr), _i2caddr(0),
+	  _inverted(false), _displayCount(0) {
+	(void)rst_pin;
+	(void)clkDuring;
+	(void)clkAfter;
+	lastDisplay = this;
+}
+
+Adafruit_SSD1306::Adafruit_SSD1306(uint8_t w, uint8_t h, SPIClass* spi, int8_t dc_pin, int8_t rst_pin, int8_t cs_pin, uint32_t bitrate)
+	: Adafruit_GFX(w, h), buffer(nullptr), _wire(nullptr), _spi(spi ? spi : &SPI), _i2caddr(0),
+	  _inverted(false), _displayCount(0) {
+	(void)dc_pin;
+	(void)rst_pin;
+	(void)cs_pin;
+	_spi->setFrequency(bitrate);
+	lastDisplay = this;
+}
+
+Adafruit_SSD1306::~Adafruit_SSD1306() {
+	if (lastDisplay == this) lastDisplay = nullptr;
+	free(buffer);
+}
+
+bool Adafruit_SSD1306::begin(uint8_t switchvcc, uint8_t i2caddr, bool reset, bool periphBegin) {
+	(void)switchvcc;
+	(void)reset;
+	(void)periphBegin;
+	if (!buffer) {
+		buffer = (uint8_t*)malloc(WIDTH * ((HEIGHT + 7) / 8));
+		if (!buffer) return false;
+	}
+	clearDisplay();
+	_i2caddr = i2caddr ? i2caddr : ((HEIGHT == 32) ? 0x3C : 0x3D);
+	// Same init sequence length as the real driver (25 command bytes)
+	for (int i = 0; i < 25; i++) ssd1306_command(0xE3);
+	return true;
+}
+
+void Adafruit_SSD1306::sendBytes(const uint8_t* data, size_t count, bool isData) {
+	if (_spi) {
+		_spi->writeBytes(data, count);
+		return;
+	}
+	// I2C: one control byte per transaction, 32-byte Wire buffer like upstream
+	size_t sent = 0;
+	while (sent < count) {
+		size_t chunk = count - sent;
+		if (chunk > 31) chunk = 31;
+		_wire->beginTransmission(_i2caddr);
+		_wire->write((uint8_t)(isData ? 0x40 : 0x00));
+		_wire->write(data + sent, chunk);
+		_wire->endTransmission();
+		sent += chunk;
+	}
+}
+
+void Adafruit_SSD1306::ssd1306_command(uint8_t c) {
+	sendBytes(&c, 1, false);
+}
+
+void Adafruit_SSD1306::display() {
+	static const uint8_t dlist[] = {SSD1306_PAGEADDR, 0, 0xFF, SSD1306_COLUMNADDR, 0};
+	sendBytes(dlist, sizeof(dlist), false);
+	ssd1306_command(WIDTH - 1);
+	if (buffer) sendBytes(buffer, WIDTH * ((HEIGHT + 7) / 8), true);
+	_displayCount++;
+}
+
+void Adafruit_SSD1306::clearDisplay() {
+	if (buffer) memset(buffer, 0, WIDTH * ((HEIGHT + 7) / 8));
+}
+
+void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
+	if (!buffer || x < 0 || x >= width() || y < 0 || y >= height()) return;
+	switch (getRotation()) {
+		case 1: std::swap(x, y); x = WIDTH - x - 1; break;
+		case 2: x = WIDTH - x - 1; y = HEIGHT - y - 1; break;
+		case 3: std::swap(x, y); y = HEIGHT - y - 1; break;
+	}
+	uint8_t* ptr = &buffer[x + (y / 8) * WIDTH];
+	switch (color) {
+		case SSD1306_WHITE: *ptr |= (1 << (y & 7)); break;
+		case SSD1306_BLACK: *ptr &= ~(1 << (y & 7)); break;
+		case SSD1306_INVERSE: *ptr ^= (1 << (y & 7)); break;
+	}
+}
+
+void Adafruit_SSD1306::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+	for (int16_t i = 0; i < w; i++) drawPixel(x + i, y, color);
+}
+
+void Adafruit_SSD1306::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+	for (int16_t i = 0; i < h; i++) drawPixel(x, y + i, color);
+}
+
+bool Adafruit_SSD1306::getPixel(int16_t x, int16_t y) {
+	if (!buffer || x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) return false;
+	return (buffer[x + (y / 8) * WIDTH] & (1 << (y & 7))) != 0;
+}
+
+bool Adafruit_SSD1306::writePBM(const char* path) const {
+	FILE* f = fopen(path, "wb");
+	if (!f) return false;
+	fprintf(f, "P1\n%d %d\n", WIDTH, HEIGHT);
+	for (int y = 0; y < HEIGHT; y++) {
+		for (int x = 0; x < WIDTH; x++) {
+			bool on = buffer && (buffer[x + (y / 8) * WIDTH] & (1 << (y & 7)));
+			fputc((on != _inverted) ? '1' : '0', f);
+			fputc(x == WIDTH - 1 ? '\n' : ' ', f);
+		}
+	}
+	fclose(f);
+	return true;
+}
@@ -0,0 +1,68 @@
+// Host shim for Adafruit_SSD1306. Keeps the page-format framebuffer of the
+// real driver; display() accounts the bus bytes a full refresh would cost
+// and the framebuffer can be dumped to a PBM image.
+#ifndef WA_HOST_ADAFRUIT_SSD1306_H
+#define WA_HOST_ADAFRUIT_SSD1306_H
+
+#include "Adafruit_GFX.h"
+#include "Wire.h"
+#include "SPI.h"
+
+#define SSD1306_BLACK 0
+#define SSD1306_WHITE 1
+#define SSD1306_INVERSE 2
+#define BLACK SSD1306_BLACK
+#define WHITE SSD1306_WHITE
+#define INVERSE SSD1306_INVERSE
+
+#define SSD1306_MEMORYMODE 0x20
+#define SSD1306_COLUMNADDR 0x21
+#define SSD1306_PAGEADDR 0x22
+#define SSD1306_SETCONTRAST 0x81
+#define SSD1306_DISPLAYOFF 0xAE
+#define SSD1306_DISPLAYON 0xAF
+#define SSD1306_SEGREMAP 0xA0
+#define SSD1306_COMSCANINC 0xC0
+#define SSD1306_COMSCANDEC 0xC8
+#define SSD1306_EXTERNALVCC 0x01
+#define SSD1306_SWITCHCAPVCC 0x02
+
+class Adafruit_SSD1306 : public Adafruit_GFX {
+public:
+	Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire* twi = &Wire, int8_t rst_pin = -1,
+	                 uint32_t clkDuring = 400000UL, uint32_t clkAfter = 100000UL);
+	Adafruit_SSD1306(uint8_t w, uint8_t h, SPIClass* spi, int8_t dc_pin, int8_t rst_pin, int8_t cs_pin,
+	                 uint32_t bitrate = 8000000UL);
+	~Adafruit_SSD1306();
+
+	bool begin(uint8_t switchvcc = SSD1306_SWITCHCAPVCC, uint8_t i2caddr = 0, bool reset = true, bool periphBegin = true);
+	void display();
+	void clearDisplay();
+	void invertDisplay(bool i) override { _inverted = i; }
+	void dim(bool dim) { (void)dim; }
+	void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+	void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+	void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+	void ssd1306_command(uint8_t c);
+	bool getPixel(int16_t x, int16_t y);
+	uint8_t* getBuffer() { return buffer; }
+
+	// Host-only helpers
+	static Adafruit_SSD1306* lastInstance(); // most recently constructed display
+	bool writePBM(const char* path) const;
+	uint32_t displayCount() const { return _displayCount; }
+	uint8_t i2cAddress() const { return _i2caddr; }
+	bool usesSPI() const { return _spi != nullptr; }
+
+private:
+	void sendBytes(const uint8_t* data, size_t count, bool isData);
+
+	uint8_t* buffer;
+	TwoWire* _wire;
+	SPIClass* _spi;
+	uint8_t _i2caddr;
+	bool _inverted;
+	uint32_t _displayCount;
+};
+
+#endif // WA_HOST_ADAFRUIT_SSD1306_H
@@ -0,0 +1,126 @@
+#include "Arduino.h"
+
+#include <time.h>
+
+HardwareSerial Serial;
+
+static bool serialEnabled = true;
+static int pinLevels[64];
+static void (*pinHandlers[64])(void);
+static void (*pinArgHandlers[64])(void*);
+static void* pinArgs[64];
+static bool pinLevelsInitialised = false;
+
+static uint64_t monotonicMicros() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+}
+
+static uint64_t startMicros = monotonicMicros();
+
+unsigned long millis() {
+	return (unsigned long)(uint32_t)((monotonicMicros() - startMicros) / 1000);
+}
+
+unsigned long micros() {
+	return (unsigned long)(uint32_t)(monotonicMicros() - startMicros);
+}
+
+void delay(unsigned long ms) {
+	struct timespec ts = {(time_t)(ms / 1000), (long)(ms % 1000) * 1000000L};
+	nanosleep(&ts, nullptr);
+}
+
+void delayMicroseconds(unsigned int us) {
+	struct timespec ts = {(time_t)(us / 1000000), (long)(us % 1000000) * 1000L};
+	nanosleep(&ts, nullptr);
+}
+
+void yield() {}
+
+long random(long howbig) {
+	if (howbig <= 0) return 0;
+	return rand() % howbig;
+}
+
+long random(long howsmall, long howbig) {
+	if (howsmall >= howbig) return howsmall;
+	return howsmall + random(howbig - howsmall);
+}
+
+void randomSeed(unsigned long seed) {
+	srand((unsigned int)seed);
+}
+
+static void ensurePins() {
+	if (!pinLevelsInitialised) {
+		for (int i = 0; i < 64; i++) pinLevels[i] = HIGH;
+		pinLevelsInitialised = true;
+	}
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+	(void)pin;
+	(void)mode;
+	ensurePins();
+}
+
+int digitalRead(uint8_t pin) {
+	ensurePins();
+	return pin < 64 ? pinLevels[pin] : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+	ensurePins();
+	if (pin < 64) pinLevels[pin] = val ? HIGH : LOW;
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode) {
+	(void)mode;
+	if (pin < 64) pinHandlers[pin] = handler;
+}
+
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void* arg, int mode) {
+	(void)mode;
+	if (pin < 64) {
+		pinArgHandlers[pin] = handler;
+		pinArgs[pin] = arg;
+	}
+}
+
+void detachInterrupt(uint8_t pin) {
+	if (pin < 64) {
+		pinHandlers[pin] = nullptr;
+		pinArgHandlers[pin] = nullptr;
+	}
+}
+
+void noInterrupts() {}
+void interrupts() {}
+
+size_t HardwareSerial::write(uint8_t c) {
+	if (serialEnabled) fputc(c, stdout);
+	return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+	if (serialEnabled) fwrite(buffer, 1, size, stdout);
+	return size;
+}
+
+namespace HostArduino {
+	void setPinLevel(uint8_t pin, int level) {
+		ensurePins();
+		if (pin < 64) pinLevels[pin] = level;
+	}
+
+	void fireInterrupt(uint8_t pin) {
+		if (pin < 64 && pinHandlers[pin] != nullptr) pinHandlers[pin]();
+		if (pin < 64 && pinArgHandlers[pin] != nullptr) pinArgHandlers[pin](pinArgs[pin]);
+	}
+
+	void setSerialEnabled(bool enabled) {
+		serialEnabled = enabled;
+	}
+}
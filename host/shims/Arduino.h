@@ -0,0 +1,94 @@
+// Host shim for the Arduino core: just enough of the API surface used by
+// the WeatherAnimations sources to compile and run on Linux.
+#ifndef WA_HOST_ARDUINO_H
+#define WA_HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <utility>
+
+#include "WString.h"
+#include "Print.h"
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define CHANGE 0x03
+#define FALLING 0x02
+#define RISING 0x01
+
+#define PROGMEM
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+#define F(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+#define pgm_read_ptr(addr) (*(void* const*)(addr))
+#define digitalPinToInterrupt(p) (p)
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+using std::min;
+using std::max;
+using std::abs;
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t val);
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode);
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void* arg, int mode);
+void detachInterrupt(uint8_t pin);
+void noInterrupts();
+void interrupts();
+
+class HardwareSerial : public Print {
+public:
+	void begin(unsigned long baud) { (void)baud; }
+	void end() {}
+	int available() { return 0; }
+	int read() { return -1; }
+	void flush() { fflush(stdout); }
+	size_t write(uint8_t c) override;
+	size_t write(const uint8_t* buffer, size_t size) override;
+	using Print::write;
+	operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+// Host-only hooks: drive the pin state seen by digitalRead(), raise pin
+// interrupts and silence Serial.
+namespace HostArduino {
+	void setPinLevel(uint8_t pin, int level);
+	void fireInterrupt(uint8_t pin);
+	void setSerialEnabled(bool enabled);
+}
+
+#endif // WA_HOST_ARDUINO_H
@@ -0,0 +1,124 @@
+#include "HTTPClient.h"
+
+HTTPClient::HTTPClient() : _port(80), _valid(false), _chunked(false), _size(-1), _timeout(5000) {
+	_client._http = true;
+}
+
+HTTPClient::~HTTPClient() {
+	end();
+}
+
+bool HTTPClient::begin(const String& url) {
+	_valid = false;
+	_headers = "";
+	_size = -1;
+	_chunked = false;
+	// A host network stands in for the TLS server too
+	bool https = url.startsWith("https://") && WiFi.hostNetwork() != nullptr;
+	if (!url.startsWith("http://") && !https) return false;
+	String rest = url.substring(https ? 8 : 7);
+	int slash = rest.indexOf('/');
+	String hostPort = slash >= 0 ? rest.substring(0, slash) : rest;
+	_path = slash >= 0 ? rest.substring(slash) : String("/");
+	int colon = hostPort.indexOf(':');
+	if (colon >= 0) {
+		_host = hostPort.substring(0, colon);
+		_port = (uint16_t)hostPort.substring(colon + 1).toInt();
+	} else {
+		_host = hostPort;
+		_port = https ? 443 : 80;
+	}
+	_valid = _host.length() > 0;
+	return _valid;
+}
+
+void HTTPClient::end() {
+	_client.stop();
+}
+
+void HTTPClient::addHeader(const String& name, const String& value) {
+	_headers += name;
+	_headers += ": ";
+	_headers += value;
+	_headers += "\r\n";
+}
+
+int HTTPClient::GET() {
+	return sendRequest("GET", nullptr, 0);
+}
+
+int HTTPClient::POST(const String& payload) {
+	return sendRequest("POST", (const uint8_t*)payload.c_str(), payload.length());
+}
+
+int HTTPClient::sendRequest(const char* type, const uint8_t* payload, size_t size) {
+	if (!_valid) return HTTPC_ERROR_CONNECTION_REFUSED;
+	_client.setTimeout(_timeout);
+	if (!_client.connect(_host.c_str(), _port, _timeout)) return HTTPC_ERROR_CONNECTION_REFUSED;
+
+	String request = String(type) + " " + _path + " HTTP/1.1\r\nHost: " + _host + "\r\n" + _headers;
+	if (payload != nullptr) {
+		request += "Content-Length: ";
+		request += String((unsigned long)size);
+		request += "\r\n";
+	}
+	request += "Connection: close\r\n\r\n";
+	if (_client.write((const uint8_t*)request.c_str(), request.length()) != request.length()) {
+		return HTTPC_ERROR_SEND_HEADER_FAILED;
+	}
+	if (payload != nullptr && size > 0 && _client.write(payload, size) != size) {
+		return HTTPC_ERROR_SEND_HEADER_FAILED;
+	}
+
+	String status = _client.readStringUntil('\n');
+	if (!status.startsWith("HTTP/1.")) return HTTPC_ERROR_READ_TIMEOUT;
+	int code = status.substring(9, 12).toInt();
+	if (!readHeaders()) return HTTPC_ERROR_CONNECTION_LOST;
+	return code;
+}
+
+bool HTTPClient::readHeaders() {
+	while (true) {
+		String line = _client.readStringUntil('\n');
+		line.trim();
+		if (line.length() == 0) return true;
+		String lower = line;
+		lower.toLowerCase();
+		if (lower.startsWith("content-length:")) {
+			_size = (int)line.substring(15).toInt();
+		} else if (lower.startsWith("transfer-encoding:") && lower.indexOf("chunked") >= 0) {
+			_chunked = true;
+		}
+		if (!_client.connected() && _client.available() == 0) return false;
+	}
+}
+
+String HTTPClient::getString() {
+	String body;
+	if (_chunked) {
+		while (true) {
+			String sizeLine = _client.readStringUntil('\n');
+			long chunk = strtol(sizeLine.c_str(), nullptr, 16);
+			if (chunk <= 0) break;
+			while (chunk-- > 0) {
+				char c;
+				if (_client.readBytes(&c, 1) != 1) return body;
+				body += c;
+			}
+			_client.readStringUntil('\n');
+		}
+		return body;
+	}
+	if (_size >= 0) body.reserve(_size);
+	int remaining = _size;
+	char buf[512];
+	while (remaining != 0) {
+		size_t want = sizeof(buf);
+		if (remaining > 0 && (size_t)remaining < want) want = remaining;
+		size_t n = _client.readBytes(buf, want);
+		if (n == 0) break;
+		body.concat(buf, n);
+		if (remaining > 0) remaining -= n;
+	}
+	return body;
+}
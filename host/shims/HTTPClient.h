@@ -0,0 +1,53 @@
+// Host shim for the ESP32 HTTPClient library (plain HTTP/1.1 over the
+// WiFiClient shim; https:// URLs fail with a connection error unless a
+// host network answers them, see WiFiClass::hostSetNetwork()).
+#ifndef WA_HOST_HTTPCLIENT_H
+#define WA_HOST_HTTPCLIENT_H
+
+#include "WiFi.h"
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+#define HTTP_CODE_OK 200
+
+class HTTPClient {
+public:
+	HTTPClient();
+	~HTTPClient();
+
+	bool begin(const String& url);
+	bool begin(const char* url) { return begin(String(url)); }
+	void end();
+	void addHeader(const String& name, const String& value);
+	void setTimeout(uint16_t timeout) { _timeout = timeout; }
+	void setReuse(bool reuse) { (void)reuse; }
+
+	int GET();
+	int POST(const String& payload);
+	int sendRequest(const char* type, const uint8_t* payload, size_t size);
+
+	int getSize() const { return _size; }
+	String getString();
+	WiFiClient* getStreamPtr() { return &_client; }
+	WiFiClient& getStream() { return _client; }
+	bool connected() { return _client.connected() || _client.available() > 0; }
+
+private:
+	bool readHeaders();
+
+	WiFiClient _client;
+	String _host;
+	uint16_t _port;
+	String _path;
+	String _headers;
+	bool _valid;
+	bool _chunked;
+	int _size;
+	uint16_t _timeout;
+};
+
+#endif // WA_HOST_HTTPCLIENT_H
@@ -0,0 +1,178 @@
+#include "PNGdec.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+static uint32_t readBE32(const uint8_t* p) {
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static int channelsFor(int pixelType) {
+	switch (pixelType) {
+		case PNG_PIXEL_TRUECOLOR: return 3;
+		case PNG_PIXEL_GRAY_ALPHA: return 2;
+		case PNG_PIXEL_TRUECOLOR_ALPHA: return 4;
+		default: return 1;
+	}
+}
+
+PNG::PNG() : _data(nullptr), _size(0), _draw(nullptr), _width(0), _height(0), _bpp(0), _pixelType(0), _error(PNG_SUCCESS) {
+	memset(_palette, 0xFF, sizeof(_palette));
+}
+
+PNG::~PNG() {}
+
+int PNG::openRAM(uint8_t* pData, int iDataSize, PNG_DRAW_CALLBACK* pfnDraw) {
+	static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+	_data = pData;
+	_size = iDataSize;
+	_draw = pfnDraw;
+	_error = PNG_SUCCESS;
+	if (!pData || iDataSize < 33 || memcmp(pData, signature, 8) != 0 || memcmp(pData + 12, "IHDR", 4) != 0) {
+		_error = PNG_INVALID_FILE;
+		return _error;
+	}
+	_width = (int)readBE32(pData + 16);
+	_height = (int)readBE32(pData + 20);
+	_bpp = pData[24];
+	_pixelType = pData[25];
+	if (pData[28] != 0 || (_bpp != 8 && _pixelType != PNG_PIXEL_GRAYSCALE && _pixelType != PNG_PIXEL_INDEXED)) {
+		_error = PNG_UNSUPPORTED_FEATURE;
+	}
+	return _error;
+}
+
+int PNG::decode(void* pUser, int iOptions) {
+	(void)iOptions;
+	if (_error != PNG_SUCCESS) return _error;
+
+	// Gather IDAT chunks and palette
+	size_t idatSize = 0;
+	for (int pos = 8; pos + 12 <= _size;) {
+		uint32_t len = readBE32(_data + pos);
+		if (memcmp(_data + pos + 4, "IDAT", 4) == 0) idatSize += len;
+		pos += 12 + len;
+	}
+	uint8_t* idat = (uint8_t*)malloc(idatSize ? idatSize : 1);
+	if (!idat) return PNG_MEM_ERROR;
+	size_t offset = 0;
+	for (int pos = 8; pos + 12 <= _size;) {
+		uint32_t len = readBE32(_data + pos);
+		const uint8_t* chunk = _data + pos + 8;
+		if (pos + 12 + (int)len > _size) break;
+		if (memcmp(_data + pos + 4, "IDAT", 4) == 0) {
+			memcpy(idat + offset, chunk, len);
+			offset += len;
+		} else if (memcmp(_data + pos + 4, "PLTE", 4) == 0 && len <= 768) {
+			memcpy(_palette, chunk, len);
+		} else if (memcmp(_data + pos + 4, "tRNS", 4) == 0 && len <= 256) {
+			memcpy(_palette + 768, chunk, len);
+		}
+		pos += 12 + len;
+	}
+
+	int bitsPerPixel = _bpp * channelsFor(_pixelType);
+	size_t pitch = ((size_t)_width * bitsPerPixel + 7) / 8;
+	size_t rawSize = (pitch + 1) * _height;
+	uint8_t* raw = (uint8_t*)malloc(rawSize);
+	uint8_t* prev = (uint8_t*)calloc(pitch, 1);
+	if (!raw || !prev) {
+		free(idat);
+		free(raw);
+		free(prev);
+		return PNG_MEM_ERROR;
+	}
+	uLongf outLen = rawSize;
+	if (uncompress(raw, &outLen, idat, offset) != Z_OK || outLen != rawSize) {
+		free(idat);
+		free(raw);
+		free(prev);
+		_error = PNG_DECODE_ERROR;
+		return _error;
+	}
+	free(idat);
+
+	int bpp = (bitsPerPixel + 7) / 8;
+	PNGDRAW draw;
+	memset(&draw, 0, sizeof(draw));
+	draw.iWidth = _width;
+	draw.iPitch = (int)pitch;
+	draw.iPixelType = _pixelType;
+	draw.iBpp = _bpp;
+	draw.iHasAlpha = hasAlpha();
+	draw.pUser = pUser;
+	draw.pPalette = _palette;
+	for (int y = 0; y < _height; y++) {
+		uint8_t filter = raw[y * (pitch + 1)];
+		uint8_t* line = raw + y * (pitch + 1) + 1;
+		for (size_t i = 0; i < pitch; i++) {
+			int a = i >= (size_t)bpp ? line[i - bpp] : 0;
+			int b = prev[i];
+			int c = i >= (size_t)bpp ? prev[i - bpp] : 0;
+			switch (filter) {
+				case 1: line[i] += a; break;
+				case 2: line[i] += b; break;
+				case 3: line[i] += (a + b) / 2; break;
+				case 4: {
+					int p = a + b - c;
+					int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+					line[i] += (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+					break;
+				}
+			}
+		}
+		memcpy(prev, line, pitch);
+		draw.y = y;
+		draw.pPixels = line;
+		if (_draw) _draw(&draw);
+	}
+	free(raw);
+	free(prev);
+	return PNG_SUCCESS;
+}
+
+void PNG::close() {
+	_data = nullptr;
+	_size = 0;
+}
+
+void PNG::getLineAsRGB565(PNGDRAW* pDraw, uint16_t* pPixels, int iEndianness, uint32_t u32Bkgd) {
+	uint8_t bgR = (u32Bkgd >> 16) & 0xFF, bgG = (u32Bkgd >> 8) & 0xFF, bgB = u32Bkgd & 0xFF;
+	const uint8_t* s = pDraw->pPixels;
+	for (int x = 0; x < pDraw->iWidth; x++) {
+		uint8_t r, g, b, a = 255;
+		switch (pDraw->iPixelType) {
+			case PNG_PIXEL_TRUECOLOR:
+				r = s[x * 3]; g = s[x * 3 + 1]; b = s[x * 3 + 2];
+				break;
+			case PNG_PIXEL_TRUECOLOR_ALPHA:
+				r = s[x * 4]; g = s[x * 4 + 1]; b = s[x * 4 + 2]; a = s[x * 4 + 3];
+				break;
+			case PNG_PIXEL_GRAY_ALPHA:
+				r = g = b = s[x * 2]; a = s[x * 2 + 1];
+				break;
+			case PNG_PIXEL_INDEXED: {
+				int bits = pDraw->iBpp;
+				int index = (s[(x * bits) / 8] >> (8 - bits - (x * bits) % 8)) & ((1 << bits) - 1);
+				r = pDraw->pPalette[index * 3]; g = pDraw->pPalette[index * 3 + 1]; b = pDraw->pPalette[index * 3 + 2];
+				a = pDraw->pPalette[768 + index];
+				break;
+			}
+			default: {
+				int bits = pDraw->iBpp;
+				int v = (s[(x * bits) / 8] >> (8 - bits - (x * bits) % 8)) & ((1 << bits) - 1);
+				r = g = b = (uint8_t)(v * 255 / ((1 << bits) - 1));
+				break;
+			}
+		}
+		if (a != 255) {
+			r = (uint8_t)((r * a + bgR * (255 - a)) / 255);
+			g = (uint8_t)((g * a + bgG * (255 - a)) / 255);
+			b = (uint8_t)((b * a + bgB * (255 - a)) / 255);
+		}
+		uint16_t c = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+		if (iEndianness == PNG_RGB565_BIG_ENDIAN) c = (uint16_t)((c << 8) | (c >> 8));
+		pPixels[x] = c;
+	}
+}
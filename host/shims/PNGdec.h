@@ -0,0 +1,69 @@
+// Host shim for bitbank2's PNGdec with the same callback-per-line API,
+// implemented on top of zlib. Non-interlaced images only.
+#ifndef WA_HOST_PNGDEC_H
+#define WA_HOST_PNGDEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define PNG_SUCCESS 0
+#define PNG_INVALID_PARAMETER 1
+#define PNG_DECODE_ERROR 2
+#define PNG_MEM_ERROR 3
+#define PNG_NO_BUFFER 4
+#define PNG_UNSUPPORTED_FEATURE 5
+#define PNG_INVALID_FILE 6
+#define PNG_TOO_BIG 7
+
+#define PNG_RGB565_LITTLE_ENDIAN 0
+#define PNG_RGB565_BIG_ENDIAN 1
+
+#define PNG_PIXEL_GRAYSCALE 0
+#define PNG_PIXEL_TRUECOLOR 2
+#define PNG_PIXEL_INDEXED 3
+#define PNG_PIXEL_GRAY_ALPHA 4
+#define PNG_PIXEL_TRUECOLOR_ALPHA 6
+
+typedef struct png_draw_tag {
+	int y;
+	int iWidth;
+	int iPitch;
+	int iPixelType;
+	int iBpp;
+	int iHasAlpha;
+	void* pUser;
+	uint8_t* pPalette;
+	uint16_t* pFastPalette;
+	uint8_t* pPixels;
+} PNGDRAW;
+
+typedef void(PNG_DRAW_CALLBACK)(PNGDRAW* pDraw);
+
+class PNG {
+public:
+	PNG();
+	~PNG();
+	int openRAM(uint8_t* pData, int iDataSize, PNG_DRAW_CALLBACK* pfnDraw);
+	int decode(void* pUser, int iOptions);
+	void close();
+	int getWidth() const { return _width; }
+	int getHeight() const { return _height; }
+	int getBpp() const { return _bpp; }
+	int hasAlpha() const { return _pixelType == PNG_PIXEL_GRAY_ALPHA || _pixelType == PNG_PIXEL_TRUECOLOR_ALPHA; }
+	int getPixelType() const { return _pixelType; }
+	int getLastError() const { return _error; }
+	void getLineAsRGB565(PNGDRAW* pDraw, uint16_t* pPixels, int iEndianness, uint32_t u32Bkgd);
+
+private:
+	uint8_t* _data;
+	int _size;
+	PNG_DRAW_CALLBACK* _draw;
+	int _width;
+	int _height;
+	int _bpp;
+	int _pixelType;
+	int _error;
+	uint8_t _palette[768 + 256];
+};
+
+#endif // WA_HOST_PNGDEC_H
@@ -0,0 +1,54 @@
+#include "Print.h"
+
+#include <stdio.h>
+#include <math.h>
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+	size_t n = 0;
+	while (size--) {
+		if (write(*buffer++)) n++;
+		else break;
+	}
+	return n;
+}
+
+size_t Print::printNumber(unsigned long long n, int base) {
+	char buf[8 * sizeof(long long) + 1];
+	char* str = &buf[sizeof(buf) - 1];
+	*str = '\0';
+	if (base < 2) base = 10;
+	do {
+		int digit = n % base;
+		*--str = digit < 10 ? '0' + digit : 'A' + digit - 10;
+		n /= base;
+	} while (n);
+	return write(str);
+}
+
+size_t Print::printSigned(long long n, int base) {
+	if (base == 10 && n < 0) {
+		size_t t = print('-');
+		return t + printNumber((unsigned long long)(-n), 10);
+	}
+	return printNumber((unsigned long long)n, base);
+}
+
+size_t Print::printFloat(double number, int digits) {
+	if (isnan(number)) return write("nan");
+	if (isinf(number)) return write("inf");
+	char buf[48];
+	int len = snprintf(buf, sizeof(buf), "%.*f", digits, number);
+	if (len < 0) return 0;
+	return write((const uint8_t*)buf, (size_t)len < sizeof(buf) ? (size_t)len : sizeof(buf) - 1);
+}
+
+size_t Print::printf(const char* format, ...) {
+	char buf[256];
+	va_list args;
+	va_start(args, format);
+	int len = vsnprintf(buf, sizeof(buf), format, args);
+	va_end(args);
+	if (len < 0) return 0;
+	if ((size_t)len >= sizeof(buf)) len = sizeof(buf) - 1;
+	return write((const uint8_t*)buf, len);
+}
@@ -0,0 +1,51 @@
+// Host shim for the Arduino SPI library. Like the Wire shim it only counts
+// the bytes that would have been clocked out.
+#ifndef WA_HOST_SPI_H
+#define WA_HOST_SPI_H
+
+#include "Arduino.h"
+
+#define SPI_MODE0 0x00
+#define MSBFIRST 1
+#define VSPI 3
+#define HSPI 2
+
+class SPISettings {
+public:
+	SPISettings(uint32_t clock = 1000000, uint8_t bitOrder = MSBFIRST, uint8_t dataMode = SPI_MODE0)
+		: clock(clock), bitOrder(bitOrder), dataMode(dataMode) {}
+	uint32_t clock;
+	uint8_t bitOrder;
+	uint8_t dataMode;
+};
+
+class SPIClass {
+public:
+	explicit SPIClass(uint8_t bus = VSPI) : _bus(bus) {}
+	void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1) { (void)sck; (void)miso; (void)mosi; (void)ss; }
+	void end() {}
+	void beginTransaction(SPISettings settings) { _frequency = settings.clock; }
+	void endTransaction() {}
+	void setFrequency(uint32_t frequency) { _frequency = frequency; }
+	uint8_t transfer(uint8_t data) { _bytesWritten++; return data; }
+	void write(uint8_t data) { (void)data; _bytesWritten++; }
+	void writeBytes(const uint8_t* data, uint32_t size) { (void)data; _bytesWritten += size; }
+	void transferBytes(const uint8_t* data, uint8_t* out, uint32_t size) {
+		if (out && data) memcpy(out, data, size);
+		_bytesWritten += size;
+	}
+
+	// Host-only accounting
+	uint32_t bytesWritten() const { return _bytesWritten; }
+	uint32_t frequency() const { return _frequency; }
+	void resetCounters() { _bytesWritten = 0; }
+
+private:
+	uint8_t _bus;
+	uint32_t _frequency = 1000000;
+	uint32_t _bytesWritten = 0;
+};
+
+extern SPIClass SPI;
+
+#endif // WA_HOST_SPI_H
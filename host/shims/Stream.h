@@ -0,0 +1,26 @@
+// Host shim for Arduino's Stream class.
+#ifndef WA_HOST_STREAM_H
+#define WA_HOST_STREAM_H
+
+#include "Print.h"
+
+class Stream : public Print {
+public:
+	virtual int available() = 0;
+	virtual int read() = 0;
+	virtual int peek() = 0;
+	virtual void flush() {}
+
+	void setTimeout(unsigned long timeout) { _timeout = timeout; }
+	unsigned long getTimeout() const { return _timeout; }
+	size_t readBytes(char* buffer, size_t length);
+	size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+	String readStringUntil(char terminator);
+	String readString();
+
+protected:
+	int timedRead();
+	unsigned long _timeout = 1000;
+};
+
+#endif // WA_HOST_STREAM_H
@@ -0,0 +1,96 @@
+#include "TFT_eSPI.h"
+
+static TFT_eSPI* lastDisplay = nullptr;
+
+TFT_eSPI* TFT_eSPI::lastInstance() {
+	return lastDisplay;
+}
+
+TFT_eSPI::TFT_eSPI(int16_t w, int16_t h)
+	: Adafruit_GFX(w, h), _framebuffer(nullptr), _winX(0), _winY(0), _winW(0), _winH(0), _winPos(0),
+	  _swapBytes(false), _pixelsWritten(0) {
+	lastDisplay = this;
+}
+
+TFT_eSPI::~TFT_eSPI() {
+	if (lastDisplay == this) lastDisplay = nullptr;
+	free(_framebuffer);
+}
+
+void TFT_eSPI::init(uint8_t tc) {
+	(void)tc;
+	if (!_framebuffer) _framebuffer = (uint16_t*)calloc((size_t)WIDTH * HEIGHT, sizeof(uint16_t));
+}
+
+void TFT_eSPI::drawPixel(int16_t x, int16_t y, uint16_t color) {
+	if (!_framebuffer || x < 0 || y < 0 || x >= _width || y >= _height) return;
+	int16_t t;
+	switch (rotation) {
+		case 1: t = x; x = WIDTH - 1 - y; y = t; break;
+		case 2: x = WIDTH - 1 - x; y = HEIGHT - 1 - y; break;
+		case 3: t = x; x = y; y = HEIGHT - 1 - t; break;
+	}
+	_framebuffer[(int32_t)y * WIDTH + x] = color;
+	_pixelsWritten++;
+}
+
+void TFT_eSPI::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+	for (int16_t j = y; j < y + h; j++) {
+		for (int16_t i = x; i < x + w; i++) drawPixel(i, j, color);
+	}
+}
+
+void TFT_eSPI::fillScreen(uint16_t color) {
+	fillRect(0, 0, _width, _height, color);
+}
+
+void TFT_eSPI::setAddrWindow(int32_t x, int32_t y, int32_t w, int32_t h) {
+	_winX = x;
+	_winY = y;
+	_winW = w;
+	_winH = h;
+	_winPos = 0;
+}
+
+void TFT_eSPI::pushColor(uint16_t color) {
+	if (_winW <= 0) return;
+	drawPixel(_winX + _winPos % _winW, _winY + _winPos / _winW, color);
+	_winPos++;
+}
+
+void TFT_eSPI::pushColors(uint16_t* data, uint32_t len, bool swap) {
+	for (uint32_t i = 0; i < len; i++) {
+		uint16_t c = data[i];
+		if (!swap) c = (uint16_t)((c << 8) | (c >> 8));
+		pushColor(c);
+	}
+}
+
+void TFT_eSPI::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* data) {
+	for (int32_t j = 0; j < h; j++) {
+		for (int32_t i = 0; i < w; i++) {
+			uint16_t c = data[j * w + i];
+			// Without byte swapping the data is expected in panel (big-endian) order
+			if (!_swapBytes) c = (uint16_t)((c << 8) | (c >> 8));
+			drawPixel(x + i, y + j, c);
+		}
+	}
+}
+
+uint16_t TFT_eSPI::readPixel(int32_t x, int32_t y) const {
+	if (!_framebuffer || x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT) return 0;
+	return _framebuffer[y * WIDTH + x];
+}
+
+bool TFT_eSPI::writePPM(const char* path) const {
+	FILE* f = fopen(path, "wb");
+	if (!f) return false;
+	fprintf(f, "P6\n%d %d\n255\n", WIDTH, HEIGHT);
+	for (int32_t i = 0; i < (int32_t)WIDTH * HEIGHT; i++) {
+		uint16_t c = _framebuffer ? _framebuffer[i] : 0;
+		uint8_t rgb[3] = {(uint8_t)((c >> 8) & 0xF8), (uint8_t)((c >> 3) & 0xFC), (uint8_t)((c << 3) & 0xF8)};
+		fwrite(rgb, 1, 3, f);
+	}
+	fclose(f);
+	return true;
+}
@@ -0,0 +1,69 @@
+// Host shim for TFT_eSPI backed by an in-memory RGB565 framebuffer that can
+// be dumped to a PPM image.
+#ifndef WA_HOST_TFT_ESPI_H
+#define WA_HOST_TFT_ESPI_H
+
+#include "Adafruit_GFX.h"
+
+#ifndef TFT_WIDTH
+#define TFT_WIDTH 240
+#endif
+#ifndef TFT_HEIGHT
+#define TFT_HEIGHT 320
+#endif
+
+#define TFT_BLACK 0x0000
+#define TFT_NAVY 0x000F
+#define TFT_DARKGREEN 0x03E0
+#define TFT_MAROON 0x7800
+#define TFT_PURPLE 0x780F
+#define TFT_OLIVE 0x7BE0
+#define TFT_LIGHTGREY 0xD69A
+#define TFT_DARKGREY 0x7BEF
+#define TFT_BLUE 0x001F
+#define TFT_GREEN 0x07E0
+#define TFT_CYAN 0x07FF
+#define TFT_RED 0xF800
+#define TFT_MAGENTA 0xF81F
+#define TFT_YELLOW 0xFFE0
+#define TFT_WHITE 0xFFFF
+#define TFT_ORANGE 0xFDA0
+
+class TFT_eSPI : public Adafruit_GFX {
+public:
+	TFT_eSPI(int16_t w = TFT_WIDTH, int16_t h = TFT_HEIGHT);
+	~TFT_eSPI();
+
+	void init(uint8_t tc = 0);
+	void begin(uint8_t tc = 0) { init(tc); }
+	void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+	void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+	void fillScreen(uint16_t color) override;
+	void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override { fillRect(x, y, w, 1, color); }
+	void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override { fillRect(x, y, 1, h, color); }
+
+	void setAddrWindow(int32_t x, int32_t y, int32_t w, int32_t h);
+	void pushColor(uint16_t color);
+	void pushColors(uint16_t* data, uint32_t len, bool swap = true);
+	void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* data);
+	void setSwapBytes(bool swap) { _swapBytes = swap; }
+	bool getSwapBytes() const { return _swapBytes; }
+	uint16_t readPixel(int32_t x, int32_t y) const;
+	uint16_t color565(uint8_t r, uint8_t g, uint8_t b) const {
+		return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+	}
+
+	// Host-only helpers
+	static TFT_eSPI* lastInstance(); // most recently constructed display
+	bool writePPM(const char* path) const;
+	uint32_t pixelsWritten() const { return _pixelsWritten; }
+	void resetCounters() { _pixelsWritten = 0; }
+
+private:
+	uint16_t* _framebuffer;
+	int32_t _winX, _winY, _winW, _winH, _winPos;
+	bool _swapBytes;
+	uint32_t _pixelsWritten;
+};
+
+#endif // WA_HOST_TFT_ESPI_H
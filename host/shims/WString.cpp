@@ -0,0 +1,263 @@
+#include "WString.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <utility>
+
+String::String(const char* cstr) : _buffer(nullptr), _capacity(0), _len(0) {
+	if (cstr) copy(cstr, strlen(cstr));
+}
+
+String::String(const char* cstr, unsigned int length) : _buffer(nullptr), _capacity(0), _len(0) {
+	if (cstr) copy(cstr, length);
+}
+
+String::String(const String& str) : _buffer(nullptr), _capacity(0), _len(0) {
+	*this = str;
+}
+
+String::String(String&& rval) noexcept : _buffer(rval._buffer), _capacity(rval._capacity), _len(rval._len) {
+	rval._buffer = nullptr;
+	rval._capacity = 0;
+	rval._len = 0;
+}
+
+String::String(char c) : _buffer(nullptr), _capacity(0), _len(0) {
+	char buf[2] = {c, 0};
+	copy(buf, 1);
+}
+
+static void formatInteger(char* buf, size_t size, unsigned long long value, bool negative, unsigned char base) {
+	char tmp[66];
+	int i = 0;
+	if (base < 2) base = 10;
+	do {
+		int digit = value % base;
+		tmp[i++] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+		value /= base;
+	} while (value > 0 && i < 64);
+	size_t pos = 0;
+	if (negative && pos + 1 < size) buf[pos++] = '-';
+	while (i > 0 && pos + 1 < size) buf[pos++] = tmp[--i];
+	buf[pos] = '\0';
+}
+
+String::String(unsigned char value, unsigned char base) : String((unsigned long)value, base) {}
+String::String(int value, unsigned char base) : String((long)value, base) {}
+String::String(unsigned int value, unsigned char base) : String((unsigned long)value, base) {}
+
+String::String(long value, unsigned char base) : _buffer(nullptr), _capacity(0), _len(0) {
+	char buf[68];
+	bool negative = value < 0 && base == 10;
+	unsigned long long magnitude = negative ? (unsigned long long)(-(long long)value) : (unsigned long)value;
+	formatInteger(buf, sizeof(buf), magnitude, negative, base);
+	copy(buf, strlen(buf));
+}
+
+String::String(unsigned long value, unsigned char base) : _buffer(nullptr), _capacity(0), _len(0) {
+	char buf[68];
+	formatInteger(buf, sizeof(buf), value, false, base);
+	copy(buf, strlen(buf));
+}
+
+String::String(float value, unsigned char decimalPlaces) : String((double)value, decimalPlaces) {}
+
+String::String(double value, unsigned char decimalPlaces) : _buffer(nullptr), _capacity(0), _len(0) {
+	char buf[64];
+	snprintf(buf, sizeof(buf), "%.*f", (int)decimalPlaces, value);
+	copy(buf, strlen(buf));
+}
+
+String::~String() {
+	free(_buffer);
+}
+
+void String::invalidate() {
+	free(_buffer);
+	_buffer = nullptr;
+	_capacity = 0;
+	_len = 0;
+}
+
+bool String::reserve(unsigned int size) {
+	if (_buffer && _capacity >= size) return true;
+	if (changeBuffer(size)) {
+		if (_len == 0) _buffer[0] = 0;
+		return true;
+	}
+	return false;
+}
+
+bool String::changeBuffer(unsigned int maxStrLen) {
+	char* newbuffer = (char*)realloc(_buffer, maxStrLen + 1);
+	if (newbuffer) {
+		_buffer = newbuffer;
+		_capacity = maxStrLen;
+		return true;
+	}
+	return false;
+}
+
+String& String::copy(const char* cstr, unsigned int length) {
+	if (!reserve(length)) {
+		invalidate();
+		return *this;
+	}
+	_len = length;
+	memmove(_buffer, cstr, length);
+	_buffer[length] = 0;
+	return *this;
+}
+
+String& String::operator=(const String& rhs) {
+	if (this == &rhs) return *this;
+	if (rhs._buffer) copy(rhs._buffer, rhs._len);
+	else invalidate();
+	return *this;
+}
+
+String& String::operator=(String&& rval) noexcept {
+	if (this != &rval) {
+		free(_buffer);
+		_buffer = rval._buffer;
+		_capacity = rval._capacity;
+		_len = rval._len;
+		rval._buffer = nullptr;
+		rval._capacity = 0;
+		rval._len = 0;
+	}
+	return *this;
+}
+
+String& String::operator=(const char* cstr) {
+	if (cstr) copy(cstr, strlen(cstr));
+	else invalidate();
+	return *this;
+}
+
+bool String::concat(const char* cstr, unsigned int length) {
+	unsigned int newlen = _len + length;
+	if (!cstr) return false;
+	if (length == 0) return true;
+	if (!reserve(newlen)) return false;
+	memmove(_buffer + _len, cstr, length);
+	_len = newlen;
+	_buffer[_len] = 0;
+	return true;
+}
+
+bool String::concat(const String& str) { return concat(str.c_str(), str._len); }
+bool String::concat(const char* cstr) { return cstr ? concat(cstr, strlen(cstr)) : false; }
+bool String::concat(char c) { return concat(&c, 1); }
+bool String::concat(int num) { return concat(String(num)); }
+bool String::concat(unsigned int num) { return concat(String(num)); }
+bool String::concat(long num) { return concat(String(num)); }
+bool String::concat(unsigned long num) { return concat(String(num)); }
+bool String::concat(float num) { return concat(String(num)); }
+bool String::concat(double num) { return concat(String(num)); }
+
+bool String::equals(const String& s) const {
+	return _len == s._len && strcmp(c_str(), s.c_str()) == 0;
+}
+
+bool String::equals(const char* cstr) const {
+	if (!cstr) return _len == 0;
+	return strcmp(c_str(), cstr) == 0;
+}
+
+bool String::startsWith(const String& prefix) const {
+	if (prefix._len > _len) return false;
+	return strncmp(c_str(), prefix.c_str(), prefix._len) == 0;
+}
+
+bool String::endsWith(const String& suffix) const {
+	if (suffix._len > _len) return false;
+	return strcmp(c_str() + _len - suffix._len, suffix.c_str()) == 0;
+}
+
+char String::charAt(unsigned int index) const {
+	return index < _len ? _buffer[index] : 0;
+}
+
+char& String::operator[](unsigned int index) {
+	static char dummy;
+	if (index >= _len) {
+		dummy = 0;
+		return dummy;
+	}
+	return _buffer[index];
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const {
+	if (fromIndex >= _len) return -1;
+	const char* found = strchr(_buffer + fromIndex, ch);
+	return found ? (int)(found - _buffer) : -1;
+}
+
+int String::indexOf(const char* str, unsigned int fromIndex) const {
+	if (fromIndex >= _len || !str) return -1;
+	const char* found = strstr(_buffer + fromIndex, str);
+	return found ? (int)(found - _buffer) : -1;
+}
+
+int String::lastIndexOf(char ch) const {
+	if (_len == 0) return -1;
+	const char* found = strrchr(_buffer, ch);
+	return found ? (int)(found - _buffer) : -1;
+}
+
+String String::substring(unsigned int left, unsigned int right) const {
+	if (left > right) std::swap(left, right);
+	if (left >= _len) return String();
+	if (right > _len) right = _len;
+	return String(_buffer + left, right - left);
+}
+
+void String::trim() {
+	if (!_buffer || _len == 0) return;
+	char* begin = _buffer;
+	while (isspace((unsigned char)*begin)) begin++;
+	char* end = _buffer + _len - 1;
+	while (end >= begin && isspace((unsigned char)*end)) end--;
+	_len = end + 1 - begin;
+	if (begin > _buffer) memmove(_buffer, begin, _len);
+	_buffer[_len] = 0;
+}
+
+void String::toLowerCase() {
+	for (unsigned int i = 0; i < _len; i++) _buffer[i] = tolower((unsigned char)_buffer[i]);
+}
+
+void String::toUpperCase() {
+	for (unsigned int i = 0; i < _len; i++) _buffer[i] = toupper((unsigned char)_buffer[i]);
+}
+
+long String::toInt() const { return _buffer ? atol(_buffer) : 0; }
+float String::toFloat() const { return _buffer ? (float)atof(_buffer) : 0; }
+double String::toDouble() const { return _buffer ? atof(_buffer) : 0; }
+
+String operator+(const String& lhs, const String& rhs) {
+	String result(lhs);
+	result.concat(rhs);
+	return result;
+}
+
+String operator+(const String& lhs, const char* rhs) {
+	String result(lhs);
+	result.concat(rhs);
+	return result;
+}
+
+String operator+(const char* lhs, const String& rhs) {
+	String result(lhs);
+	result.concat(rhs);
+	return result;
+}
+
+String operator+(const String& lhs, char rhs) {
+	String result(lhs);
+	result.concat(rhs);
+	return result;
+}
@@ -0,0 +1,92 @@
+// Host shim for Arduino's String class. Heap behaviour mirrors the real
+// class closely enough (one buffer per instance, grown on demand) for the
+// allocation counters in host builds to be representative.
+#ifndef WA_HOST_WSTRING_H
+#define WA_HOST_WSTRING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+class String {
+public:
+	String(const char* cstr = "");
+	String(const char* cstr, unsigned int length);
+	String(const String& str);
+	String(String&& rval) noexcept;
+	explicit String(char c);
+	explicit String(unsigned char value, unsigned char base = 10);
+	explicit String(int value, unsigned char base = 10);
+	explicit String(unsigned int value, unsigned char base = 10);
+	explicit String(long value, unsigned char base = 10);
+	explicit String(unsigned long value, unsigned char base = 10);
+	explicit String(float value, unsigned char decimalPlaces = 2);
+	explicit String(double value, unsigned char decimalPlaces = 2);
+	~String();
+
+	String& operator=(const String& rhs);
+	String& operator=(String&& rval) noexcept;
+	String& operator=(const char* cstr);
+
+	bool reserve(unsigned int size);
+	unsigned int length() const { return _len; }
+	const char* c_str() const { return _buffer ? _buffer : ""; }
+	bool isEmpty() const { return _len == 0; }
+
+	bool concat(const String& str);
+	bool concat(const char* cstr);
+	bool concat(const char* cstr, unsigned int length);
+	bool concat(char c);
+	bool concat(int num);
+	bool concat(unsigned int num);
+	bool concat(long num);
+	bool concat(unsigned long num);
+	bool concat(float num);
+	bool concat(double num);
+
+	template <typename T> String& operator+=(const T& rhs) { concat(rhs); return *this; }
+
+	bool equals(const String& s) const;
+	bool equals(const char* cstr) const;
+	bool operator==(const String& rhs) const { return equals(rhs); }
+	bool operator==(const char* cstr) const { return equals(cstr); }
+	bool operator!=(const String& rhs) const { return !equals(rhs); }
+	bool operator!=(const char* cstr) const { return !equals(cstr); }
+	bool startsWith(const String& prefix) const;
+	bool endsWith(const String& suffix) const;
+
+	char charAt(unsigned int index) const;
+	char operator[](unsigned int index) const { return charAt(index); }
+	char& operator[](unsigned int index);
+
+	int indexOf(char ch, unsigned int fromIndex = 0) const;
+	int indexOf(const char* str, unsigned int fromIndex = 0) const;
+	int indexOf(const String& str, unsigned int fromIndex = 0) const { return indexOf(str.c_str(), fromIndex); }
+	int lastIndexOf(char ch) const;
+
+	String substring(unsigned int beginIndex) const { return substring(beginIndex, _len); }
+	String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+	void trim();
+	void toLowerCase();
+	void toUpperCase();
+
+	long toInt() const;
+	float toFloat() const;
+	double toDouble() const;
+
+private:
+	char* _buffer;
+	unsigned int _capacity;
+	unsigned int _len;
+
+	void invalidate();
+	bool changeBuffer(unsigned int maxStrLen);
+	String& copy(const char* cstr, unsigned int length);
+};
+
+String operator+(const String& lhs, const String& rhs);
+String operator+(const String& lhs, const char* rhs);
+String operator+(const char* lhs, const String& rhs);
+String operator+(const String& lhs, char rhs);
+
+#endif // WA_HOST_WSTRING_H
@@ -0,0 +1,194 @@
+#include "WiFi.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+WiFiClass WiFi;
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* passphrase) {
+	(void)ssid;
+	(void)passphrase;
+	_status = WL_CONNECTED;
+	return _status;
+}
+
+bool WiFiClass::disconnect(bool wifioff, bool eraseap) {
+	(void)wifioff;
+	(void)eraseap;
+	_status = WL_DISCONNECTED;
+	return true;
+}
+
+WiFiClient::WiFiClient() : _fd(-1), _handle(-1), _http(false), _rxHead(0), _rxTail(0), _eof(false) {}
+
+WiFiClient::~WiFiClient() {
+	stop();
+}
+
+int WiFiClient::connect(const char* host, uint16_t port) {
+	return connect(host, port, 3000);
+}
+
+int WiFiClient::connect(const char* host, uint16_t port, int32_t timeoutMs) {
+	stop();
+
+	if (WiFi.hostNetwork() != nullptr) {
+		_handle = WiFi.hostNetwork()->open(host, port, _http);
+		return _handle >= 0 ? 1 : 0;
+	}
+
+	// IP literals need no lookup (and, like lwIP, no heap allocation)
+	struct sockaddr_in literal;
+	memset(&literal, 0, sizeof(literal));
+	literal.sin_family = AF_INET;
+	literal.sin_port = htons(port);
+	if (inet_pton(AF_INET, host, &literal.sin_addr) == 1) {
+		return connectTo((struct sockaddr*)&literal, sizeof(literal), timeoutMs);
+	}
+
+	struct addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	char portStr[8];
+	snprintf(portStr, sizeof(portStr), "%u", port);
+	struct addrinfo* result = nullptr;
+	if (getaddrinfo(host, portStr, &hints, &result) != 0 || result == nullptr) return 0;
+
+	int rc = connectTo(result->ai_addr, result->ai_addrlen, timeoutMs);
+	freeaddrinfo(result);
+	return rc;
+}
+
+int WiFiClient::connectTo(const struct sockaddr* address, socklen_t length, int32_t timeoutMs) {
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0) return 0;
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+	int rc = ::connect(fd, address, length);
+	if (rc < 0 && errno != EINPROGRESS) {
+		close(fd);
+		return 0;
+	}
+	if (rc < 0) {
+		struct pollfd pfd = {fd, POLLOUT, 0};
+		if (poll(&pfd, 1, timeoutMs) <= 0) {
+			close(fd);
+			return 0;
+		}
+		int err = 0;
+		socklen_t len = sizeof(err);
+		getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+		if (err != 0) {
+			close(fd);
+			return 0;
+		}
+	}
+	_fd = fd;
+	_rxHead = _rxTail = 0;
+	_eof = false;
+	return 1;
+}
+
+size_t WiFiClient::write(const uint8_t* buf, size_t size) {
+	// The host network has its answers already
+	if (_handle >= 0) return size;
+	if (_fd < 0) return 0;
+	size_t sent = 0;
+	while (sent < size) {
+		ssize_t n = send(_fd, buf + sent, size - sent, MSG_NOSIGNAL);
+		if (n > 0) {
+			sent += n;
+		} else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			struct pollfd pfd = {_fd, POLLOUT, 0};
+			if (poll(&pfd, 1, (int)_timeout) <= 0) break;
+		} else {
+			break;
+		}
+	}
+	return sent;
+}
+
+bool WiFiClient::fill(bool block) {
+	if ((_fd < 0 && _handle < 0) || _eof) return false;
+	if (_rxHead == _rxTail) _rxHead = _rxTail = 0;
+	if (_rxTail == sizeof(_rx)) return true;
+	if (_handle >= 0) {
+		HostNetwork* network = WiFi.hostNetwork();
+		int n = network != nullptr ? network->read(_handle, _rx + _rxTail, sizeof(_rx) - _rxTail) : -1;
+		if (n > 0) {
+			_rxTail += n;
+			return true;
+		}
+		if (network == nullptr || network->closed(_handle)) _eof = true;
+		return false;
+	}
+	if (block) {
+		struct pollfd pfd = {_fd, POLLIN, 0};
+		if (poll(&pfd, 1, (int)_timeout) <= 0) return false;
+	}
+	ssize_t n = recv(_fd, _rx + _rxTail, sizeof(_rx) - _rxTail, 0);
+	if (n > 0) {
+		_rxTail += n;
+		return true;
+	}
+	if (n == 0) _eof = true;
+	return false;
+}
+
+int WiFiClient::available() {
+	if (_rxHead == _rxTail) fill(false);
+	return (int)(_rxTail - _rxHead);
+}
+
+int WiFiClient::read() {
+	if (_rxHead == _rxTail && !fill(false)) return -1;
+	return _rx[_rxHead++];
+}
+
+int WiFiClient::read(uint8_t* buf, size_t size) {
+	if (_rxHead == _rxTail && !fill(false)) return -1;
+	size_t n = _rxTail - _rxHead;
+	if (n > size) n = size;
+	memcpy(buf, _rx + _rxHead, n);
+	_rxHead += n;
+	return (int)n;
+}
+
+int WiFiClient::peek() {
+	if (_rxHead == _rxTail && !fill(false)) return -1;
+	return _rx[_rxHead];
+}
+
+void WiFiClient::stop() {
+	if (_fd >= 0) {
+		close(_fd);
+		_fd = -1;
+	}
+	if (_handle >= 0) {
+		if (WiFi.hostNetwork() != nullptr) WiFi.hostNetwork()->close(_handle);
+		_handle = -1;
+	}
+	_rxHead = _rxTail = 0;
+	_eof = false;
+}
+
+uint8_t WiFiClient::connected() {
+	if (_fd < 0 && _handle < 0) return 0;
+	if (_rxHead != _rxTail) return 1;
+	if (_eof) return 0;
+	fill(false);
+	return (_rxHead != _rxTail || !_eof) ? 1 : 0;
+}
+
+void WiFiClient::setNoDelay(bool nodelay) {
+	if (_fd < 0) return;
+	int flag = nodelay ? 1 : 0;
+	setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+}
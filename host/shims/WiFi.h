@@ -0,0 +1,101 @@
+// Host shim for the ESP32 WiFi library. The "station" is always the host's
+// network stack; WiFiClient is a plain POSIX TCP socket.
+#ifndef WA_HOST_WIFI_H
+#define WA_HOST_WIFI_H
+
+#include "Arduino.h"
+#include "Stream.h"
+#include <sys/socket.h>
+
+typedef enum {
+	WL_IDLE_STATUS = 0,
+	WL_NO_SSID_AVAIL = 1,
+	WL_CONNECTED = 3,
+	WL_CONNECT_FAILED = 4,
+	WL_CONNECTION_LOST = 5,
+	WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum {
+	WIFI_OFF = 0,
+	WIFI_STA = 1,
+	WIFI_AP = 2,
+	WIFI_AP_STA = 3
+} wifi_mode_t;
+
+// Host-only: answers connections in place of the network, e.g. from a
+// recording (host/SessionReplay.h). Handles are the implementation's own.
+class HostNetwork {
+public:
+	virtual ~HostNetwork() {}
+	// A connection to host:port, by HTTPClient if http; -1 refuses it
+	virtual int open(const char* host, uint16_t port, bool http) = 0;
+	virtual int available(int handle) = 0;
+	virtual int read(int handle, uint8_t* buf, size_t size) = 0;
+	// The peer has closed the connection (bytes may still be available)
+	virtual bool closed(int handle) = 0;
+	virtual void close(int handle) = 0;
+};
+
+class WiFiClient : public Stream {
+public:
+	WiFiClient();
+	~WiFiClient();
+	WiFiClient(const WiFiClient&) = delete;
+	WiFiClient& operator=(const WiFiClient&) = delete;
+
+	int connect(const char* host, uint16_t port);
+	int connect(const char* host, uint16_t port, int32_t timeoutMs);
+	size_t write(uint8_t c) override { return write(&c, 1); }
+	size_t write(const uint8_t* buf, size_t size) override;
+	using Print::write;
+	int available() override;
+	int read() override;
+	int read(uint8_t* buf, size_t size);
+	int peek() override;
+	void flush() override {}
+	void stop();
+	uint8_t connected();
+	operator bool() { return connected(); }
+	void setNoDelay(bool nodelay);
+
+private:
+	friend class HTTPClient;
+
+	bool fill(bool block);
+	int connectTo(const struct sockaddr* address, socklen_t length, int32_t timeoutMs);
+
+	int _fd;
+	int _handle;    // connection of the host network, if one is set
+	bool _http;     // owned by an HTTPClient
+	uint8_t _rx[1460];
+	size_t _rxHead;
+	size_t _rxTail;
+	bool _eof;
+};
+
+class WiFiClass {
+public:
+	wl_status_t status() const { return _status; }
+	bool mode(wifi_mode_t m) { _mode = m; return true; }
+	wl_status_t begin(const char* ssid, const char* passphrase = nullptr);
+	bool disconnect(bool wifioff = false, bool eraseap = false);
+	bool setAutoReconnect(bool autoReconnect) { (void)autoReconnect; return true; }
+	int8_t RSSI() const { return -50; }
+
+	// Host-only: simulate link loss and recovery
+	void hostSetStatus(wl_status_t status) { _status = status; }
+
+	// Host-only: send new connections to network instead of the sockets (nullptr for the sockets again)
+	void hostSetNetwork(HostNetwork* network) { _network = network; }
+	HostNetwork* hostNetwork() const { return _network; }
+
+private:
+	wl_status_t _status = WL_DISCONNECTED;
+	wifi_mode_t _mode = WIFI_OFF;
+	HostNetwork* _network = nullptr;
+};
+
+extern WiFiClass WiFi;
+
+#endif // WA_HOST_WIFI_H
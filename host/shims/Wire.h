@@ -0,0 +1,40 @@
+// Host shim for the Arduino Wire (I2C) library. Transfers are not sent
+// anywhere; the shim only counts the bytes and transactions so that bus
+// usage can be compared between library versions.
+#ifndef WA_HOST_WIRE_H
+#define WA_HOST_WIRE_H
+
+#include "Arduino.h"
+
+class TwoWire : public Print {
+public:
+	bool begin() { return true; }
+	bool begin(int sda, int scl, uint32_t frequency = 0) { (void)sda; (void)scl; (void)frequency; return true; }
+	void setClock(uint32_t frequency) { _clock = frequency; }
+	uint32_t getClock() const { return _clock; }
+	void beginTransmission(uint8_t address) { _address = address; _transmitting = true; }
+	uint8_t endTransmission(bool sendStop = true);
+	uint8_t requestFrom(uint8_t address, uint8_t quantity) { (void)address; (void)quantity; return 0; }
+	int available() { return 0; }
+	int read() { return -1; }
+	size_t write(uint8_t data) override;
+	size_t write(const uint8_t* data, size_t quantity) override;
+	using Print::write;
+
+	// Host-only accounting
+	uint32_t bytesWritten() const { return _bytesWritten; }
+	uint32_t transactions() const { return _transactions; }
+	uint8_t lastAddress() const { return _address; }
+	void resetCounters() { _bytesWritten = 0; _transactions = 0; }
+
+private:
+	uint32_t _clock = 100000;
+	uint8_t _address = 0;
+	bool _transmitting = false;
+	uint32_t _bytesWritten = 0;
+	uint32_t _transactions = 0;
+};
+
+extern TwoWire Wire;
+
+#endif // WA_HOST_WIRE_H
@@ -27,24 +27,26 @@
 #define TFT_WIDTH 240
 #define TFT_HEIGHT 320
 
-// Global display objects (will be initialized based on display type)
-Adafruit_SSD1306* oledDisplay = nullptr;
-
-// Only define tftDisplay for ESP32/ESP8266 platforms
-#if defined(ESP32) || defined(ESP8266)
-TFT_eSPI* tftDisplay = nullptr;
-#endif
-
 using namespace WeatherAnimationsLib;
 
 WeatherAnimations::WeatherAnimations(const char* ssid, const char* password, const char* haIP, const char* haToken)
     : _ssid(ssid), _password(password), _haIP(haIP), _haToken(haToken),
-      _displayType(OLED_SSD1306), _i2cAddr(0x3C), _mode(CONTINUOUS_WEATHER),
+      _displayType(OLED_SSD1306), _i2cAddr(0x3C), _mode(CONTINUOUS_WEATHER), _animationMode(ANIMATION_ONLINE),
+      _oledDisplay(nullptr), _spiConfig(oledSPIConfig(-1, -1)), _busScheduler(nullptr),
+      _oledRotation(OLED_ROTATE_0), _oledMirror(OLED_MIRROR_NONE), _tftDisplay(nullptr),
       _manageWiFi(true), _currentWeather(WEATHER_CLEAR), _weatherEntityID("weather.forecast"),
       _indoorTempEntity("sensor.t_h_sensor_temperature"), _outdoorTempEntity("sensor.sam_outside_temperature"),
       _indoorTemp(0), _outdoorTemp(0), _minForecastTemp(0), _maxForecastTemp(0), _hasTemperatureData(false),
-      _lastFetchTime(0), _fetchCooldown(300000), _isTransitioning(false),
-      _lastFrameTime(0), _currentFrame(0), _animationMode(ANIMATION_ONLINE), _displayInitFailed(false)
+      _lastFetchTime(0), _fetchCooldown(300000), _clock(systemClock()), _dataHub(nullptr), _tickMode(false),
+      _networkTask(-1), _downloadTask(-1), _renderTask(-1), _flushTask(-1), _nextPollTime(0),
+      _wifiConnectStart(0), _flushPending(false), _pendingIcon(nullptr), _pendingFrames(0),
+      _downloadCondition(0), _downloadFrame(0), _downloadData(nullptr), _downloadSize(0), _input(nullptr),
+      _inputHandler(nullptr), _inputContext(nullptr), _inputTask(-1), _pipelineRunning(false),
+      _stateDropped(false), _appliedStateVersion(0), _warmBoot(false),
+      _warmBootTime(0), _lastIsDaytime(true), _beginTime(0), _firstFrameTime(0),
+      _fullFidelityTime(0), _startupAssets(0), _hasLiveWeather(false), _isTransitioning(false),
+      _lastFrameTime(0), _currentFrame(0), _gifFramePool(GIF_FRAME_BYTES, GIF_POOL_FRAMES),
+      _displayInitFailed(false)
 {
     // Zero-initialize animation structure
     for (int i = 0; i < 5; i++) {
@@ -52,6 +54,9 @@ WeatherAnimations::WeatherAnimations(const char* ssid, const char* password, con
         _animations[i].frameCount = 0;
         _animations[i].frameDelay = 200;
         _onlineAnimationURLs[i] = nullptr;
+        _conditionURLs[i][0] = '\0';
+        _conditionIcons[i] = nullptr;
+        _downloadURLs[i][0] = '\0';
         _onlineAnimationCache[i].imageData = nullptr;
         _onlineAnimationCache[i].dataSize = 0;
         _onlineAnimationCache[i].isLoaded = false;
@@ -62,46 +67,108 @@ WeatherAnimations::WeatherAnimations(const char* ssid, const char* password, con
             _onlineAnimationCache[i].frameData[j] = nullptr;
         }
     }
+    _lastCondition[0] = '\0';
+    
     // Set default animations for OLED (monochrome)
-    setAnimation(WEATHER_CLEAR, clearSkyFrames, 2, 500);
-    setAnimation(WEATHER_CLOUDY, cloudySkyFrames, 2, 500);
-    setAnimation(WEATHER_RAIN, rainFrames, 3, 300);
-    setAnimation(WEATHER_SNOW, snowFrames, 3, 300);
-    setAnimation(WEATHER_STORM, stormFrames, 2, 200);
+    for (uint8_t i = 0; i < 5; i++) {
+        setAnimation(i, nullptr, _frameStore.frameCount(i), _frameStore.frameDelay(i));
+    }
+}
+
+void WeatherAnimations::setSPIConfig(int8_t dcPin, int8_t csPin, int8_t rstPin, uint32_t frequency, bool useDMA) {
+    _spiConfig = oledSPIConfig(dcPin, csPin, rstPin, frequency, useDMA);
+}
+
+void WeatherAnimations::setBusScheduler(OLEDBusScheduler* scheduler) {
+    _busScheduler = scheduler;
+}
+
+bool WeatherAnimations::setOrientation(uint8_t rotation, uint8_t mirror) {
+    // A quarter turn would leave a 64x128 canvas for the 128x64 layouts
+    if (rotation != OLED_ROTATE_0 && rotation != OLED_ROTATE_180) {
+        WA_LOG_WARN("OLED rotation %u would clip the landscape layouts, keeping the current orientation.",
+                    (unsigned)rotation);
+        return false;
+    }
+    _oledRotation = rotation;
+    _oledMirror = mirror;
+    return true;
+}
+
+float WeatherAnimations::getFrameRate() const {
+    return _busScheduler != nullptr ? _busScheduler->frameRate(&_oledPanel) : 0;
+}
+
+uint32_t WeatherAnimations::getBusBytes() const {
+    return _oledPanel.bytesSent();
+}
+
+uint32_t WeatherAnimations::getFlushCount() const {
+    return _oledPanel.flushCount();
+}
+
+void WeatherAnimations::setDataHub(WeatherDataHub* hub) {
+    _dataHub = hub;
+}
+
+void WeatherAnimations::setClock(Clock* clock) {
+    _clock = clock != nullptr ? clock : systemClock();
 }
 
 void WeatherAnimations::begin(uint8_t displayType, uint8_t i2cAddr, bool manageWiFi) {
     _displayType = displayType;
     _i2cAddr = i2cAddr;
     _manageWiFi = manageWiFi;
+    _beginTime = _clock->millis();
     
     // Initialize display based on type
     initDisplay();
     
-    // Connect to Wi-Fi only if we are managing it and not already connected
+    // The built-in animations are shared by all instances and only drawn once
+    generateFallbackAnimations();
+    
+    // Downloaded frames and icons go into fixed blocks reserved up front, so
+    // later downloads never search or fragment the heap
+    if (_animationMode == ANIMATION_ONLINE && !_frameStore.reserve()) {
+        WA_LOG_ERROR("Failed to reserve the frame pool");
+    }
+    if ((_displayType == TFT_DISPLAY || _animationMode == ANIMATION_ONLINE) && !_iconCache.reserve()) {
+        WA_LOG_ERROR("Failed to reserve the icon pool");
+    }
+    
+    // Show something before touching the network: the last scene after a
+    // reset or deep sleep, the generated one otherwise
+    if (!(_warmBoot && restoreWarmBoot())) {
+        displayAnimation();
+    }
+    _firstFrameTime = max(_clock->millis() - _beginTime, (uint32_t)1);
+    WA_LOG_INFO("First frame %lu ms after begin()", (unsigned long)_firstFrameTime);
+    
+    // Everything else happens in the background, from update() or tick():
+    // Wi-Fi connects on its own and the first poll runs as soon as it is up
     if (_manageWiFi && WiFi.status() != WL_CONNECTED) {
-        if (!connectToWiFi()) {
-            // Log error (for now, just a serial print)
-            WA_SERIAL_PRINTLN("Failed to connect to Wi-Fi");
-        }
+        WiFi.mode(WIFI_STA);
+        WiFi.begin(_ssid, _password);
+        _wifiConnectStart = _clock->millis() | 1;
     } else if (!_manageWiFi) {
-        WA_SERIAL_PRINTLN("Wi-Fi management disabled, assuming connection is handled externally.");
+        WA_LOG_INFO("Wi-Fi management disabled, assuming connection is handled externally.");
     }
+    _lastFetchTime = _clock->millis() - _fetchCooldown;
     
-    // If we're using online animations and we're connected to Wi-Fi, preload the icons
-    if (_animationMode == ANIMATION_ONLINE && WiFi.status() == WL_CONNECTED) {
-        WA_SERIAL_PRINTLN("Preloading weather icons...");
-        // Try to get animations from online resources first
-        if (!initializeAnimationsFromOnline(_displayType)) {
-            // If failed, generate fallback animations
-            WA_SERIAL_PRINTLN("Failed to load animations from online, using fallbacks");
-            generateFallbackAnimations();
-        } else {
-            WA_SERIAL_PRINTLN("Successfully loaded animations from online resources");
-        }
-    } else {
-        // If not using online animations or not connected, use fallbacks
-        generateFallbackAnimations();
+    // Online frames replace the generated ones one condition at a time as they
+    // arrive. OLED displays keep the generated frames.
+    if (_animationMode == ANIMATION_ONLINE && !isOLEDDisplay()) {
+        _pendingFrames |= (1 << ANIMATION_CONDITION_COUNT) - 1;
+        _startupAssets = (1 << ANIMATION_CONDITION_COUNT) - 1;
+    }
+    
+    if (_dataHub != nullptr && !_dataHub->addDisplay(this)) {
+        WA_LOG_WARN("Weather data hub is full, this display will poll on its own.");
+        _dataHub = nullptr;
+    }
+    if (recordActive()) {
+        recordBegin(_displayType, _mode, _animationMode, _dataHub != nullptr,
+                    _dataHub != nullptr ? _dataHub->fetchInterval() : _fetchCooldown);
     }
 }
 
@@ -120,31 +187,516 @@ void WeatherAnimations::setAnimationMode(uint8_t animationMode) {
 }
 
 void WeatherAnimations::update() {
-    WA_SERIAL_PRINTLN("Update loop running.");
-    // Fetch new weather data if connected and cooldown period has passed
-    if (WiFi.status() == WL_CONNECTED) {
-        unsigned long currentTime = millis();
+    WA_LOG_VERBOSE("Update loop running.");
+    if (_input != nullptr) {
+        inputStep(_clock->millis());
+    }
+    if (_dataHub != nullptr) {
+        // The hub polls for every display and calls applyWeatherSnapshot() with the result
+        _dataHub->update();
+    } else if (WiFi.status() == WL_CONNECTED) {
+        // Fetch new weather data if connected and cooldown period has passed
+        uint32_t currentTime = _clock->millis();
         if (currentTime - _lastFetchTime >= _fetchCooldown) {
-            WA_SERIAL_PRINTLN("Attempting to fetch weather data...");
+            WA_LOG_DEBUG("Attempting to fetch weather data...");
             bool weatherSuccess = fetchWeatherData();
             bool tempSuccess = fetchTemperatureData();
             
             if (weatherSuccess || tempSuccess) {
                 _lastFetchTime = currentTime;
-                WA_SERIAL_PRINTLN("Weather and/or temperature data fetched successfully.");
+                saveWarmBoot();
+                WA_LOG_DEBUG("Weather and/or temperature data fetched successfully.");
             } else {
-                WA_SERIAL_PRINTLN("Failed to fetch weather and temperature data.");
+                WA_LOG_WARN("Failed to fetch weather and temperature data.");
             }
+        } else if (_pendingFrames != 0) {
+            // Queued animations load one condition per call
+            uint8_t condition = 0;
+            while (!(_pendingFrames & (1 << condition))) {
+                condition++;
+            }
+            _pendingFrames &= ~(1 << condition);
+            if (!_frameStore.fetch(condition, downloadURL(condition))) {
+                WA_LOG_WARN("Some frames failed to load, continuing with available frames");
+            }
+            startupAssetDone(condition);
         } else {
-            WA_SERIAL_PRINTLN("Waiting for cooldown period to fetch new data.");
+            WA_LOG_VERBOSE("Waiting for cooldown period to fetch new data.");
         }
     } else {
-        WA_SERIAL_PRINTLN("WiFi not connected, skipping weather data fetch.");
+        WA_LOG_VERBOSE("WiFi not connected, skipping weather data fetch.");
     }
     
     // Display animation based on current weather and mode
-    WA_SERIAL_PRINTLN("Updating display with current weather animation.");
+    WA_LOG_VERBOSE("Updating display with current weather animation.");
     displayAnimation();
+#if WA_LOG_LEVEL > WA_LOG_LEVEL_NONE
+    logTask(nullptr, _clock->millis());
+#endif
+}
+
+uint32_t WeatherAnimations::tick(uint32_t now) {
+    if (_pipelineRunning) {
+        return now + TICK_MAX_SLEEP;
+    }
+    if (!_tickMode) {
+        startTasks(now);
+    }
+    return _scheduler.tick(now);
+}
+
+void WeatherAnimations::setTickBudget(uint32_t budgetMicros) {
+    _scheduler.setBudget(budgetMicros);
+}
+
+uint32_t WeatherAnimations::fastForward(VirtualClock* clock, uint32_t duration) {
+    uint32_t end = clock->millis() + duration;
+    uint32_t ticks = 0;
+    while ((int32_t)(clock->millis() - end) < 0) {
+        uint32_t now = clock->millis();
+        uint32_t next = tick(now);
+        ticks++;
+        // Work that is due now (a poll waiting for the network) runs again
+        // without moving the clock
+        if ((int32_t)(next - now) > 0) {
+            clock->set((int32_t)(next - end) < 0 ? next : end);
+        }
+    }
+    return ticks;
+}
+
+const SlabPool& WeatherAnimations::framePool() const {
+    return _frameStore.pool();
+}
+
+const SlabPool& WeatherAnimations::iconPool() const {
+    return _iconCache.pool();
+}
+
+const TickScheduler& WeatherAnimations::scheduler() const {
+    return _scheduler;
+}
+
+// Helper function to register the tick() tasks on the first call
+void WeatherAnimations::startTasks(uint32_t now) {
+    _tickMode = true;
+    _nextPollTime = now;
+    _networkTask = _scheduler.addTask("network", networkTask, this);
+    _downloadTask = _scheduler.addTask("download", downloadTask, this);
+    _renderTask = _scheduler.addTask("render", renderTask, this);
+    _flushTask = _scheduler.addTask("flush", flushTask, this);
+#if WA_LOG_LEVEL > WA_LOG_LEVEL_NONE
+    _scheduler.addTask("log", logTask, nullptr, LOG_DRAIN_INTERVAL);
+#endif
+    addInputTask();
+}
+
+void WeatherAnimations::setInput(InputManager* input, InputHandler handler, void* context) {
+    _input = input;
+    _inputHandler = handler;
+    _inputContext = context;
+}
+
+void WeatherAnimations::requestRedraw() {
+    // May be called from another task while the pipeline runs
+    _scheduler.wakeFromISR(_renderTask);
+}
+
+// Helper function to run the input task on the render side and let interrupts wake it
+void WeatherAnimations::addInputTask() {
+    if (_input == nullptr) {
+        return;
+    }
+    _inputTask = _scheduler.addTask("input", inputTask, this);
+    _input->attach(&_scheduler, _inputTask, _clock);
+}
+
+uint32_t WeatherAnimations::inputTask(void* context, uint32_t now) {
+    return static_cast<WeatherAnimations*>(context)->inputStep(now);
+}
+
+// Input task: hands debounced events to the sketch and redraws after them
+uint32_t WeatherAnimations::inputStep(uint32_t now) {
+    InputEvent event;
+    bool handled = false;
+    while (_input->poll(&event, now)) {
+        if (recordActive()) {
+            recordInput(event, now);
+        }
+        if (_inputHandler != nullptr) {
+            _inputHandler(event, _inputContext);
+        }
+        handled = true;
+    }
+    if (handled && _tickMode) {
+        _scheduler.wake(_renderTask);
+    }
+    return _input->nextCheck(now);
+}
+
+uint32_t WeatherAnimations::networkTask(void* context, uint32_t now) {
+    return static_cast<WeatherAnimations*>(context)->networkStep(now);
+}
+
+uint32_t WeatherAnimations::downloadTask(void* context, uint32_t /*now*/) {
+    return static_cast<WeatherAnimations*>(context)->downloadStep();
+}
+
+uint32_t WeatherAnimations::renderTask(void* context, uint32_t now) {
+    return static_cast<WeatherAnimations*>(context)->renderStep(now);
+}
+
+uint32_t WeatherAnimations::flushTask(void* context, uint32_t /*now*/) {
+    return static_cast<WeatherAnimations*>(context)->flushStep();
+}
+
+// Log task: formats a few waiting log records and writes them out
+uint32_t WeatherAnimations::logTask(void* /*context*/, uint32_t /*now*/) {
+    Print* out = logOutput();
+    if (out != nullptr) {
+        logDrain(*out, LOG_DRAIN_BATCH);
+    }
+    return LOG_DRAIN_INTERVAL;
+}
+
+// Network task: one step of the Home Assistant poll (or of the shared hub's poll)
+uint32_t WeatherAnimations::networkStep(uint32_t now) {
+    if (_dataHub != nullptr) {
+        return _dataHub->tick(now);
+    }
+
+    if (!_poller.busy()) {
+        if ((int32_t)(now - _nextPollTime) < 0) {
+            return _nextPollTime - now;
+        }
+        if (WiFi.status() != WL_CONNECTED) {
+            return wifiStep(now);
+        }
+        if (_wifiConnectStart != 0) {
+            // Started in begin() or wifiStep(), possibly on another task
+            perfRecordMicros(PERF_WIFI, (now - _wifiConnectStart) * 1000);
+            _wifiConnectStart = 0;
+        }
+
+        // Sensors that are not read again keep their last published values
+        WeatherSnapshot previous;
+        if (!_publishedState.read(&previous)) {
+            clearWeatherSnapshot(&previous);
+        }
+        _poller.start(_haIP, _haToken, _weatherEntityID, _indoorTempEntity, _outdoorTempEntity, previous);
+    }
+
+    uint8_t result = _poller.step(now);
+    if (result == HA_POLL_BUSY) {
+        return 0;
+    }
+
+    if (result == HA_POLL_DONE) {
+        WA_LOG_DEBUG("Weather and/or temperature data fetched successfully.");
+        applyWeatherSnapshot(_poller.result());
+        _lastFetchTime = now;
+        _nextPollTime = now + _fetchCooldown;
+    } else {
+        WA_LOG_WARN("Failed to fetch weather and temperature data.");
+        _nextPollTime = now + WEATHER_HUB_RETRY_INTERVAL;
+    }
+    return _nextPollTime - now;
+}
+
+// Helper function to bring Wi-Fi up without waiting for it
+uint32_t WeatherAnimations::wifiStep(uint32_t now) {
+    if (!_manageWiFi) {
+        return 1000;
+    }
+    if (_wifiConnectStart == 0) {
+        WiFi.mode(WIFI_STA);
+        WiFi.begin(_ssid, _password);
+        _wifiConnectStart = now | 1;
+        return 500;
+    }
+    // Same 10 second limit as connectToWiFi()
+    if (now - _wifiConnectStart > 10000) {
+        WA_LOG_WARN("Failed to connect to Wi-Fi");
+        perfRecordMicros(PERF_WIFI, (now - _wifiConnectStart) * 1000);
+        _wifiConnectStart = 0;
+        _nextPollTime = now + WEATHER_HUB_RETRY_INTERVAL;
+        return WEATHER_HUB_RETRY_INTERVAL;
+    }
+    return 500;
+}
+
+// Download task: fetches the queued icon, then refreshes queued animations
+// one frame per step, alternating downloads with PNG decodes
+uint32_t WeatherAnimations::downloadStep() {
+    if (_downloadData != nullptr) {
+        _frameStore.decodeFrame(_downloadFrame, _downloadData, _downloadSize);
+        delete[] _downloadData;
+        _downloadData = nullptr;
+        _downloadFrame++;
+        finishFrameDownload();
+        return 0;
+    }
+
+    if (_pendingIcon != nullptr) {
+        _iconCache.load(_pendingIcon);
+        _pendingIcon = nullptr;
+        return 0;
+    }
+
+    if (!_frameStore.updating()) {
+        if (_pendingFrames == 0) {
+            return TICK_IDLE;
+        }
+        if (WiFi.status() != WL_CONNECTED) {
+            return 1000;
+        }
+        uint8_t condition = 0;
+        while (!(_pendingFrames & (1 << condition))) {
+            condition++;
+        }
+        _pendingFrames &= ~(1 << condition);
+        if (downloadURL(condition) != nullptr && _frameStore.beginUpdate(condition)) {
+            WA_LOG_DEBUG("Fetching the frames of weather condition %u", (unsigned)condition);
+            _downloadCondition = condition;
+            _downloadFrame = 0;
+        } else {
+            startupAssetDone(condition);
+        }
+        return 0;
+    }
+
+    if (!fetchAnimationFrame(downloadURL(_downloadCondition), _downloadFrame,
+                             &_downloadData, &_downloadSize)) {
+        _downloadFrame++;
+        finishFrameDownload();
+    }
+    return 0;
+}
+
+// Helper function to swap in a refreshed animation once its last frame is done
+void WeatherAnimations::finishFrameDownload() {
+    if (_downloadFrame < _frameStore.frameCount(_downloadCondition)) {
+        return;
+    }
+    // Publishes the new version in one swap; the renderer picks it up on its next frame
+    bool loaded = _frameStore.finishUpdate();
+    startupAssetDone(_downloadCondition);
+    if (!loaded) {
+        WA_LOG_WARN("No new frames loaded, keeping the current ones");
+        return;
+    }
+    
+    if (_pipelineRunning) {
+        // Only a wakeup: the render half reads the frames from _frameStore itself
+        PipelineMessage message;
+        memset(&message, 0, sizeof(message));
+        message.type = PIPELINE_FRAMES_READY;
+        message.weatherCondition = _downloadCondition;
+        _pipelineEvents.push(message);
+    } else if (_downloadCondition == _currentWeather) {
+        _scheduler.wake(_renderTask);
+    }
+}
+
+// Helper function for the URL the download task fetches a condition's frames from
+const char* WeatherAnimations::downloadURL(uint8_t weatherCondition) const {
+    if (_pipelineRunning) {
+        return _downloadURLs[weatherCondition][0] != '\0' ? _downloadURLs[weatherCondition] : nullptr;
+    }
+    // Startup downloads use the default frames unless a source was set
+    return _onlineAnimationURLs[weatherCondition] != nullptr ? _onlineAnimationURLs[weatherCondition]
+                                                             : defaultAnimationURL(weatherCondition);
+}
+
+bool WeatherAnimations::startPipeline() {
+#if WA_PIPELINE_THREADS
+    if (_pipelineRunning) {
+        return true;
+    }
+    if (_dataHub != nullptr) {
+        WA_LOG_ERROR("The pipeline polls Home Assistant itself and cannot share a data hub.");
+        return false;
+    }
+    if (_tickMode && _networkScheduler.taskCount() == 0) {
+        WA_LOG_ERROR("startPipeline() cannot be used after tick().");
+        return false;
+    }
+    
+    // The network half polls, downloads and decodes; the render half draws and flushes
+    if (_networkScheduler.taskCount() == 0) {
+        _tickMode = true;
+        _nextPollTime = _clock->millis();
+        _networkTask = _networkScheduler.addTask("network", networkTask, this);
+        _downloadTask = _networkScheduler.addTask("download", downloadTask, this);
+        _renderTask = _scheduler.addTask("render", renderTask, this);
+        _flushTask = _scheduler.addTask("flush", flushTask, this);
+#if WA_LOG_LEVEL > WA_LOG_LEVEL_NONE
+        // Serial writes can block, so the network half drains the log
+        _networkScheduler.addTask("log", logTask, nullptr, LOG_DRAIN_INTERVAL);
+#endif
+        addInputTask();
+    }
+    
+    // Downloads still queued by begin() need network-side copies of their URLs
+    for (uint8_t i = 0; i < 5; i++) {
+        if ((_pendingFrames & (1 << i)) && _downloadURLs[i][0] == '\0') {
+            strncpy(_downloadURLs[i], downloadURL(i), ONLINE_ANIMATION_URL_LENGTH - 1);
+            _downloadURLs[i][ONLINE_ANIMATION_URL_LENGTH - 1] = '\0';
+        }
+    }
+    
+    _pipelineRunning = true;
+    if (!_networkWorker.start("wa_network", networkWorker, this, PIPELINE_NETWORK_CORE) ||
+        !_renderWorker.start("wa_render", renderWorker, this, PIPELINE_RENDER_CORE)) {
+        WA_LOG_ERROR("Failed to start the pipeline tasks.");
+        stopPipeline();
+        return false;
+    }
+    return true;
+#else
+    WA_LOG_ERROR("The pipeline needs a second core (ESP32).");
+    return false;
+#endif
+}
+
+void WeatherAnimations::stopPipeline() {
+    _pipelineRunning = false;
+    _networkWorker.join();
+    _renderWorker.join();
+    
+    // Both halves have stopped: pick up what was still queued
+    receivePipelineEvents();
+    PipelineMessage message;
+    while (_pipelineRequests.pop(&message)) {
+    }
+}
+
+bool WeatherAnimations::pipelineRunning() const {
+    return _pipelineRunning;
+}
+
+bool WeatherAnimations::readWeatherState(WeatherSnapshot* snapshot) const {
+    return _publishedState.read(snapshot);
+}
+
+// Helper function to sleep a pipeline worker until its next wakeup
+static void sleepUntil(Clock* clock, uint32_t wakeup) {
+    int32_t wait = (int32_t)(wakeup - clock->millis());
+    if (wait > PIPELINE_MAX_SLEEP) {
+        wait = PIPELINE_MAX_SLEEP;
+    }
+    pipelineSleep(wait > 0 ? wait : 1);
+}
+
+// Network half of the pipeline (core 0 on ESP32)
+void WeatherAnimations::networkWorker(void* context) {
+    WeatherAnimations* self = static_cast<WeatherAnimations*>(context);
+    while (self->_pipelineRunning) {
+        self->receivePipelineRequests();
+        sleepUntil(self->_clock, self->_networkScheduler.tick(self->_clock->millis()));
+    }
+}
+
+// Render half of the pipeline (core 1 on ESP32)
+void WeatherAnimations::renderWorker(void* context) {
+    WeatherAnimations* self = static_cast<WeatherAnimations*>(context);
+    while (self->_pipelineRunning) {
+        self->receivePipelineEvents();
+        sleepUntil(self->_clock, self->_scheduler.tick(self->_clock->millis()));
+    }
+}
+
+// Helper function to queue the render half's download requests on the network half
+void WeatherAnimations::receivePipelineRequests() {
+    PipelineMessage message;
+    while (_pipelineRequests.pop(&message)) {
+        if (message.type == PIPELINE_FETCH_FRAMES && message.weatherCondition < 5) {
+            snprintf(_downloadURLs[message.weatherCondition], ONLINE_ANIMATION_URL_LENGTH, "%s", message.url);
+            _pendingFrames |= 1 << message.weatherCondition;
+        } else if (message.type == PIPELINE_FETCH_ICON) {
+            _pendingIcon = message.icon;
+        }
+        _networkScheduler.wake(_downloadTask);
+    }
+}
+
+// Helper function to apply the network half's results on the render half
+void WeatherAnimations::receivePipelineEvents() {
+    PipelineMessage message;
+    while (_pipelineEvents.pop(&message)) {
+        if (message.type == PIPELINE_WEATHER_STATE) {
+            // Older than a state already taken from _publishedState
+            if (message.snapshot.sequence <= _appliedStateVersion) {
+                continue;
+            }
+            _appliedStateVersion = message.snapshot.sequence;
+            showWeatherSnapshot(message.snapshot);
+        } else if (message.type == PIPELINE_FRAMES_READY) {
+            if (message.weatherCondition == _currentWeather) {
+                _scheduler.wake(_renderTask);
+            }
+        }
+    }
+    
+    // A state that did not fit in the queue is still in _publishedState
+    if (_stateDropped.exchange(false)) {
+        WeatherSnapshot snapshot;
+        if (_publishedState.read(&snapshot) && snapshot.sequence > _appliedStateVersion) {
+            _appliedStateVersion = snapshot.sequence;
+            showWeatherSnapshot(snapshot);
+        }
+    }
+}
+
+// Render task: draws the current frame and returns the time until the next one
+uint32_t WeatherAnimations::renderStep(uint32_t now) {
+    // Let the previous frame reach the panel before drawing over it. A frame
+    // drawn outside this task (runTransition()) has not woken the flush task yet.
+    if (isOLEDDisplay() && (_flushPending || _oledPanel.flushInProgress())) {
+        if (_flushPending) {
+            _scheduler.wake(_flushTask);
+        }
+        return 1;
+    }
+
+    displayAnimation();
+    if (_flushPending) {
+        _scheduler.wake(_flushTask);
+    }
+
+    if (_isTransitioning) {
+        return 16;
+    }
+    if (_animationMode == ANIMATION_STATIC) {
+        return TICK_IDLE;
+    }
+    if (_displayType == TFT_DISPLAY) {
+        const OnlineAnimation& cache = _onlineAnimationCache[_currentWeather];
+        return (cache.isLoaded && cache.isAnimated) ? cache.frameDelay : TICK_IDLE;
+    }
+    uint16_t frameDelay = _animations[_currentWeather].frameDelay;
+    if (_animations[_currentWeather].frameCount == 0 || frameDelay == 0) {
+        return TICK_IDLE;
+    }
+    // Wake on the next frame boundary
+    return frameDelay - (now % frameDelay);
+}
+
+// Flush task: sends one dirty region of the OLED per step
+uint32_t WeatherAnimations::flushStep() {
+    if (_flushPending) {
+        _flushPending = false;
+        if (_busScheduler != nullptr) {
+            _busScheduler->requestFlush(&_oledPanel);
+            return TICK_IDLE;
+        }
+        if (!_oledPanel.beginFlush()) {
+            return TICK_IDLE;
+        }
+        return 0;
+    }
+    _oledPanel.flushStep();
+    return _oledPanel.flushInProgress() ? 0 : TICK_IDLE;
 }
 
 uint8_t WeatherAnimations::getCurrentWeather() const {
@@ -167,12 +719,7 @@ void WeatherAnimations::setOnlineAnimationSource(uint8_t weatherCondition, const
     if (weatherCondition < 5) {
         _onlineAnimationURLs[weatherCondition] = url;
         // Reset cache status for this condition
-        if (_onlineAnimationCache[weatherCondition].imageData != nullptr) {
-            free(_onlineAnimationCache[weatherCondition].imageData);
-            _onlineAnimationCache[weatherCondition].imageData = nullptr;
-        }
-        _onlineAnimationCache[weatherCondition].dataSize = 0;
-        _onlineAnimationCache[weatherCondition].isLoaded = false;
+        releaseOnlineAnimation(weatherCondition);
     }
 }
 
@@ -180,13 +727,14 @@ bool WeatherAnimations::connectToWiFi() {
     if (!_manageWiFi) {
         return WiFi.status() == WL_CONNECTED;
     }
+    WA_PERF_SCOPE(PERF_WIFI);
     WiFi.mode(WIFI_STA);
     WiFi.disconnect();
     WiFi.begin(_ssid, _password);
     int attempts = 0;
     while (WiFi.status() != WL_CONNECTED && attempts < 10) {
-        delay(1000);
-        WA_SERIAL_PRINT(".");
+        _clock->delay(1000);
+        WA_LOG_DEBUG("Waiting for Wi-Fi");
         attempts++;
     }
     return WiFi.status() == WL_CONNECTED;
@@ -198,157 +746,22 @@ bool WeatherAnimations::fetchWeatherData() {
             connectToWiFi();
         }
         if (WiFi.status() != WL_CONNECTED) {
-            WA_SERIAL_PRINTLN("No Wi-Fi connection available.");
+            WA_LOG_WARN("No Wi-Fi connection available.");
             return false;
         }
     }
     
-    HTTPClient http;
-    String url = String("http://") + _haIP + ":8123/api/states/" + _weatherEntityID;
-    http.begin(url);
-    http.addHeader("Authorization", String("Bearer ") + _haToken);
-    int httpCode = http.GET();
-    
-    if (httpCode == 200) {
-        String payload = http.getString();
-        WA_SERIAL_PRINTLN("Home Assistant Response:");
-        WA_SERIAL_PRINTLN(payload);
-        
-        // Parse JSON (extended parsing)
-        String condition = "";
-        bool isDaytime = true;
-        
-        // Extract min/max forecast temperatures
-        int forecastTempMinIdx = payload.indexOf("\"forecast_temp_min\":");
-        if (forecastTempMinIdx > 0) {
-            forecastTempMinIdx += 19; // Length of the search string
-            int endIdx = payload.indexOf(",", forecastTempMinIdx);
-            if (endIdx < 0) endIdx = payload.indexOf("}", forecastTempMinIdx);
-            if (endIdx > forecastTempMinIdx) {
-                String minTempStr = payload.substring(forecastTempMinIdx, endIdx);
-                _minForecastTemp = minTempStr.toFloat();
-                WA_SERIAL_PRINT("Min forecast temp: ");
-                WA_SERIAL_PRINTLN(_minForecastTemp);
-            }
-        }
-        
-        int forecastTempMaxIdx = payload.indexOf("\"forecast_temp_max\":");
-        if (forecastTempMaxIdx > 0) {
-            forecastTempMaxIdx += 19; // Length of the search string
-            int endIdx = payload.indexOf(",", forecastTempMaxIdx);
-            if (endIdx < 0) endIdx = payload.indexOf("}", forecastTempMaxIdx);
-            if (endIdx > forecastTempMaxIdx) {
-                String maxTempStr = payload.substring(forecastTempMaxIdx, endIdx);
-                _maxForecastTemp = maxTempStr.toFloat();
-                WA_SERIAL_PRINT("Max forecast temp: ");
-                WA_SERIAL_PRINTLN(_maxForecastTemp);
-            }
-        }
-        
-        // Extract condition from JSON (simplistic parsing)
-        int stateStart = payload.indexOf("\"state\":\"") + 9;
-        if (stateStart > 9) {
-            int stateEnd = payload.indexOf("\",", stateStart);
-            if (stateEnd > stateStart) {
-                condition = payload.substring(stateStart, stateEnd);
-            }
-        }
-        
-        // Check for daytime attribute (if available)
-        bool isDayFound = false;
-        int isDayStart = payload.indexOf("\"is_daytime\":") + 13;
-        if (isDayStart > 13) {
-            // Could be true or false
-            if (payload.substring(isDayStart, isDayStart + 4) == "true") {
-                isDaytime = true;
-                isDayFound = true;
-            } else if (payload.substring(isDayStart, isDayStart + 5) == "false") {
-                isDaytime = false;
-                isDayFound = true;
-            }
-        }
-        
-        // If no daytime attribute, guess based on time
-        if (!isDayFound) {
-            // Simple heuristic: 6 AM to 6 PM is daytime
-            time_t now;
-            time(&now);
-            struct tm *timeinfo = localtime(&now);
-            isDaytime = (timeinfo->tm_hour >= 6 && timeinfo->tm_hour < 18);
-        }
-        
-        // If condition is empty or invalid, try to detect from payload text
-        if (condition.length() == 0) {
-            if (payload.indexOf("clear") != -1 || payload.indexOf("sunny") != -1) {
-                condition = payload.indexOf("night") != -1 ? "clear-night" : "sunny";
-            } else if (payload.indexOf("cloud") != -1) {
-                condition = payload.indexOf("partly") != -1 ? "partlycloudy" : "cloudy";
-            } else if (payload.indexOf("fog") != -1) {
-                condition = "fog";
-            } else if (payload.indexOf("hail") != -1) {
-                condition = "hail";
-            } else if (payload.indexOf("lightning") != -1 || payload.indexOf("thunder") != -1) {
-                condition = payload.indexOf("rain") != -1 ? "lightning-rainy" : "lightning";
-            } else if (payload.indexOf("pouring") != -1) {
-                condition = "pouring";
-            } else if (payload.indexOf("rain") != -1 || payload.indexOf("drizzle") != -1) {
-                condition = "rainy";
-            } else if (payload.indexOf("snow") != -1) {
-                condition = payload.indexOf("rain") != -1 ? "snowy-rainy" : "snowy";
-            } else if (payload.indexOf("wind") != -1) {
-                condition = payload.indexOf("extreme") != -1 ? "windy-variant" : "windy";
-            } else {
-                condition = "cloudy"; // Default
-            }
-        }
-        
-        WA_SERIAL_PRINT("Detected weather condition: ");
-        WA_SERIAL_PRINTLN(condition);
-        
-        // Save the previous weather to check if it changed
-        uint8_t previousWeather = _currentWeather;
-        
-        // Set animation based on Home Assistant weather condition
-        if (setAnimationFromHACondition(condition.c_str(), isDaytime)) {
-            // If the weather changed and we're using online animations, refresh them
-            if (_animationMode == ANIMATION_ONLINE && previousWeather != _currentWeather) {
-                WA_SERIAL_PRINTLN("Weather changed, refreshing animations");
-                // Only reload the animation for the current weather to save bandwidth
-                // Use fetchAnimationFrames instead of fetchAnimationData
-                if (_onlineAnimationURLs[_currentWeather] != nullptr) {
-                    bool fetchSuccess = false;
-                    // Use the stored URL as a base URL for frame fetching
-                    switch(_currentWeather) {
-                        case WEATHER_CLEAR:
-                            fetchSuccess = fetchAnimationFrames(_onlineAnimationURLs[_currentWeather], (uint8_t**)clearSkyFrames, 2, 1024);
-                            break;
-                        case WEATHER_CLOUDY:
-                            fetchSuccess = fetchAnimationFrames(_onlineAnimationURLs[_currentWeather], (uint8_t**)cloudySkyFrames, 2, 1024);
-                            break;
-                        case WEATHER_RAIN:
-                            fetchSuccess = fetchAnimationFrames(_onlineAnimationURLs[_currentWeather], (uint8_t**)rainFrames, 3, 1024);
-                            break;
-                        case WEATHER_SNOW:
-                            fetchSuccess = fetchAnimationFrames(_onlineAnimationURLs[_currentWeather], (uint8_t**)snowFrames, 3, 1024);
-                            break;
-                        case WEATHER_STORM:
-                            fetchSuccess = fetchAnimationFrames(_onlineAnimationURLs[_currentWeather], (uint8_t**)stormFrames, 2, 1024);
-                            break;
-                    }
-                    
-                    if (!fetchSuccess) {
-                        WA_SERIAL_PRINTLN("Some frames failed to load, continuing with available frames");
-                    }
-                }
-            }
-            
-            http.end();
-            return true;
-        }
+    WeatherSnapshot snapshot;
+    clearWeatherSnapshot(&snapshot);
+    snapshot.minForecastTemp = _minForecastTemp;
+    snapshot.maxForecastTemp = _maxForecastTemp;
+    if (!fetchWeatherState(_haIP, _haToken, _weatherEntityID, &snapshot)) {
+        return false;
     }
     
-    http.end();
-    return false;
+    _minForecastTemp = snapshot.minForecastTemp;
+    _maxForecastTemp = snapshot.maxForecastTemp;
+    return applyWeatherCondition(snapshot);
 }
 
 bool WeatherAnimations::fetchTemperatureData() {
@@ -357,66 +770,13 @@ bool WeatherAnimations::fetchTemperatureData() {
             connectToWiFi();
         }
         if (WiFi.status() != WL_CONNECTED) {
-            WA_SERIAL_PRINTLN("No Wi-Fi connection available.");
+            WA_LOG_WARN("No Wi-Fi connection available.");
             return false;
         }
     }
     
-    // Fetch indoor temperature
-    bool indoorSuccess = false;
-    if (_indoorTempEntity != nullptr) {
-        HTTPClient httpIndoor;
-        String urlIndoor = String("http://") + _haIP + ":8123/api/states/" + _indoorTempEntity;
-        httpIndoor.begin(urlIndoor);
-        httpIndoor.addHeader("Authorization", String("Bearer ") + _haToken);
-        int httpCodeIndoor = httpIndoor.GET();
-        
-        if (httpCodeIndoor == 200) {
-            String payload = httpIndoor.getString();
-            WA_SERIAL_PRINTLN("Indoor Temperature Response:");
-            WA_SERIAL_PRINTLN(payload);
-            
-            _indoorTemp = extractTemperatureFromHA(payload);
-            if (_indoorTemp != -999.0f) {
-                indoorSuccess = true;
-                WA_SERIAL_PRINT("Indoor temperature: ");
-                WA_SERIAL_PRINTLN(_indoorTemp);
-            }
-        } else {
-            WA_SERIAL_PRINT("Failed to fetch indoor temperature, HTTP code: ");
-            WA_SERIAL_PRINTLN(httpCodeIndoor);
-        }
-        
-        httpIndoor.end();
-    }
-    
-    // Fetch outdoor temperature
-    bool outdoorSuccess = false;
-    if (_outdoorTempEntity != nullptr) {
-        HTTPClient httpOutdoor;
-        String urlOutdoor = String("http://") + _haIP + ":8123/api/states/" + _outdoorTempEntity;
-        httpOutdoor.begin(urlOutdoor);
-        httpOutdoor.addHeader("Authorization", String("Bearer ") + _haToken);
-        int httpCodeOutdoor = httpOutdoor.GET();
-        
-        if (httpCodeOutdoor == 200) {
-            String payload = httpOutdoor.getString();
-            WA_SERIAL_PRINTLN("Outdoor Temperature Response:");
-            WA_SERIAL_PRINTLN(payload);
-            
-            _outdoorTemp = extractTemperatureFromHA(payload);
-            if (_outdoorTemp != -999.0f) {
-                outdoorSuccess = true;
-                WA_SERIAL_PRINT("Outdoor temperature: ");
-                WA_SERIAL_PRINTLN(_outdoorTemp);
-            }
-        } else {
-            WA_SERIAL_PRINT("Failed to fetch outdoor temperature, HTTP code: ");
-            WA_SERIAL_PRINTLN(httpCodeOutdoor);
-        }
-        
-        httpOutdoor.end();
-    }
+    bool indoorSuccess = fetchTemperatureState(_haIP, _haToken, _indoorTempEntity, &_indoorTemp);
+    bool outdoorSuccess = fetchTemperatureState(_haIP, _haToken, _outdoorTempEntity, &_outdoorTemp);
     
     // Update temperature data flag
     _hasTemperatureData = indoorSuccess || outdoorSuccess;
@@ -424,32 +784,193 @@ bool WeatherAnimations::fetchTemperatureData() {
     return _hasTemperatureData;
 }
 
-float WeatherAnimations::extractTemperatureFromHA(const String& payload) {
-    // Extract state value from Home Assistant response
-    int stateStart = payload.indexOf("\"state\":\"") + 9;
-    if (stateStart > 9) {
-        int stateEnd = payload.indexOf("\",", stateStart);
-        if (stateEnd > stateStart) {
-            String tempStr = payload.substring(stateStart, stateEnd);
-            return tempStr.toFloat();
-        }
+void WeatherAnimations::applyWeatherSnapshot(const WeatherSnapshot& snapshot) {
+    if (!_pipelineRunning) {
+        _publishedState.write(snapshot);
+        showWeatherSnapshot(snapshot);
+        return;
     }
     
-    return -999.0f; // Error value
+    // On the network half: number the state and hand it to the render half
+    WeatherSnapshot published = snapshot;
+    published.sequence = _publishedState.version() + 1;
+    _publishedState.write(published);
+    
+    PipelineMessage message;
+    memset(&message, 0, sizeof(message));
+    message.type = PIPELINE_WEATHER_STATE;
+    message.snapshot = published;
+    if (!_pipelineEvents.push(message)) {
+        _stateDropped = true;
+    }
+}
+
+// Helper function to show a snapshot's weather and temperatures
+void WeatherAnimations::showWeatherSnapshot(const WeatherSnapshot& snapshot) {
+    _minForecastTemp = snapshot.minForecastTemp;
+    _maxForecastTemp = snapshot.maxForecastTemp;
+    if (snapshot.hasTemperatureData) {
+        _indoorTemp = snapshot.indoorTemp;
+        _outdoorTemp = snapshot.outdoorTemp;
+        _hasTemperatureData = true;
+    }
+    if (snapshot.hasCondition) {
+        applyWeatherCondition(snapshot);
+    }
+    saveWarmBoot();
+    if (_tickMode) {
+        _scheduler.wake(_renderTask);
+    }
+}
+
+void WeatherAnimations::setWarmBoot(bool enabled) {
+    _warmBoot = enabled;
+}
+
+uint32_t WeatherAnimations::getWarmBootTime() const {
+    return _warmBootTime;
+}
+
+uint32_t WeatherAnimations::getTimeToFirstFrame() const {
+    return _firstFrameTime;
+}
+
+uint32_t WeatherAnimations::getTimeToFullFidelity() const {
+    return _fullFidelityTime.load(std::memory_order_relaxed);
+}
+
+// Helper function to note that a startup download has finished, loaded or not
+void WeatherAnimations::startupAssetDone(uint8_t weatherCondition) {
+    _startupAssets.fetch_and(~(1 << weatherCondition));
+    checkFullFidelity();
+}
+
+// Helper function to record when live weather and every startup download are in
+void WeatherAnimations::checkFullFidelity() {
+    if (_startupAssets.load() != 0 || !_hasLiveWeather.load()) {
+        return;
+    }
+    // Called from both pipeline halves; only the first one records the time
+    uint32_t unset = 0;
+    uint32_t elapsed = max(_clock->millis() - _beginTime, (uint32_t)1);
+    if (_fullFidelityTime.compare_exchange_strong(unset, elapsed)) {
+        WA_LOG_INFO("Full fidelity %lu ms after begin()", (unsigned long)elapsed);
+    }
+}
+
+// Helper function to show the scene saved before the last reset or deep sleep
+bool WeatherAnimations::restoreWarmBoot() {
+    WarmBootState state;
+    if (!loadWarmBootState(&state) || state.weatherCondition >= 5) {
+        WA_LOG_INFO("Cold boot: no saved scene.");
+        return false;
+    }
+    
+    // Only local state: icons and online frames are loaded by the first poll
+    WeatherSnapshot snapshot;
+    clearWeatherSnapshot(&snapshot);
+    // The saved text survived a reset, so terminate it here rather than trust it
+    memcpy(snapshot.condition, state.condition, WEATHER_CONDITION_LENGTH - 1);
+    snapshot.condition[WEATHER_CONDITION_LENGTH - 1] = '\0';
+    snapshot.isDaytime = state.isDaytime;
+    snapshot.hasCondition = true;
+    snapshot.minForecastTemp = state.minForecastTemp;
+    snapshot.maxForecastTemp = state.maxForecastTemp;
+    snapshot.indoorTemp = state.indoorTemp;
+    snapshot.outdoorTemp = state.outdoorTemp;
+    snapshot.hasTemperatureData = state.hasTemperatureData;
+    _publishedState.write(snapshot);
+    
+    memcpy(_lastCondition, snapshot.condition, WEATHER_CONDITION_LENGTH);
+    _lastIsDaytime = state.isDaytime;
+    _currentWeather = state.weatherCondition;
+    _minForecastTemp = state.minForecastTemp;
+    _maxForecastTemp = state.maxForecastTemp;
+    _indoorTemp = state.indoorTemp;
+    _outdoorTemp = state.outdoorTemp;
+    _hasTemperatureData = state.hasTemperatureData;
+    
+    displayAnimation();
+    _warmBootTime = max(_clock->millis(), (uint32_t)1);
+    WA_LOG_INFO("Warm boot: last scene shown %lu ms after reset", (unsigned long)_warmBootTime);
+    return true;
+}
+
+// Helper function to keep the scene on screen for the next warm boot
+void WeatherAnimations::saveWarmBoot() {
+    if (!_warmBoot || _lastCondition[0] == '\0') {
+        return;
+    }
+    WarmBootState state;
+    memset(&state, 0, sizeof(state));
+    state.weatherCondition = _currentWeather;
+    state.isDaytime = _lastIsDaytime;
+    snprintf(state.condition, sizeof(state.condition), "%s", _lastCondition);
+    state.minForecastTemp = _minForecastTemp;
+    state.maxForecastTemp = _maxForecastTemp;
+    state.indoorTemp = _indoorTemp;
+    state.outdoorTemp = _outdoorTemp;
+    state.hasTemperatureData = _hasTemperatureData;
+    saveWarmBootState(&state);
+}
+
+// Helper function to switch to the animation for a Home Assistant condition
+bool WeatherAnimations::applyWeatherCondition(const WeatherSnapshot& snapshot) {
+    // Save the previous weather to check if it changed
+    uint8_t previousWeather = _currentWeather;
+    
+    // Set animation based on Home Assistant weather condition
+    if (!setAnimationFromHACondition(snapshot.condition, snapshot.isDaytime)) {
+        return false;
+    }
+    strncpy(_lastCondition, snapshot.condition, WEATHER_CONDITION_LENGTH - 1);
+    _lastCondition[WEATHER_CONDITION_LENGTH - 1] = '\0';
+    _lastIsDaytime = snapshot.isDaytime;
+    _hasLiveWeather = true;
+    checkFullFidelity();
+    if (previousWeather != _currentWeather) {
+        WA_LOG_INFO("Weather condition %u, daytime %d", _currentWeather, _lastIsDaytime);
+    }
+    
+    // If the weather changed and we're using online animations, refresh them
+    if (_animationMode == ANIMATION_ONLINE && previousWeather != _currentWeather &&
+        _onlineAnimationURLs[_currentWeather] != nullptr) {
+        WA_LOG_INFO("Weather changed, refreshing animations");
+        // Only reload the animation for the current weather to save bandwidth
+        if (_pipelineRunning) {
+            // Downloaded and decoded by the network half
+            PipelineMessage message;
+            memset(&message, 0, sizeof(message));
+            message.type = PIPELINE_FETCH_FRAMES;
+            message.weatherCondition = _currentWeather;
+            strncpy(message.url, _onlineAnimationURLs[_currentWeather], ONLINE_ANIMATION_URL_LENGTH - 1);
+            if (!_pipelineRequests.push(message)) {
+                WA_LOG_WARN("Pipeline queue full, keeping the current frames");
+            }
+        } else if (_tickMode) {
+            // Downloaded a frame at a time by the download task
+            _pendingFrames |= 1 << _currentWeather;
+            _scheduler.wake(_downloadTask);
+        } else if (!_frameStore.fetch(_currentWeather, _onlineAnimationURLs[_currentWeather])) {
+            WA_LOG_WARN("Some frames failed to load, continuing with available frames");
+        }
+    }
+    return true;
 }
 
 void WeatherAnimations::displayAnimation() {
-    WA_SERIAL_PRINTLN("Entering displayAnimation method.");
+    WA_PERF_SCOPE_ARG(PERF_RENDER, "condition", _currentWeather);
+    // Between frames: replaced frame versions can be freed now
+    _frameStore.quiescent();
+    WA_LOG_VERBOSE("Entering displayAnimation method.");
     // If currently in transition mode, handle that instead of normal display
     if (_isTransitioning) {
-        WA_SERIAL_PRINTLN("Handling transition animation.");
-        unsigned long currentMillis = millis();
-        unsigned long elapsedTime = currentMillis - _transitionStartTime;
+        WA_LOG_VERBOSE("Handling transition animation.");
+        uint32_t elapsedTime = _clock->millis() - _transitionStartTime;
         
         // Calculate progress (0.0 to 1.0)
         float progress = min(1.0f, (float)elapsedTime / _transitionDuration);
-        WA_SERIAL_PRINT("Transition progress: ");
-        WA_SERIAL_PRINTLN(progress);
+        WA_LOG_VERBOSE("Transition progress: %.2f", progress);
         
         // Display the transition frame
         displayTransitionFrame(_currentWeather, progress);
@@ -457,30 +978,25 @@ void WeatherAnimations::displayAnimation() {
         // End transition when complete
         if (progress >= 1.0f) {
             _isTransitioning = false;
-            WA_SERIAL_PRINTLN("Transition completed.");
+            WA_LOG_DEBUG("Transition completed.");
         }
         
         return;
     }
     
-    WA_SERIAL_PRINTLN("Handling regular animation display.");
+    WA_LOG_VERBOSE("Handling regular animation display.");
     // Regular animation display based on animation mode
-    if (_displayType == OLED_SSD1306 || _displayType == OLED_SH1106) {
-        if (oledDisplay == nullptr) {
-            WA_SERIAL_PRINTLN("OLED display not initialized, cannot draw animation.");
+    if (isOLEDDisplay()) {
+        if (_oledDisplay == nullptr) {
+            WA_LOG_ERROR("OLED display not initialized, cannot draw animation.");
             return;
         }
         
-        oledDisplay->clearDisplay();
+        _oledDisplay->clearDisplay();
         
         // Draw header with weather type name
-        oledDisplay->setTextSize(1);
-        oledDisplay->setTextColor(SSD1306_WHITE);
-        oledDisplay->setCursor(0, 0);
-        oledDisplay->println("Weather:");
-        oledDisplay->setTextSize(2);
-        oledDisplay->setCursor(0, 12);
-        oledDisplay->println(getWeatherText(_currentWeather));
+        _textCache.draw(_oledDisplay, 0, 0, "Weather:", 1);
+        _textCache.draw(_oledDisplay, 0, 12, getWeatherText(_currentWeather), 2);
         
         if (_animationMode == ANIMATION_STATIC) {
             // Draw static weather icon using BasicUsage style
@@ -489,7 +1005,7 @@ void WeatherAnimations::displayAnimation() {
             // Check if we have animation frames
             if (_animations[_currentWeather].frameCount > 0) {
                 // Get current frame based on timing
-                uint8_t frameIndex = (millis() / _animations[_currentWeather].frameDelay) % _animations[_currentWeather].frameCount;
+                uint8_t frameIndex = (_clock->millis() / _animations[_currentWeather].frameDelay) % _animations[_currentWeather].frameCount;
                 
                 // Draw animated weather icon using BasicUsage style
                 drawAnimatedWeatherIcon(_currentWeather, frameIndex);
@@ -501,36 +1017,24 @@ void WeatherAnimations::displayAnimation() {
         
         // Add temperature data at the bottom if available
         if (_hasTemperatureData) {
-            oledDisplay->setTextSize(1);
-            oledDisplay->setCursor(0, 45);
-            
             // Show indoor and outdoor temps
-            oledDisplay->print("In:");
-            oledDisplay->print(_indoorTemp, 1);
-            oledDisplay->print("C  Out:");
-            oledDisplay->print(_outdoorTemp, 1);
-            oledDisplay->print("C");
+            drawOLEDTemperatureLine(45, "In:", _indoorTemp, "  Out:", _outdoorTemp);
             
             // Show forecast min/max on last line
-            oledDisplay->setCursor(0, 56);
-            oledDisplay->print("Min:");
-            oledDisplay->print(_minForecastTemp, 1);
-            oledDisplay->print("C Max:");
-            oledDisplay->print(_maxForecastTemp, 1);
-            oledDisplay->print("C");
+            drawOLEDTemperatureLine(56, "Min:", _minForecastTemp, " Max:", _maxForecastTemp);
         }
         
-        oledDisplay->display();
-        WA_SERIAL_PRINTLN("Updated OLED display with BasicUsage style.");
+        flushOLED();
+        WA_LOG_VERBOSE("Updated OLED display with BasicUsage style.");
     } 
 #if defined(ESP32) || defined(ESP8266)
-    else if (_displayType == TFT_DISPLAY && tftDisplay != nullptr) {
+    else if (_displayType == TFT_DISPLAY && _tftDisplay != nullptr) {
         // For TFT display, we can handle animated GIFs if in online animation mode
         if (_animationMode == ANIMATION_ONLINE && 
             _onlineAnimationCache[_currentWeather].isLoaded &&
             _onlineAnimationCache[_currentWeather].isAnimated) {
             
-            unsigned long currentTime = millis();
+            uint32_t currentTime = _clock->millis();
             
             // Update the frame based on timing
             if (currentTime - _lastFrameTime >= _onlineAnimationCache[_currentWeather].frameDelay) {
@@ -539,7 +1043,7 @@ void WeatherAnimations::displayAnimation() {
                 
                 // Clear the screen once per cycle for clean animation
                 if (_currentFrame == 0) {
-                    tftDisplay->fillScreen(TFT_BLACK);
+                    _tftDisplay->fillScreen(TFT_BLACK);
                 }
                 
                 // Display the current frame
@@ -550,44 +1054,31 @@ void WeatherAnimations::displayAnimation() {
                 // Add temperature data if available
                 if (_hasTemperatureData) {
                     // Preserve area for temperature display
-                    tftDisplay->fillRect(0, TFT_HEIGHT - 40, TFT_WIDTH, 40, TFT_BLACK);
-                    
-                    tftDisplay->setCursor(10, TFT_HEIGHT - 35);
-                    tftDisplay->setTextColor(TFT_WHITE);
-                    tftDisplay->setTextSize(1);
-                    
-                    tftDisplay->print("Indoor: ");
-                    tftDisplay->print(_indoorTemp, 1);
-                    tftDisplay->print("C  Outdoor: ");
-                    tftDisplay->print(_outdoorTemp, 1);
-                    tftDisplay->println("C");
+                    _tftDisplay->fillRect(0, TFT_HEIGHT - 40, TFT_WIDTH, 40, TFT_BLACK);
                     
-                    tftDisplay->setCursor(10, TFT_HEIGHT - 20);
-                    tftDisplay->print("Forecast: Min ");
-                    tftDisplay->print(_minForecastTemp, 1);
-                    tftDisplay->print("C  Max ");
-                    tftDisplay->print(_maxForecastTemp, 1);
-                    tftDisplay->println("C");
+                    drawTFTTemperatureLine(TFT_HEIGHT - 35, "Indoor: ", _indoorTemp, "  Outdoor: ", _outdoorTemp);
+                    drawTFTTemperatureLine(TFT_HEIGHT - 20, "Forecast: Min ", _minForecastTemp, "  Max ", _maxForecastTemp);
                 }
             }
         } else {
             // Static display or fallback
-            tftDisplay->fillScreen(TFT_BLACK);
+            _tftDisplay->fillScreen(TFT_BLACK);
             displayTextFallback(_currentWeather);
         }
     } 
 #endif
     else {
-        WA_SERIAL_PRINTLN("No display initialized or unsupported display type.");
+        WA_LOG_ERROR("No display initialized or unsupported display type.");
     }
     
     // Continuous animation update for the continuous weather mode
-    if (_mode == CONTINUOUS_WEATHER) {
+    // (tick() paces frames itself and must not block)
+    if (_mode == CONTINUOUS_WEATHER && !_tickMode) {
         // For continuous display, we need to periodically refresh
-        delay(16); // ~60 fps maximum update rate
+        _clock->delay(16); // ~60 fps maximum update rate
     }
     
-    WA_SERIAL_PRINTLN("Exiting displayAnimation method.");
+    WA_LOG_VERBOSE("Exiting displayAnimation method.");
 }
 
 bool WeatherAnimations::fetchOnlineAnimation(uint8_t weatherCondition) {
@@ -595,8 +1086,7 @@ bool WeatherAnimations::fetchOnlineAnimation(uint8_t weatherCondition) {
         return false;
     }
     
-    WA_SERIAL_PRINT("Fetching online animation for condition: ");
-    WA_SERIAL_PRINTLN(weatherCondition);
+    WA_LOG_DEBUG("Fetching online animation for condition: %u", weatherCondition);
     
     const char* url = _onlineAnimationURLs[weatherCondition];
     
@@ -612,8 +1102,10 @@ bool WeatherAnimations::fetchOnlineAnimation(uint8_t weatherCondition) {
     }
     
     // For static images, use the original method
+    WA_PERF_SCOPE_ARG(PERF_ASSET_LOAD, "condition", weatherCondition);
     HTTPClient http;
     http.begin(url);
+    uint32_t fetchStart = recordActive() ? recordMillis() : 0;
     int httpCode = http.GET();
     
     if (httpCode == 200) {
@@ -621,10 +1113,8 @@ bool WeatherAnimations::fetchOnlineAnimation(uint8_t weatherCondition) {
         int dataSize = http.getSize();
         
         if (dataSize > 0) {
-            // Free previous memory if any
-            if (_onlineAnimationCache[weatherCondition].imageData != nullptr) {
-                free(_onlineAnimationCache[weatherCondition].imageData);
-            }
+            // Free previous memory if any, GIF frames included
+            releaseOnlineAnimation(weatherCondition);
             
             // Allocate memory for the new data
             _onlineAnimationCache[weatherCondition].imageData = (uint8_t*)malloc(dataSize);
@@ -638,19 +1128,20 @@ bool WeatherAnimations::fetchOnlineAnimation(uint8_t weatherCondition) {
                     _onlineAnimationCache[weatherCondition].dataSize = bytesRead;
                     _onlineAnimationCache[weatherCondition].isLoaded = true;
                     _onlineAnimationCache[weatherCondition].isAnimated = false;
-                    WA_SERIAL_PRINTLN("Online animation data loaded successfully.");
+                    WA_LOG_DEBUG("Online animation data loaded successfully.");
                 }
             } else {
-                WA_SERIAL_PRINTLN("Failed to allocate memory for animation data.");
+                WA_LOG_ERROR("Failed to allocate memory for animation data.");
             }
         }
         
         http.end();
+        recordOnlineFetch(weatherCondition, fetchStart, httpCode, dataSize);
         return _onlineAnimationCache[weatherCondition].isLoaded;
     } else {
-        WA_SERIAL_PRINT("Failed to fetch online animation, HTTP code: ");
-        WA_SERIAL_PRINTLN(httpCode);
+        WA_LOG_WARN("Failed to fetch online animation, HTTP code: %d", httpCode);
         http.end();
+        recordOnlineFetch(weatherCondition, fetchStart, httpCode, -1);
         return false;
     }
 }
@@ -658,9 +1149,11 @@ bool WeatherAnimations::fetchOnlineAnimation(uint8_t weatherCondition) {
 bool WeatherAnimations::loadAnimatedGif(uint8_t weatherCondition, const char* url) {
     // This is a simplified approach for demonstration
     // In a real-world implementation, you would use a GIF decoder library
+    WA_PERF_SCOPE_ARG(PERF_ASSET_LOAD, "condition", weatherCondition);
     
     HTTPClient http;
     http.begin(url);
+    uint32_t fetchStart = recordActive() ? recordMillis() : 0;
     int httpCode = http.GET();
     
     if (httpCode == 200) {
@@ -669,17 +1162,7 @@ bool WeatherAnimations::loadAnimatedGif(uint8_t weatherCondition, const char* ur
         
         if (dataSize > 0) {
             // Free previous memory if any
-            if (_onlineAnimationCache[weatherCondition].imageData != nullptr) {
-                free(_onlineAnimationCache[weatherCondition].imageData);
-                
-                // Free any frame data
-                for (int i = 0; i < 10; i++) {
-                    if (_onlineAnimationCache[weatherCondition].frameData[i] != nullptr) {
-                        free(_onlineAnimationCache[weatherCondition].frameData[i]);
-                        _onlineAnimationCache[weatherCondition].frameData[i] = nullptr;
-                    }
-                }
-            }
+            releaseOnlineAnimation(weatherCondition);
             
             // Allocate memory for the new data
             _onlineAnimationCache[weatherCondition].imageData = (uint8_t*)malloc(dataSize);
@@ -696,28 +1179,60 @@ bool WeatherAnimations::loadAnimatedGif(uint8_t weatherCondition, const char* ur
                     
                     // Parse the GIF to extract frames
                     if (parseGifFrames(weatherCondition)) {
-                        WA_SERIAL_PRINTLN("Animated GIF loaded and parsed successfully.");
+                        WA_LOG_DEBUG("Animated GIF loaded and parsed successfully.");
                         http.end();
+                        recordOnlineFetch(weatherCondition, fetchStart, httpCode, dataSize);
                         return true;
                     } else {
-                        WA_SERIAL_PRINTLN("Failed to parse GIF frames.");
+                        WA_LOG_WARN("Failed to parse GIF frames.");
                     }
                 }
             } else {
-                WA_SERIAL_PRINTLN("Failed to allocate memory for GIF data.");
+                WA_LOG_ERROR("Failed to allocate memory for GIF data.");
             }
         }
         
         http.end();
+        recordOnlineFetch(weatherCondition, fetchStart, httpCode, dataSize);
         return false;
     } else {
-        WA_SERIAL_PRINT("Failed to fetch animated GIF, HTTP code: ");
-        WA_SERIAL_PRINTLN(httpCode);
+        WA_LOG_WARN("Failed to fetch animated GIF, HTTP code: %d", httpCode);
         http.end();
+        recordOnlineFetch(weatherCondition, fetchStart, httpCode, -1);
         return false;
     }
 }
 
+// Helper function to add a finished online animation download to a running recording
+void WeatherAnimations::recordOnlineFetch(uint8_t weatherCondition, uint32_t start, int httpCode, int dataSize) {
+    if (!recordActive()) {
+        return;
+    }
+    const OnlineAnimation& cache = _onlineAnimationCache[weatherCondition];
+    recordFetch(start, httpCode, dataSize, cache.isLoaded ? cache.imageData : nullptr,
+                cache.isLoaded ? cache.dataSize : 0);
+}
+
+// Helper function to free a condition's cached online animation: the image
+// and every GIF frame, whether or not frameCount still counts it
+void WeatherAnimations::releaseOnlineAnimation(uint8_t weatherCondition) {
+    OnlineAnimation& cache = _onlineAnimationCache[weatherCondition];
+    if (cache.imageData != nullptr) {
+        free(cache.imageData);
+        cache.imageData = nullptr;
+    }
+    for (int i = 0; i < 10; i++) {
+        if (cache.frameData[i] != nullptr) {
+            _gifFramePool.release(cache.frameData[i]);
+            cache.frameData[i] = nullptr;
+        }
+    }
+    cache.dataSize = 0;
+    cache.isLoaded = false;
+    cache.isAnimated = false;
+    cache.frameCount = 0;
+}
+
 bool WeatherAnimations::parseGifFrames(uint8_t weatherCondition) {
     // This is a placeholder for GIF parsing logic
     // In a real implementation, you would use a library like AnimatedGIF
@@ -729,12 +1244,11 @@ bool WeatherAnimations::parseGifFrames(uint8_t weatherCondition) {
     _onlineAnimationCache[weatherCondition].frameDelay = 250; // 250ms between frames
     
     for (int i = 0; i < simulatedFrameCount; i++) {
-        // Allocate memory for each frame (just for demonstration)
-        _onlineAnimationCache[weatherCondition].frameData[i] = 
-            (uint8_t*)malloc(TFT_WIDTH * TFT_HEIGHT * 2); // 2 bytes per pixel for RGB565
+        // Take a block for each frame (just for demonstration); 2 bytes per pixel for RGB565
+        _onlineAnimationCache[weatherCondition].frameData[i] = (uint8_t*)_gifFramePool.acquire();
         
         if (_onlineAnimationCache[weatherCondition].frameData[i] == nullptr) {
-            WA_SERIAL_PRINTLN("Failed to allocate memory for GIF frame.");
+            WA_LOG_ERROR("Failed to allocate memory for GIF frame.");
             return false;
         }
         
@@ -747,36 +1261,91 @@ bool WeatherAnimations::parseGifFrames(uint8_t weatherCondition) {
 
 void WeatherAnimations::initDisplay() {
     _displayInitFailed = false;
-    if (_displayType == OLED_SSD1306 || _displayType == OLED_SH1106) {
+    if (isOLEDDisplay()) {
         // Use SSD1306 library for both SSD1306 and SH1106 displays (compatibility mode)
-        oledDisplay = new Adafruit_SSD1306(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1);
-        if (oledDisplay->begin(SSD1306_SWITCHCAPVCC, _i2cAddr)) {
-            oledDisplay->clearDisplay();
-            oledDisplay->display();
-            WA_SERIAL_PRINTLN("SSD1306 display initialized.");
+        if (_displayType == OLED_SSD1306_SPI && _spiConfig.dcPin < 0) {
+            WA_LOG_ERROR("OLED_SSD1306_SPI needs setSPIConfig() before begin().");
+            _displayInitFailed = true;
+            return;
+        }
+        OLEDBusConfig config = (_displayType == OLED_SSD1306_SPI) ? _spiConfig : oledI2CConfig(_i2cAddr);
+        _oledDisplay = _oledPanel.begin(SCREEN_WIDTH, SCREEN_HEIGHT, config, _oledRotation, _oledMirror);
+        if (_oledDisplay != nullptr) {
+            _oledDisplay->clearDisplay();
+            _oledPanel.flush();
+            if (_busScheduler != nullptr && !_busScheduler->addPanel(&_oledPanel)) {
+                WA_LOG_WARN("OLED bus is full, this panel will flush on its own.");
+                _busScheduler = nullptr;
+            }
+            WA_LOG_INFO("SSD1306 display initialized.");
         } else {
-            WA_SERIAL_PRINTLN("SSD1306 display initialization failed. Library will continue without display.");
-            delete oledDisplay;
-            oledDisplay = nullptr;
+            WA_LOG_ERROR("SSD1306 display initialization failed. Library will continue without display.");
             _displayInitFailed = true;
         }
     } 
 #if defined(ESP32) || defined(ESP8266)
     else if (_displayType == TFT_DISPLAY) {
-        tftDisplay = new TFT_eSPI();
-        tftDisplay->init();
-        tftDisplay->fillScreen(TFT_BLACK);
-        tftDisplay->setRotation(0);
-        WA_SERIAL_PRINTLN("TFT display initialized.");
+        // Kept across begin() calls
+        if (_tftDisplay == nullptr) {
+            _tftDisplay = new TFT_eSPI();
+        }
+        _tftDisplay->init();
+        _tftDisplay->fillScreen(TFT_BLACK);
+        _tftDisplay->setRotation(0);
+        WA_LOG_INFO("TFT display initialized.");
     }
 #endif
 }
 
+bool WeatherAnimations::isOLEDDisplay() const {
+    return _displayType == OLED_SSD1306 || _displayType == OLED_SH1106 || _displayType == OLED_SSD1306_SPI;
+}
+
+// Helper function to send the OLED framebuffer, through the shared bus if there is one
+void WeatherAnimations::flushOLED() {
+    if (_tickMode) {
+        // Sent a region at a time by the flush task
+        _flushPending = true;
+    } else if (_busScheduler != nullptr) {
+        _busScheduler->requestFlush(&_oledPanel);
+    } else {
+        _oledPanel.flush();
+    }
+}
+
+// Helper function to draw two labelled temperatures on one OLED text line.
+// Labels come from the text cache, values are written with the digit font.
+void WeatherAnimations::drawOLEDTemperatureLine(int16_t y, const char* firstLabel, float firstValue,
+                                                const char* secondLabel, float secondValue) {
+    char value[12];
+    int16_t x = _textCache.draw(_oledDisplay, 0, y, firstLabel, 1);
+    formatTemperature(value, sizeof(value), firstValue, 1, 'C', false);
+    x += drawDigits(_oledDisplay, x, y, value, DIGIT_FONT_SMALL);
+    x += _textCache.draw(_oledDisplay, x, y, secondLabel, 1);
+    formatTemperature(value, sizeof(value), secondValue, 1, 'C', false);
+    drawDigits(_oledDisplay, x, y, value, DIGIT_FONT_SMALL);
+}
+
+#if defined(ESP32) || defined(ESP8266)
+// Helper function to draw two labelled temperatures on one TFT text line
+void WeatherAnimations::drawTFTTemperatureLine(int16_t y, const char* firstLabel, float firstValue,
+                                               const char* secondLabel, float secondValue) {
+    char value[12];
+    int16_t x = 10;
+    x += _textCache.draw(_tftDisplay, x, y, firstLabel, 1, TFT_WHITE, TFT_BLACK);
+    formatTemperature(value, sizeof(value), firstValue, 1, 'C', false);
+    x += drawDigits(_tftDisplay, x, y, value, DIGIT_FONT_SMALL, TFT_WHITE, TFT_BLACK);
+    x += _textCache.draw(_tftDisplay, x, y, secondLabel, 1, TFT_WHITE, TFT_BLACK);
+    formatTemperature(value, sizeof(value), secondValue, 1, 'C', false);
+    drawDigits(_tftDisplay, x, y, value, DIGIT_FONT_SMALL, TFT_WHITE, TFT_BLACK);
+}
+#endif
+
 bool WeatherAnimations::setAnimationFromHACondition(const char* condition, bool isDaytime) {
     // Find the appropriate icon based on condition and time of day
     const IconMapping* icon = findWeatherIcon(condition, isDaytime);
     if (icon == nullptr) {
-        WA_SERIAL_PRINTLN("Warning: Could not find icon for condition");
+        WA_LOG_WARN("Could not find icon for condition");
         return false;
     }
     
@@ -799,41 +1368,42 @@ bool WeatherAnimations::setAnimationFromHACondition(const char* condition, bool
     }
     
     // For OLED display, use embedded animations
-    if (_displayType == OLED_SSD1306) {
-        switch (weatherCode) {
-            case WEATHER_CLEAR:
-                setAnimation(weatherCode, clearSkyFrames, 2, 500);
-                break;
-            case WEATHER_CLOUDY:
-                setAnimation(weatherCode, cloudySkyFrames, 2, 500);
-                break;
-            case WEATHER_RAIN:
-                setAnimation(weatherCode, rainFrames, 3, 300);
-                break;
-            case WEATHER_SNOW:
-                setAnimation(weatherCode, snowFrames, 3, 300);
-                break;
-            case WEATHER_STORM:
-                setAnimation(weatherCode, stormFrames, 2, 200);
-                break;
-        }
+    if (_displayType == OLED_SSD1306 || _displayType == OLED_SSD1306_SPI) {
+        setAnimation(weatherCode, nullptr, _frameStore.frameCount(weatherCode), _frameStore.frameDelay(weatherCode));
     }
     
     // For TFT display or if using online animation mode, set URL to fetch the icon online
     if (_displayType == TFT_DISPLAY || _animationMode == ANIMATION_ONLINE) {
-        // Load the icon if not already loaded
-        if (!icon->isLoaded) {
-            loadWeatherIcon((IconMapping*)icon);
+        // Load the icon if not already loaded (in tick mode, from the download task)
+        if (_pipelineRunning) {
+            // The network half owns the icon cache
+            PipelineMessage message;
+            memset(&message, 0, sizeof(message));
+            message.type = PIPELINE_FETCH_ICON;
+            message.icon = icon;
+            _pipelineRequests.push(message);
+        } else if (_tickMode) {
+            if (!_iconCache.isLoaded(icon)) {
+                _pendingIcon = icon;
+                _scheduler.wake(_downloadTask);
+            }
+        } else {
+            _iconCache.load(icon);
         }
         
-        // Generate URL based on the condition and variant for online animations
-        char url[150];
-        sprintf(url, "https://raw.githubusercontent.com/basmilius/weather-icons/master/production/fill/%s%s%s.png", 
-                condition,
-                (icon->variant[0] != '\0' ? "-" : ""),
-                icon->variant);
-        
-        setOnlineAnimationSource(weatherCode, url);
+        // Generate URL based on the condition and variant for online animations.
+        // It is kept per condition because downloads may run after this returns,
+        // and only built again when the condition maps to a different icon.
+        char* url = _conditionURLs[weatherCode];
+        if (_conditionIcons[weatherCode] != icon || _onlineAnimationURLs[weatherCode] != url) {
+            snprintf(url, ONLINE_ANIMATION_URL_LENGTH,
+                     "https://raw.githubusercontent.com/basmilius/weather-icons/master/production/fill/%s%s%s.png",
+                     icon->condition,
+                     (icon->variant[0] != '\0' ? "-" : ""),
+                     icon->variant);
+            _conditionIcons[weatherCode] = icon;
+            setOnlineAnimationSource(weatherCode, url);
+        }
     }
     
     // Update current weather
@@ -856,9 +1426,12 @@ bool WeatherAnimations::runTransition(uint8_t weatherCondition, uint8_t directio
     // Start a new transition
     _currentWeather = weatherCondition;
     _transitionDirection = direction;
-    _transitionStartTime = millis();
+    _transitionStartTime = _clock->millis();
     _transitionDuration = duration;
     _isTransitioning = true;
+    if (_tickMode) {
+        _scheduler.wake(_renderTask);
+    }
     
     // Update the display to show the first frame
     displayAnimation();
@@ -869,17 +1442,12 @@ bool WeatherAnimations::runTransition(uint8_t weatherCondition, uint8_t directio
 
 // New method: Display a single frame of the transition animation
 void WeatherAnimations::displayTransitionFrame(uint8_t weatherCondition, float progress) {
-    if ((_displayType == OLED_SSD1306 || _displayType == OLED_SH1106) && oledDisplay != nullptr) {
-        oledDisplay->clearDisplay();
+    if (isOLEDDisplay() && _oledDisplay != nullptr) {
+        _oledDisplay->clearDisplay();
         
         // Draw header with weather type name
-        oledDisplay->setTextSize(1);
-        oledDisplay->setTextColor(SSD1306_WHITE);
-        oledDisplay->setCursor(0, 0);
-        oledDisplay->println("Weather:");
-        oledDisplay->setTextSize(2);
-        oledDisplay->setCursor(0, 12);
-        oledDisplay->println(getWeatherText(weatherCondition));
+        _textCache.draw(_oledDisplay, 0, 0, "Weather:", 1);
+        _textCache.draw(_oledDisplay, 0, 12, getWeatherText(weatherCondition), 2);
         
         // Determine transition effect based on transition direction
         switch (_transitionDirection) {
@@ -915,44 +1483,44 @@ void WeatherAnimations::displayTransitionFrame(uint8_t weatherCondition, float p
                 }
                 
                 // Save current cursor position
-                int16_t curX = oledDisplay->getCursorX();
-                int16_t curY = oledDisplay->getCursorY();
+                int16_t curX = _oledDisplay->getCursorX();
+                int16_t curY = _oledDisplay->getCursorY();
                 
                 // Prepare for offscreen drawing
-                oledDisplay->setCursor(curX + x, curY + y);
+                _oledDisplay->setCursor(curX + x, curY + y);
                 
                 // Draw the icon offset by the transition amount
                 // We'll need to manually offset all drawing commands
                 
                 // Save and restore cursor after drawing
-                oledDisplay->setCursor(curX, curY);
+                _oledDisplay->setCursor(curX, curY);
                 
                 // Draw the icon with proper offset
                 // (This is simplified - in practice, you'd need to offset all drawing commands)
                 switch (weatherCondition) {
                     case WEATHER_CLEAR:
-                        oledDisplay->fillCircle(96 + x, 32 + y, 16, SSD1306_WHITE);
+                        _oledDisplay->fillCircle(96 + x, 32 + y, 16, SSD1306_WHITE);
                         break;
                     case WEATHER_CLOUDY:
-                        oledDisplay->fillRoundRect(86 + x, 34 + y, 36, 18, 8, SSD1306_WHITE);
-                        oledDisplay->fillRoundRect(78 + x, 24 + y, 28, 20, 8, SSD1306_WHITE);
+                        _oledDisplay->fillRoundRect(86 + x, 34 + y, 36, 18, 8, SSD1306_WHITE);
+                        _oledDisplay->fillRoundRect(78 + x, 24 + y, 28, 20, 8, SSD1306_WHITE);
                         break;
                     case WEATHER_RAIN:
-                        oledDisplay->fillRoundRect(86 + x, 24 + y, 36, 16, 8, SSD1306_WHITE);
+                        _oledDisplay->fillRoundRect(86 + x, 24 + y, 36, 16, 8, SSD1306_WHITE);
                         for (int i = 0; i < 6; i++) {
-                            oledDisplay->drawLine(86 + i*7 + x, 42 + y, 89 + i*7 + x, 52 + y, SSD1306_WHITE);
+                            _oledDisplay->drawLine(86 + i*7 + x, 42 + y, 89 + i*7 + x, 52 + y, SSD1306_WHITE);
                         }
                         break;
                     case WEATHER_SNOW:
-                        oledDisplay->fillRoundRect(86 + x, 24 + y, 36, 16, 8, SSD1306_WHITE);
+                        _oledDisplay->fillRoundRect(86 + x, 24 + y, 36, 16, 8, SSD1306_WHITE);
                         for (int i = 0; i < 6; i++) {
-                            oledDisplay->drawCircle(89 + i*7 + x, 48 + y, 2, SSD1306_WHITE);
+                            _oledDisplay->drawCircle(89 + i*7 + x, 48 + y, 2, SSD1306_WHITE);
                         }
                         break;
                     case WEATHER_STORM:
-                        oledDisplay->fillRoundRect(86 + x, 24 + y, 36, 16, 8, SSD1306_WHITE);
-                        oledDisplay->fillTriangle(100 + x, 42 + y, 90 + x, 52 + y, 95 + x, 52 + y, SSD1306_WHITE);
-                        oledDisplay->fillTriangle(95 + x, 52 + y, 105 + x, 52 + y, 98 + x, 62 + y, SSD1306_WHITE);
+                        _oledDisplay->fillRoundRect(86 + x, 24 + y, 36, 16, 8, SSD1306_WHITE);
+                        _oledDisplay->fillTriangle(100 + x, 42 + y, 90 + x, 52 + y, 95 + x, 52 + y, SSD1306_WHITE);
+                        _oledDisplay->fillTriangle(95 + x, 52 + y, 105 + x, 52 + y, 98 + x, 62 + y, SSD1306_WHITE);
                         break;
                 }
                 break;
@@ -961,35 +1529,23 @@ void WeatherAnimations::displayTransitionFrame(uint8_t weatherCondition, float p
         
         // Add temperature data at the bottom if available
         if (_hasTemperatureData) {
-            oledDisplay->setTextSize(1);
-            oledDisplay->setCursor(0, 45);
-            
             // Show indoor and outdoor temps
-            oledDisplay->print("In:");
-            oledDisplay->print(_indoorTemp, 1);
-            oledDisplay->print("C  Out:");
-            oledDisplay->print(_outdoorTemp, 1);
-            oledDisplay->print("C");
+            drawOLEDTemperatureLine(45, "In:", _indoorTemp, "  Out:", _outdoorTemp);
             
             // Show forecast min/max on last line
-            oledDisplay->setCursor(0, 56);
-            oledDisplay->print("Min:");
-            oledDisplay->print(_minForecastTemp, 1);
-            oledDisplay->print("C Max:");
-            oledDisplay->print(_maxForecastTemp, 1);
-            oledDisplay->print("C");
+            drawOLEDTemperatureLine(56, "Min:", _minForecastTemp, " Max:", _maxForecastTemp);
         }
         
-        oledDisplay->display();
+        flushOLED();
     } 
 #if defined(ESP32) || defined(ESP8266)
-    else if (_displayType == TFT_DISPLAY && tftDisplay != nullptr) {
+    else if (_displayType == TFT_DISPLAY && _tftDisplay != nullptr) {
         // For TFT display, we'll implement a simple transition
         // This is a basic implementation - you can enhance it with more complex animations
         
         // Clear the display on the first frame
         if (progress == 0.0f) {
-            tftDisplay->fillScreen(TFT_BLACK);
+            _tftDisplay->fillScreen(TFT_BLACK);
         }
         
         // Get display dimensions
@@ -1017,17 +1573,17 @@ void WeatherAnimations::displayTransitionFrame(uint8_t weatherCondition, float p
                 // For fade, adjust opacity based on progress
                 // This is a simplified version - you'd need to implement
                 // alpha blending for a proper fade
-                tftDisplay->setTextColor(TFT_WHITE, TFT_BLACK);
-                tftDisplay->setTextSize(2);
-                tftDisplay->setCursor(10, 10);
-                tftDisplay->println(getWeatherText(weatherCondition));
+                _tftDisplay->setTextColor(TFT_WHITE, TFT_BLACK);
+                _tftDisplay->setTextSize(2);
+                _tftDisplay->setCursor(10, 10);
+                _tftDisplay->println(getWeatherText(weatherCondition));
                 
                 // Create a fade pattern
                 if (progress < 1.0f) {
                     uint16_t stripeCount = 10 * (1.0f - progress);
                     for (uint16_t i = 0; i < stripeCount; i++) {
                         uint16_t y = (i * height) / stripeCount;
-                        tftDisplay->fillRect(0, y, width, height / stripeCount / 2, TFT_BLACK);
+                        _tftDisplay->fillRect(0, y, width, height / stripeCount / 2, TFT_BLACK);
                     }
                 }
                 break;
@@ -1035,175 +1591,158 @@ void WeatherAnimations::displayTransitionFrame(uint8_t weatherCondition, float p
         
         if (_transitionDirection != TRANSITION_FADE) {
             // Draw the weather text with the calculated offset
-            tftDisplay->setTextColor(TFT_WHITE, TFT_BLACK);
-            tftDisplay->setTextSize(2);
-            tftDisplay->setCursor(10 + x, 10 + y);
-            tftDisplay->println(getWeatherText(weatherCondition));
+            _tftDisplay->setTextColor(TFT_WHITE, TFT_BLACK);
+            _tftDisplay->setTextSize(2);
+            _tftDisplay->setCursor(10 + x, 10 + y);
+            _tftDisplay->println(getWeatherText(weatherCondition));
             
             // Draw a simple weather icon
             switch (weatherCondition) {
                 case WEATHER_CLEAR:
-                    tftDisplay->fillCircle(120 + x, 160, 40, TFT_YELLOW);
+                    _tftDisplay->fillCircle(120 + x, 160, 40, TFT_YELLOW);
                     break;
                 case WEATHER_CLOUDY:
-                    tftDisplay->fillRoundRect(80, 140, 100, 40, 20, TFT_WHITE);
+                    _tftDisplay->fillRoundRect(80, 140, 100, 40, 20, TFT_WHITE);
                     break;
                 case WEATHER_RAIN:
-                    tftDisplay->fillRoundRect(80, 120, 100, 40, 20, TFT_LIGHTGREY);
+                    _tftDisplay->fillRoundRect(80, 120, 100, 40, 20, TFT_LIGHTGREY);
                     for (int i = 0; i < 10; i++) {
-                        tftDisplay->drawLine(90 + i*10, 170, 90 + i*10 + 5, 190, TFT_BLUE);
+                        _tftDisplay->drawLine(90 + i*10, 170, 90 + i*10 + 5, 190, TFT_BLUE);
                     }
                     break;
                 case WEATHER_SNOW:
-                    tftDisplay->fillRoundRect(80, 120, 100, 40, 20, TFT_LIGHTGREY);
+                    _tftDisplay->fillRoundRect(80, 120, 100, 40, 20, TFT_LIGHTGREY);
                     for (int i = 0; i < 10; i++) {
-                        tftDisplay->drawPixel(90 + i*10, 180, TFT_WHITE);
-                        tftDisplay->drawPixel(90 + i*10 + 1, 180, TFT_WHITE);
-                        tftDisplay->drawPixel(90 + i*10, 180 + 1, TFT_WHITE);
-                        tftDisplay->drawPixel(90 + i*10 + 1, 180 + 1, TFT_WHITE);
+                        _tftDisplay->drawPixel(90 + i*10, 180, TFT_WHITE);
+                        _tftDisplay->drawPixel(90 + i*10 + 1, 180, TFT_WHITE);
+                        _tftDisplay->drawPixel(90 + i*10, 180 + 1, TFT_WHITE);
+                        _tftDisplay->drawPixel(90 + i*10 + 1, 180 + 1, TFT_WHITE);
                     }
                     break;
                 case WEATHER_STORM:
-                    tftDisplay->fillRoundRect(80, 120, 100, 40, 20, TFT_DARKGREY);
-                    tftDisplay->fillTriangle(120, 170, 130, 200, 110, 190, TFT_YELLOW);
+                    _tftDisplay->fillRoundRect(80, 120, 100, 40, 20, TFT_DARKGREY);
+                    _tftDisplay->fillTriangle(120, 170, 130, 200, 110, 190, TFT_YELLOW);
                     break;
                 default:
-                    tftDisplay->println("Unknown");
+                    _tftDisplay->println("Unknown");
             }
         }
     } 
 #endif
     else {
-        WA_SERIAL_PRINTLN("No display initialized or unsupported display type.");
+        WA_LOG_ERROR("No display initialized or unsupported display type.");
     }
 }
 
 void WeatherAnimations::displayTextFallback(uint8_t weatherCondition) {
-    if ((_displayType == OLED_SSD1306 || _displayType == OLED_SH1106) && oledDisplay != nullptr) {
-        oledDisplay->clearDisplay();
-        oledDisplay->setTextSize(1);
-        oledDisplay->setTextColor(SSD1306_WHITE);
-        oledDisplay->setCursor(0, 0);
-        oledDisplay->println(getWeatherText(weatherCondition));
+    if (isOLEDDisplay() && _oledDisplay != nullptr) {
+        _oledDisplay->clearDisplay();
+        _textCache.draw(_oledDisplay, 0, 0, getWeatherText(weatherCondition), 1);
         
         // Display temperature information if available
         if (_hasTemperatureData) {
-            oledDisplay->setCursor(0, 54);
-            
-            // Indoor temp
-            oledDisplay->print("In:");
-            oledDisplay->print(_indoorTemp, 1);
-            oledDisplay->print("C ");
-            
-            // Outdoor temp
-            oledDisplay->print("Out:");
-            oledDisplay->print(_outdoorTemp, 1);
-            oledDisplay->print("C");
+            // Indoor and outdoor temp
+            drawOLEDTemperatureLine(54, "In:", _indoorTemp, " Out:", _outdoorTemp);
             
             // Min/Max forecast on second line
-            oledDisplay->setCursor(0, 54);
-            oledDisplay->print("Min:");
-            oledDisplay->print(_minForecastTemp, 1);
-            oledDisplay->print("C Max:");
-            oledDisplay->print(_maxForecastTemp, 1);
-            oledDisplay->print("C");
+            drawOLEDTemperatureLine(54, "Min:", _minForecastTemp, " Max:", _maxForecastTemp);
         }
         
         // Draw a simple weather icon based on condition
         switch (weatherCondition) {
             case WEATHER_CLEAR:
-                oledDisplay->fillCircle(64, 32, 16, SSD1306_WHITE);
+                _oledDisplay->fillCircle(64, 32, 16, SSD1306_WHITE);
                 break;
             case WEATHER_CLOUDY:
-                oledDisplay->fillRoundRect(44, 22, 50, 20, 10, SSD1306_WHITE);
-                oledDisplay->fillRoundRect(34, 32, 70, 18, 10, SSD1306_WHITE);
+                _oledDisplay->fillRoundRect(44, 22, 50, 20, 10, SSD1306_WHITE);
+                _oledDisplay->fillRoundRect(34, 32, 70, 18, 10, SSD1306_WHITE);
                 break;
             case WEATHER_RAIN:
-                oledDisplay->fillRoundRect(44, 20, 50, 16, 8, SSD1306_WHITE);
+                _oledDisplay->fillRoundRect(44, 20, 50, 16, 8, SSD1306_WHITE);
                 for (int i = 0; i < 5; i++) {
-                    oledDisplay->drawLine(44 + i*10, 38, 47 + i*10, 46, SSD1306_WHITE);
+                    _oledDisplay->drawLine(44 + i*10, 38, 47 + i*10, 46, SSD1306_WHITE);
                 }
                 break;
             case WEATHER_SNOW:
-                oledDisplay->fillRoundRect(44, 20, 50, 16, 8, SSD1306_WHITE);
+                _oledDisplay->fillRoundRect(44, 20, 50, 16, 8, SSD1306_WHITE);
                 for (int i = 0; i < 5; i++) {
-                    oledDisplay->drawCircle(44 + i*10, 42, 2, SSD1306_WHITE);
+                    _oledDisplay->drawCircle(44 + i*10, 42, 2, SSD1306_WHITE);
                 }
                 break;
             case WEATHER_STORM:
-                oledDisplay->fillRoundRect(44, 20, 50, 16, 8, SSD1306_WHITE);
-                oledDisplay->fillTriangle(64, 36, 58, 46, 64, 46, SSD1306_WHITE);
-                oledDisplay->fillTriangle(64, 46, 70, 46, 64, 54, SSD1306_WHITE);
+                _oledDisplay->fillRoundRect(44, 20, 50, 16, 8, SSD1306_WHITE);
+                _oledDisplay->fillTriangle(64, 36, 58, 46, 64, 46, SSD1306_WHITE);
+                _oledDisplay->fillTriangle(64, 46, 70, 46, 64, 54, SSD1306_WHITE);
                 break;
             default:
-                oledDisplay->setTextSize(2);
-                oledDisplay->setCursor(10, 30);
-                oledDisplay->println("?");
+                _oledDisplay->setTextSize(2);
+                _oledDisplay->setCursor(10, 30);
+                _oledDisplay->println("?");
                 break;
         }
         
-        oledDisplay->display();
+        flushOLED();
     } 
 #if defined(ESP32) || defined(ESP8266)
-    else if (_displayType == TFT_DISPLAY && tftDisplay != nullptr) {
-        tftDisplay->fillScreen(TFT_BLACK);
-        tftDisplay->setCursor(10, 10);
-        tftDisplay->setTextColor(TFT_WHITE);
-        tftDisplay->setTextSize(2);
+    else if (_displayType == TFT_DISPLAY && _tftDisplay != nullptr) {
+        _tftDisplay->fillScreen(TFT_BLACK);
+        _tftDisplay->setCursor(10, 10);
+        _tftDisplay->setTextColor(TFT_WHITE);
+        _tftDisplay->setTextSize(2);
         
         switch (weatherCondition) {
             case WEATHER_CLEAR:
-                tftDisplay->println("Clear Sky");
-                tftDisplay->fillCircle(120, 160, 40, TFT_YELLOW);
+                _tftDisplay->println("Clear Sky");
+                _tftDisplay->fillCircle(120, 160, 40, TFT_YELLOW);
                 break;
             case WEATHER_CLOUDY:
-                tftDisplay->println("Cloudy");
-                tftDisplay->fillRoundRect(80, 140, 100, 40, 20, TFT_WHITE);
+                _tftDisplay->println("Cloudy");
+                _tftDisplay->fillRoundRect(80, 140, 100, 40, 20, TFT_WHITE);
                 break;
             case WEATHER_RAIN:
-                tftDisplay->println("Rainy");
-                tftDisplay->fillRoundRect(80, 120, 100, 40, 20, TFT_LIGHTGREY);
+                _tftDisplay->println("Rainy");
+                _tftDisplay->fillRoundRect(80, 120, 100, 40, 20, TFT_LIGHTGREY);
                 for (int i = 0; i < 10; i++) {
-                    tftDisplay->drawLine(90 + i*10, 170, 90 + i*10 + 5, 190, TFT_BLUE);
+                    _tftDisplay->drawLine(90 + i*10, 170, 90 + i*10 + 5, 190, TFT_BLUE);
                 }
                 break;
             case WEATHER_SNOW:
-                tftDisplay->println("Snowy");
-                tftDisplay->fillRoundRect(80, 120, 100, 40, 20, TFT_LIGHTGREY);
+                _tftDisplay->println("Snowy");
+                _tftDisplay->fillRoundRect(80, 120, 100, 40, 20, TFT_LIGHTGREY);
                 for (int i = 0; i < 10; i++) {
-                    tftDisplay->drawPixel(90 + i*10, 180, TFT_WHITE);
-                    tftDisplay->drawPixel(90 + i*10 + 1, 180, TFT_WHITE);
-                    tftDisplay->drawPixel(90 + i*10, 180 + 1, TFT_WHITE);
-                    tftDisplay->drawPixel(90 + i*10 + 1, 180 + 1, TFT_WHITE);
+                    _tftDisplay->drawPixel(90 + i*10, 180, TFT_WHITE);
+                    _tftDisplay->drawPixel(90 + i*10 + 1, 180, TFT_WHITE);
+                    _tftDisplay->drawPixel(90 + i*10, 180 + 1, TFT_WHITE);
+                    _tftDisplay->drawPixel(90 + i*10 + 1, 180 + 1, TFT_WHITE);
                 }
                 break;
             case WEATHER_STORM:
-                tftDisplay->println("Stormy");
-                tftDisplay->fillRoundRect(80, 120, 100, 40, 20, TFT_DARKGREY);
-                tftDisplay->fillTriangle(120, 170, 130, 200, 110, 190, TFT_YELLOW);
+                _tftDisplay->println("Stormy");
+                _tftDisplay->fillRoundRect(80, 120, 100, 40, 20, TFT_DARKGREY);
+                _tftDisplay->fillTriangle(120, 170, 130, 200, 110, 190, TFT_YELLOW);
                 break;
             default:
-                tftDisplay->println("Unknown");
+                _tftDisplay->println("Unknown");
         }
         
         // Display temperature information if available
         if (_hasTemperatureData) {
-            tftDisplay->setCursor(10, 220);
-            tftDisplay->setTextSize(1);
+            _tftDisplay->setCursor(10, 220);
+            _tftDisplay->setTextSize(1);
             
-            tftDisplay->print("Indoor: ");
-            tftDisplay->print(_indoorTemp, 1);
-            tftDisplay->println("C");
+            _tftDisplay->print("Indoor: ");
+            _tftDisplay->print(_indoorTemp, 1);
+            _tftDisplay->println("C");
             
-            tftDisplay->print("Outdoor: ");
-            tftDisplay->print(_outdoorTemp, 1);
-            tftDisplay->println("C");
+            _tftDisplay->print("Outdoor: ");
+            _tftDisplay->print(_outdoorTemp, 1);
+            _tftDisplay->println("C");
             
-            tftDisplay->print("Forecast: ");
-            tftDisplay->print(_minForecastTemp, 1);
-            tftDisplay->print("C - ");
-            tftDisplay->print(_maxForecastTemp, 1);
-            tftDisplay->println("C");
+            _tftDisplay->print("Forecast: ");
+            _tftDisplay->print(_minForecastTemp, 1);
+            _tftDisplay->print("C - ");
+            _tftDisplay->print(_maxForecastTemp, 1);
+            _tftDisplay->println("C");
         }
     }
 #endif
@@ -1221,181 +1760,32 @@ const char* WeatherAnimations::getWeatherText(uint8_t weatherCondition) {
 }
 
 WeatherAnimations::~WeatherAnimations() {
+    stopPipeline();
+    
     // Clean up display objects
-    if ((_displayType == OLED_SSD1306 || _displayType == OLED_SH1106) && oledDisplay != nullptr) {
-        delete oledDisplay;
-        oledDisplay = nullptr;
-    } else if (_displayType == TFT_DISPLAY && tftDisplay != nullptr) {
-        delete tftDisplay;
-        tftDisplay = nullptr;
+    if (isOLEDDisplay() && _oledDisplay != nullptr) {
+        if (_busScheduler != nullptr) {
+            _busScheduler->removePanel(&_oledPanel);
+        }
+        _oledPanel.end();
+        _oledDisplay = nullptr;
+    } else if (_displayType == TFT_DISPLAY && _tftDisplay != nullptr) {
+        delete _tftDisplay;
+        _tftDisplay = nullptr;
     }
     
-    // Clean up online animation cache
-    for (int i = 0; i < 5; i++) {
-        if (_onlineAnimationCache[i].imageData != nullptr) {
-            free(_onlineAnimationCache[i].imageData);
-            _onlineAnimationCache[i].imageData = nullptr;
-        }
-        for (int j = 0; j < _onlineAnimationCache[i].frameCount && j < 10; j++) {
-            if (_onlineAnimationCache[i].frameData[j] != nullptr) {
-                free(_onlineAnimationCache[i].frameData[j]);
-                _onlineAnimationCache[i].frameData[j] = nullptr;
-            }
-        }
+    if (_dataHub != nullptr) {
+        _dataHub->removeDisplay(this);
     }
     
-    // Clean up icon data
-    clearWeatherIcons();
-}
-
-#if defined(ESP32) || defined(ESP8266)
-// Only include renderTFTAnimation for ESP32/ESP8266 platforms
-void WeatherAnimations::renderTFTAnimation(uint8_t weatherCondition) {
-    if (tftDisplay == nullptr) {
-        return;
+    if (_downloadData != nullptr) {
+        delete[] _downloadData;
+        _downloadData = nullptr;
     }
     
-    // Check if we have valid frame data
-    if (_onlineAnimationCache[weatherCondition].frameCount > 0 &&
-        _onlineAnimationCache[weatherCondition].frameData[_currentFrame] != nullptr) {
-        
-        // In a real implementation, this would decode and display the actual frame data
-        // This is a simplified implementation that draws placeholder graphics
-        
-        tftDisplay->fillScreen(TFT_BLACK);
-        
-        // Draw the frame number for debugging
-        tftDisplay->setCursor(10, 10);
-        tftDisplay->setTextColor(TFT_WHITE);
-        tftDisplay->setTextSize(1);
-        tftDisplay->print("Frame: ");
-        tftDisplay->println(_currentFrame + 1);
-        
-        // Center coordinates for the animation
-        int16_t centerX = TFT_WIDTH / 2;
-        int16_t centerY = TFT_HEIGHT / 2;
-        
-        // Create animated effects based on weather condition and current frame
-        switch (weatherCondition) {
-            case WEATHER_CLEAR: {
-                // Sun with rays that get longer/shorter based on frame
-                int16_t rayLength = 15 + (_currentFrame * 5);
-                tftDisplay->fillCircle(centerX, centerY, 30, TFT_YELLOW);
-                
-                // Draw 8 rays around the sun
-                for (int i = 0; i < 8; i++) {
-                    float angle = i * PI / 4;
-                    int16_t x1 = centerX + cos(angle) * 30;
-                    int16_t y1 = centerY + sin(angle) * 30;
-                    int16_t x2 = centerX + cos(angle) * (30 + rayLength);
-                    int16_t y2 = centerY + sin(angle) * (30 + rayLength);
-                    tftDisplay->drawLine(x1, y1, x2, y2, TFT_YELLOW);
-                }
-                break;
-            }
-            
-            case WEATHER_CLOUDY: {
-                // Animate clouds moving horizontally
-                int16_t offset = _currentFrame * 10;
-                if (offset > TFT_WIDTH / 2) offset = 0;
-                
-                // Draw cloud shapes with offset
-                tftDisplay->fillCircle(centerX - 20 + offset, centerY, 20, TFT_LIGHTGREY);
-                tftDisplay->fillCircle(centerX + offset, centerY - 10, 25, TFT_LIGHTGREY);
-                tftDisplay->fillCircle(centerX + 20 + offset, centerY, 20, TFT_LIGHTGREY);
-                tftDisplay->fillRect(centerX - 20 + offset, centerY, 40, 20, TFT_LIGHTGREY);
-                
-                // Second smaller cloud
-                tftDisplay->fillCircle(centerX - 60 - offset, centerY + 40, 15, TFT_LIGHTGREY);
-                tftDisplay->fillCircle(centerX - 40 - offset, centerY + 35, 18, TFT_LIGHTGREY);
-                tftDisplay->fillRect(centerX - 60 - offset, centerY + 35, 30, 15, TFT_LIGHTGREY);
-                break;
-            }
-            
-            case WEATHER_RAIN: {
-                // Cloud with animated rain drops
-                // Draw the cloud
-                tftDisplay->fillCircle(centerX - 20, centerY - 30, 20, TFT_LIGHTGREY);
-                tftDisplay->fillCircle(centerX, centerY - 40, 25, TFT_LIGHTGREY);
-                tftDisplay->fillCircle(centerX + 20, centerY - 30, 20, TFT_LIGHTGREY);
-                tftDisplay->fillRect(centerX - 20, centerY - 30, 40, 20, TFT_LIGHTGREY);
-                
-                // Draw raindrops at different positions based on frame
-                for (int i = 0; i < 10; i++) {
-                    int16_t x = centerX - 40 + (i * 10);
-                    int16_t yOffset = ((i + _currentFrame) % 4) * 20;
-                    int16_t y = centerY + yOffset;
-                    
-                    // Only draw if within screen bounds
-                    if (y < TFT_HEIGHT) {
-                        tftDisplay->drawLine(x, y, x + 3, y + 10, TFT_BLUE);
-                    }
-                }
-                break;
-            }
-            
-            case WEATHER_SNOW: {
-                // Cloud with animated snowflakes
-                // Draw the cloud
-                tftDisplay->fillCircle(centerX - 20, centerY - 30, 20, TFT_LIGHTGREY);
-                tftDisplay->fillCircle(centerX, centerY - 40, 25, TFT_LIGHTGREY);
-                tftDisplay->fillCircle(centerX + 20, centerY - 30, 20, TFT_LIGHTGREY);
-                tftDisplay->fillRect(centerX - 20, centerY - 30, 40, 20, TFT_LIGHTGREY);
-                
-                // Draw snowflakes at different positions based on frame
-                for (int i = 0; i < 10; i++) {
-                    int16_t x = centerX - 40 + (i * 10);
-                    int16_t yOffset = ((i + _currentFrame) % 4) * 20;
-                    int16_t y = centerY + yOffset;
-                    
-                    // Only draw if within screen bounds
-                    if (y < TFT_HEIGHT) {
-                        // Draw a simple snowflake pattern
-                        tftDisplay->drawLine(x, y, x + 4, y + 4, TFT_WHITE);
-                        tftDisplay->drawLine(x + 4, y, x, y + 4, TFT_WHITE);
-                        tftDisplay->drawLine(x, y + 2, x + 4, y + 2, TFT_WHITE);
-                        tftDisplay->drawLine(x + 2, y, x + 2, y + 4, TFT_WHITE);
-                    }
-                }
-                break;
-            }
-            
-            case WEATHER_STORM: {
-                // Cloud with animated lightning bolt
-                // Draw the storm cloud
-                tftDisplay->fillCircle(centerX - 20, centerY - 30, 20, TFT_DARKGREY);
-                tftDisplay->fillCircle(centerX, centerY - 40, 25, TFT_DARKGREY);
-                tftDisplay->fillCircle(centerX + 20, centerY - 30, 20, TFT_DARKGREY);
-                tftDisplay->fillRect(centerX - 20, centerY - 30, 40, 20, TFT_DARKGREY);
-                
-                // Draw lightning bolt - flash on alternate frames
-                if (_currentFrame % 2 == 0) {
-                    tftDisplay->fillTriangle(
-                        centerX, centerY,
-                        centerX - 10, centerY + 30,
-                        centerX + 5, centerY + 15,
-                        TFT_YELLOW
-                    );
-                    tftDisplay->fillTriangle(
-                        centerX + 5, centerY + 15,
-                        centerX - 5, centerY + 45,
-                        centerX + 15, centerY + 45,
-                        TFT_YELLOW
-                    );
-                }
-                break;
-            }
-            
-            default:
-                // Default animation if no specific animation is available
-                tftDisplay->setCursor(centerX - 30, centerY);
-                tftDisplay->setTextSize(2);
-                tftDisplay->println("?");
-                break;
-        }
-    } else {
-        // Fallback to text display if no animation frames are available
-        displayTextFallback(weatherCondition);
+    // Clean up online animation cache
+    for (int i = 0; i < 5; i++) {
+        releaseOnlineAnimation(i);
     }
 }
 
@@ -1404,38 +1794,38 @@ void WeatherAnimations::drawStaticWeatherIcon(uint8_t weatherType) {
     switch (weatherType) {
         case WEATHER_CLEAR:
             // Draw sun
-            oledDisplay->fillCircle(96, 32, 16, SSD1306_WHITE);
+            _oledDisplay->fillCircle(96, 32, 16, SSD1306_WHITE);
             break;
         case WEATHER_CLOUDY:
             // Draw cloud
-            oledDisplay->fillRoundRect(86, 34, 36, 18, 8, SSD1306_WHITE);
-            oledDisplay->fillRoundRect(78, 24, 28, 20, 8, SSD1306_WHITE);
+            _oledDisplay->fillRoundRect(86, 34, 36, 18, 8, SSD1306_WHITE);
+            _oledDisplay->fillRoundRect(78, 24, 28, 20, 8, SSD1306_WHITE);
             break;
         case WEATHER_RAIN:
             // Draw cloud with rain
-            oledDisplay->fillRoundRect(86, 24, 36, 16, 8, SSD1306_WHITE);
+            _oledDisplay->fillRoundRect(86, 24, 36, 16, 8, SSD1306_WHITE);
             for (int i = 0; i < 6; i++) {
-                oledDisplay->drawLine(86 + i*7, 42, 89 + i*7, 52, SSD1306_WHITE);
+                _oledDisplay->drawLine(86 + i*7, 42, 89 + i*7, 52, SSD1306_WHITE);
             }
             break;
         case WEATHER_SNOW:
             // Draw cloud with snow
-            oledDisplay->fillRoundRect(86, 24, 36, 16, 8, SSD1306_WHITE);
+            _oledDisplay->fillRoundRect(86, 24, 36, 16, 8, SSD1306_WHITE);
             for (int i = 0; i < 6; i++) {
-                oledDisplay->drawCircle(89 + i*7, 48, 2, SSD1306_WHITE);
+                _oledDisplay->drawCircle(89 + i*7, 48, 2, SSD1306_WHITE);
             }
             break;
         case WEATHER_STORM:
             // Draw cloud with lightning
-            oledDisplay->fillRoundRect(86, 24, 36, 16, 8, SSD1306_WHITE);
-            oledDisplay->fillTriangle(100, 42, 90, 52, 95, 52, SSD1306_WHITE);
-            oledDisplay->fillTriangle(95, 52, 105, 52, 98, 62, SSD1306_WHITE);
+            _oledDisplay->fillRoundRect(86, 24, 36, 16, 8, SSD1306_WHITE);
+            _oledDisplay->fillTriangle(100, 42, 90, 52, 95, 52, SSD1306_WHITE);
+            _oledDisplay->fillTriangle(95, 52, 105, 52, 98, 62, SSD1306_WHITE);
             break;
         default:
             // Unknown weather, draw question mark
-            oledDisplay->setTextSize(3);
-            oledDisplay->setCursor(90, 30);
-            oledDisplay->print("?");
+            _oledDisplay->setTextSize(3);
+            _oledDisplay->setCursor(90, 30);
+            _oledDisplay->print("?");
             break;
     }
 }
@@ -1448,7 +1838,7 @@ void WeatherAnimations::drawAnimatedWeatherIcon(uint8_t weatherType, uint8_t fra
     switch (weatherType) {
         case WEATHER_CLEAR:
             // Animated sun (rays expand/contract)
-            oledDisplay->fillCircle(96, 32, 12, SSD1306_WHITE);
+            _oledDisplay->fillCircle(96, 32, 12, SSD1306_WHITE);
             if (frame % 2 == 0) {
                 // Draw longer rays
                 for (int i = 0; i < 8; i++) {
@@ -1457,7 +1847,7 @@ void WeatherAnimations::drawAnimatedWeatherIcon(uint8_t weatherType, uint8_t fra
                     int y1 = 32 + sin(angle) * 14;
                     int x2 = 96 + cos(angle) * 22;
                     int y2 = 32 + sin(angle) * 22;
-                    oledDisplay->drawLine(x1, y1, x2, y2, SSD1306_WHITE);
+                    _oledDisplay->drawLine(x1, y1, x2, y2, SSD1306_WHITE);
                 }
             } else {
                 // Draw shorter rays
@@ -1467,49 +1857,43 @@ void WeatherAnimations::drawAnimatedWeatherIcon(uint8_t weatherType, uint8_t fra
                     int y1 = 32 + sin(angle) * 14;
                     int x2 = 96 + cos(angle) * 18;
                     int y2 = 32 + sin(angle) * 18;
-                    oledDisplay->drawLine(x1, y1, x2, y2, SSD1306_WHITE);
+                    _oledDisplay->drawLine(x1, y1, x2, y2, SSD1306_WHITE);
                 }
             }
             break;
         case WEATHER_CLOUDY:
             // Animated cloud (moves slightly)
             offset = (frame % 2 == 0) ? 0 : 2;
-            oledDisplay->fillRoundRect(86 + offset, 34, 36, 18, 8, SSD1306_WHITE);
-            oledDisplay->fillRoundRect(78 + offset, 24, 28, 20, 8, SSD1306_WHITE);
+            _oledDisplay->fillRoundRect(86 + offset, 34, 36, 18, 8, SSD1306_WHITE);
+            _oledDisplay->fillRoundRect(78 + offset, 24, 28, 20, 8, SSD1306_WHITE);
             break;
         case WEATHER_RAIN:
             // Animated rain (drops move)
-            oledDisplay->fillRoundRect(86, 24, 36, 16, 8, SSD1306_WHITE);
+            _oledDisplay->fillRoundRect(86, 24, 36, 16, 8, SSD1306_WHITE);
             for (int i = 0; i < 6; i++) {
                 int height = ((i + frame) % 3) * 4; // Vary drop heights
-                oledDisplay->drawLine(86 + i*7, 42 + height, 89 + i*7, 52 + height, SSD1306_WHITE);
+                _oledDisplay->drawLine(86 + i*7, 42 + height, 89 + i*7, 52 + height, SSD1306_WHITE);
             }
             break;
         case WEATHER_SNOW:
             // Animated snow (flakes move)
-            oledDisplay->fillRoundRect(86, 24, 36, 16, 8, SSD1306_WHITE);
+            _oledDisplay->fillRoundRect(86, 24, 36, 16, 8, SSD1306_WHITE);
             for (int i = 0; i < 6; i++) {
                 int offset_y = ((i + frame) % 3) * 3;
                 int offset_x = ((i + frame) % 2) * 2 - 1;
-                oledDisplay->drawCircle(89 + i*7 + offset_x, 48 + offset_y, 2, SSD1306_WHITE);
+                _oledDisplay->drawCircle(89 + i*7 + offset_x, 48 + offset_y, 2, SSD1306_WHITE);
             }
             break;
         case WEATHER_STORM:
             // Animated lightning (flash)
-            oledDisplay->fillRoundRect(86, 24, 36, 16, 8, SSD1306_WHITE);
+            _oledDisplay->fillRoundRect(86, 24, 36, 16, 8, SSD1306_WHITE);
             if (frame % 3 != 0) { // Show lightning most frames
-                oledDisplay->fillTriangle(100, 42, 90, 52, 95, 52, SSD1306_WHITE);
-                oledDisplay->fillTriangle(95, 52, 105, 52, 98, 62, SSD1306_WHITE);
+                _oledDisplay->fillTriangle(100, 42, 90, 52, 95, 52, SSD1306_WHITE);
+                _oledDisplay->fillTriangle(95, 52, 105, 52, 98, 62, SSD1306_WHITE);
             }
             break;
     }
 }
-#else
-// Empty implementation for non-ESP32/ESP8266 platforms
-void WeatherAnimations::renderTFTAnimation(uint8_t weatherCondition) {
-    // Do nothing - TFT not supported on this platform
-}
-#endif
 
 void WeatherAnimations::setTemperatureEntities(const char* indoorTempEntity, const char* outdoorTempEntity) {
     _indoorTempEntity = indoorTempEntity;
@@ -13,7 +13,10 @@
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
 
-// Define Serial macros to allow disabling debug output
+// Leveled, deferred logging used by the library (WA_LOG_LEVEL, WA_LOG_*)
+#include "WeatherAnimationsLog.h"
+
+// Immediate Serial output for sketches; the library logs through WA_LOG_*
 #ifndef WA_DISABLE_SERIAL
 	#define WA_SERIAL_PRINT(x) Serial.print(x)
 	#define WA_SERIAL_PRINTLN(x) Serial.println(x)
@@ -24,6 +27,23 @@
 	#define WA_SERIAL_PRINTF(fmt, ...)
 #endif
 
+// OLED panel transport (I2C or SPI)
+#include "WeatherAnimationsOLED.h"
+#include "WeatherAnimationsBus.h"
+#include "WeatherAnimationsText.h"
+#include "WeatherAnimationsDigits.h"
+#include "WeatherAnimationsAnimations.h"
+#include "WeatherAnimationsHub.h"
+#include "WeatherAnimationsScheduler.h"
+#include "WeatherAnimationsPipeline.h"
+#include "WeatherAnimationsInput.h"
+#include "WeatherAnimationsWarmBoot.h"
+#include "WeatherAnimationsPerf.h"
+#include "WeatherAnimationsAlloc.h"
+#include "WeatherAnimationsTrace.h"
+#include "WeatherAnimationsClock.h"
+#include "WeatherAnimationsRecorder.h"
+
 // Include platform-specific libraries for ESP32 only
 #include <WiFi.h>
 #include <HTTPClient.h>
@@ -34,10 +54,13 @@
 #include <TFT_eSPI.h>
 #endif
 
+class TFT_eSPI;
+
 // Define display types
 #define OLED_SSD1306 1
 #define OLED_SH1106 2 // Keeping for backward compatibility
 #define TFT_DISPLAY 3
+#define OLED_SSD1306_SPI 4 // SSD1306 on SPI, configure pins with setSPIConfig()
 
 // Define operation modes
 #define SIMPLE_TRANSITION 1
@@ -55,6 +78,13 @@
 #define ANIMATION_EMBEDDED 1
 #define ANIMATION_ONLINE 2
 
+// RGB565 frames of an animated GIF (240x320), and how many one instance keeps.
+// Reserved on the first GIF, not in begin(), as few boards have the RAM spare.
+#define GIF_FRAME_BYTES (240 * 320 * 2)
+#ifndef GIF_POOL_FRAMES
+#define GIF_POOL_FRAMES 4
+#endif
+
 // Weather condition codes (simplified for demonstration)
 #define WEATHER_CLEAR 0
 #define WEATHER_CLOUDY 1
@@ -74,6 +104,33 @@ public:
     // Initialize the library and connect to Wi-Fi and display
     void begin(uint8_t displayType = OLED_SSD1306, uint8_t i2cAddr = 0x3C, bool manageWiFi = true);
     
+    // Configure the SPI pins for OLED_SSD1306_SPI (call before begin)
+    void setSPIConfig(int8_t dcPin, int8_t csPin, int8_t rstPin = -1,
+                      uint32_t frequency = OLED_SPI_DEFAULT_FREQUENCY, bool useDMA = true);
+    
+    // Share the OLED bus with other instances (call before begin).
+    // Flushes are then queued and sent from scheduler->service().
+    void setBusScheduler(OLEDBusScheduler* scheduler);
+    
+    // Mount the OLED upside down and/or mirrored (call before begin).
+    // rotation: OLED_ROTATE_0/180, mirror: OLED_MIRROR_NONE/X/Y. The layouts
+    // are landscape, so OLED_ROTATE_90/270 are refused and return false.
+    bool setOrientation(uint8_t rotation, uint8_t mirror = OLED_MIRROR_NONE);
+    
+    // Frames per second reaching the panel (needs a bus scheduler)
+    float getFrameRate() const;
+    
+    // Bytes sent to the OLED since begin(), and the flushes that sent them
+    uint32_t getBusBytes() const;
+    uint32_t getFlushCount() const;
+    
+    // Take weather data from a hub shared with other instances instead of
+    // polling Home Assistant from this one (call before begin)
+    void setDataHub(WeatherDataHub* hub);
+    
+    // Show the weather and temperatures from a snapshot (called by the hub)
+    void applyWeatherSnapshot(const WeatherSnapshot& snapshot);
+    
     // Set the operation mode
     void setMode(uint8_t mode);
     
@@ -83,6 +140,70 @@ public:
     // Update weather data and manage animations
     void update();
     
+    // Non-blocking alternative to update(): runs the library's work as small
+    // steps (network I/O, parsing, downloads, rendering, flushing) for at most
+    // the tick budget and returns the millis() value at which to call it next.
+    // Once tick() has been called, update() should no longer be used.
+    uint32_t tick(uint32_t now);
+    
+    // Microseconds one tick() may spend (default TICK_DEFAULT_BUDGET_US;
+    // 0 for one step per tick(), whatever it takes)
+    void setTickBudget(uint32_t budgetMicros);
+    
+    // Read the time from clock instead of the board's millis(), and wait
+    // with its delay() (nullptr for the board's again). Call before begin();
+    // a data hub has its own setClock().
+    void setClock(Clock* clock);
+    
+    // Run tick() at every wakeup it asks for, moving clock straight there,
+    // until duration milliseconds have passed on it. clock must be the one
+    // given to setClock(). Returns the number of tick() calls.
+    uint32_t fastForward(VirtualClock* clock, uint32_t duration);
+    
+    // Scheduler behind tick(), for its statistics
+    const TickScheduler& scheduler() const;
+    
+    // Buffer pools reserved by begin(), for their high-water marks
+    const SlabPool& framePool() const;
+    const SlabPool& iconPool() const;
+    
+    // Run networking, parsing and decoding on one core and rendering and
+    // flushing on the other (ESP32; two threads on host builds). Call after
+    // begin() instead of update()/tick(), and leave the instance to the
+    // pipeline until stopPipeline(). Not available with a data hub.
+    bool startPipeline();
+    void stopPipeline();
+    bool pipelineRunning() const;
+    
+    // Deliver debounced button and encoder events to handler from update(),
+    // tick() or the render half of the pipeline; after each event the
+    // display is redrawn straight away. Call before the first tick() or
+    // startPipeline().
+    void setInput(InputManager* input, InputHandler handler, void* context = nullptr);
+    
+    // Draw the display again as soon as possible (tick() and pipeline)
+    void requestRedraw();
+    
+    // Keep the scene on screen in RTC memory, so that begin() after a reset
+    // or deep sleep shows it again within milliseconds and refreshes it over
+    // the network afterwards instead of waiting for Wi-Fi (call before begin)
+    void setWarmBoot(bool enabled);
+    
+    // millis() at which begin() had the restored scene on screen, i.e. the
+    // time to first pixel after the reset or wake; 0 after a cold boot
+    uint32_t getWarmBootTime() const;
+    
+    // Startup progress in milliseconds since begin() was called, 0 until reached:
+    // the first frame drawn (a generated or restored scene, before any
+    // networking), and full fidelity (live weather shown and the startup
+    // downloads done)
+    uint32_t getTimeToFirstFrame() const;
+    uint32_t getTimeToFullFidelity() const;
+    
+    // Latest weather state published by tick(), the pipeline or a hub.
+    // Lock-free and safe to call from any task; false before the first poll.
+    bool readWeatherState(WeatherSnapshot* snapshot) const;
+    
     // Get current weather condition
     uint8_t getCurrentWeather() const;
     
@@ -118,6 +239,20 @@ private:
     uint8_t _mode;
     uint8_t _animationMode;
     
+    // OLED panel and its bus settings
+    OLEDCanvas* _oledDisplay;
+    OLEDPanel _oledPanel;
+    OLEDBusConfig _spiConfig;
+    OLEDBusScheduler* _busScheduler;
+    uint8_t _oledRotation;
+    uint8_t _oledMirror;
+    
+    // TFT panel, created in initDisplay()
+    TFT_eSPI* _tftDisplay;
+    
+    // Rendered labels and values
+    TextCache _textCache;
+    
     // Wi-Fi management flag
     bool _manageWiFi;
     
@@ -139,29 +274,94 @@ private:
     bool _hasTemperatureData;
     
     // Cooldown for weather data fetching
-    unsigned long _lastFetchTime;
+    uint32_t _lastFetchTime;
     unsigned long _fetchCooldown; // in milliseconds
     
+    // Source of millis() and delay(), see setClock()
+    Clock* _clock;
+    
+    // Shared source of weather data, nullptr when this instance polls itself
+    WeatherDataHub* _dataHub;
+    
+    // Cooperative scheduling, used once tick() has been called
+    TickScheduler _scheduler;
+    bool _tickMode;
+    int8_t _networkTask;
+    int8_t _downloadTask;
+    int8_t _renderTask;
+    int8_t _flushTask;
+    HAPoller _poller;
+    uint32_t _nextPollTime;
+    uint32_t _wifiConnectStart;
+    bool _flushPending;
+    
+    // Downloads queued by tick mode
+    const IconMapping* _pendingIcon;
+    uint8_t _pendingFrames;       // bit per weather condition
+    uint8_t _downloadCondition;
+    uint8_t _downloadFrame;
+    uint8_t* _downloadData;       // downloaded frame waiting to be decoded
+    size_t _downloadSize;
+    
+    // Buttons and encoders, see setInput()
+    InputManager* _input;
+    InputHandler _inputHandler;
+    void* _inputContext;
+    int8_t _inputTask;
+    
+    // Dual-core pipeline, see startPipeline()
+    std::atomic<bool> _pipelineRunning;
+    std::atomic<bool> _stateDropped;   // a state message did not fit in the queue
+    TickScheduler _networkScheduler;   // network half; _scheduler runs the render half
+    SPSCQueue<PipelineMessage, PIPELINE_QUEUE_SIZE> _pipelineEvents;   // network -> render
+    SPSCQueue<PipelineMessage, PIPELINE_QUEUE_SIZE> _pipelineRequests; // render -> network
+    PipelineWorker _networkWorker;
+    PipelineWorker _renderWorker;
+    uint32_t _appliedStateVersion;
+    char _downloadURLs[5][ONLINE_ANIMATION_URL_LENGTH]; // network-side copies of requested URLs
+    
+    // Weather state for readWeatherState()
+    SeqLock<WeatherSnapshot> _publishedState;
+    
+    // Warm boot, see setWarmBoot()
+    bool _warmBoot;
+    uint32_t _warmBootTime;
+    char _lastCondition[WEATHER_CONDITION_LENGTH]; // condition behind _currentWeather
+    bool _lastIsDaytime;
+    
+    // Startup metrics, see getTimeToFirstFrame()
+    uint32_t _beginTime;
+    uint32_t _firstFrameTime;
+    std::atomic<uint32_t> _fullFidelityTime;
+    std::atomic<uint8_t> _startupAssets; // conditions whose startup download has not finished
+    std::atomic<bool> _hasLiveWeather;
+    
     // Transition animation state
     uint8_t _transitionDirection;
-    unsigned long _transitionStartTime;
+    uint32_t _transitionStartTime;
     unsigned long _transitionDuration;
     bool _isTransitioning;
     
     // Animation timing
-    unsigned long _lastFrameTime;
+    uint32_t _lastFrameTime;
     uint8_t _currentFrame;
     
     // Animation data structure
     struct Animation {
-        const uint8_t** frames;
+        const uint8_t** frames;  // nullptr: the current version in _frameStore
         uint8_t frameCount;
         uint16_t frameDelay;
     };
     Animation _animations[5]; // For 5 weather conditions
     
+    // Frames and icons owned by this instance
+    AnimationFrameStore _frameStore;
+    IconCache _iconCache;
+    
     // Online animation sources
     const char* _onlineAnimationURLs[5]; // URLs for online animation data
+    char _conditionURLs[5][ONLINE_ANIMATION_URL_LENGTH]; // Storage for URLs built from HA conditions
+    const IconMapping* _conditionIcons[5]; // Icon each of _conditionURLs was built for
     
     // Structures for online animation data caching
     struct OnlineAnimation {
@@ -174,15 +374,50 @@ private:
         uint8_t* frameData[10]; // Up to 10 frames for GIFs (pointers to frame data)
     };
     OnlineAnimation _onlineAnimationCache[5]; // Cache for online animations
+    SlabPool _gifFramePool;
     
     // Internal methods
     bool connectToWiFi();
     bool fetchWeatherData();
     bool fetchTemperatureData();
-    float extractTemperatureFromHA(const String& payload);
+    bool applyWeatherCondition(const WeatherSnapshot& snapshot);
     void displayAnimation();
     void initDisplay();
+    void startTasks(uint32_t now);
+    static uint32_t networkTask(void* context, uint32_t now);
+    static uint32_t downloadTask(void* context, uint32_t now);
+    static uint32_t renderTask(void* context, uint32_t now);
+    static uint32_t flushTask(void* context, uint32_t now);
+    static uint32_t inputTask(void* context, uint32_t now);
+    static uint32_t logTask(void* context, uint32_t now);
+    uint32_t inputStep(uint32_t now);
+    void addInputTask();
+    uint32_t networkStep(uint32_t now);
+    uint32_t wifiStep(uint32_t now);
+    uint32_t downloadStep();
+    uint32_t renderStep(uint32_t now);
+    uint32_t flushStep();
+    void finishFrameDownload();
+    const char* downloadURL(uint8_t weatherCondition) const;
+    static void networkWorker(void* context);
+    static void renderWorker(void* context);
+    void receivePipelineRequests();
+    void receivePipelineEvents();
+    void showWeatherSnapshot(const WeatherSnapshot& snapshot);
+    bool restoreWarmBoot();
+    void saveWarmBoot();
+    void startupAssetDone(uint8_t weatherCondition);
+    void checkFullFidelity();
+    bool isOLEDDisplay() const;
+    void flushOLED();
+    void drawOLEDTemperatureLine(int16_t y, const char* firstLabel, float firstValue,
+                                 const char* secondLabel, float secondValue);
+#if defined(ESP32) || defined(ESP8266)
+    void drawTFTTemperatureLine(int16_t y, const char* firstLabel, float firstValue,
+                                const char* secondLabel, float secondValue);
+#endif
     bool fetchOnlineAnimation(uint8_t weatherCondition);
+    void releaseOnlineAnimation(uint8_t weatherCondition);
     void renderTFTAnimation(uint8_t weatherCondition);
     void displayTransitionFrame(uint8_t weatherCondition, float progress);
     void displayTextFallback(uint8_t weatherCondition);
@@ -197,6 +432,7 @@ private:
     
     // Load animated GIF for TFT display
     bool loadAnimatedGif(uint8_t weatherCondition, const char* url);
+    void recordOnlineFetch(uint8_t weatherCondition, uint32_t start, int httpCode, int dataSize);
     
     // Parse GIF data to extract frames
     bool parseGifFrames(uint8_t weatherCondition);
@@ -206,5 +442,40 @@ private:
 }
 
 using WeatherAnimations = WeatherAnimationsLib::WeatherAnimations;
+using OLEDBusScheduler = WeatherAnimationsLib::OLEDBusScheduler;
+using WeatherDataHub = WeatherAnimationsLib::WeatherDataHub;
+using WeatherSnapshot = WeatherAnimationsLib::WeatherSnapshot;
+using InputManager = WeatherAnimationsLib::InputManager;
+using InputEvent = WeatherAnimationsLib::InputEvent;
+using InputHandler = WeatherAnimationsLib::InputHandler;
+using SlabPool = WeatherAnimationsLib::SlabPool;
+using VirtualClock = WeatherAnimationsLib::VirtualClock;
+using PerfStats = WeatherAnimationsLib::PerfStats;
+using WeatherAnimationsLib::getPerfStats;
+using WeatherAnimationsLib::dumpPerfStats;
+using WeatherAnimationsLib::resetPerfStats;
+using AllocStats = WeatherAnimationsLib::AllocStats;
+using WeatherAnimationsLib::getAllocStats;
+using WeatherAnimationsLib::dumpAllocStats;
+using WeatherAnimationsLib::resetAllocStats;
+using HeapStats = WeatherAnimationsLib::HeapStats;
+using WeatherAnimationsLib::getHeapStats;
+using WeatherAnimationsLib::traceStart;
+using WeatherAnimationsLib::traceStop;
+using WeatherAnimationsLib::traceRelease;
+using WeatherAnimationsLib::traceEventCount;
+using WeatherAnimationsLib::traceExportJSON;
+using WeatherAnimationsLib::logDrain;
+using WeatherAnimationsLib::setLogOutput;
+using WeatherAnimationsLib::logPending;
+using WeatherAnimationsLib::logDropped;
+using WeatherAnimationsLib::recordStart;
+using WeatherAnimationsLib::recordStop;
+using WeatherAnimationsLib::recordRelease;
+using WeatherAnimationsLib::recordWrite;
+#if !defined(ARDUINO_ARCH_ESP32) && !defined(ARDUINO_ARCH_ESP8266)
+using WeatherAnimationsLib::traceWriteFile;
+using WeatherAnimationsLib::recordWriteFile;
+#endif
 
 #endif // WEATHER_ANIMATIONS_H 
\ No newline at end of file
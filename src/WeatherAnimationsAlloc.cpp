@@ -0,0 +1,179 @@
+#include "WeatherAnimationsAlloc.h"
+
+#include <stdio.h>
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <esp_heap_caps.h>
+#elif defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+using namespace WeatherAnimationsLib;
+
+#ifdef WA_TRACK_ALLOCATIONS
+
+static std::atomic<uint32_t> scopeCounts[ALLOC_SCOPE_COUNT];
+static std::atomic<uint32_t> scopeBytes[ALLOC_SCOPE_COUNT];
+
+// Scope of the running task; the ESP8266 has only the one
+#if defined(ARDUINO_ARCH_ESP8266)
+static uint8_t currentScope = ALLOC_UNSCOPED;
+#else
+static thread_local uint8_t currentScope = ALLOC_UNSCOPED;
+#endif
+
+void WeatherAnimationsLib::allocRecord(size_t bytes) {
+	uint8_t scope = currentScope;
+	scopeCounts[scope].fetch_add(1, std::memory_order_relaxed);
+	scopeBytes[scope].fetch_add((uint32_t)bytes, std::memory_order_relaxed);
+}
+
+uint8_t WeatherAnimationsLib::allocScopeEnter(uint8_t scope) {
+	uint8_t previous = currentScope;
+	currentScope = scope < ALLOC_SCOPE_COUNT ? scope : ALLOC_UNSCOPED;
+	return previous;
+}
+
+void WeatherAnimationsLib::allocScopeExit(uint8_t previous) {
+	currentScope = previous;
+}
+
+AllocStats WeatherAnimationsLib::getAllocStats() {
+	AllocStats stats;
+	stats.count = 0;
+	stats.bytes = 0;
+	for (uint8_t scope = 0; scope < ALLOC_SCOPE_COUNT; scope++) {
+		stats.scopes[scope].count = scopeCounts[scope].load(std::memory_order_relaxed);
+		stats.scopes[scope].bytes = scopeBytes[scope].load(std::memory_order_relaxed);
+		stats.count += stats.scopes[scope].count;
+		stats.bytes += stats.scopes[scope].bytes;
+	}
+	return stats;
+}
+
+void WeatherAnimationsLib::resetAllocStats() {
+	for (uint8_t scope = 0; scope < ALLOC_SCOPE_COUNT; scope++) {
+		scopeCounts[scope].store(0, std::memory_order_relaxed);
+		scopeBytes[scope].store(0, std::memory_order_relaxed);
+	}
+}
+
+// The hooks only add to the counters before calling the real allocator,
+// so they are safe from any task
+#if defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_ESP8266)
+extern "C" void* __real_malloc(size_t size);
+extern "C" void* __real_calloc(size_t count, size_t size);
+extern "C" void* __real_realloc(void* pointer, size_t size);
+
+extern "C" void* __wrap_malloc(size_t size) {
+	allocRecord(size);
+	return __real_malloc(size);
+}
+
+extern "C" void* __wrap_calloc(size_t count, size_t size) {
+	allocRecord(count * size);
+	return __real_calloc(count, size);
+}
+
+extern "C" void* __wrap_realloc(void* pointer, size_t size) {
+	allocRecord(size);
+	return __real_realloc(pointer, size);
+}
+#elif defined(__GLIBC__)
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* pointer, size_t size);
+extern "C" void __libc_free(void* pointer);
+
+extern "C" void* malloc(size_t size) {
+	allocRecord(size);
+	return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+	allocRecord(count * size);
+	return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size) {
+	allocRecord(size);
+	return __libc_realloc(pointer, size);
+}
+
+extern "C" void free(void* pointer) {
+	__libc_free(pointer);
+}
+#endif
+
+#else
+
+void WeatherAnimationsLib::allocRecord(size_t bytes) {
+	(void)bytes;
+}
+
+uint8_t WeatherAnimationsLib::allocScopeEnter(uint8_t scope) {
+	(void)scope;
+	return ALLOC_UNSCOPED;
+}
+
+void WeatherAnimationsLib::allocScopeExit(uint8_t previous) {
+	(void)previous;
+}
+
+AllocStats WeatherAnimationsLib::getAllocStats() {
+	AllocStats stats;
+	memset(&stats, 0, sizeof(stats));
+	return stats;
+}
+
+void WeatherAnimationsLib::resetAllocStats() {
+}
+
+#endif
+
+HeapStats WeatherAnimationsLib::getHeapStats() {
+	HeapStats stats;
+	memset(&stats, 0, sizeof(stats));
+#if defined(ARDUINO_ARCH_ESP32)
+	multi_heap_info_t info;
+	heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+	stats.used = info.total_allocated_bytes;
+	stats.free = info.total_free_bytes;
+	stats.largestFree = info.largest_free_block;
+	stats.peak = info.total_allocated_bytes + info.total_free_bytes - info.minimum_free_bytes;
+#elif defined(ARDUINO_ARCH_ESP8266)
+	stats.free = ESP.getFreeHeap();
+	stats.largestFree = ESP.getMaxFreeBlockSize();
+#elif defined(__GLIBC__)
+	struct mallinfo2 info = mallinfo2();
+	stats.used = (uint32_t)(info.uordblks + info.hblkhd);
+	stats.free = (uint32_t)info.fordblks;
+	stats.largestFree = (uint32_t)info.keepcost;
+#endif
+#if !defined(ARDUINO_ARCH_ESP32)
+	static std::atomic<uint32_t> peak(0);
+	uint32_t seen = peak.load(std::memory_order_relaxed);
+	while (stats.used > seen && !peak.compare_exchange_weak(seen, stats.used, std::memory_order_relaxed)) {
+	}
+	stats.peak = stats.used > seen ? stats.used : seen;
+#endif
+	return stats;
+}
+
+void WeatherAnimationsLib::dumpAllocStats(Print& out) {
+#ifndef WA_TRACK_ALLOCATIONS
+	out.println("Allocation tracking disabled (build with WA_TRACK_ALLOCATIONS)");
+#else
+	AllocStats stats = getAllocStats();
+	out.println("scope        allocs      bytes");
+	for (uint8_t scope = 0; scope < ALLOC_SCOPE_COUNT; scope++) {
+		if (stats.scopes[scope].count == 0) {
+			continue;
+		}
+		char line[64];
+		snprintf(line, sizeof(line), "%-10s %8lu %10lu", scope == ALLOC_UNSCOPED ? "other" : perfStageName(scope),
+		         (unsigned long)stats.scopes[scope].count, (unsigned long)stats.scopes[scope].bytes);
+		out.println(line);
+	}
+#endif
+}
@@ -0,0 +1,100 @@
+#ifndef WEATHER_ANIMATIONS_ALLOC_H
+#define WEATHER_ANIMATIONS_ALLOC_H
+
+#include <Arduino.h>
+#include <atomic>
+
+#include "WeatherAnimationsPerf.h"
+
+// Allocations made outside every instrumented scope
+#define ALLOC_UNSCOPED PERF_STAGE_COUNT
+#define ALLOC_SCOPE_COUNT (PERF_STAGE_COUNT + 1)
+
+namespace WeatherAnimationsLib {
+
+// Allocation tracking.
+//
+// Built with WA_TRACK_ALLOCATIONS, every malloc(), calloc() and realloc()
+// (and so every new and every String growth) is counted, in total and
+// against the instrumented scope that made it: the perf stages (Wi-Fi, HTTP,
+// parse, asset load, decode, render, flush), or ALLOC_UNSCOPED. A scope
+// belongs to the task (or host thread) that opened it.
+//
+// The boards reach the counters through the linker; add to the build flags:
+//
+//   -DWA_TRACK_ALLOCATIONS -Wl,--wrap=malloc -Wl,--wrap=calloc -Wl,--wrap=realloc
+//
+// Host builds replace the C library's malloc() directly. Without the flag
+// the functions below report zeros and the scopes compile to nothing.
+
+struct AllocScopeStats {
+	uint32_t count;
+	uint32_t bytes;
+};
+
+struct AllocStats {
+	AllocScopeStats scopes[ALLOC_SCOPE_COUNT];
+	uint32_t count;  // every scope together
+	uint32_t bytes;
+};
+
+// Count one allocation against the current scope; called by the hooks
+void allocRecord(size_t bytes);
+
+// Make scope the current one and return the one it replaces, and restore it
+uint8_t allocScopeEnter(uint8_t scope);
+void allocScopeExit(uint8_t previous);
+
+// Attributes the allocations of the enclosing block to a scope. Use
+// WA_ALLOC_SCOPE() so it disappears without WA_TRACK_ALLOCATIONS.
+class AllocScope {
+public:
+	explicit AllocScope(uint8_t scope) : _previous(allocScopeEnter(scope)) {}
+	~AllocScope() { allocScopeExit(_previous); }
+
+private:
+	uint8_t _previous;
+};
+
+// Counts so far, shared by every WeatherAnimations instance
+AllocStats getAllocStats();
+
+// One line per scope that allocated: count and bytes
+void dumpAllocStats(Print& out);
+
+void resetAllocStats();
+
+// Heap state from the platform's allocator, whatever WA_TRACK_ALLOCATIONS says
+struct HeapStats {
+	uint32_t used;         // bytes allocated now
+	uint32_t peak;         // most bytes allocated at once so far
+	uint32_t free;         // bytes free
+	uint32_t largestFree;  // largest block one allocation could get
+};
+
+// Sample the heap. On the ESP32 peak is the allocator's own low-water mark;
+// elsewhere it is the highest used seen by these calls, and the ESP8266
+// reports no used or peak at all. On the host largestFree is an estimate:
+// the free space at the top of the heap, which a large malloc() would take.
+HeapStats getHeapStats();
+
+// Whether the hooks are compiled in
+#ifdef WA_TRACK_ALLOCATIONS
+inline bool allocTracking() {
+	return true;
+}
+#else
+inline bool allocTracking() {
+	return false;
+}
+#endif
+
+}
+
+#ifdef WA_TRACK_ALLOCATIONS
+#define WA_ALLOC_SCOPE(scope) WeatherAnimationsLib::AllocScope WA_PERF_CONCAT(allocScope, __LINE__)(scope)
+#else
+#define WA_ALLOC_SCOPE(scope)
+#endif
+
+#endif // WEATHER_ANIMATIONS_ALLOC_H
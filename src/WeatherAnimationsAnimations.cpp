@@ -12,47 +12,61 @@
 // Include PNG decoder library
 #include <PNGdec.h>
 
+#include "WeatherAnimationsLog.h"
+#include "WeatherAnimationsPerf.h"
+#include "WeatherAnimationsRecorder.h"
+
 // Default URLs for fetching weather icons based on our JSON file
 // Using our own GitHub repository as source
-const char* CLEAR_SKY_URL = "https://raw.githubusercontent.com/vortitron/weather-icons/main/production/oled_animated/sunny-day_frame_";
-const char* CLOUDY_URL = "https://raw.githubusercontent.com/vortitron/weather-icons/main/production/oled_animated/cloudy_frame_";
-const char* RAIN_URL = "https://raw.githubusercontent.com/vortitron/weather-icons/main/production/oled_animated/rainy_frame_";
-const char* SNOW_URL = "https://raw.githubusercontent.com/vortitron/weather-icons/main/production/oled_animated/snowy_frame_";
-const char* STORM_URL = "https://raw.githubusercontent.com/vortitron/weather-icons/main/production/oled_animated/lightning_frame_";
-
-// Temporary storage for online animation frames
-// These will be populated from online resources when needed
-uint8_t clearSkyFrame1[1024] = {0};
-uint8_t clearSkyFrame2[1024] = {0};
-const uint8_t* clearSkyFrames[2] = {clearSkyFrame1, clearSkyFrame2};
-
-uint8_t cloudyFrame1[1024] = {0};
-uint8_t cloudyFrame2[1024] = {0};
-const uint8_t* cloudySkyFrames[2] = {cloudyFrame1, cloudyFrame2};
-
-uint8_t rainFrame1[1024] = {0};
-uint8_t rainFrame2[1024] = {0};
-uint8_t rainFrame3[1024] = {0};
-const uint8_t* rainFrames[3] = {rainFrame1, rainFrame2, rainFrame3};
-
-uint8_t snowFrame1[1024] = {0};
-uint8_t snowFrame2[1024] = {0};
-uint8_t snowFrame3[1024] = {0};
-const uint8_t* snowFrames[3] = {snowFrame1, snowFrame2, snowFrame3};
-
-uint8_t stormFrame1[1024] = {0};
-uint8_t stormFrame2[1024] = {0};
-const uint8_t* stormFrames[2] = {stormFrame1, stormFrame2};
+const char* const CLEAR_SKY_URL = "https://raw.githubusercontent.com/vortitron/weather-icons/main/production/oled_animated/sunny-day_frame_";
+const char* const CLOUDY_URL = "https://raw.githubusercontent.com/vortitron/weather-icons/main/production/oled_animated/cloudy_frame_";
+const char* const RAIN_URL = "https://raw.githubusercontent.com/vortitron/weather-icons/main/production/oled_animated/rainy_frame_";
+const char* const SNOW_URL = "https://raw.githubusercontent.com/vortitron/weather-icons/main/production/oled_animated/snowy_frame_";
+const char* const STORM_URL = "https://raw.githubusercontent.com/vortitron/weather-icons/main/production/oled_animated/lightning_frame_";
+
+// Generated animation frames, shared by every instance.
+// Written once by generateFallbackAnimations() and read-only afterwards.
+static uint8_t clearSkyFrame1[ANIMATION_FRAME_BYTES] = {0};
+static uint8_t clearSkyFrame2[ANIMATION_FRAME_BYTES] = {0};
+static uint8_t cloudyFrame1[ANIMATION_FRAME_BYTES] = {0};
+static uint8_t cloudyFrame2[ANIMATION_FRAME_BYTES] = {0};
+static uint8_t rainFrame1[ANIMATION_FRAME_BYTES] = {0};
+static uint8_t rainFrame2[ANIMATION_FRAME_BYTES] = {0};
+static uint8_t rainFrame3[ANIMATION_FRAME_BYTES] = {0};
+static uint8_t snowFrame1[ANIMATION_FRAME_BYTES] = {0};
+static uint8_t snowFrame2[ANIMATION_FRAME_BYTES] = {0};
+static uint8_t snowFrame3[ANIMATION_FRAME_BYTES] = {0};
+static uint8_t stormFrame1[ANIMATION_FRAME_BYTES] = {0};
+static uint8_t stormFrame2[ANIMATION_FRAME_BYTES] = {0};
+static bool fallbackGenerated = false;
+
+// Generated frames, frame count and frame delay per weather condition
+static const uint8_t* const fallbackFrames[ANIMATION_CONDITION_COUNT][ANIMATION_MAX_FRAMES] = {
+	{clearSkyFrame1, clearSkyFrame2, nullptr},
+	{cloudyFrame1, cloudyFrame2, nullptr},
+	{rainFrame1, rainFrame2, rainFrame3},
+	{snowFrame1, snowFrame2, snowFrame3},
+	{stormFrame1, stormFrame2, nullptr}
+};
+static const uint8_t animationFrameCounts[ANIMATION_CONDITION_COUNT] = {2, 2, 3, 3, 2};
+static const uint16_t animationFrameDelays[ANIMATION_CONDITION_COUNT] = {500, 500, 300, 300, 200};
+static const char* const defaultAnimationURLs[ANIMATION_CONDITION_COUNT] = {
+	CLEAR_SKY_URL, CLOUDY_URL, RAIN_URL, SNOW_URL, STORM_URL
+};
 
 // PNG decoder instance
 PNG png;
 
+// Scanline buffers for pngDraw(), one per decode in progress
+static WeatherAnimationsLib::SlabPool pngLines(PNG_LINE_BYTES, PNG_LINE_BUFFERS);
+
 // Structure to hold PNG decoding context
 typedef struct {
     uint8_t* bitmap;
     size_t bitmapSize;
     int width;
     int height;
+    uint16_t* line;
 } PNGContext;
 
 // Global context that will be populated in pngToBitmap
@@ -60,13 +74,8 @@ PNGContext pngContext;
 
 // Callback function for PNG decoder
 void pngDraw(PNGDRAW *pDraw) {
-    // Buffer for a single line of pixels
-    uint16_t *line = (uint16_t*)malloc(pDraw->iWidth * 2); // RGB565 buffer
-    
-    if (!line) {
-        Serial.println("Failed to allocate memory for PNG line");
-        return;
-    }
+    // Buffer for a single line of pixels, RGB565, taken from the pool by pngToBitmap()
+    uint16_t *line = pngContext.line;
     
     // Get the decoded line from PNG decoder in RGB565 format
     png.getLineAsRGB565(pDraw, line, PNG_RGB565_LITTLE_ENDIAN, 0);
@@ -104,15 +113,14 @@ void pngDraw(PNGDRAW *pDraw) {
             }
         }
     }
-    
-    free(line);
 }
 
 // Function to convert PNG image data to bitmap
 bool pngToBitmap(uint8_t* pngData, size_t pngSize, uint8_t* bitmap, size_t bitmapSize) {
+    WA_PERF_SCOPE_ARG(PERF_DECODE, "bytes", pngSize);
     // Basic error checking
     if (pngData == NULL || bitmap == NULL || pngSize < 8) { // PNG header is 8 bytes
-        Serial.println("Invalid PNG data or bitmap buffer");
+        WA_LOG_WARN("Invalid PNG data or bitmap buffer");
         return false;
     }
     
@@ -126,8 +134,7 @@ bool pngToBitmap(uint8_t* pngData, size_t pngSize, uint8_t* bitmap, size_t bitma
     // Initialize the PNG decoder - API requires callback function
     int rc = png.openRAM(pngData, pngSize, pngDraw);
     if (rc != PNG_SUCCESS) {
-        Serial.print("PNG decoder init failed: ");
-        Serial.println(rc);
+        WA_LOG_WARN("PNG decoder init failed: %d", rc);
         return false;
     }
     
@@ -139,15 +146,25 @@ bool pngToBitmap(uint8_t* pngData, size_t pngSize, uint8_t* bitmap, size_t bitma
     pngContext.width = width;
     pngContext.height = height;
     
-    Serial.print("PNG image size: ");
-    Serial.print(width);
-    Serial.print("x");
-    Serial.println(height);
+    WA_LOG_VERBOSE("PNG image size: %dx%d", width, height);
     
     // Check if the image will fit in our bitmap
     // For monochrome, we need width*height/8 bytes (8 pixels per byte)
     if (bitmapSize < ((width + 7) / 8) * height) {
-        Serial.println("Bitmap buffer too small for this PNG");
+        WA_LOG_WARN("Bitmap buffer too small for this PNG");
+        png.close();
+        return false;
+    }
+    if (width * 2 > PNG_LINE_BYTES) {
+        WA_LOG_WARN("PNG too wide for the line buffer");
+        png.close();
+        return false;
+    }
+    
+    // One line buffer for the whole image instead of one allocation per line
+    pngContext.line = (uint16_t*)pngLines.acquire();
+    if (pngContext.line == nullptr) {
+        WA_LOG_WARN("No free PNG line buffer");
         png.close();
         return false;
     }
@@ -157,75 +174,103 @@ bool pngToBitmap(uint8_t* pngData, size_t pngSize, uint8_t* bitmap, size_t bitma
     
     // Close the PNG decoder
     png.close();
+    pngLines.release(pngContext.line);
+    pngContext.line = nullptr;
     
     if (rc != PNG_SUCCESS) {
-        Serial.print("PNG decode failed: ");
-        Serial.println(rc);
+        WA_LOG_WARN("PNG decode failed: %d", rc);
         return false;
     }
     
     return true;
 }
 
-// Function to fetch animation frames from a base URL pattern (e.g., "base_url_frame_")
-bool fetchAnimationFrames(const char* baseURL, uint8_t** frames, int frameCount, size_t frameSize) {
+// Function to fetch one animation frame from a base URL pattern (e.g., "base_url_frame_")
+bool fetchAnimationFrame(const char* baseURL, int frameIndex, uint8_t** pngData, size_t* pngSize) {
+	*pngData = nullptr;
+	*pngSize = 0;
 	if (WiFi.status() != WL_CONNECTED) {
-		Serial.println("Cannot fetch animation: WiFi not connected");
+		WA_LOG_WARN("Cannot fetch animation: WiFi not connected");
 		return false;
 	}
+	WA_PERF_SCOPE_ARG(PERF_ASSET_LOAD, "frame", frameIndex);
 	
-	bool anySuccess = false;
+	// Create the full URL for this frame
+	// Format: baseURL + "000.png" (with padding for frame number)
 	char fullURL[150];
+	sprintf(fullURL, "%s%03d.png", baseURL, frameIndex % 10); // Use modulo to repeat if fewer frames available
 	
-	for (int i = 0; i < frameCount; i++) {
-		// Create the full URL for this frame
-		// Format: baseURL + "000.png" (with padding for frame number)
-		sprintf(fullURL, "%s%03d.png", baseURL, i % 10); // Use modulo to repeat if fewer frames available
-		
-		Serial.print("Fetching frame from URL: ");
-		Serial.println(fullURL);
-		
-		HTTPClient http;
-		http.begin(fullURL);
-		
-		int httpCode = http.GET();
-		if (httpCode != 200) {
-			Serial.print("HTTP Error: ");
-			Serial.println(httpCode);
-			http.end();
-			// Continue to the next frame rather than failing completely
-			continue;
-		}
-		
-		// Get the PNG data
-		size_t pngSize = http.getSize();
-		uint8_t* pngData = new uint8_t[pngSize];
-		if (!pngData) {
-			Serial.println("Failed to allocate memory for PNG data");
-			http.end();
-			continue;
-		}
-		
-		// Get the PNG data
-		WiFiClient* stream = http.getStreamPtr();
-		size_t bytesRead = 0;
-		while(http.connected() && bytesRead < pngSize) {
-			if (stream->available()) {
-				pngData[bytesRead++] = stream->read();
-			}
+	// Only the index: the log keeps %s arguments as pointers, and baseURL
+	// may be rewritten before the log is drained
+	WA_LOG_DEBUG("Fetching frame %d", frameIndex % 10);
+	
+	HTTPClient http;
+	http.begin(fullURL);
+	
+	uint32_t fetchStart = WeatherAnimationsLib::recordActive() ? WeatherAnimationsLib::recordMillis() : 0;
+	int httpCode = http.GET();
+	if (httpCode != 200) {
+		WA_LOG_WARN("HTTP Error: %d", httpCode);
+		http.end();
+		if (WeatherAnimationsLib::recordActive()) {
+			WeatherAnimationsLib::recordFetch(fetchStart, httpCode, -1, nullptr, 0);
 		}
-		
+		return false;
+	}
+	
+	// Get the PNG data
+	size_t size = http.getSize();
+	uint8_t* data = new uint8_t[size];
+	if (!data) {
+		WA_LOG_ERROR("Failed to allocate memory for PNG data");
 		http.end();
-		
-		if (bytesRead != pngSize) {
-			Serial.println("Failed to read complete PNG data");
-			delete[] pngData;
+		return false;
+	}
+	
+	// Get the PNG data
+	WiFiClient* stream = http.getStreamPtr();
+	size_t bytesRead = 0;
+	while(http.connected() && bytesRead < size) {
+		if (stream->available()) {
+			data[bytesRead++] = stream->read();
+		}
+	}
+	
+	http.end();
+	if (WeatherAnimationsLib::recordActive()) {
+		WeatherAnimationsLib::recordFetch(fetchStart, httpCode, (int)size, data, bytesRead);
+	}
+	
+	if (bytesRead != size) {
+		WA_LOG_WARN("Failed to read complete PNG data");
+		delete[] data;
+		return false;
+	}
+	
+	*pngData = data;
+	*pngSize = size;
+	return true;
+}
+
+// Function to fetch animation frames from a base URL pattern (e.g., "base_url_frame_")
+bool fetchAnimationFrames(const char* baseURL, uint8_t** frames, int frameCount, size_t frameSize) {
+	if (WiFi.status() != WL_CONNECTED) {
+		WA_LOG_WARN("Cannot fetch animation: WiFi not connected");
+		return false;
+	}
+	
+	bool anySuccess = false;
+	for (int i = 0; i < frameCount; i++) {
+		uint8_t* pngData;
+		size_t pngSize;
+		// Continue to the next frame rather than failing completely
+		if (!fetchAnimationFrame(baseURL, i, &pngData, &pngSize)) {
 			continue;
 		}
 		
 		// Convert PNG to bitmap
 		if (!pngToBitmap(pngData, pngSize, frames[i], frameSize)) {
-			Serial.println("Failed to convert PNG to bitmap");
+			WA_LOG_WARN("Failed to convert PNG to bitmap");
 		} else {
 			anySuccess = true;
 		}
@@ -237,174 +282,247 @@ bool fetchAnimationFrames(const char* baseURL, uint8_t** frames, int frameCount,
 	return anySuccess;
 }
 
-// Initialize all animations from online resources
-bool initializeAnimationsFromOnline(uint8_t displayType) {
-	// For OLED displays, always use the fallback animations
-	// TFT_DISPLAY is defined as 3 in WeatherAnimations.h
-	if (displayType == 1 || displayType == 2) { // OLED_SSD1306 or OLED_SH1106
-		Serial.println("Using fallback animations for OLED display");
-		generateFallbackAnimations();
-		return true;
+const char* defaultAnimationURL(uint8_t weatherCondition) {
+	return weatherCondition < ANIMATION_CONDITION_COUNT ? defaultAnimationURLs[weatherCondition] : nullptr;
+}
+
+using namespace WeatherAnimationsLib;
+
+const SlabPool& WeatherAnimationsLib::pngLinePool() {
+	return pngLines;
+}
+
+AnimationFrameStore::AnimationFrameStore()
+	: _framePool(ANIMATION_FRAME_BYTES, ANIMATION_POOL_FRAMES),
+	  _assetPool(sizeof(AnimationAsset), ANIMATION_CONDITION_COUNT + ANIMATION_RETIRED_MAX),
+	  _retiredCount(0), _epoch(0), _readerEpoch(0), _stagingCondition(0), _stagingDecoded(false), _updating(false) {
+	for (uint8_t i = 0; i < ANIMATION_CONDITION_COUNT; i++) {
+		_fallback[i].owned = false;
+		for (uint8_t j = 0; j < ANIMATION_MAX_FRAMES; j++) {
+			_fallback[i].frames[j] = fallbackFrames[i][j];
+		}
+		_current[i].store(&_fallback[i], std::memory_order_relaxed);
+	}
+	for (uint8_t i = 0; i < ANIMATION_MAX_FRAMES; i++) {
+		_staging[i] = nullptr;
+	}
+}
+
+AnimationFrameStore::~AnimationFrameStore() {
+	reset();
+}
+
+bool AnimationFrameStore::fetch(uint8_t weatherCondition, const char* baseURL) {
+	if (baseURL == nullptr || !beginUpdate(weatherCondition)) {
+		return false;
 	}
 	
-	// For TFT displays, try to fetch online PNG images
-	bool allSuccess = true;
-	bool anySuccess = false;
+	for (uint8_t i = 0; i < animationFrameCounts[weatherCondition]; i++) {
+		uint8_t* pngData;
+		size_t pngSize;
+		if (fetchAnimationFrame(baseURL, i, &pngData, &pngSize)) {
+			decodeFrame(i, pngData, pngSize);
+			delete[] pngData;
+		}
+	}
+	return finishUpdate();
+}
+
+bool AnimationFrameStore::reserve() {
+	return _framePool.reserve() && _assetPool.reserve();
+}
+
+bool AnimationFrameStore::beginUpdate(uint8_t weatherCondition) {
+	if (weatherCondition >= ANIMATION_CONDITION_COUNT || _updating) {
+		return false;
+	}
 	
-	// Fetch frames for each weather condition
-	Serial.println("Fetching clear sky frames...");
-	bool clearSuccess = fetchAnimationFrames(CLEAR_SKY_URL, (uint8_t**)clearSkyFrames, 2, 1024);
-	allSuccess &= clearSuccess;
-	anySuccess |= clearSuccess;
-	
-	Serial.println("Fetching cloudy frames...");
-	bool cloudySuccess = fetchAnimationFrames(CLOUDY_URL, (uint8_t**)cloudySkyFrames, 2, 1024);
-	allSuccess &= cloudySuccess;
-	anySuccess |= cloudySuccess;
-	
-	Serial.println("Fetching rain frames...");
-	bool rainSuccess = fetchAnimationFrames(RAIN_URL, (uint8_t**)rainFrames, 3, 1024);
-	allSuccess &= rainSuccess;
-	anySuccess |= rainSuccess;
-	
-	Serial.println("Fetching snow frames...");
-	bool snowSuccess = fetchAnimationFrames(SNOW_URL, (uint8_t**)snowFrames, 3, 1024);
-	allSuccess &= snowSuccess;
-	anySuccess |= snowSuccess;
-	
-	Serial.println("Fetching storm frames...");
-	bool stormSuccess = fetchAnimationFrames(STORM_URL, (uint8_t**)stormFrames, 2, 1024);
-	allSuccess &= stormSuccess;
-	anySuccess |= stormSuccess;
-	
-	// If any fetch failed, use fallback animations
-	if (!allSuccess) {
-		Serial.println("Some animations failed to load - falling back to generated animations");
-		if (!anySuccess) {
-			// If all fetches failed, regenerate all animations
-			generateFallbackAnimations();
-		} else {
-			// If some fetches succeeded, only regenerate failed animations
-			if (!clearSuccess) {
-				// Generate clear sky frames
-				for (int i = 0; i < 1024; i++) {
-					clearSkyFrame1[i] = 0;
-					clearSkyFrame2[i] = 0;
-				}
-				// Draw sun
-				for (int y = 20; y < 44; y++) {
-					for (int x = 52; x < 76; x++) {
-						int centerX = 64;
-						int centerY = 32;
-						int dx = x - centerX;
-						int dy = y - centerY;
-						float distance = sqrt(dx*dx + dy*dy);
-						
-						if (distance <= 10) {
-							int bytePos = y * 16 + x / 8;
-							int bitPos = 7 - (x % 8);
-							clearSkyFrame1[bytePos] |= (1 << bitPos);
-							clearSkyFrame2[bytePos] |= (1 << bitPos);
-						}
-					}
-				}
-				// Add rays to frame 2
-				int rays = 8;
-				float angleStep = 2 * PI / rays;
-				for (int ray = 0; ray < rays; ray++) {
-					float angle = ray * angleStep;
-					int innerX = 64 + cos(angle) * 12;
-					int innerY = 32 + sin(angle) * 12;
-					int outerX = 64 + cos(angle) * 18;
-					int outerY = 32 + sin(angle) * 18;
-					
-					for (float t = 0; t <= 1.0; t += 0.1) {
-						int x = innerX + (outerX - innerX) * t;
-						int y = innerY + (outerY - innerY) * t;
-						
-						if (x >= 0 && x < 128 && y >= 0 && y < 64) {
-							int bytePos = y * 16 + x / 8;
-							int bitPos = 7 - (x % 8);
-							clearSkyFrame2[bytePos] |= (1 << bitPos);
-						}
-					}
-				}
-			}
-			
-			if (!cloudySuccess) {
-				// Clear memory first
-				for (int i = 0; i < 1024; i++) {
-					cloudyFrame1[i] = 0;
-					cloudyFrame2[i] = 0;
-				}
-				// Generate cloudy frames
-				drawCloud(30, 25, 35, 15, cloudyFrame1);
-				drawCloud(35, 25, 30, 15, cloudyFrame2);
-				drawCloud(85, 30, 40, 15, cloudyFrame1);
-				drawCloud(80, 30, 40, 15, cloudyFrame2);
-			}
-			
-			if (!rainSuccess) {
-				// Clear memory first
-				for (int i = 0; i < 1024; i++) {
-					rainFrame1[i] = 0;
-					rainFrame2[i] = 0;
-					rainFrame3[i] = 0;
-				}
-				// Generate rain frames
-				drawCloud(64, 20, 50, 15, rainFrame1);
-				drawCloud(64, 20, 50, 15, rainFrame2);
-				drawCloud(64, 20, 50, 15, rainFrame3);
-				
-				// Add raindrops
-				for (int i = 0; i < 5; i++) {
-					drawRainDrop(40 + i * 15, 45, rainFrame1);
-					drawRainDrop(40 + i * 15, 50, rainFrame2);
-					drawRainDrop(40 + i * 15, 55, rainFrame3);
-				}
-			}
-			
-			if (!snowSuccess) {
-				// Clear memory first
-				for (int i = 0; i < 1024; i++) {
-					snowFrame1[i] = 0;
-					snowFrame2[i] = 0;
-					snowFrame3[i] = 0;
-				}
-				// Generate snow frames
-				drawCloud(64, 20, 50, 15, snowFrame1);
-				drawCloud(64, 20, 50, 15, snowFrame2);
-				drawCloud(64, 20, 50, 15, snowFrame3);
-				
-				// Add snowflakes
-				for (int i = 0; i < 5; i++) {
-					drawSnowflake(40 + i * 15, 45, snowFrame1);
-					drawSnowflake(35 + i * 15, 50, snowFrame2);
-					drawSnowflake(40 + i * 15, 55, snowFrame3);
-				}
-			}
-			
-			if (!stormSuccess) {
-				// Clear memory first
-				for (int i = 0; i < 1024; i++) {
-					stormFrame1[i] = 0;
-					stormFrame2[i] = 0;
-				}
-				// Generate storm frames
-				drawCloud(64, 20, 60, 20, stormFrame1);
-				drawCloud(64, 20, 60, 20, stormFrame2);
-				drawLightning(55, 40, stormFrame1);
-				drawLightning(75, 38, stormFrame2);
-			}
+	// Replaced versions the renderer is done with give their blocks back first
+	reclaim();
+	_stagingCondition = weatherCondition;
+	uint8_t count = animationFrameCounts[weatherCondition];
+	for (uint8_t i = 0; i < count; i++) {
+		_staging[i] = (uint8_t*)_framePool.acquire();
+		if (_staging[i] == nullptr) {
+			WA_LOG_WARN("Frame pool exhausted, keeping the current frames");
+			releaseStaging();
+			return false;
 		}
+		// Start from the generated frames so any frame that fails to download still shows something
+		memcpy(_staging[i], fallbackFrames[weatherCondition][i], ANIMATION_FRAME_BYTES);
+	}
+	_stagingDecoded = false;
+	_updating = true;
+	return true;
+}
+
+bool AnimationFrameStore::decodeFrame(uint8_t frameIndex, uint8_t* pngData, size_t pngSize) {
+	if (!_updating || frameIndex >= animationFrameCounts[_stagingCondition]) {
+		return false;
 	}
 	
-	// Return true if at least some frames were loaded successfully
+	// Convert PNG to bitmap
+	if (!pngToBitmap(pngData, pngSize, _staging[frameIndex], ANIMATION_FRAME_BYTES)) {
+		WA_LOG_WARN("Failed to convert PNG to bitmap");
+		return false;
+	}
+	_stagingDecoded = true;
 	return true;
 }
 
+bool AnimationFrameStore::finishUpdate() {
+	if (!_updating) {
+		return false;
+	}
+	_updating = false;
+	uint8_t condition = _stagingCondition;
+	
+	// Nothing decoded: keep showing the current frames
+	if (!_stagingDecoded) {
+		releaseStaging();
+		return false;
+	}
+	
+	// Publishing would replace a version with nowhere to park it until the renderer is done
+	reclaim();
+	if (_retiredCount >= ANIMATION_RETIRED_MAX &&
+	    _current[condition].load(std::memory_order_relaxed)->owned) {
+		WA_LOG_WARN("Renderer still holds replaced frames, keeping the current ones");
+		releaseStaging();
+		return false;
+	}
+	
+	AnimationAsset* asset = (AnimationAsset*)_assetPool.acquire();
+	if (asset == nullptr) {
+		WA_LOG_ERROR("Failed to allocate memory for animation frames");
+		releaseStaging();
+		return false;
+	}
+	asset->owned = true;
+	for (uint8_t i = 0; i < ANIMATION_MAX_FRAMES; i++) {
+		asset->frames[i] = i < animationFrameCounts[condition] ? _staging[i] : nullptr;
+		_staging[i] = nullptr;
+	}
+	publish(condition, asset);
+	return true;
+}
+
+bool AnimationFrameStore::updating() const {
+	return _updating;
+}
+
+// Helper function to give the blocks of an unpublished update back to the pool
+void AnimationFrameStore::releaseStaging() {
+	for (uint8_t i = 0; i < ANIMATION_MAX_FRAMES; i++) {
+		if (_staging[i] != nullptr) {
+			_framePool.release(_staging[i]);
+			_staging[i] = nullptr;
+		}
+	}
+}
+
+// Helper function to give a downloaded version's frames and the version itself back to their pools
+void AnimationFrameStore::release(AnimationAsset* asset) {
+	for (uint8_t i = 0; i < ANIMATION_MAX_FRAMES; i++) {
+		if (asset->frames[i] != nullptr) {
+			_framePool.release((void*)asset->frames[i]);
+		}
+	}
+	_assetPool.release(asset);
+}
+
+// Helper function to swap in a new version and park the old one until the renderer moves past it
+void AnimationFrameStore::publish(uint8_t weatherCondition, AnimationAsset* asset) {
+	AnimationAsset* old = _current[weatherCondition].exchange(asset, std::memory_order_acq_rel);
+	uint32_t epoch = _epoch.fetch_add(1, std::memory_order_release) + 1;
+	
+	// The generated frames are shared and never freed
+	if (old->owned) {
+		_retired[_retiredCount].asset = old;
+		_retired[_retiredCount].epoch = epoch;
+		_retiredCount++;
+	}
+}
+
+// Helper function to free the replaced versions the renderer can no longer be using
+void AnimationFrameStore::reclaim() {
+	uint32_t seen = _readerEpoch.load(std::memory_order_acquire);
+	uint8_t kept = 0;
+	for (uint8_t i = 0; i < _retiredCount; i++) {
+		if ((int32_t)(seen - _retired[i].epoch) >= 0) {
+			release(_retired[i].asset);
+		} else {
+			_retired[kept++] = _retired[i];
+		}
+	}
+	_retiredCount = kept;
+}
+
+void AnimationFrameStore::quiescent() {
+	_readerEpoch.store(_epoch.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+// Only called while no renderer is running
+void AnimationFrameStore::reset() {
+	releaseStaging();
+	_updating = false;
+	for (uint8_t i = 0; i < ANIMATION_CONDITION_COUNT; i++) {
+		AnimationAsset* asset = _current[i].exchange(&_fallback[i], std::memory_order_acq_rel);
+		if (asset->owned) {
+			release(asset);
+		}
+	}
+	for (uint8_t i = 0; i < _retiredCount; i++) {
+		release(_retired[i].asset);
+	}
+	_retiredCount = 0;
+}
+
+const AnimationAsset* AnimationFrameStore::current(uint8_t weatherCondition) const {
+	return weatherCondition < ANIMATION_CONDITION_COUNT ? _current[weatherCondition].load(std::memory_order_acquire) : nullptr;
+}
+
+const uint8_t* const* AnimationFrameStore::frames(uint8_t weatherCondition) const {
+	const AnimationAsset* asset = current(weatherCondition);
+	return asset != nullptr ? asset->frames : nullptr;
+}
+
+uint8_t AnimationFrameStore::frameCount(uint8_t weatherCondition) const {
+	return weatherCondition < ANIMATION_CONDITION_COUNT ? animationFrameCounts[weatherCondition] : 0;
+}
+
+uint16_t AnimationFrameStore::frameDelay(uint8_t weatherCondition) const {
+	return weatherCondition < ANIMATION_CONDITION_COUNT ? animationFrameDelays[weatherCondition] : 200;
+}
+
+size_t AnimationFrameStore::bytesAllocated() const {
+	size_t total = 0;
+	for (uint8_t i = 0; i < ANIMATION_CONDITION_COUNT; i++) {
+		if (_current[i].load(std::memory_order_acquire)->owned) {
+			total += animationFrameCounts[i] * ANIMATION_FRAME_BYTES;
+		}
+	}
+	for (uint8_t i = 0; i < _retiredCount; i++) {
+		for (uint8_t j = 0; j < ANIMATION_MAX_FRAMES; j++) {
+			if (_retired[i].asset->frames[j] != nullptr) {
+				total += ANIMATION_FRAME_BYTES;
+			}
+		}
+	}
+	return total;
+}
+
+const SlabPool& AnimationFrameStore::pool() const {
+	return _framePool;
+}
+
 // New improved fallback animations based on BasicUsage example
 void generateFallbackAnimations() {
+	if (fallbackGenerated) {
+		return;
+	}
+	fallbackGenerated = true;
+	
 	// Clear memory first
 	for (int i = 0; i < 1024; i++) {
 		clearSkyFrame1[i] = 0;
@@ -637,14 +755,18 @@ void drawTriangle(int x0, int y0, int x1, int y1, int x2, int y2, uint8_t* buffe
 		std::swap(x0, x1);
 	}
 	
-	// Special case for a flat bottom triangle
-	if (y0 == y1) {
-		fillFlatBottomTriangle(x0, y0, x1, y1, x2, y2, buffer);
+	// Degenerate case: all three vertices on one row
+	if (y0 == y2) {
+		drawLine(min(x0, min(x1, x2)), y0, max(x0, max(x1, x2)), y0, buffer);
 	}
-	// Special case for a flat top triangle
-	else if (y1 == y2) {
+	// Special case for a flat top triangle (apex at the bottom)
+	else if (y0 == y1) {
 		fillFlatTopTriangle(x0, y0, x1, y1, x2, y2, buffer);
 	}
+	// Special case for a flat bottom triangle (apex at the top)
+	else if (y1 == y2) {
+		fillFlatBottomTriangle(x0, y0, x1, y1, x2, y2, buffer);
+	}
 	// General case: split into flat bottom and flat top triangles
 	else {
 		// Calculate the new vertex at the split point
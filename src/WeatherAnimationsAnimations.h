@@ -2,51 +2,151 @@
 #define WEATHER_ANIMATIONS_ANIMATIONS_H
 
 #include <Arduino.h>
+#include <atomic>
 #include "WeatherAnimationsIcons.h"
+#include "WeatherAnimationsPool.h"
 
 // Animation frames for 128x64 OLED display
 // Each frame is 128x64 pixels, stored as 1024 bytes (128*64/8)
+#define ANIMATION_FRAME_BYTES 1024
+#define ANIMATION_MAX_FRAMES 3
+#define ANIMATION_CONDITION_COUNT 5
+
+// Longest URL kept for an online animation
+#define ONLINE_ANIMATION_URL_LENGTH 150
+
+// Replaced frame sets that can wait for the renderer to move past them
+#define ANIMATION_RETIRED_MAX ANIMATION_CONDITION_COUNT
+
+// Downloaded frames one AnimationFrameStore can hold: every condition, plus
+// one update in progress or one replaced set waiting for the renderer
+#ifndef ANIMATION_POOL_FRAMES
+#define ANIMATION_POOL_FRAMES (ANIMATION_MAX_FRAMES * (ANIMATION_CONDITION_COUNT + 1))
+#endif
+
+// Widest PNG line the decoder converts (320 RGB565 pixels), and how many
+// decodes can run at once
+#define PNG_LINE_BYTES 640
+#define PNG_LINE_BUFFERS 2
 
 // Base URLs for fetching weather animations from online sources
-extern const char* CLEAR_SKY_URL;
-extern const char* CLOUDY_URL;
-extern const char* RAIN_URL;
-extern const char* SNOW_URL;
-extern const char* STORM_URL;
-
-// Clear Sky Animation (2 frames)
-extern uint8_t clearSkyFrame1[1024];
-extern uint8_t clearSkyFrame2[1024];
-extern const uint8_t* clearSkyFrames[2];
-
-// Cloudy Animation (2 frames)
-extern uint8_t cloudyFrame1[1024];
-extern uint8_t cloudyFrame2[1024];
-extern const uint8_t* cloudySkyFrames[2];
-
-// Rain Animation (3 frames)
-extern uint8_t rainFrame1[1024];
-extern uint8_t rainFrame2[1024];
-extern uint8_t rainFrame3[1024];
-extern const uint8_t* rainFrames[3];
-
-// Snow Animation (3 frames)
-extern uint8_t snowFrame1[1024];
-extern uint8_t snowFrame2[1024];
-extern uint8_t snowFrame3[1024];
-extern const uint8_t* snowFrames[3];
-
-// Storm Animation (2 frames)
-extern uint8_t stormFrame1[1024];
-extern uint8_t stormFrame2[1024];
-extern const uint8_t* stormFrames[2];
+extern const char* const CLEAR_SKY_URL;
+extern const char* const CLOUDY_URL;
+extern const char* const RAIN_URL;
+extern const char* const SNOW_URL;
+extern const char* const STORM_URL;
 
 // Functions for fetching and initializing animations
 bool pngToBitmap(uint8_t* pngData, size_t pngSize, uint8_t* bitmap, size_t bitmapSize);
 bool fetchAnimationFrames(const char* baseURL, uint8_t** frames, int frameCount, size_t frameSize);
-bool initializeAnimationsFromOnline(uint8_t displayType);
+
+// Download one frame ("<baseURL>NNN.png"). On success *pngData is allocated
+// with new[] and must be released by the caller with delete[].
+bool fetchAnimationFrame(const char* baseURL, int frameIndex, uint8_t** pngData, size_t* pngSize);
+
+// Base URL of the default online frames for a condition
+const char* defaultAnimationURL(uint8_t weatherCondition);
+
+// Draw the built-in animations. They are generated once and then shared,
+// read-only, by every WeatherAnimations instance; later calls do nothing.
 void generateFallbackAnimations();
 
+namespace WeatherAnimationsLib {
+
+// Scanline buffers of the PNG decoder, shared by every instance
+const SlabPool& pngLinePool();
+
+// One version of a condition's frames. Never modified once published.
+struct AnimationAsset {
+	bool owned;                                     // downloaded frames from the pool, false for the generated ones
+	const uint8_t* frames[ANIMATION_MAX_FRAMES];
+};
+
+// Animation frames owned by one WeatherAnimations instance.
+//
+// Every condition starts out pointing at the shared generated frames. Frames
+// downloaded with fetch() are decoded into fresh blocks from this store's
+// frame pool, so two instances never overwrite each other's animations and
+// the frames on screen are never written to.
+//
+// A finished download is published with a single atomic pointer swap (RCU
+// style): one writer task updates, one renderer task reads. The replaced
+// version is only freed after the renderer has called quiescent(), i.e. has
+// finished the frame that may still have been using it.
+class AnimationFrameStore {
+public:
+	AnimationFrameStore();
+	~AnimationFrameStore();
+
+	// Download the frames for one condition from a base URL ("..._frame_")
+	bool fetch(uint8_t weatherCondition, const char* baseURL);
+
+	// Drop all downloaded frames and go back to the generated ones
+	void reset();
+
+	// Reserve the frame pool now instead of on the first download
+	bool reserve();
+
+	// Step-wise version of fetch() for callers that cannot block:
+	// beginUpdate(), then decodeFrame() for each downloaded frame, then
+	// finishUpdate(). Frames are decoded into a staging buffer, so the
+	// current animation keeps playing until finishUpdate() publishes it.
+	// beginUpdate() fails if the frame pool has no blocks left, and
+	// finishUpdate() returns false and keeps the current frames if nothing
+	// decoded or too many replaced versions still wait for the renderer.
+	bool beginUpdate(uint8_t weatherCondition);
+	bool decodeFrame(uint8_t frameIndex, uint8_t* pngData, size_t pngSize);
+	bool finishUpdate();
+	bool updating() const;
+
+	// Renderer side: the current version of a condition's frames. Valid
+	// until the renderer's next quiescent() call.
+	const AnimationAsset* current(uint8_t weatherCondition) const;
+	const uint8_t* const* frames(uint8_t weatherCondition) const;
+
+	// Renderer side: called between frames, when it holds no version any more
+	void quiescent();
+
+	uint8_t frameCount(uint8_t weatherCondition) const;
+	uint16_t frameDelay(uint8_t weatherCondition) const;
+
+	// Bytes held by downloaded frames, including versions waiting to be freed
+	size_t bytesAllocated() const;
+
+	// Blocks of 1024-byte frames, for its high-water mark
+	const SlabPool& pool() const;
+
+private:
+	struct Retired {
+		AnimationAsset* asset;
+		uint32_t epoch;        // publish that replaced it
+	};
+
+	void publish(uint8_t weatherCondition, AnimationAsset* asset);
+	void reclaim();
+	void release(AnimationAsset* asset);
+	void releaseStaging();
+
+	AnimationAsset _fallback[ANIMATION_CONDITION_COUNT];
+	SlabPool _framePool;
+	SlabPool _assetPool;
+	std::atomic<AnimationAsset*> _current[ANIMATION_CONDITION_COUNT];
+
+	// Writer side: versions the renderer may still be drawing
+	Retired _retired[ANIMATION_RETIRED_MAX];
+	uint8_t _retiredCount;
+	std::atomic<uint32_t> _epoch;        // publishes so far
+	std::atomic<uint32_t> _readerEpoch;  // publishes the renderer had seen at its last quiescent()
+
+	// Update in progress
+	uint8_t* _staging[ANIMATION_MAX_FRAMES];
+	uint8_t _stagingCondition;
+	bool _stagingDecoded;
+	bool _updating;
+};
+
+}
+
 // Original helper functions for drawing fallback animations
 void drawCloud(int centerX, int centerY, int width, int height, uint8_t* buffer);
 void drawRainDrop(int x, int y, uint8_t* buffer);
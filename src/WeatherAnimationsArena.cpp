@@ -0,0 +1,53 @@
+#include "WeatherAnimationsArena.h"
+
+using namespace WeatherAnimationsLib;
+
+PollArena::PollArena(size_t capacity)
+	: _buffer(nullptr), _capacity(capacity), _used(0), _highWater(0), _failures(0) {
+}
+
+PollArena::~PollArena() {
+	free(_buffer);
+}
+
+void* PollArena::allocate(size_t size) {
+	if (_buffer == nullptr) {
+		_buffer = (uint8_t*)malloc(_capacity);
+		if (_buffer == nullptr) {
+			_failures++;
+			return nullptr;
+		}
+	}
+
+	size_t aligned = (size + POLL_ARENA_ALIGN - 1) & ~(size_t)(POLL_ARENA_ALIGN - 1);
+	if (aligned > _capacity - _used) {
+		_failures++;
+		return nullptr;
+	}
+	void* block = _buffer + _used;
+	_used += aligned;
+	if (_used > _highWater) {
+		_highWater = _used;
+	}
+	return block;
+}
+
+void PollArena::reset() {
+	_used = 0;
+}
+
+size_t PollArena::capacity() const {
+	return _capacity;
+}
+
+size_t PollArena::used() const {
+	return _used;
+}
+
+size_t PollArena::highWater() const {
+	return _highWater;
+}
+
+uint32_t PollArena::failures() const {
+	return _failures;
+}
@@ -0,0 +1,48 @@
+#ifndef WEATHER_ANIMATIONS_ARENA_H
+#define WEATHER_ANIMATIONS_ARENA_H
+
+#include <Arduino.h>
+
+// Alignment of every arena allocation
+#define POLL_ARENA_ALIGN 4
+
+namespace WeatherAnimationsLib {
+
+// Bump allocator for short-lived buffers.
+//
+// The memory block is allocated once, on first use, and kept. allocate()
+// only moves a pointer forward and reset() moves it back, so polling the
+// same entities over and over never touches the general heap and cannot
+// fragment it.
+class PollArena {
+public:
+	explicit PollArena(size_t capacity);
+	~PollArena();
+
+	// Returns nullptr once the capacity is used up. The memory stays valid until reset().
+	void* allocate(size_t size);
+
+	// Release everything allocated so far
+	void reset();
+
+	size_t capacity() const;
+	size_t used() const;
+
+	// Most bytes in use at once, and allocations that did not fit
+	size_t highWater() const;
+	uint32_t failures() const;
+
+private:
+	PollArena(const PollArena&);
+	PollArena& operator=(const PollArena&);
+
+	uint8_t* _buffer;
+	size_t _capacity;
+	size_t _used;
+	size_t _highWater;
+	uint32_t _failures;
+};
+
+}
+
+#endif // WEATHER_ANIMATIONS_ARENA_H
@@ -0,0 +1,142 @@
+#include "WeatherAnimationsBus.h"
+
+using namespace WeatherAnimationsLib;
+
+OLEDBusScheduler::OLEDBusScheduler(uint16_t bytesPerCycle)
+	: _panelCount(0), _nextPanel(0), _bytesPerCycle(bytesPerCycle), _clock(systemClock()) {
+}
+
+bool OLEDBusScheduler::addPanel(OLEDPanel* panel) {
+	if (panel == nullptr || findSlot(panel) >= 0) {
+		return panel != nullptr;
+	}
+	if (_panelCount >= OLED_BUS_MAX_PANELS) {
+		return false;
+	}
+
+	PanelSlot& slot = _slots[_panelCount++];
+	slot.panel = panel;
+	slot.requested = false;
+	slot.coalesced = 0;
+	slot.windowFrames = 0;
+	slot.windowStart = _clock->millis();
+	slot.frameRate = 0;
+	return true;
+}
+
+void OLEDBusScheduler::removePanel(OLEDPanel* panel) {
+	int8_t index = findSlot(panel);
+	if (index < 0) {
+		return;
+	}
+
+	// Send whatever is left so the panel is not left half drawn
+	while (panel->flushInProgress()) {
+		panel->flushStep();
+	}
+
+	for (uint8_t i = index; i + 1 < _panelCount; i++) {
+		_slots[i] = _slots[i + 1];
+	}
+	_panelCount--;
+	if (_nextPanel >= _panelCount) {
+		_nextPanel = 0;
+	}
+}
+
+void OLEDBusScheduler::requestFlush(OLEDPanel* panel) {
+	int8_t index = findSlot(panel);
+	if (index < 0) {
+		return;
+	}
+
+	if (_slots[index].requested) {
+		_slots[index].coalesced++;
+	}
+	_slots[index].requested = true;
+}
+
+uint16_t OLEDBusScheduler::service() {
+	if (_panelCount == 0) {
+		return 0;
+	}
+
+	unsigned long now = _clock->millis();
+
+	// Start a flush on every panel that asked for one and is not mid-transfer
+	for (uint8_t i = 0; i < _panelCount; i++) {
+		PanelSlot& slot = _slots[i];
+		if (!slot.requested || slot.panel->flushInProgress()) {
+			continue;
+		}
+		slot.requested = false;
+		if (!slot.panel->beginFlush()) {
+			// Nothing changed, the panel already shows this frame
+			recordFrame(slot, now);
+		}
+	}
+
+	// Send one region per panel per round until the budget is spent
+	uint16_t sent = 0;
+	bool active = true;
+	while (active && sent < _bytesPerCycle) {
+		active = false;
+		for (uint8_t i = 0; i < _panelCount && sent < _bytesPerCycle; i++) {
+			PanelSlot& slot = _slots[(_nextPanel + i) % _panelCount];
+			if (!slot.panel->flushInProgress()) {
+				continue;
+			}
+			sent += slot.panel->flushStep();
+			active = true;
+			if (!slot.panel->flushInProgress()) {
+				recordFrame(slot, now);
+			}
+		}
+	}
+
+	// Rotate who goes first so a large flush cannot always win the budget
+	_nextPanel = (_nextPanel + 1) % _panelCount;
+	return sent;
+}
+
+void OLEDBusScheduler::setBytesPerCycle(uint16_t bytesPerCycle) {
+	_bytesPerCycle = bytesPerCycle;
+}
+
+float OLEDBusScheduler::frameRate(const OLEDPanel* panel) const {
+	int8_t index = findSlot(panel);
+	return index < 0 ? 0 : _slots[index].frameRate;
+}
+
+uint32_t OLEDBusScheduler::coalescedFlushes(const OLEDPanel* panel) const {
+	int8_t index = findSlot(panel);
+	return index < 0 ? 0 : _slots[index].coalesced;
+}
+
+uint8_t OLEDBusScheduler::panelCount() const {
+	return _panelCount;
+}
+
+void OLEDBusScheduler::setClock(Clock* clock) {
+	_clock = clock != nullptr ? clock : systemClock();
+}
+
+int8_t OLEDBusScheduler::findSlot(const OLEDPanel* panel) const {
+	for (uint8_t i = 0; i < _panelCount; i++) {
+		if (_slots[i].panel == panel) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+// Helper function to update a panel's frame rate window
+void OLEDBusScheduler::recordFrame(PanelSlot& slot, unsigned long now) {
+	slot.windowFrames++;
+	unsigned long elapsed = now - slot.windowStart;
+	if (elapsed >= OLED_BUS_FPS_WINDOW) {
+		slot.frameRate = slot.windowFrames * 1000.0f / elapsed;
+		slot.windowFrames = 0;
+		slot.windowStart = now;
+	}
+}
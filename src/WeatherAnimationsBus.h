@@ -0,0 +1,75 @@
+#ifndef WEATHER_ANIMATIONS_BUS_H
+#define WEATHER_ANIMATIONS_BUS_H
+
+#include <Arduino.h>
+#include "WeatherAnimationsClock.h"
+#include "WeatherAnimationsOLED.h"
+
+// Maximum number of panels sharing one bus
+#define OLED_BUS_MAX_PANELS 4
+
+// Bytes sent per service() call before yielding back to the sketch
+#define OLED_BUS_DEFAULT_BUDGET 1024
+
+// Window over which per-panel frame rates are measured (ms)
+#define OLED_BUS_FPS_WINDOW 1000
+
+namespace WeatherAnimationsLib {
+
+// Shares one bus between several OLED panels.
+//
+// Panels ask for a flush with requestFlush(); the transfer itself happens in
+// service(), which sends the pending dirty regions of all panels one region
+// at a time in round-robin order so no panel can starve the others. Repeated
+// requests from a panel before its flush starts collapse into one transfer.
+class OLEDBusScheduler {
+public:
+	OLEDBusScheduler(uint16_t bytesPerCycle = OLED_BUS_DEFAULT_BUDGET);
+
+	// Register or remove a panel. addPanel() returns false when the bus is full.
+	bool addPanel(OLEDPanel* panel);
+	void removePanel(OLEDPanel* panel);
+
+	// Mark a panel's framebuffer as ready to be sent
+	void requestFlush(OLEDPanel* panel);
+
+	// Run one bus cycle. Returns the number of framebuffer bytes sent.
+	uint16_t service();
+
+	// Byte budget for a single service() call
+	void setBytesPerCycle(uint16_t bytesPerCycle);
+
+	// Completed flushes per second for a panel, measured over OLED_BUS_FPS_WINDOW
+	float frameRate(const OLEDPanel* panel) const;
+
+	// Requests that were merged into an already pending flush
+	uint32_t coalescedFlushes(const OLEDPanel* panel) const;
+
+	uint8_t panelCount() const;
+
+	// Time source for the frame rates (nullptr for the board's millis())
+	void setClock(Clock* clock);
+
+private:
+	struct PanelSlot {
+		OLEDPanel* panel;
+		bool requested;
+		uint32_t coalesced;
+		uint16_t windowFrames;
+		unsigned long windowStart;
+		float frameRate;
+	};
+
+	int8_t findSlot(const OLEDPanel* panel) const;
+	void recordFrame(PanelSlot& slot, unsigned long now);
+
+	PanelSlot _slots[OLED_BUS_MAX_PANELS];
+	uint8_t _panelCount;
+	uint8_t _nextPanel;
+	uint16_t _bytesPerCycle;
+	Clock* _clock;
+};
+
+}
+
+#endif // WEATHER_ANIMATIONS_BUS_H
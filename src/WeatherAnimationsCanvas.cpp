@@ -0,0 +1,223 @@
+#include "WeatherAnimationsCanvas.h"
+
+using namespace WeatherAnimationsLib;
+
+OLEDCanvas::OLEDCanvas(uint16_t width, uint16_t height, uint8_t* buffer)
+	: Adafruit_GFX(width, height), _buffer(buffer), _ownsBuffer(false) {
+	if (_buffer == nullptr) {
+		_buffer = (uint8_t*)malloc(width * ((height + 7) / 8));
+		_ownsBuffer = true;
+		if (_buffer != nullptr) {
+			clearDisplay();
+		}
+	}
+}
+
+OLEDCanvas::~OLEDCanvas() {
+	if (_ownsBuffer && _buffer != nullptr) {
+		free(_buffer);
+	}
+}
+
+bool OLEDCanvas::valid() const {
+	return _buffer != nullptr;
+}
+
+uint8_t* OLEDCanvas::getBuffer() const {
+	return _buffer;
+}
+
+uint16_t OLEDCanvas::bufferWidth() const {
+	return WIDTH;
+}
+
+uint16_t OLEDCanvas::bufferHeight() const {
+	return HEIGHT;
+}
+
+void OLEDCanvas::clearDisplay() {
+	memset(_buffer, 0, WIDTH * ((HEIGHT + 7) / 8));
+}
+
+void OLEDCanvas::fillScreen(uint16_t color) {
+	if (color == SSD1306_INVERSE) {
+		Adafruit_GFX::fillScreen(color);
+		return;
+	}
+	memset(_buffer, color ? 0xFF : 0x00, WIDTH * ((HEIGHT + 7) / 8));
+}
+
+void OLEDCanvas::drawPixel(int16_t x, int16_t y, uint16_t color) {
+	if (x < 0 || y < 0 || x >= width() || y >= height()) {
+		return;
+	}
+
+	// Map GFX rotation back to the raw buffer
+	int16_t t;
+	switch (rotation) {
+		case 1:
+			t = x;
+			x = WIDTH - 1 - y;
+			y = t;
+			break;
+		case 2:
+			x = WIDTH - 1 - x;
+			y = HEIGHT - 1 - y;
+			break;
+		case 3:
+			t = x;
+			x = y;
+			y = HEIGHT - 1 - t;
+			break;
+	}
+
+	uint8_t* byte = _buffer + x + (y / 8) * WIDTH;
+	uint8_t mask = 1 << (y & 7);
+	switch (color) {
+		case SSD1306_WHITE:   *byte |= mask; break;
+		case SSD1306_BLACK:   *byte &= ~mask; break;
+		case SSD1306_INVERSE: *byte ^= mask; break;
+	}
+}
+
+bool OLEDCanvas::getPixel(int16_t x, int16_t y) const {
+	if (x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT) {
+		return false;
+	}
+	return (_buffer[x + (y / 8) * WIDTH] >> (y & 7)) & 1;
+}
+
+void OLEDCanvas::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+	if (rotation != 0) {
+		Adafruit_GFX::drawFastHLine(x, y, w, color);
+		return;
+	}
+	if (y < 0 || y >= HEIGHT) {
+		return;
+	}
+	if (x < 0) {
+		w += x;
+		x = 0;
+	}
+	if (x + w > WIDTH) {
+		w = WIDTH - x;
+	}
+	if (w <= 0) {
+		return;
+	}
+
+	// One bit in each of w consecutive column bytes
+	uint8_t* byte = _buffer + x + (y / 8) * WIDTH;
+	uint8_t mask = 1 << (y & 7);
+	switch (color) {
+		case SSD1306_WHITE:   while (w--) { *byte++ |= mask; } break;
+		case SSD1306_BLACK:   while (w--) { *byte++ &= ~mask; } break;
+		case SSD1306_INVERSE: while (w--) { *byte++ ^= mask; } break;
+	}
+}
+
+void OLEDCanvas::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+	if (rotation != 0) {
+		Adafruit_GFX::drawFastVLine(x, y, h, color);
+		return;
+	}
+	if (x < 0 || x >= WIDTH) {
+		return;
+	}
+	if (y < 0) {
+		h += y;
+		y = 0;
+	}
+	if (y + h > HEIGHT) {
+		h = HEIGHT - y;
+	}
+	if (h <= 0) {
+		return;
+	}
+
+	// Whole bytes in the middle of the run, partial masks at either end
+	uint8_t* byte = _buffer + x + (y / 8) * WIDTH;
+	while (h > 0) {
+		uint8_t bit = y & 7;
+		uint8_t count = min((int16_t)(8 - bit), h);
+		uint8_t mask = (uint8_t)(((1 << count) - 1) << bit);
+		switch (color) {
+			case SSD1306_WHITE:   *byte |= mask; break;
+			case SSD1306_BLACK:   *byte &= ~mask; break;
+			case SSD1306_INVERSE: *byte ^= mask; break;
+		}
+		y += count;
+		h -= count;
+		byte += WIDTH;
+	}
+}
+
+// Helper function to transpose an 8x8 bit matrix held as eight bytes
+// (byte i, bit j <-> byte j, bit i) using three delta swaps
+static inline uint64_t transpose8x8(uint64_t x) {
+	uint64_t t;
+	t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+	x = x ^ t ^ (t << 7);
+	t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+	x = x ^ t ^ (t << 14);
+	t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+	x = x ^ t ^ (t << 28);
+	return x;
+}
+
+// Helper function to reverse the bit order inside each of the eight bytes
+static inline uint64_t reverseBits8x8(uint64_t x) {
+	x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+	x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+	x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+	return x;
+}
+
+void WeatherAnimationsLib::blitPageBuffer(const uint8_t* src, uint16_t width, uint16_t height, uint8_t* dst,
+                                          uint8_t rotation, uint8_t mirror) {
+	bool mirrorX = mirror & OLED_MIRROR_X;
+	bool mirrorY = mirror & OLED_MIRROR_Y;
+
+	// Reduce mirror + rotation to: swap axes, then flip the destination X and/or Y
+	bool swap = (rotation & 1) != 0;
+	bool flipX, flipY;
+	switch (rotation & 3) {
+		case OLED_ROTATE_90:  flipX = !mirrorY; flipY = mirrorX; break;
+		case OLED_ROTATE_180: flipX = !mirrorX; flipY = !mirrorY; break;
+		case OLED_ROTATE_270: flipX = mirrorY; flipY = !mirrorX; break;
+		default:              flipX = mirrorX; flipY = mirrorY; break;
+	}
+
+	uint16_t srcBlocksX = width / 8;
+	uint16_t srcPages = height / 8;
+	uint16_t dstWidth = swap ? height : width;
+	uint16_t dstBlocksX = dstWidth / 8;
+	uint16_t dstPages = (swap ? width : height) / 8;
+
+	for (uint16_t page = 0; page < srcPages; page++) {
+		for (uint16_t block = 0; block < srcBlocksX; block++) {
+			// Eight columns of one page: byte i is column i, bit j is row j
+			// (ESP32 and ESP8266 are little-endian)
+			uint64_t bits;
+			memcpy(&bits, src + page * width + block * 8, 8);
+
+			uint16_t dstBlock = block;
+			uint16_t dstPage = page;
+			if (swap) {
+				bits = transpose8x8(bits);
+				dstBlock = page;
+				dstPage = block;
+			}
+			if (flipX) {
+				bits = __builtin_bswap64(bits);
+				dstBlock = dstBlocksX - 1 - dstBlock;
+			}
+			if (flipY) {
+				bits = reverseBits8x8(bits);
+				dstPage = dstPages - 1 - dstPage;
+			}
+
+			memcpy(dst + dstPage * dstWidth + dstBlock * 8, &bits, 8);
+		}
+	}
+}
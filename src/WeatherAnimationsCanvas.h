@@ -0,0 +1,64 @@
+#ifndef WEATHER_ANIMATIONS_CANVAS_H
+#define WEATHER_ANIMATIONS_CANVAS_H
+
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>
+
+// Panel orientation, applied when the canvas is copied to the panel.
+// Rotation numbers follow Adafruit_GFX::setRotation (clockwise quarter turns).
+#define OLED_ROTATE_0 0
+#define OLED_ROTATE_90 1
+#define OLED_ROTATE_180 2
+#define OLED_ROTATE_270 3
+
+// Mirroring of the drawn image, applied before rotation
+#define OLED_MIRROR_NONE 0
+#define OLED_MIRROR_X 1
+#define OLED_MIRROR_Y 2
+
+namespace WeatherAnimationsLib {
+
+// 1bpp drawing surface in SSD1306 page format: each byte holds eight
+// vertical pixels of one column, least significant bit on top.
+//
+// The canvas either owns its buffer or draws straight into an existing
+// one (such as the Adafruit_SSD1306 framebuffer) when no rotation is needed.
+class OLEDCanvas : public Adafruit_GFX {
+public:
+	OLEDCanvas(uint16_t width, uint16_t height, uint8_t* buffer = nullptr);
+	~OLEDCanvas();
+
+	// False if the canvas could not allocate its buffer
+	bool valid() const;
+
+	void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+	void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+	void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+	void fillScreen(uint16_t color) override;
+
+	// Same as Adafruit_SSD1306::clearDisplay()
+	void clearDisplay();
+
+	bool getPixel(int16_t x, int16_t y) const;
+	uint8_t* getBuffer() const;
+
+	// Buffer dimensions, unaffected by setRotation()
+	uint16_t bufferWidth() const;
+	uint16_t bufferHeight() const;
+
+private:
+	uint8_t* _buffer;
+	bool _ownsBuffer;
+};
+
+// Copy a page-format image into a page-format destination, rotating and
+// mirroring on the way. Works on 8x8 pixel blocks, so both dimensions must
+// be multiples of 8. The destination is width x height for OLED_ROTATE_0/180
+// and height x width for OLED_ROTATE_90/270.
+void blitPageBuffer(const uint8_t* src, uint16_t width, uint16_t height, uint8_t* dst,
+                    uint8_t rotation, uint8_t mirror);
+
+}
+
+#endif // WEATHER_ANIMATIONS_CANVAS_H
@@ -0,0 +1,35 @@
+#include "WeatherAnimationsClock.h"
+
+using namespace WeatherAnimationsLib;
+
+uint32_t SystemClock::millis() {
+	return ::millis();
+}
+
+void SystemClock::delay(uint32_t ms) {
+	::delay(ms);
+}
+
+Clock* WeatherAnimationsLib::systemClock() {
+	static SystemClock clock;
+	return &clock;
+}
+
+VirtualClock::VirtualClock(uint32_t start) : _now(start) {
+}
+
+uint32_t VirtualClock::millis() {
+	return _now.load(std::memory_order_relaxed);
+}
+
+void VirtualClock::delay(uint32_t ms) {
+	advance(ms);
+}
+
+void VirtualClock::advance(uint32_t ms) {
+	_now.fetch_add(ms, std::memory_order_relaxed);
+}
+
+void VirtualClock::set(uint32_t now) {
+	_now.store(now, std::memory_order_relaxed);
+}
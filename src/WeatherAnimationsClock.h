@@ -0,0 +1,53 @@
+#ifndef WEATHER_ANIMATIONS_CLOCK_H
+#define WEATHER_ANIMATIONS_CLOCK_H
+
+#include <Arduino.h>
+#include <atomic>
+
+namespace WeatherAnimationsLib {
+
+// Where the library reads the time and waits.
+//
+// Polling intervals, frame timing, transitions and the blocking update()
+// loop all go through a Clock. The default is the board's millis() and
+// delay(); WeatherAnimations::setClock(), WeatherDataHub::setClock() and
+// OLEDBusScheduler::setClock() replace it, e.g. with a VirtualClock to run
+// hours of behaviour in seconds.
+// millis() wraps after 49.7 days; compare times by their difference.
+class Clock {
+public:
+	virtual ~Clock() {}
+	virtual uint32_t millis() = 0;
+	virtual void delay(uint32_t ms) = 0;
+};
+
+// The board's millis() and delay()
+class SystemClock : public Clock {
+public:
+	uint32_t millis() override;
+	void delay(uint32_t ms) override;
+};
+
+// Shared SystemClock, used wherever no clock was set
+Clock* systemClock();
+
+// A clock that only moves when told to. delay() returns at once, having
+// moved the clock forward, so code that waits runs at full speed. The
+// time can be set anywhere, e.g. just before the 49.7-day wrap.
+class VirtualClock : public Clock {
+public:
+	explicit VirtualClock(uint32_t start = 0);
+
+	uint32_t millis() override;
+	void delay(uint32_t ms) override;
+
+	void advance(uint32_t ms);
+	void set(uint32_t now);
+
+private:
+	std::atomic<uint32_t> _now;
+};
+
+}
+
+#endif // WEATHER_ANIMATIONS_CLOCK_H
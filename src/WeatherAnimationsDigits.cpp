@@ -0,0 +1,240 @@
+#include "WeatherAnimationsDigits.h"
+#include "WeatherAnimationsDigitFont.h"
+
+using namespace WeatherAnimationsLib;
+
+// Largest glyph cell, used to size the TFT strip buffer
+#define DIGIT_MAX_CELL_WIDTH 24
+
+// Helper function to find the glyph for a character, -1 if there is none
+static int8_t digitGlyphIndex(char c) {
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	}
+	switch (c) {
+		case '-':          return 10;
+		case '.':          return 11;
+		case DIGIT_DEGREE: return 12;
+		case 'C':          return 13;
+		case 'F':          return 14;
+		case ' ':          return 15;
+		default:           return -1;
+	}
+}
+
+// Helper function to read one column byte of a glyph, blank in the spacing columns
+static inline uint8_t digitColumn(const DigitFont& font, uint16_t offset, uint8_t width, uint8_t page, uint8_t column) {
+	if (column >= width) {
+		return 0;
+	}
+	return pgm_read_byte(font.bitmap + offset + page * width + column);
+}
+
+uint16_t WeatherAnimationsLib::digitTextWidth(const char* text, uint8_t font) {
+	if (text == nullptr || font >= DIGIT_FONT_COUNT) {
+		return 0;
+	}
+
+	const DigitFont& digitFont = digitFonts[font];
+	uint16_t width = 0;
+	for (const char* c = text; *c != '\0'; c++) {
+		int8_t index = digitGlyphIndex(*c);
+		if (index >= 0) {
+			width += pgm_read_byte(&digitFont.glyphs[index].width) + digitFont.spacing;
+		}
+	}
+	return width;
+}
+
+uint8_t WeatherAnimationsLib::digitFontHeight(uint8_t font) {
+	return font < DIGIT_FONT_COUNT ? digitFonts[font].pages * 8 : 0;
+}
+
+size_t WeatherAnimationsLib::formatTemperature(char* buffer, size_t size, float value, uint8_t decimals,
+                                               char unit, bool showDegree) {
+	if (buffer == nullptr || size == 0) {
+		return 0;
+	}
+
+	// Avoid printing "-0.0" for small negative values
+	float half = 0.5f;
+	for (uint8_t i = 0; i < decimals; i++) {
+		half /= 10;
+	}
+	if (value > -half && value < half) {
+		value = 0;
+	}
+
+	int length = snprintf(buffer, size, "%.*f", decimals, value);
+	if (length < 0 || (size_t)length >= size) {
+		return length < 0 ? 0 : size - 1;
+	}
+	if (unit != 0) {
+		if (showDegree && (size_t)length + 1 < size) {
+			buffer[length++] = DIGIT_DEGREE;
+		}
+		if ((size_t)length + 1 < size) {
+			buffer[length++] = unit;
+		}
+		buffer[length] = '\0';
+	}
+	return length;
+}
+
+// Helper function to merge glyph bits into a buffer byte. Opaque bits are
+// already inverted for black and replace everything under mask.
+static inline void mergeDigitBits(uint8_t* target, uint8_t bits, uint8_t mask, uint16_t color, bool opaque) {
+	if (opaque) {
+		*target = (*target & ~mask) | (bits & mask);
+		return;
+	}
+	switch (color) {
+		case SSD1306_WHITE:   *target |= bits; break;
+		case SSD1306_BLACK:   *target &= ~bits; break;
+		case SSD1306_INVERSE: *target ^= bits; break;
+	}
+}
+
+int16_t WeatherAnimationsLib::drawDigits(OLEDCanvas* canvas, int16_t x, int16_t y, const char* text, uint8_t font,
+                                         uint16_t color, uint8_t mode) {
+	if (canvas == nullptr || text == nullptr || font >= DIGIT_FONT_COUNT) {
+		return 0;
+	}
+
+	const DigitFont& digitFont = digitFonts[font];
+	bool opaque = mode == DIGIT_OPAQUE && color != SSD1306_INVERSE;
+	bool invert = opaque && color == SSD1306_BLACK;
+	uint8_t* buffer = canvas->getBuffer();
+	int16_t bufferWidth = canvas->bufferWidth();
+	int16_t bufferPages = (canvas->bufferHeight() + 7) / 8;
+	uint8_t shift = y & 7;
+	int16_t firstPage = (y - shift) / 8;
+	int16_t startX = x;
+
+	for (const char* c = text; *c != '\0'; c++) {
+		int8_t index = digitGlyphIndex(*c);
+		if (index < 0) {
+			continue;
+		}
+		uint16_t offset = pgm_read_word(&digitFont.glyphs[index].offset);
+		uint8_t width = pgm_read_byte(&digitFont.glyphs[index].width);
+		uint8_t cellWidth = width + digitFont.spacing;
+
+		for (uint8_t page = 0; page < digitFont.pages; page++) {
+			for (uint8_t column = 0; column < cellWidth; column++) {
+				uint8_t bits = digitColumn(digitFont, offset, width, page, column);
+				if (invert) {
+					bits = ~bits;
+				}
+				if (!opaque && bits == 0) {
+					continue;
+				}
+
+				// Rotated canvases go through drawPixel so the GFX rotation is honoured
+				if (canvas->getRotation() != 0) {
+					for (uint8_t bit = 0; bit < 8; bit++) {
+						bool set = (bits >> bit) & 1;
+						if (opaque) {
+							canvas->drawPixel(x + column, y + page * 8 + bit, set ? SSD1306_WHITE : SSD1306_BLACK);
+						} else if (set) {
+							canvas->drawPixel(x + column, y + page * 8 + bit, color);
+						}
+					}
+					continue;
+				}
+
+				int16_t dx = x + column;
+				if (dx < 0 || dx >= bufferWidth) {
+					continue;
+				}
+
+				// Page-aligned glyphs are a single byte each; otherwise the
+				// column straddles two pages and is merged into both
+				int16_t target = firstPage + page;
+				if (target >= 0 && target < bufferPages) {
+					mergeDigitBits(buffer + target * bufferWidth + dx, (uint8_t)(bits << shift),
+					               (uint8_t)(0xFF << shift), color, opaque);
+				}
+				if (shift != 0 && target + 1 >= 0 && target + 1 < bufferPages) {
+					mergeDigitBits(buffer + (target + 1) * bufferWidth + dx, (uint8_t)(bits >> (8 - shift)),
+					               (uint8_t)(0xFF >> (8 - shift)), color, opaque);
+				}
+			}
+		}
+		x += cellWidth;
+	}
+
+	return x - startX;
+}
+
+int16_t WeatherAnimationsLib::drawDigits(uint16_t* strip, uint16_t stripWidth, uint16_t stripHeight, int16_t x, int16_t y,
+                                         const char* text, uint8_t font, uint16_t fgColor, uint16_t bgColor) {
+	if (strip == nullptr || text == nullptr || font >= DIGIT_FONT_COUNT) {
+		return 0;
+	}
+
+	const DigitFont& digitFont = digitFonts[font];
+	int16_t startX = x;
+
+	for (const char* c = text; *c != '\0'; c++) {
+		int8_t index = digitGlyphIndex(*c);
+		if (index < 0) {
+			continue;
+		}
+		uint16_t offset = pgm_read_word(&digitFont.glyphs[index].offset);
+		uint8_t width = pgm_read_byte(&digitFont.glyphs[index].width);
+		uint8_t cellWidth = width + digitFont.spacing;
+
+		for (uint8_t column = 0; column < cellWidth; column++) {
+			int16_t dx = x + column;
+			if (dx < 0 || dx >= stripWidth) {
+				continue;
+			}
+			for (uint8_t page = 0; page < digitFont.pages; page++) {
+				uint8_t bits = digitColumn(digitFont, offset, width, page, column);
+				for (uint8_t bit = 0; bit < 8; bit++) {
+					int16_t dy = y + page * 8 + bit;
+					if (dy >= 0 && dy < stripHeight) {
+						strip[dy * stripWidth + dx] = ((bits >> bit) & 1) ? fgColor : bgColor;
+					}
+				}
+			}
+		}
+		x += cellWidth;
+	}
+
+	return x - startX;
+}
+
+#if defined(ESP32) || defined(ESP8266)
+int16_t WeatherAnimationsLib::drawDigits(TFT_eSPI* tft, int16_t x, int16_t y, const char* text, uint8_t font,
+                                         uint16_t fgColor, uint16_t bgColor) {
+	if (tft == nullptr || text == nullptr || font >= DIGIT_FONT_COUNT) {
+		return 0;
+	}
+
+	const DigitFont& digitFont = digitFonts[font];
+	uint16_t strip[DIGIT_MAX_CELL_WIDTH * 8];
+	char glyph[2] = { 0, 0 };
+	int16_t startX = x;
+
+	// Strips hold native-endian colours, so let the driver swap them
+	bool swapBytes = tft->getSwapBytes();
+	tft->setSwapBytes(true);
+	for (const char* c = text; *c != '\0'; c++) {
+		if (digitGlyphIndex(*c) < 0) {
+			continue;
+		}
+		glyph[0] = *c;
+		uint16_t cellWidth = digitTextWidth(glyph, font);
+		for (uint8_t page = 0; page < digitFont.pages; page++) {
+			drawDigits(strip, cellWidth, 8, 0, -page * 8, glyph, font, fgColor, bgColor);
+			tft->pushImage(x, y + page * 8, cellWidth, 8, strip);
+		}
+		x += cellWidth;
+	}
+	tft->setSwapBytes(swapBytes);
+
+	return x - startX;
+}
+#endif
@@ -0,0 +1,74 @@
+#ifndef WEATHER_ANIMATIONS_DIGITS_H
+#define WEATHER_ANIMATIONS_DIGITS_H
+
+#include <Arduino.h>
+#include "WeatherAnimationsCanvas.h"
+
+#if defined(ESP32) || defined(ESP8266)
+#include <TFT_eSPI.h>
+#endif
+
+// Numeric fonts (see generate_digit_font.py)
+#define DIGIT_FONT_SMALL 0    // 5x8, same glyphs as print() at text size 1
+#define DIGIT_FONT_MEDIUM 1   // 10x16, same glyphs as print() at text size 2
+#define DIGIT_FONT_LARGE 2    // 15x24, same glyphs as print() at text size 3
+#define DIGIT_FONT_SEGMENT 3  // 20x40 seven-segment style for large readouts
+#define DIGIT_FONT_COUNT 4
+
+// Glyphs: 0-9, '-', '.', DIGIT_DEGREE, 'C', 'F' and ' '
+#define DIGIT_GLYPH_COUNT 16
+#define DIGIT_DEGREE '\xB0'
+
+// How drawDigits() treats the background of each glyph cell on a canvas
+#define DIGIT_TRANSPARENT 0   // only the set bits are drawn, like print() without a background colour
+#define DIGIT_OPAQUE 1        // the whole cell is written, for callers that own it
+
+namespace WeatherAnimationsLib {
+
+struct DigitGlyph {
+	uint16_t offset;  // Into the font bitmap
+	uint8_t width;    // Columns, without spacing
+};
+
+struct DigitFont {
+	uint8_t pages;    // Glyph height in 8-row pages
+	uint8_t spacing;  // Blank columns after each glyph
+	const DigitGlyph* glyphs;
+	const uint8_t* bitmap;
+};
+
+// Width in pixels of text drawn with drawDigits(), including glyph spacing
+uint16_t digitTextWidth(const char* text, uint8_t font);
+
+// Height in pixels of a digit font
+uint8_t digitFontHeight(uint8_t font);
+
+// Format a temperature such as "-4.5°C" using the glyphs above.
+// Pass unit 0 to leave out the unit; showDegree adds DIGIT_DEGREE before it.
+size_t formatTemperature(char* buffer, size_t size, float value, uint8_t decimals,
+                         char unit = 'C', bool showDegree = true);
+
+// Draw digits with their top-left corner at (x, y). DIGIT_TRANSPARENT leaves
+// the pixels around the glyphs alone, so digits can sit over an icon.
+// DIGIT_OPAQUE writes each glyph cell whole, so a new value can be written
+// over the old one without clearing; with y a multiple of 8 every column is
+// then a single byte store. color SSD1306_WHITE draws white (on black when
+// opaque), SSD1306_BLACK black (on white); SSD1306_INVERSE flips the set
+// bits and is always transparent.
+// Returns the width drawn. Characters outside the glyph set are skipped.
+int16_t drawDigits(OLEDCanvas* canvas, int16_t x, int16_t y, const char* text, uint8_t font,
+                   uint16_t color = SSD1306_WHITE, uint8_t mode = DIGIT_TRANSPARENT);
+
+// Draw digits into a row-major RGB565 strip
+int16_t drawDigits(uint16_t* strip, uint16_t stripWidth, uint16_t stripHeight, int16_t x, int16_t y,
+                   const char* text, uint8_t font, uint16_t fgColor, uint16_t bgColor);
+
+#if defined(ESP32) || defined(ESP8266)
+// Draw digits on a TFT, one 8-row strip per glyph page
+int16_t drawDigits(TFT_eSPI* tft, int16_t x, int16_t y, const char* text, uint8_t font,
+                   uint16_t fgColor, uint16_t bgColor);
+#endif
+
+}
+
+#endif // WEATHER_ANIMATIONS_DIGITS_H
@@ -0,0 +1,837 @@
+#include "WeatherAnimationsHub.h"
+#include "WeatherAnimations.h"
+#include "WeatherAnimationsPerf.h"
+#include "WeatherAnimationsRecorder.h"
+
+#include <WiFi.h>
+#include <time.h>
+
+using namespace WeatherAnimationsLib;
+
+// HTTP/1.0 so that the reply is never chunked
+static const char* const requestFormat =
+	"GET /api/states/%s HTTP/1.0\r\nHost: %s\r\nAuthorization: Bearer %s\r\nConnection: close\r\n\r\n";
+
+// Helper function to GET one Home Assistant state, running the step-wise
+// request to completion. Returns the HTTP code; on 200 *response holds the
+// scanned body, which stays valid until the next call.
+static int getHAState(const char* haIP, const char* haToken, const char* entityID, const HARequest** response) {
+	// Shared by the blocking calls, which all run on the same task
+	static PollArena arena(HA_REQUEST_ARENA_SIZE);
+	static HARequestTemplates templates;
+	static HARequest request;
+
+	size_t length = 0;
+	const char* text = templates.lookup(haIP, haToken, entityID, &length);
+	arena.reset();
+	request.begin(haIP, text, length, &arena);
+	while (request.busy()) {
+		request.step(millis());
+		if (request.busy()) {
+			delay(1);
+		}
+	}
+	if (request.state() != HA_REQUEST_DONE) {
+		return request.statusCode() != 0 ? request.statusCode() : -1;
+	}
+	*response = &request;
+	return request.statusCode();
+}
+
+// Keys of the HA_FIELD_* values, and the bytes that end each value
+static const char* const fieldKeys[HA_FIELD_COUNT] = {
+	"\"state\":\"", "\"forecast_temp_min\":", "\"forecast_temp_max\":", "\"is_daytime\":"};
+static const char* const fieldEnds[HA_FIELD_COUNT] = {"\"", ",}", ",}", ",}"};
+
+#define HA_FIELD_SEARCH 0
+#define HA_FIELD_VALUE 1
+#define HA_FIELD_DONE 2
+
+HAStateScanner::HAStateScanner() {
+	reset();
+}
+
+void HAStateScanner::reset() {
+	for (uint8_t i = 0; i < HA_FIELD_COUNT; i++) {
+		_values[i][0] = '\0';
+		_matched[i] = 0;
+		_lengths[i] = 0;
+		_phases[i] = HA_FIELD_SEARCH;
+	}
+}
+
+void HAStateScanner::scan(const char* data, size_t size) {
+	const char* end = data + size;
+	while (data < end) {
+		// Between keys only a quote can start one, so skip to the next
+		bool matching = false;
+		bool searching = false;
+		for (uint8_t i = 0; i < HA_FIELD_COUNT; i++) {
+			matching = matching || _phases[i] == HA_FIELD_VALUE || _matched[i] > 0;
+			searching = searching || _phases[i] == HA_FIELD_SEARCH;
+		}
+		if (!matching) {
+			if (!searching) {
+				return;
+			}
+			data = (const char*)memchr(data, '"', end - data);
+			if (data == nullptr) {
+				return;
+			}
+		}
+
+		char c = *data++;
+		for (uint8_t i = 0; i < HA_FIELD_COUNT; i++) {
+			if (_phases[i] == HA_FIELD_VALUE) {
+				if (strchr(fieldEnds[i], c) != nullptr) {
+					_values[i][_lengths[i]] = '\0';
+					_phases[i] = HA_FIELD_DONE;
+				} else if (_lengths[i] < WEATHER_CONDITION_LENGTH - 1) {
+					_values[i][_lengths[i]++] = c;
+				}
+			} else if (_phases[i] == HA_FIELD_SEARCH) {
+				// Every key has its only quotes where a match cannot restart, so a
+				// mismatch starts over from this byte
+				if (c == fieldKeys[i][_matched[i]]) {
+					if (fieldKeys[i][++_matched[i]] == '\0') {
+						_phases[i] = HA_FIELD_VALUE;
+					}
+				} else {
+					_matched[i] = c == '"' ? 1 : 0;
+				}
+			}
+		}
+	}
+}
+
+const char* HAStateScanner::field(uint8_t index) const {
+	if (index >= HA_FIELD_COUNT || _phases[index] != HA_FIELD_DONE || _lengths[index] == 0) {
+		return nullptr;
+	}
+	return _values[index];
+}
+
+void WeatherAnimationsLib::clearWeatherSnapshot(WeatherSnapshot* snapshot) {
+	snapshot->condition[0] = '\0';
+	snapshot->isDaytime = true;
+	snapshot->hasCondition = false;
+	snapshot->minForecastTemp = 0;
+	snapshot->maxForecastTemp = 0;
+	snapshot->indoorTemp = 0;
+	snapshot->outdoorTemp = 0;
+	snapshot->hasTemperatureData = false;
+	snapshot->sequence = 0;
+}
+
+bool WeatherAnimationsLib::fetchWeatherState(const char* haIP, const char* haToken, const char* entityID,
+                                             WeatherSnapshot* snapshot) {
+	const HARequest* response;
+	int httpCode = getHAState(haIP, haToken, entityID, &response);
+	if (httpCode != 200) {
+		WA_LOG_WARN("Failed to fetch weather, HTTP code: %d", httpCode);
+		return false;
+	}
+	return parseWeatherState(response->fields(), response->body(), snapshot);
+}
+
+// Helper function to turn the scanned fields of a weather entity into snapshot fields
+static bool applyWeatherState(const HAStateScanner& fields, const char* text, WeatherSnapshot* snapshot) {
+	// Extract min/max forecast temperatures
+	const char* value = fields.field(HA_FIELD_MIN_TEMP);
+	if (value != nullptr) {
+		snapshot->minForecastTemp = (float)atof(value);
+		WA_LOG_DEBUG("Min forecast temp: %.1f", snapshot->minForecastTemp);
+	}
+	value = fields.field(HA_FIELD_MAX_TEMP);
+	if (value != nullptr) {
+		snapshot->maxForecastTemp = (float)atof(value);
+		WA_LOG_DEBUG("Max forecast temp: %.1f", snapshot->maxForecastTemp);
+	}
+
+	// Condition from the state
+	char condition[WEATHER_CONDITION_LENGTH];
+	const char* state = fields.field(HA_FIELD_STATE);
+	if (state != nullptr) {
+		memcpy(condition, state, WEATHER_CONDITION_LENGTH);
+	}
+
+	// Check for daytime attribute (if available)
+	bool isDaytime = true;
+	bool isDayFound = false;
+	const char* isDay = fields.field(HA_FIELD_DAYTIME);
+	if (isDay != nullptr) {
+		// Could be true or false
+		if (strncmp(isDay, "true", 4) == 0) {
+			isDaytime = true;
+			isDayFound = true;
+		} else if (strncmp(isDay, "false", 5) == 0) {
+			isDaytime = false;
+			isDayFound = true;
+		}
+	}
+
+	// If no daytime attribute, guess based on time
+	if (!isDayFound) {
+		// Simple heuristic: 6 AM to 6 PM is daytime
+		time_t now;
+		time(&now);
+		struct tm *timeinfo = localtime(&now);
+		isDaytime = (timeinfo->tm_hour >= 6 && timeinfo->tm_hour < 18);
+	}
+
+	// If condition is empty or invalid, try to detect from payload text
+	if (state == nullptr) {
+		const char* detected;
+		if (strstr(text, "clear") != nullptr || strstr(text, "sunny") != nullptr) {
+			detected = strstr(text, "night") != nullptr ? "clear-night" : "sunny";
+		} else if (strstr(text, "cloud") != nullptr) {
+			detected = strstr(text, "partly") != nullptr ? "partlycloudy" : "cloudy";
+		} else if (strstr(text, "fog") != nullptr) {
+			detected = "fog";
+		} else if (strstr(text, "hail") != nullptr) {
+			detected = "hail";
+		} else if (strstr(text, "lightning") != nullptr || strstr(text, "thunder") != nullptr) {
+			detected = strstr(text, "rain") != nullptr ? "lightning-rainy" : "lightning";
+		} else if (strstr(text, "pouring") != nullptr) {
+			detected = "pouring";
+		} else if (strstr(text, "rain") != nullptr || strstr(text, "drizzle") != nullptr) {
+			detected = "rainy";
+		} else if (strstr(text, "snow") != nullptr) {
+			detected = strstr(text, "rain") != nullptr ? "snowy-rainy" : "snowy";
+		} else if (strstr(text, "wind") != nullptr) {
+			detected = strstr(text, "extreme") != nullptr ? "windy-variant" : "windy";
+		} else {
+			detected = "cloudy"; // Default
+		}
+		strncpy(condition, detected, sizeof(condition) - 1);
+		condition[sizeof(condition) - 1] = '\0';
+	}
+
+	memcpy(snapshot->condition, condition, WEATHER_CONDITION_LENGTH);
+	snapshot->isDaytime = isDaytime;
+	snapshot->hasCondition = true;
+	return true;
+}
+
+// Helper function to read the state of a temperature sensor
+static bool applyTemperatureState(const HAStateScanner& fields, float* value) {
+	const char* state = fields.field(HA_FIELD_STATE);
+	if (state == nullptr) {
+		return false;
+	}
+	*value = (float)atof(state);
+	WA_LOG_DEBUG("Temperature: %.1f", *value);
+	return true;
+}
+
+bool WeatherAnimationsLib::parseWeatherState(const char* payload, WeatherSnapshot* snapshot) {
+	WA_PERF_SCOPE(PERF_PARSE);
+	WA_LOG_VERBOSE("Home Assistant weather response, %u bytes", (unsigned)strlen(payload));
+	HAStateScanner fields;
+	fields.scan(payload, strlen(payload));
+	return applyWeatherState(fields, payload, snapshot);
+}
+
+bool WeatherAnimationsLib::parseWeatherState(const HAStateScanner& fields, const char* text,
+                                             WeatherSnapshot* snapshot) {
+	WA_PERF_SCOPE(PERF_PARSE);
+	return applyWeatherState(fields, text, snapshot);
+}
+
+bool WeatherAnimationsLib::fetchTemperatureState(const char* haIP, const char* haToken, const char* entityID,
+                                                 float* value) {
+	if (entityID == nullptr) {
+		return false;
+	}
+
+	const HARequest* response;
+	int httpCode = getHAState(haIP, haToken, entityID, &response);
+	if (httpCode != 200) {
+		WA_LOG_WARN("Failed to fetch temperature, HTTP code: %d", httpCode);
+		return false;
+	}
+	return parseTemperatureState(response->fields(), value);
+}
+
+bool WeatherAnimationsLib::parseTemperatureState(const char* payload, float* value) {
+	WA_PERF_SCOPE(PERF_PARSE);
+	WA_LOG_VERBOSE("Home Assistant temperature response, %u bytes", (unsigned)strlen(payload));
+	HAStateScanner fields;
+	fields.scan(payload, strlen(payload));
+	return applyTemperatureState(fields, value);
+}
+
+bool WeatherAnimationsLib::parseTemperatureState(const HAStateScanner& fields, float* value) {
+	WA_PERF_SCOPE(PERF_PARSE);
+	return applyTemperatureState(fields, value);
+}
+
+HARequestTemplates::HARequestTemplates()
+	: _buffer(nullptr), _capacity(0), _haIP(nullptr), _haToken(nullptr), _count(0), _builds(0) {
+	for (uint8_t i = 0; i < HA_TEMPLATE_MAX_ENTITIES; i++) {
+		_entities[i] = nullptr;
+		_offsets[i] = 0;
+		_lengths[i] = 0;
+	}
+}
+
+HARequestTemplates::~HARequestTemplates() {
+	free(_buffer);
+}
+
+bool HARequestTemplates::build(const char* haIP, const char* haToken, const char* const* entityIDs, uint8_t count) {
+	if (count > HA_TEMPLATE_MAX_ENTITIES) {
+		return false;
+	}
+	if (_builds > 0 && haIP == _haIP && haToken == _haToken && count == _count) {
+		bool same = true;
+		for (uint8_t i = 0; i < count; i++) {
+			same = same && entityIDs[i] == _entities[i];
+		}
+		if (same) {
+			return true;
+		}
+	}
+
+	// Measure every request first so the buffer is (re)allocated at most once
+	int lengths[HA_TEMPLATE_MAX_ENTITIES];
+	size_t total = 0;
+	for (uint8_t i = 0; i < count; i++) {
+		lengths[i] = entityIDs[i] != nullptr ? snprintf(nullptr, 0, requestFormat, entityIDs[i], haIP, haToken) : 0;
+		total += lengths[i] + 1;
+	}
+	_count = 0;
+	if (total > _capacity) {
+		char* buffer = (char*)realloc(_buffer, total);
+		if (buffer == nullptr) {
+			WA_LOG_ERROR("Failed to allocate memory for Home Assistant requests");
+			return false;
+		}
+		_buffer = buffer;
+		_capacity = total;
+	}
+
+	size_t offset = 0;
+	for (uint8_t i = 0; i < count; i++) {
+		_entities[i] = entityIDs[i];
+		_offsets[i] = offset;
+		_lengths[i] = lengths[i];
+		if (entityIDs[i] != nullptr) {
+			snprintf(_buffer + offset, lengths[i] + 1, requestFormat, entityIDs[i], haIP, haToken);
+		}
+		offset += lengths[i] + 1;
+	}
+	_haIP = haIP;
+	_haToken = haToken;
+	_count = count;
+	_builds++;
+	return true;
+}
+
+const char* HARequestTemplates::request(uint8_t index, size_t* length) const {
+	if (index >= _count || _entities[index] == nullptr) {
+		return nullptr;
+	}
+	*length = _lengths[index];
+	return _buffer + _offsets[index];
+}
+
+const char* HARequestTemplates::lookup(const char* haIP, const char* haToken, const char* entityID, size_t* length) {
+	if (entityID == nullptr) {
+		return nullptr;
+	}
+	bool sameHost = _builds > 0 && haIP == _haIP && haToken == _haToken;
+	if (sameHost) {
+		for (uint8_t i = 0; i < _count; i++) {
+			if (_entities[i] == entityID) {
+				return request(i, length);
+			}
+		}
+	}
+
+	// Keep the entities already built unless the host changed or the set is full
+	const char* entities[HA_TEMPLATE_MAX_ENTITIES];
+	uint8_t count = 0;
+	if (sameHost && _count < HA_TEMPLATE_MAX_ENTITIES) {
+		for (; count < _count; count++) {
+			entities[count] = _entities[count];
+		}
+	}
+	entities[count++] = entityID;
+	if (!build(haIP, haToken, entities, count)) {
+		return nullptr;
+	}
+	return request(count - 1, length);
+}
+
+uint32_t HARequestTemplates::builds() const {
+	return _builds;
+}
+
+HARequest::HARequest()
+	: _haIP(nullptr), _request(nullptr), _requestLength(0), _arena(nullptr), _state(HA_REQUEST_IDLE),
+	  _statusCode(0), _contentLength(-1), _line(nullptr), _lineLength(0), _body(nullptr), _chunk(nullptr), _bodyLength(0),
+	  _bodyCapacity(0), _lastProgress(0), _startTicks(0), _recordConnection(0) {
+}
+
+void HARequest::begin(const char* haIP, const char* request, size_t requestLength, PollArena* arena) {
+	reset();
+	_haIP = haIP;
+	_request = request;
+	_requestLength = requestLength;
+	_arena = arena;
+	_state = HA_REQUEST_CONNECT;
+	_startTicks = perfTicks();
+}
+
+// Buffers belong to the arena, which the owner resets
+void HARequest::reset() {
+	_client.stop();
+	_state = HA_REQUEST_IDLE;
+	_statusCode = 0;
+	_contentLength = -1;
+	_line = nullptr;
+	_lineLength = 0;
+	_body = nullptr;
+	_chunk = nullptr;
+	_bodyLength = 0;
+	_bodyCapacity = 0;
+	_fields.reset();
+}
+
+// Helper function to read the response headers one line at a time.
+// Returns true once the blank line that ends them has been read.
+bool HARequest::readHeaderLine(uint32_t now) {
+	int budget = HA_REQUEST_CHUNK;
+	while (budget-- > 0 && _client.available() > 0) {
+		char c = (char)_client.read();
+		_lastProgress = now;
+		if (recordActive()) {
+			recordReceived(_recordConnection, (const uint8_t*)&c, 1);
+		}
+		if (c == '\r') {
+			continue;
+		}
+		if (c != '\n') {
+			// Only the status line and Content-Length matter, longer lines are cut short
+			if (_lineLength < HA_REQUEST_LINE_LENGTH - 1) {
+				_line[_lineLength++] = c;
+			}
+			continue;
+		}
+
+		if (_lineLength == 0) {
+			return true;
+		}
+		_line[_lineLength] = '\0';
+		if (_statusCode == 0 && strncmp(_line, "HTTP/", 5) == 0) {
+			const char* space = strchr(_line, ' ');
+			_statusCode = space != nullptr ? atoi(space + 1) : -1;
+		} else if (strncasecmp(_line, "content-length:", 15) == 0) {
+			_contentLength = atol(_line + 15);
+		}
+		_lineLength = 0;
+	}
+	return false;
+}
+
+uint8_t HARequest::step(uint32_t now) {
+	WA_ALLOC_SCOPE(PERF_HTTP);
+	switch (_state) {
+		case HA_REQUEST_CONNECT: {
+			if (_request == nullptr) {
+				_state = HA_REQUEST_FAILED;
+				break;
+			}
+			_line = (char*)_arena->allocate(HA_REQUEST_LINE_LENGTH);
+			if (_line == nullptr) {
+				WA_LOG_WARN("Poll arena full");
+				_state = HA_REQUEST_FAILED;
+				break;
+			}
+
+			uint32_t connectStart = recordActive() ? recordMillis() : 0;
+			bool connected = _client.connect(_haIP, 8123);
+			if (recordActive()) {
+				_recordConnection = recordConnect(connected, recordMillis() - connectStart);
+			}
+			if (!connected) {
+				WA_LOG_WARN("Failed to connect to Home Assistant");
+				_state = HA_REQUEST_FAILED;
+				break;
+			}
+			// The request was built in advance, so sending it is one write
+			_client.write((const uint8_t*)_request, _requestLength);
+			_lastProgress = now;
+			_state = HA_REQUEST_HEADERS;
+			break;
+		}
+
+		case HA_REQUEST_HEADERS:
+			if (readHeaderLine(now)) {
+				if (_statusCode != 200 || _contentLength > (long)HA_REQUEST_MAX_BODY) {
+					WA_LOG_WARN("Home Assistant request failed, HTTP code: %d", _statusCode);
+					_client.stop();
+					_state = HA_REQUEST_FAILED;
+					break;
+				}
+				// The start of the body is kept, the rest read through a chunk buffer
+				bool kept = _contentLength >= 0 && _contentLength <= HA_REQUEST_BODY_KEPT;
+				_bodyCapacity = kept ? _contentLength : HA_REQUEST_BODY_KEPT;
+				_body = (char*)_arena->allocate(_bodyCapacity + 1);
+				if (!kept && _body != nullptr) {
+					_chunk = (char*)_arena->allocate(HA_REQUEST_CHUNK);
+				}
+				if (_body == nullptr || (!kept && _chunk == nullptr)) {
+					WA_LOG_WARN("Poll arena full");
+					_client.stop();
+					_state = HA_REQUEST_FAILED;
+					break;
+				}
+				_body[0] = '\0';
+				_state = HA_REQUEST_BODY;
+			} else if (_client.available() <= 0 && !_client.connected()) {
+				if (recordActive()) {
+					recordClosed(_recordConnection);
+				}
+				_state = HA_REQUEST_FAILED;
+			}
+			break;
+
+		case HA_REQUEST_BODY: {
+			int count = _client.available();
+			if (count > 0) {
+				if (count > HA_REQUEST_CHUNK) count = HA_REQUEST_CHUNK;
+				if (_contentLength >= 0 && count > _contentLength - (long)_bodyLength) {
+					count = _contentLength - _bodyLength;
+				}
+				// Bytes go into the kept text while it has room, then into the chunk buffer
+				char* target = _chunk;
+				if (_bodyLength < _bodyCapacity) {
+					if ((size_t)count > _bodyCapacity - _bodyLength) count = _bodyCapacity - _bodyLength;
+					target = _body + _bodyLength;
+				}
+				count = _client.read((uint8_t*)target, count);
+				if (count > 0) {
+					if (recordActive()) {
+						recordReceived(_recordConnection, (const uint8_t*)target, count);
+					}
+					_fields.scan(target, count);
+					if (target != _chunk) {
+						target[count] = '\0';
+					}
+					_bodyLength += count;
+					_lastProgress = now;
+					// Without a Content-Length the body could go on for ever
+					if (_bodyLength > HA_REQUEST_MAX_BODY) {
+						WA_LOG_WARN("Home Assistant response too large");
+						_client.stop();
+						_state = HA_REQUEST_FAILED;
+						break;
+					}
+				}
+			}
+			if (_contentLength >= 0 && (long)_bodyLength >= _contentLength) {
+				_client.stop();
+				_state = HA_REQUEST_DONE;
+			} else if (_client.available() <= 0 && !_client.connected()) {
+				if (recordActive()) {
+					recordClosed(_recordConnection);
+				}
+				// Without a Content-Length the body ends when the server closes
+				_state = _contentLength < 0 ? HA_REQUEST_DONE : HA_REQUEST_FAILED;
+			}
+			break;
+		}
+
+		default:
+			return _state;
+	}
+
+	if ((_state == HA_REQUEST_HEADERS || _state == HA_REQUEST_BODY) && now - _lastProgress > HA_REQUEST_TIMEOUT) {
+		WA_LOG_WARN("Home Assistant request timed out");
+		_client.stop();
+		_state = HA_REQUEST_FAILED;
+	}
+	if (!busy()) {
+		perfRecord(PERF_HTTP, _startTicks, "status", _statusCode);
+	}
+	return _state;
+}
+
+uint8_t HARequest::state() const {
+	return _state;
+}
+
+bool HARequest::busy() const {
+	return _state != HA_REQUEST_IDLE && _state != HA_REQUEST_DONE && _state != HA_REQUEST_FAILED;
+}
+
+int HARequest::statusCode() const {
+	return _statusCode;
+}
+
+const char* HARequest::body() const {
+	return _body != nullptr ? _body : "";
+}
+
+size_t HARequest::bodyLength() const {
+	return _bodyLength;
+}
+
+const HAStateScanner& HARequest::fields() const {
+	return _fields;
+}
+
+HAPoller::HAPoller()
+	: _arena(HA_REQUEST_ARENA_SIZE), _haIP(nullptr), _stage(3), _parsePending(false) {
+	for (uint8_t i = 0; i < 3; i++) {
+		_entities[i] = nullptr;
+		_stageSuccess[i] = false;
+	}
+	clearWeatherSnapshot(&_result);
+}
+
+void HAPoller::start(const char* haIP, const char* haToken, const char* weatherEntity,
+                     const char* indoorTempEntity, const char* outdoorTempEntity,
+                     const WeatherSnapshot& previous) {
+	_haIP = haIP;
+	_entities[0] = weatherEntity;
+	_entities[1] = indoorTempEntity;
+	_entities[2] = outdoorTempEntity;
+	_templates.build(haIP, haToken, _entities, 3);
+	_result = previous;
+	_parsePending = false;
+	for (uint8_t i = 0; i < 3; i++) {
+		_stageSuccess[i] = false;
+	}
+
+	// Stage 0 is the weather entity, 1 and 2 the indoor and outdoor sensors
+	_stage = 0;
+	if (stageEntity() == nullptr) {
+		nextStage();
+	} else {
+		beginStage();
+	}
+}
+
+const char* HAPoller::stageEntity() const {
+	return _stage < 3 ? _entities[_stage] : nullptr;
+}
+
+// Helper function to send the current stage's prebuilt request
+void HAPoller::beginStage() {
+	size_t length = 0;
+	const char* request = _templates.request(_stage, &length);
+	_arena.reset();
+	_request.begin(_haIP, request, length, &_arena);
+}
+
+// Helper function to move on to the next entity that is configured
+void HAPoller::nextStage() {
+	_request.reset();
+	do {
+		_stage++;
+	} while (_stage < 3 && stageEntity() == nullptr);
+	// The previous response has been parsed, so its buffers can be reused
+	if (_stage < 3) {
+		beginStage();
+	} else {
+		_arena.reset();
+	}
+}
+
+uint8_t HAPoller::step(uint32_t now) {
+	if (_stage < 3) {
+		if (_parsePending) {
+			// Parse step: turn the finished response into snapshot fields
+			_parsePending = false;
+			if (_stage == 0) {
+				_stageSuccess[0] = parseWeatherState(_request.fields(), _request.body(), &_result);
+			} else {
+				float* target = (_stage == 1) ? &_result.indoorTemp : &_result.outdoorTemp;
+				_stageSuccess[_stage] = parseTemperatureState(_request.fields(), target);
+			}
+			nextStage();
+		} else {
+			// Network step
+			uint8_t state = _request.step(now);
+			if (state == HA_REQUEST_DONE) {
+				_parsePending = true;
+			} else if (state == HA_REQUEST_FAILED) {
+				nextStage();
+			}
+		}
+		if (_stage < 3) {
+			return HA_POLL_BUSY;
+		}
+	}
+
+	_result.hasCondition = _stageSuccess[0];
+	_result.hasTemperatureData = _stageSuccess[1] || _stageSuccess[2];
+	return (_result.hasCondition || _result.hasTemperatureData) ? HA_POLL_DONE : HA_POLL_FAILED;
+}
+
+bool HAPoller::busy() const {
+	return _stage < 3;
+}
+
+const WeatherSnapshot& HAPoller::result() const {
+	return _result;
+}
+
+const PollArena& HAPoller::arena() const {
+	return _arena;
+}
+
+const HARequestTemplates& HAPoller::templates() const {
+	return _templates;
+}
+
+WeatherDataHub::WeatherDataHub(const char* haIP, const char* haToken)
+	: _haIP(haIP), _haToken(haToken), _weatherEntityID("weather.forecast"),
+	  _indoorTempEntity("sensor.t_h_sensor_temperature"), _outdoorTempEntity("sensor.sam_outside_temperature"),
+	  _displayCount(0), _nextPoll(0), _fetchInterval(WEATHER_HUB_DEFAULT_INTERVAL), _lastFetchTime(0), _fetchCount(0),
+	  _clock(systemClock()) {
+	for (uint8_t i = 0; i < WEATHER_HUB_MAX_DISPLAYS; i++) {
+		_displays[i] = nullptr;
+	}
+	clearWeatherSnapshot(&_snapshot);
+}
+
+void WeatherDataHub::setWeatherEntity(const char* entityID) {
+	_weatherEntityID = entityID;
+}
+
+void WeatherDataHub::setTemperatureEntities(const char* indoorTempEntity, const char* outdoorTempEntity) {
+	_indoorTempEntity = indoorTempEntity;
+	_outdoorTempEntity = outdoorTempEntity;
+}
+
+void WeatherDataHub::setFetchInterval(unsigned long interval) {
+	_fetchInterval = interval;
+}
+
+unsigned long WeatherDataHub::fetchInterval() const {
+	return _fetchInterval;
+}
+
+void WeatherDataHub::setClock(Clock* clock) {
+	_clock = clock != nullptr ? clock : systemClock();
+}
+
+bool WeatherDataHub::addDisplay(WeatherAnimations* display) {
+	if (display == nullptr) {
+		return false;
+	}
+	for (uint8_t i = 0; i < _displayCount; i++) {
+		if (_displays[i] == display) {
+			return true;
+		}
+	}
+	if (_displayCount >= WEATHER_HUB_MAX_DISPLAYS) {
+		return false;
+	}
+	_displays[_displayCount++] = display;
+
+	// Late joiners start from the data the others already show
+	if (_snapshot.sequence > 0) {
+		display->applyWeatherSnapshot(_snapshot);
+	}
+	return true;
+}
+
+void WeatherDataHub::removeDisplay(WeatherAnimations* display) {
+	for (uint8_t i = 0; i < _displayCount; i++) {
+		if (_displays[i] == display) {
+			for (uint8_t j = i + 1; j < _displayCount; j++) {
+				_displays[j - 1] = _displays[j];
+			}
+			_displays[--_displayCount] = nullptr;
+			return;
+		}
+	}
+}
+
+bool WeatherDataHub::update() {
+	if (_fetchCount > 0 && _clock->millis() - _lastFetchTime < _fetchInterval) {
+		return false;
+	}
+	return refresh();
+}
+
+bool WeatherDataHub::refresh() {
+	if (WiFi.status() != WL_CONNECTED) {
+		WA_LOG_VERBOSE("WiFi not connected, skipping weather data fetch.");
+		return false;
+	}
+
+	WA_LOG_DEBUG("Hub fetching weather data...");
+	bool weatherSuccess = fetchWeatherState(_haIP, _haToken, _weatherEntityID, &_snapshot);
+	bool indoorSuccess = fetchTemperatureState(_haIP, _haToken, _indoorTempEntity, &_snapshot.indoorTemp);
+	bool outdoorSuccess = fetchTemperatureState(_haIP, _haToken, _outdoorTempEntity, &_snapshot.outdoorTemp);
+
+	_snapshot.hasCondition = weatherSuccess;
+	_snapshot.hasTemperatureData = indoorSuccess || outdoorSuccess;
+	if (!weatherSuccess && !_snapshot.hasTemperatureData) {
+		WA_LOG_WARN("Failed to fetch weather and temperature data.");
+		return false;
+	}
+
+	_lastFetchTime = _clock->millis();
+	_nextPoll = _lastFetchTime + _fetchInterval;
+	_fetchCount++;
+	publish();
+	return true;
+}
+
+uint32_t WeatherDataHub::tick(uint32_t now) {
+	if (!_poller.busy()) {
+		if (_nextPoll != 0 && (int32_t)(now - _nextPoll) < 0) {
+			return _nextPoll - now;
+		}
+		if (WiFi.status() != WL_CONNECTED) {
+			return 1000;
+		}
+		_poller.start(_haIP, _haToken, _weatherEntityID, _indoorTempEntity, _outdoorTempEntity, _snapshot);
+	}
+
+	uint8_t result = _poller.step(now);
+	if (result == HA_POLL_BUSY) {
+		return 0;
+	}
+
+	if (result == HA_POLL_DONE) {
+		uint32_t sequence = _snapshot.sequence;
+		_snapshot = _poller.result();
+		_snapshot.sequence = sequence;
+		_lastFetchTime = now;
+		_nextPoll = now + _fetchInterval;
+		_fetchCount++;
+		publish();
+	} else {
+		WA_LOG_WARN("Failed to fetch weather and temperature data.");
+		_nextPoll = now + WEATHER_HUB_RETRY_INTERVAL;
+	}
+	return _nextPoll - now;
+}
+
+// Helper function to hand the current snapshot to every registered display
+void WeatherDataHub::publish() {
+	_snapshot.sequence++;
+	for (uint8_t i = 0; i < _displayCount; i++) {
+		_displays[i]->applyWeatherSnapshot(_snapshot);
+	}
+}
+
+const WeatherSnapshot& WeatherDataHub::snapshot() const {
+	return _snapshot;
+}
+
+uint8_t WeatherDataHub::displayCount() const {
+	return _displayCount;
+}
+
+uint32_t WeatherDataHub::fetchCount() const {
+	return _fetchCount;
+}
@@ -0,0 +1,327 @@
+#ifndef WEATHER_ANIMATIONS_HUB_H
+#define WEATHER_ANIMATIONS_HUB_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "WeatherAnimationsArena.h"
+#include "WeatherAnimationsClock.h"
+
+// Most displays a hub can feed
+#define WEATHER_HUB_MAX_DISPLAYS 4
+
+// Default time between Home Assistant polls, in milliseconds
+#define WEATHER_HUB_DEFAULT_INTERVAL 300000UL
+
+// Delay before tick() retries a poll that failed, in milliseconds
+#define WEATHER_HUB_RETRY_INTERVAL 30000UL
+
+// Longest Home Assistant condition name kept in a snapshot
+#define WEATHER_CONDITION_LENGTH 24
+
+// Step-wise request states
+#define HA_REQUEST_IDLE 0
+#define HA_REQUEST_CONNECT 1
+#define HA_REQUEST_HEADERS 2
+#define HA_REQUEST_BODY 3
+#define HA_REQUEST_DONE 4
+#define HA_REQUEST_FAILED 5
+
+// Bytes read per request step, longest header line kept, and how long a
+// request may go without receiving anything before it fails
+#define HA_REQUEST_CHUNK 256
+#define HA_REQUEST_LINE_LENGTH 128
+#define HA_REQUEST_TIMEOUT 5000UL
+
+// Bytes of a response body kept as text. The whole body is scanned for the
+// fields the parsers read as it arrives, so only the condition guess for a
+// response without a state looks at the text.
+#ifndef HA_REQUEST_BODY_KEPT
+#define HA_REQUEST_BODY_KEPT 1024
+#endif
+
+// Largest body read before a request fails; a weather entity with an
+// hourly forecast in its attributes is 6 to 10 kB
+#ifndef HA_REQUEST_MAX_BODY
+#define HA_REQUEST_MAX_BODY 65536UL
+#endif
+
+// Arena block for one request: a header line, the kept body text and its
+// terminator, and the read chunk, each rounded up to the arena alignment
+#define HA_REQUEST_ARENA_SIZE \
+	(HA_REQUEST_LINE_LENGTH + HA_REQUEST_BODY_KEPT + 1 + HA_REQUEST_CHUNK + 3 * POLL_ARENA_ALIGN)
+
+// Fields of a /api/states response, see HAStateScanner
+#define HA_FIELD_STATE 0
+#define HA_FIELD_MIN_TEMP 1
+#define HA_FIELD_MAX_TEMP 2
+#define HA_FIELD_DAYTIME 3
+#define HA_FIELD_COUNT 4
+
+// Most entities one set of request templates holds
+#define HA_TEMPLATE_MAX_ENTITIES 3
+
+// Poll results
+#define HA_POLL_BUSY 0
+#define HA_POLL_DONE 1
+#define HA_POLL_FAILED 2
+
+namespace WeatherAnimationsLib {
+
+class WeatherAnimations;
+
+// One reading of the Home Assistant entities
+struct WeatherSnapshot {
+	char condition[WEATHER_CONDITION_LENGTH]; // Home Assistant condition, e.g. "partlycloudy"
+	bool isDaytime;
+	bool hasCondition;       // condition/isDaytime were read in this poll
+	float minForecastTemp;
+	float maxForecastTemp;
+	float indoorTemp;
+	float outdoorTemp;
+	bool hasTemperatureData; // at least one sensor was read in this poll
+	uint32_t sequence;       // Incremented for every published snapshot
+};
+
+// Reset a snapshot to "nothing known yet"
+void clearWeatherSnapshot(WeatherSnapshot* snapshot);
+
+// Read a weather entity into snapshot (condition, day/night and forecast range)
+bool fetchWeatherState(const char* haIP, const char* haToken, const char* entityID, WeatherSnapshot* snapshot);
+
+// Read a temperature sensor. value is left untouched on failure.
+bool fetchTemperatureState(const char* haIP, const char* haToken, const char* entityID, float* value);
+
+// Picks the fields the parsers read out of a /api/states body while it
+// arrives: "state", "forecast_temp_min", "forecast_temp_max" and
+// "is_daytime". Only the values are kept, so a response of any size is
+// parsed without holding it whole. As with strstr() on the whole body, the
+// first occurrence of each key counts.
+class HAStateScanner {
+public:
+	HAStateScanner();
+
+	void reset();
+	void scan(const char* data, size_t size);
+
+	// Value of an HA_FIELD_*, NUL-terminated, or nullptr if it was not seen
+	// whole; values are cut to WEATHER_CONDITION_LENGTH - 1 characters
+	const char* field(uint8_t index) const;
+
+private:
+	char _values[HA_FIELD_COUNT][WEATHER_CONDITION_LENGTH];
+	uint8_t _matched[HA_FIELD_COUNT];  // bytes of the key matched so far
+	uint8_t _lengths[HA_FIELD_COUNT];
+	uint8_t _phases[HA_FIELD_COUNT];   // looking for the key, reading the value, done
+};
+
+// Parse a /api/states response body for the functions above
+bool parseWeatherState(const char* payload, WeatherSnapshot* snapshot);
+bool parseTemperatureState(const char* payload, float* value);
+
+// The same from a scanned body; text is what was kept of it, for guessing
+// the condition of a response without a state
+bool parseWeatherState(const HAStateScanner& fields, const char* text, WeatherSnapshot* snapshot);
+bool parseTemperatureState(const HAStateScanner& fields, float* value);
+
+// Ready-to-send GET requests (request line and headers) for a few entities.
+//
+// build() formats every request once into a single buffer owned by the
+// set; sending one is then a single write of bytes that already exist. The
+// set keeps the pointers it was built from and only formats again when the
+// host, the token or an entity changes.
+class HARequestTemplates {
+public:
+	HARequestTemplates();
+	~HARequestTemplates();
+
+	// Build requests for up to HA_TEMPLATE_MAX_ENTITIES entities; nullptr entries are skipped
+	bool build(const char* haIP, const char* haToken, const char* const* entityIDs, uint8_t count);
+
+	// Prebuilt request for the entity at index, or nullptr if there is none
+	const char* request(uint8_t index, size_t* length) const;
+
+	// Prebuilt request for an entity, added to the set (and the set rebuilt) if it is missing
+	const char* lookup(const char* haIP, const char* haToken, const char* entityID, size_t* length);
+
+	// Times the requests were formatted
+	uint32_t builds() const;
+
+private:
+	HARequestTemplates(const HARequestTemplates&);
+	HARequestTemplates& operator=(const HARequestTemplates&);
+
+	char* _buffer;
+	size_t _capacity;
+	const char* _haIP;
+	const char* _haToken;
+	const char* _entities[HA_TEMPLATE_MAX_ENTITIES];
+	uint16_t _offsets[HA_TEMPLATE_MAX_ENTITIES];
+	uint16_t _lengths[HA_TEMPLATE_MAX_ENTITIES];
+	uint8_t _count;
+	uint32_t _builds;
+};
+
+// A GET of one /api/states entity that runs a little at a time.
+//
+// Each step() does one bounded piece of work: open the connection and send
+// the request, read up to HA_REQUEST_CHUNK bytes of headers or body, or
+// notice a timeout. Opening the connection is the one step that can block,
+// for as long as the platform's WiFiClient connect timeout.
+//
+// The request text comes prebuilt from an HARequestTemplates, and the
+// header line and the kept start of the body live in the arena given to
+// begin(), so a request allocates and formats nothing. The body is scanned
+// for the parsers' fields as it is read, so it can be longer than what is kept.
+class HARequest {
+public:
+	HARequest();
+
+	// request must stay valid until the request has been sent
+	void begin(const char* haIP, const char* request, size_t requestLength, PollArena* arena);
+	uint8_t step(uint32_t now);
+	void reset();
+
+	uint8_t state() const;
+	bool busy() const;
+	int statusCode() const;
+
+	// First HA_REQUEST_BODY_KEPT bytes of the response body, NUL-terminated;
+	// valid until the arena is reset
+	const char* body() const;
+	// Bytes of the whole body
+	size_t bodyLength() const;
+	// Parser fields of the whole body
+	const HAStateScanner& fields() const;
+
+private:
+	bool readHeaderLine(uint32_t now);
+
+	WiFiClient _client;
+	const char* _haIP;
+	const char* _request;
+	size_t _requestLength;
+	PollArena* _arena;
+	uint8_t _state;
+	int _statusCode;
+	long _contentLength;
+	char* _line;
+	size_t _lineLength;
+	char* _body;
+	char* _chunk;            // read buffer for the body beyond what is kept
+	size_t _bodyLength;
+	size_t _bodyCapacity;
+	HAStateScanner _fields;
+	uint32_t _lastProgress;
+	uint32_t _startTicks;    // perfTicks() at begin()
+	uint32_t _recordConnection; // number of the connection in a running recording
+};
+
+// Step-wise poll of the weather entity and both temperature sensors.
+//
+// Network steps and parse steps alternate: once a response is complete, the
+// next step() parses it into the result before the next request starts.
+// Each request reuses the poller's arena once the previous response has
+// been parsed. The three requests are built when the first poll starts and
+// again only after the entities, host or token change.
+class HAPoller {
+public:
+	HAPoller();
+
+	// Start a poll. Values that are not read again are kept from previous.
+	void start(const char* haIP, const char* haToken, const char* weatherEntity,
+	           const char* indoorTempEntity, const char* outdoorTempEntity,
+	           const WeatherSnapshot& previous);
+
+	// One bounded step. Returns HA_POLL_BUSY until the poll has finished.
+	uint8_t step(uint32_t now);
+
+	bool busy() const;
+	const WeatherSnapshot& result() const;
+
+	// Scratch memory of the requests, for its high-water mark
+	const PollArena& arena() const;
+
+	// Prebuilt requests, for how often they were built
+	const HARequestTemplates& templates() const;
+
+private:
+	const char* stageEntity() const;
+	void beginStage();
+	void nextStage();
+
+	PollArena _arena;
+	HARequestTemplates _templates;
+	HARequest _request;
+	const char* _haIP;
+	const char* _entities[3];
+	WeatherSnapshot _result;
+	uint8_t _stage;
+	bool _parsePending;
+	bool _stageSuccess[3];
+};
+
+// Polls Home Assistant once and hands the result to several displays.
+//
+// Each WeatherAnimations instance normally fetches its own data. Give them all
+// the same hub with setDataHub() and only the hub talks to Home Assistant;
+// the instances' update() or tick() calls let the hub poll when its interval
+// is due.
+class WeatherDataHub {
+public:
+	WeatherDataHub(const char* haIP, const char* haToken);
+
+	// Entities to poll (same defaults as WeatherAnimations)
+	void setWeatherEntity(const char* entityID);
+	void setTemperatureEntities(const char* indoorTempEntity, const char* outdoorTempEntity);
+
+	// Time between polls in milliseconds
+	void setFetchInterval(unsigned long interval);
+	unsigned long fetchInterval() const;
+
+	// Time source for update() and refresh() (nullptr for the board's millis())
+	void setClock(Clock* clock);
+
+	// Register a display; it receives the latest snapshot straight away if there is one
+	bool addDisplay(WeatherAnimations* display);
+	void removeDisplay(WeatherAnimations* display);
+
+	// Poll if the interval has passed. Returns true if a new snapshot was published.
+	bool update();
+
+	// Poll now and publish the result
+	bool refresh();
+
+	// Cooperative version of update(): runs one step of the poll and
+	// returns how many milliseconds until it needs to run again
+	uint32_t tick(uint32_t now);
+
+	// Latest published snapshot
+	const WeatherSnapshot& snapshot() const;
+
+	uint8_t displayCount() const;
+	uint32_t fetchCount() const;
+
+private:
+	void publish();
+
+	const char* _haIP;
+	const char* _haToken;
+	const char* _weatherEntityID;
+	const char* _indoorTempEntity;
+	const char* _outdoorTempEntity;
+
+	WeatherAnimations* _displays[WEATHER_HUB_MAX_DISPLAYS];
+	uint8_t _displayCount;
+
+	WeatherSnapshot _snapshot;
+	HAPoller _poller;
+	uint32_t _nextPoll;
+	unsigned long _fetchInterval;
+	uint32_t _lastFetchTime;
+	uint32_t _fetchCount;
+	Clock* _clock;
+};
+
+}
+
+#endif // WEATHER_ANIMATIONS_HUB_H
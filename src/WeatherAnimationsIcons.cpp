@@ -1,4 +1,7 @@
 #include "WeatherAnimationsIcons.h"
+#include "WeatherAnimationsLog.h"
+#include "WeatherAnimationsPerf.h"
+#include "WeatherAnimationsRecorder.h"
 
 #if !defined(ESP32)
 	#define ESP32
@@ -13,27 +16,27 @@
 #endif
 
 // Base URL for weather icons
-const char* WEATHER_ICON_BASE_URL = "https://raw.githubusercontent.com/basmilius/weather-icons/master/production/fill/";
+static const char* const WEATHER_ICON_BASE_URL = "https://raw.githubusercontent.com/basmilius/weather-icons/master/production/fill/";
 
 // Define the weather icon mappings with URLs
-IconMapping weatherIcons[] = {
-	{"clear-night", "", "moon.png", false, nullptr, 0},
-	{"cloudy", "", "cloudy.png", false, nullptr, 0},
-	{"fog", "", "fog.png", false, nullptr, 0},
-	{"hail", "", "hail.png", false, nullptr, 0},
-	{"lightning", "", "thunderstorm.png", false, nullptr, 0},
-	{"lightning-rainy", "", "thunderstorms-rain.png", false, nullptr, 0},
-	{"partlycloudy", "day", "partly-cloudy-day.png", false, nullptr, 0},
-	{"partlycloudy", "night", "partly-cloudy-night.png", false, nullptr, 0},
-	{"pouring", "", "extreme-rain.png", false, nullptr, 0},
-	{"rainy", "", "rain.png", false, nullptr, 0},
-	{"snowy", "", "snow.png", false, nullptr, 0},
-	{"snowy-rainy", "", "sleet.png", false, nullptr, 0},
-	{"sunny", "day", "clear-day.png", false, nullptr, 0},
-	{"sunny", "night", "clear-night.png", false, nullptr, 0},
-	{"windy", "", "wind.png", false, nullptr, 0},
-	{"exceptional", "", "not-available.png", false, nullptr, 0},
-	{nullptr, nullptr, nullptr, false, nullptr, 0} // End marker
+const IconMapping weatherIcons[] = {
+	{"clear-night", "", "moon.png"},
+	{"cloudy", "", "cloudy.png"},
+	{"fog", "", "fog.png"},
+	{"hail", "", "hail.png"},
+	{"lightning", "", "thunderstorm.png"},
+	{"lightning-rainy", "", "thunderstorms-rain.png"},
+	{"partlycloudy", "day", "partly-cloudy-day.png"},
+	{"partlycloudy", "night", "partly-cloudy-night.png"},
+	{"pouring", "", "extreme-rain.png"},
+	{"rainy", "", "rain.png"},
+	{"snowy", "", "snow.png"},
+	{"snowy-rainy", "", "sleet.png"},
+	{"sunny", "day", "clear-day.png"},
+	{"sunny", "night", "clear-night.png"},
+	{"windy", "", "wind.png"},
+	{"exceptional", "", "not-available.png"},
+	{nullptr, nullptr, nullptr} // End marker
 };
 
 // Helper function to find icon by condition and time of day
@@ -73,85 +76,188 @@ const IconMapping* findWeatherIcon(const char* condition, bool isDay) {
 	return &weatherIcons[0];
 }
 
-// Load icon data from the URL specified in the icon mapping
-bool loadWeatherIcon(IconMapping* icon) {
-	if (icon == nullptr || icon->url == nullptr) {
-		return false;
-	}
-	
-	// If already loaded, return success
-	if (icon->isLoaded && icon->iconData != nullptr) {
-		return true;
-	}
-	
-	// Clear any existing data
-	if (icon->iconData != nullptr) {
-		free(icon->iconData);
-		icon->iconData = nullptr;
-		icon->dataSize = 0;
-		icon->isLoaded = false;
-	}
-	
+// Helper function to download an icon into a buffer of capacity bytes. An
+// icon that does not fit goes into a heap buffer instead; *data says which.
+static bool downloadWeatherIcon(const IconMapping* icon, uint8_t* buffer, size_t capacity, uint8_t** data,
+                                size_t* dataSize) {
+	WA_PERF_SCOPE(PERF_ASSET_LOAD);
+
 	// Construct the full URL
-	String fullUrl = String(WEATHER_ICON_BASE_URL) + icon->url;
+	char fullUrl[160];
+	snprintf(fullUrl, sizeof(fullUrl), "%s%s", WEATHER_ICON_BASE_URL, icon->url);
 
 	HTTPClient http;
 	http.begin(fullUrl);
 	
+	uint32_t fetchStart = WeatherAnimationsLib::recordActive() ? WeatherAnimationsLib::recordMillis() : 0;
 	int httpCode = http.GET();
 	if (httpCode != 200) {
 		http.end();
+		if (WeatherAnimationsLib::recordActive()) {
+			WeatherAnimationsLib::recordFetch(fetchStart, httpCode, -1, nullptr, 0);
+		}
 		return false;
 	}
 	
 	// Get the data size
 	int contentLength = http.getSize();
-	if (contentLength <= 0) {
-		http.end();
-		return false;
+	if (contentLength > 0 && (size_t)contentLength > capacity) {
+		WA_LOG_WARN("Icon %s is %d bytes, more than its %u-byte block; keeping it on the heap", icon->url,
+		            contentLength, (unsigned)capacity);
+		buffer = (uint8_t*)malloc(contentLength);
 	}
-	
-	// Allocate memory for the icon data
-	icon->iconData = (uint8_t*)malloc(contentLength);
-	if (icon->iconData == nullptr) {
+	if (contentLength <= 0 || buffer == nullptr) {
 		http.end();
+		if (WeatherAnimationsLib::recordActive()) {
+			WeatherAnimationsLib::recordFetch(fetchStart, httpCode, contentLength, nullptr, 0);
+		}
 		return false;
 	}
 	
 	// Get the data
 	WiFiClient* stream = http.getStreamPtr();
 	size_t bytesRead = 0;
-	while (http.connected() && bytesRead < contentLength) {
+	while (http.connected() && bytesRead < (size_t)contentLength) {
 		if (stream->available()) {
-			icon->iconData[bytesRead++] = stream->read();
+			buffer[bytesRead++] = stream->read();
 		}
 	}
 	
 	http.end();
+	if (WeatherAnimationsLib::recordActive()) {
+		WeatherAnimationsLib::recordFetch(fetchStart, httpCode, contentLength, buffer, bytesRead);
+	}
+	
+	if (bytesRead == 0) {
+		if ((size_t)contentLength > capacity) {
+			free(buffer);
+		}
+		return false;
+	}
+	
+	*data = buffer;
+	*dataSize = bytesRead;
+	return true;
+}
+
+using namespace WeatherAnimationsLib;
+
+IconCache::IconCache() : _pool(WEATHER_ICON_BLOCK_BYTES, WEATHER_ICON_POOL_BLOCKS), _loads(0) {
+	for (size_t i = 0; i < WEATHER_ICON_COUNT; i++) {
+		_data[i] = nullptr;
+		_sizes[i] = 0;
+		_onHeap[i] = false;
+		_loadedAt[i] = 0;
+	}
+}
+
+IconCache::~IconCache() {
+	clear();
+}
+
+// Helper function to map an entry of weatherIcons[] to its cache slot
+int IconCache::indexOf(const IconMapping* icon) const {
+	if (icon == nullptr || icon < weatherIcons || icon >= weatherIcons + WEATHER_ICON_COUNT) {
+		return -1;
+	}
+	return icon - weatherIcons;
+}
+
+// Load icon data from the URL specified in the icon mapping
+bool IconCache::load(const IconMapping* icon) {
+	int index = indexOf(icon);
+	if (index < 0 || icon->url == nullptr) {
+		return false;
+	}
 	
-	// Update the icon's data info
-	icon->dataSize = bytesRead;
-	icon->isLoaded = true;
+	// If already loaded, return success
+	if (_data[index] != nullptr) {
+		return true;
+	}
 	
-	return (bytesRead > 0);
+	uint8_t* block = (uint8_t*)_pool.acquire();
+	if (block == nullptr && evictOldest()) {
+		block = (uint8_t*)_pool.acquire();
+	}
+	if (block == nullptr) {
+		return false;
+	}
+	uint8_t* data = nullptr;
+	if (!downloadWeatherIcon(icon, block, _pool.blockSize(), &data, &_sizes[index])) {
+		_pool.release(block);
+		return false;
+	}
+	_onHeap[index] = data != block;
+	if (_onHeap[index]) {
+		_pool.release(block);
+	}
+	_data[index] = data;
+	_loadedAt[index] = ++_loads;
+	return true;
+}
+
+// Helper function to drop the icon that was loaded longest ago
+bool IconCache::evictOldest() {
+	int oldest = -1;
+	for (size_t i = 0; i < WEATHER_ICON_COUNT; i++) {
+		if (_data[i] != nullptr && (oldest < 0 || _loadedAt[i] < _loadedAt[oldest])) {
+			oldest = i;
+		}
+	}
+	if (oldest < 0) {
+		return false;
+	}
+	drop(oldest);
+	return true;
+}
+
+// Helper function to free one cached icon, from the pool or the heap
+void IconCache::drop(size_t index) {
+	if (_onHeap[index]) {
+		free(_data[index]);
+	} else {
+		_pool.release(_data[index]);
+	}
+	_data[index] = nullptr;
+	_sizes[index] = 0;
+	_onHeap[index] = false;
+}
+
+const uint8_t* IconCache::data(const IconMapping* icon, size_t* size) const {
+	int index = indexOf(icon);
+	if (index < 0 || _data[index] == nullptr) {
+		if (size != nullptr) *size = 0;
+		return nullptr;
+	}
+	if (size != nullptr) *size = _sizes[index];
+	return _data[index];
+}
+
+bool IconCache::isLoaded(const IconMapping* icon) const {
+	return data(icon) != nullptr;
 }
 
 // Preload all weather icons in advance
-void preloadWeatherIcons() {
-	for (size_t i = 0; weatherIcons[i].condition != nullptr; i++) {
-		loadWeatherIcon(&weatherIcons[i]);
+void IconCache::preload() {
+	for (size_t i = 0; weatherIcons[i].condition != nullptr && _pool.inUse() < _pool.blockCount(); i++) {
+		load(&weatherIcons[i]);
 		delay(100); // Small delay to prevent overwhelming the server
 	}
 }
 
 // Clear all loaded icon data and free memory
-void clearWeatherIcons() {
-	for (size_t i = 0; weatherIcons[i].condition != nullptr; i++) {
-		if (weatherIcons[i].iconData != nullptr) {
-			free(weatherIcons[i].iconData);
-			weatherIcons[i].iconData = nullptr;
-			weatherIcons[i].dataSize = 0;
-			weatherIcons[i].isLoaded = false;
+void IconCache::clear() {
+	for (size_t i = 0; i < WEATHER_ICON_COUNT; i++) {
+		if (_data[i] != nullptr) {
+			drop(i);
 		}
 	}
-} 
\ No newline at end of file
+}
+
+bool IconCache::reserve() {
+	return _pool.reserve();
+}
+
+const SlabPool& IconCache::pool() const {
+	return _pool;
+}
@@ -2,32 +2,78 @@
 #define WEATHER_ANIMATIONS_ICONS_H
 
 #include <Arduino.h>
+#include "WeatherAnimationsPool.h"
 
 // Icon mapping structure
 struct IconMapping {
 	const char* condition;
 	const char* variant; // 'day', 'night', or empty string
 	const char* url; // URL to fetch the icon from
-	bool isLoaded;
-	uint8_t* iconData;
-	size_t dataSize;
 };
 
-// Declare the standard icon mappings with online URLs
-// These will be initialized in WeatherAnimationsIcons.cpp
-extern IconMapping weatherIcons[];
+// Number of entries in weatherIcons[], not counting the end marker
+#define WEATHER_ICON_COUNT 16
+
+// Icon block size, and how many icons one IconCache holds at once. The
+// standard icons are 1 to 3 kB; a larger icon is kept on the heap.
+#ifndef WEATHER_ICON_BLOCK_BYTES
+#define WEATHER_ICON_BLOCK_BYTES 4096
+#endif
+#ifndef WEATHER_ICON_POOL_BLOCKS
+#define WEATHER_ICON_POOL_BLOCKS 4
+#endif
+
+// The standard icon mappings with online URLs.
+// Read-only and shared; downloaded data lives in each instance's IconCache.
+extern const IconMapping weatherIcons[];
 
 // Helper function to find icon by condition and time of day
 // This declaration allows it to be used in other files
 const IconMapping* findWeatherIcon(const char* condition, bool isDay);
 
-// Helper function to load icon data from the internet
-bool loadWeatherIcon(IconMapping* icon);
+namespace WeatherAnimationsLib {
+
+// Downloaded icon data for one WeatherAnimations instance, indexed like weatherIcons[].
+// Icons are kept in fixed blocks from a pool; when all blocks are in use the
+// icon loaded longest ago makes room for the new one. An icon larger than a
+// block is kept on the heap instead, with a warning.
+class IconCache {
+public:
+	IconCache();
+	~IconCache();
+
+	// Download the icon unless it is already cached
+	bool load(const IconMapping* icon);
+
+	// Cached data for an icon, or nullptr if it has not been loaded
+	const uint8_t* data(const IconMapping* icon, size_t* size = nullptr) const;
+	bool isLoaded(const IconMapping* icon) const;
+
+	// Fetch icons in advance, as many as the pool holds
+	void preload();
 
-// Helper function to fetch all icons in advance
-void preloadWeatherIcons();
+	// Free all downloaded icon data
+	void clear();
+
+	// Reserve the icon blocks now instead of on the first download
+	bool reserve();
+
+	// Icon blocks, for their high-water mark
+	const SlabPool& pool() const;
+
+private:
+	int indexOf(const IconMapping* icon) const;
+	bool evictOldest();
+	void drop(size_t index);
+
+	SlabPool _pool;
+	uint8_t* _data[WEATHER_ICON_COUNT];
+	size_t _sizes[WEATHER_ICON_COUNT];
+	bool _onHeap[WEATHER_ICON_COUNT]; // larger than a block, so not from _pool
+	uint32_t _loadedAt[WEATHER_ICON_COUNT]; // value of _loads when each icon was loaded
+	uint32_t _loads;
+};
 
-// Helper function to clear icon data and free memory
-void clearWeatherIcons();
+}
 
 #endif // WEATHER_ANIMATIONS_ICONS_H 
\ No newline at end of file
@@ -0,0 +1,225 @@
+#include "WeatherAnimationsInput.h"
+
+using namespace WeatherAnimationsLib;
+
+// Quadrature transitions indexed by (previous AB << 2) | current AB:
+// +1 or -1 for a valid quarter step, 0 for no change or a skipped (invalid) one
+static const int8_t encoderTransitions[16] = {
+	0, -1, 1, 0,
+	1, 0, 0, -1,
+	-1, 0, 0, 1,
+	0, 1, -1, 0
+};
+
+InputManager::InputManager()
+	: _buttonCount(0), _encoderCount(0), _debounce(INPUT_DEFAULT_DEBOUNCE), _overflows(0),
+	  _scheduler(nullptr), _taskId(-1), _clock(systemClock()) {
+}
+
+InputManager::~InputManager() {
+	for (uint8_t i = 0; i < _buttonCount; i++) {
+		detachInterrupt(digitalPinToInterrupt(_buttons[i].pin));
+	}
+	for (uint8_t i = 0; i < _encoderCount; i++) {
+		detachInterrupt(digitalPinToInterrupt(_encoders[i].pinA));
+		detachInterrupt(digitalPinToInterrupt(_encoders[i].pinB));
+	}
+}
+
+bool InputManager::addButton(uint8_t pin, uint8_t id, bool activeLow) {
+	if (_buttonCount >= INPUT_MAX_BUTTONS) {
+		return false;
+	}
+	pinMode(pin, activeLow ? INPUT_PULLUP : INPUT);
+
+	Button& button = _buttons[_buttonCount++];
+	button.manager = this;
+	button.pin = pin;
+	button.id = id;
+	button.activeLow = activeLow;
+	button.pressed = digitalRead(pin) == (activeLow ? LOW : HIGH);
+	button.changing = false;
+	button.lastEdge = 0;
+	attachInterruptArg(digitalPinToInterrupt(pin), buttonISR, &button, CHANGE);
+	return true;
+}
+
+bool InputManager::addEncoder(uint8_t pinA, uint8_t pinB, uint8_t id, uint8_t stepsPerDetent) {
+	if (_encoderCount >= INPUT_MAX_ENCODERS || stepsPerDetent == 0) {
+		return false;
+	}
+	pinMode(pinA, INPUT_PULLUP);
+	pinMode(pinB, INPUT_PULLUP);
+
+	Encoder& encoder = _encoders[_encoderCount++];
+	encoder.manager = this;
+	encoder.pinA = pinA;
+	encoder.pinB = pinB;
+	encoder.id = id;
+	encoder.stepsPerDetent = stepsPerDetent;
+	encoder.state = (digitalRead(pinA) << 1) | digitalRead(pinB);
+	encoder.count = 0;
+	encoder.steps = 0;
+	encoder.lastStep = 0;
+	attachInterruptArg(digitalPinToInterrupt(pinA), encoderISR, &encoder, CHANGE);
+	attachInterruptArg(digitalPinToInterrupt(pinB), encoderISR, &encoder, CHANGE);
+	return true;
+}
+
+void InputManager::setDebounce(uint16_t debounceMs) {
+	_debounce = debounceMs;
+}
+
+void InputManager::attach(TickScheduler* scheduler, int8_t taskId, Clock* clock) {
+	_scheduler = scheduler;
+	_taskId = taskId;
+	_clock = clock != nullptr ? clock : systemClock();
+}
+
+uint32_t InputManager::overflows() const {
+	return _overflows.load(std::memory_order_relaxed);
+}
+
+void IRAM_ATTR InputManager::buttonISR(void* arg) {
+	Button* button = static_cast<Button*>(arg);
+	InputManager* manager = button->manager;
+	manager->record(button - manager->_buttons, 0);
+}
+
+void IRAM_ATTR InputManager::encoderISR(void* arg) {
+	Encoder* encoder = static_cast<Encoder*>(arg);
+	uint8_t current = (digitalRead(encoder->pinA) << 1) | digitalRead(encoder->pinB);
+	int8_t step = encoderTransitions[(encoder->state << 2) | current];
+	encoder->state = current;
+	if (step == 0) {
+		return;
+	}
+
+	// Only whole detents are reported
+	encoder->count += step;
+	if (encoder->count >= (int8_t)encoder->stepsPerDetent || encoder->count <= -(int8_t)encoder->stepsPerDetent) {
+		InputManager* manager = encoder->manager;
+		manager->record(INPUT_MAX_BUTTONS + (encoder - manager->_encoders), encoder->count > 0 ? 1 : -1);
+		encoder->count = 0;
+	}
+}
+
+// Helper function to queue a raw edge from an interrupt. On the boards the
+// Clock's vtable and millis() may live in flash, which an interrupt must not
+// touch while the flash cache is off, so the edge is stamped with the
+// board's millis() and drain() moves it onto the clock.
+void IRAM_ATTR InputManager::record(uint8_t source, int8_t steps) {
+	RawEvent event;
+	event.source = source;
+	event.steps = steps;
+#if defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_ESP8266)
+	event.time = ::millis();
+#else
+	event.time = _clock->millis();
+#endif
+	if (!_queue.push(event)) {
+		_overflows.fetch_add(1, std::memory_order_relaxed);
+	}
+	if (_scheduler != nullptr) {
+		_scheduler->wakeFromISR(_taskId);
+	}
+}
+
+// Helper function to move raw edges into the button and encoder state
+void InputManager::drain() {
+	uint32_t offset = 0;
+#if defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_ESP8266)
+	if (_clock != systemClock() && !_queue.empty()) {
+		offset = _clock->millis() - ::millis();
+	}
+#endif
+	RawEvent event;
+	while (_queue.pop(&event)) {
+		event.time += offset;
+		if (event.source < INPUT_MAX_BUTTONS) {
+			Button& button = _buttons[event.source];
+			button.changing = true;
+			button.lastEdge = event.time;
+		} else {
+			Encoder& encoder = _encoders[event.source - INPUT_MAX_BUTTONS];
+			encoder.steps += event.steps;
+			encoder.lastStep = event.time;
+		}
+	}
+}
+
+bool InputManager::inject(const InputEvent& event) {
+	if (!_injected.push(event)) {
+		_overflows.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	if (_scheduler != nullptr) {
+		_scheduler->wakeFromISR(_taskId);
+	}
+	return true;
+}
+
+bool InputManager::poll(InputEvent* event, uint32_t now) {
+	drain();
+	if (_injected.pop(event)) {
+		return true;
+	}
+
+	for (uint8_t i = 0; i < _encoderCount; i++) {
+		Encoder& encoder = _encoders[i];
+		if (encoder.steps == 0) {
+			continue;
+		}
+		int16_t steps = constrain(encoder.steps, -127, 127);
+		encoder.steps -= steps;
+		event->type = INPUT_ROTATED;
+		event->id = encoder.id;
+		event->steps = steps;
+		event->time = encoder.lastStep;
+		return true;
+	}
+
+	// A button counts once its pin has stopped bouncing for the debounce time
+	for (uint8_t i = 0; i < _buttonCount; i++) {
+		Button& button = _buttons[i];
+		if (!button.changing || now - button.lastEdge < _debounce) {
+			continue;
+		}
+		button.changing = false;
+		bool pressed = digitalRead(button.pin) == (button.activeLow ? LOW : HIGH);
+		if (pressed == button.pressed) {
+			continue;
+		}
+		button.pressed = pressed;
+		event->type = pressed ? INPUT_PRESSED : INPUT_RELEASED;
+		event->id = button.id;
+		event->steps = 0;
+		event->time = button.lastEdge;
+		return true;
+	}
+	return false;
+}
+
+uint32_t InputManager::nextCheck(uint32_t now) const {
+	if (!_queue.empty() || !_injected.empty()) {
+		return 0;
+	}
+	uint32_t next = TICK_IDLE;
+	for (uint8_t i = 0; i < _encoderCount; i++) {
+		if (_encoders[i].steps != 0) {
+			return 0;
+		}
+	}
+	for (uint8_t i = 0; i < _buttonCount; i++) {
+		const Button& button = _buttons[i];
+		if (!button.changing) {
+			continue;
+		}
+		uint32_t elapsed = now - button.lastEdge;
+		uint32_t remaining = elapsed >= _debounce ? 0 : _debounce - elapsed;
+		if (remaining < next) {
+			next = remaining;
+		}
+	}
+	return next;
+}
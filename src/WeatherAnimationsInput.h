@@ -0,0 +1,126 @@
+#ifndef WEATHER_ANIMATIONS_INPUT_H
+#define WEATHER_ANIMATIONS_INPUT_H
+
+#include <Arduino.h>
+#include "WeatherAnimationsClock.h"
+#include "WeatherAnimationsPipeline.h"
+#include "WeatherAnimationsScheduler.h"
+
+// Most buttons and encoders one InputManager can watch
+#define INPUT_MAX_BUTTONS 6
+#define INPUT_MAX_ENCODERS 2
+
+// Raw events the interrupts can queue before poll() drains them
+#define INPUT_QUEUE_SIZE 32
+
+// Default time a button must be stable before a press or release counts, in milliseconds
+#define INPUT_DEFAULT_DEBOUNCE 20
+
+// Event types
+#define INPUT_PRESSED 1
+#define INPUT_RELEASED 2
+#define INPUT_ROTATED 3
+
+namespace WeatherAnimationsLib {
+
+// One debounced input event
+struct InputEvent {
+	uint8_t type;   // INPUT_PRESSED, INPUT_RELEASED or INPUT_ROTATED
+	uint8_t id;     // id given to addButton() or addEncoder()
+	int8_t steps;   // INPUT_ROTATED: detents turned, positive is clockwise
+	uint32_t time;  // clock time of the edge that caused it, see attach()
+};
+
+// Called for each event, see WeatherAnimations::setInput()
+typedef void (*InputHandler)(const InputEvent& event, void* context);
+
+// Buttons and rotary encoders read from pin-change interrupts.
+//
+// The interrupt handlers only record edges in a lock-free queue; poll()
+// drains it, debounces buttons and turns encoder steps into events, so no
+// loop() has to sample pins with delay() between reads. Pin-change
+// interrupts do not nest, so the handlers of all pins count as the queue's
+// single producer.
+class InputManager {
+public:
+	InputManager();
+	~InputManager();
+
+	// Watch a button; activeLow buttons connect the pin to GND and use the pull-up
+	bool addButton(uint8_t pin, uint8_t id, bool activeLow = true);
+
+	// Watch a quadrature encoder on two pins (both with pull-ups)
+	bool addEncoder(uint8_t pinA, uint8_t pinB, uint8_t id, uint8_t stepsPerDetent = 4);
+
+	// Time a button must be stable, in milliseconds
+	void setDebounce(uint16_t debounceMs);
+
+	// Next debounced event, if any
+	bool poll(InputEvent* event, uint32_t now);
+
+	// Queue an event as if it had just been debounced, e.g. one from a
+	// replayed recording (call from one task only)
+	bool inject(const InputEvent& event);
+
+	// Milliseconds until poll() has more to do (a debounce window closing), or TICK_IDLE
+	uint32_t nextCheck(uint32_t now) const;
+
+	// Wake a scheduler task whenever an interrupt fires, and stamp edges
+	// with clock's millis() (the board's when nullptr), so event times
+	// compare with the now given to poll()
+	void attach(TickScheduler* scheduler, int8_t taskId, Clock* clock = nullptr);
+
+	// Raw events lost because the queue was full
+	uint32_t overflows() const;
+
+private:
+	struct Button {
+		InputManager* manager;
+		uint8_t pin;
+		uint8_t id;
+		bool activeLow;
+		bool pressed;          // debounced state
+		bool changing;         // an edge is waiting for its debounce window
+		uint32_t lastEdge;
+	};
+
+	struct Encoder {
+		InputManager* manager;
+		uint8_t pinA;
+		uint8_t pinB;
+		uint8_t id;
+		uint8_t stepsPerDetent;
+		uint8_t state;         // last two A/B readings
+		int8_t count;          // quarter steps towards the next detent, ISR only
+		int16_t steps;         // detents not yet reported
+		uint32_t lastStep;
+	};
+
+	// Raw edge recorded by an interrupt
+	struct RawEvent {
+		uint8_t source;        // button index, or INPUT_MAX_BUTTONS + encoder index
+		int8_t steps;
+		uint32_t time;         // clock time; on the boards their millis() until drain()
+	};
+
+	static void IRAM_ATTR buttonISR(void* button);
+	static void IRAM_ATTR encoderISR(void* encoder);
+	void IRAM_ATTR record(uint8_t source, int8_t steps);
+	void drain();
+
+	Button _buttons[INPUT_MAX_BUTTONS];
+	Encoder _encoders[INPUT_MAX_ENCODERS];
+	uint8_t _buttonCount;
+	uint8_t _encoderCount;
+	uint16_t _debounce;
+	SPSCQueue<RawEvent, INPUT_QUEUE_SIZE> _queue;
+	SPSCQueue<InputEvent, INPUT_QUEUE_SIZE> _injected;
+	std::atomic<uint32_t> _overflows;
+	TickScheduler* _scheduler;
+	int8_t _taskId;
+	Clock* _clock;
+};
+
+}
+
+#endif // WEATHER_ANIMATIONS_INPUT_H
@@ -0,0 +1,182 @@
+#include "WeatherAnimationsLog.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace WeatherAnimationsLib;
+
+struct LogSlot {
+	// Position this slot takes next (+1 once filled), less the slot's index so
+	// that the zeroed array starts out right
+	std::atomic<uint32_t> sequence;
+	uint32_t millis;
+	const char* format;
+	LogArg args[LOG_MAX_ARGS];
+	uint8_t level;
+	uint8_t argCount;
+};
+
+// Bounded queue: writers on either core claim positions with a compare and
+// swap, and a slot's sequence tells the reader when it has been filled
+static_assert((LOG_RING_RECORDS & (LOG_RING_RECORDS - 1)) == 0, "LOG_RING_RECORDS must be a power of two");
+static LogSlot slots[LOG_RING_RECORDS];
+static std::atomic<uint32_t> writePosition(0);
+static std::atomic<uint32_t> readPosition(0);
+static std::atomic<uint32_t> dropped(0);
+static std::atomic<bool> draining(false);
+static Print* output = &Serial;
+
+static const char levelLetters[] = {'-', 'E', 'W', 'I', 'D', 'V'};
+
+// Helper functions to read and set a slot's sequence as a record position
+static uint32_t loadSequence(uint32_t position) {
+	return slots[position % LOG_RING_RECORDS].sequence.load(std::memory_order_acquire) + position % LOG_RING_RECORDS;
+}
+
+static void storeSequence(uint32_t position, uint32_t sequence) {
+	slots[position % LOG_RING_RECORDS].sequence.store(sequence - position % LOG_RING_RECORDS, std::memory_order_release);
+}
+
+void WeatherAnimationsLib::logRecord(uint8_t level, const char* format, const LogArg* args, uint8_t argCount) {
+	uint32_t position = writePosition.load(std::memory_order_relaxed);
+	while (true) {
+		int32_t difference = (int32_t)(loadSequence(position) - position);
+		if (difference == 0) {
+			if (writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+				break;
+			}
+		} else if (difference < 0) {
+			// The reader has not freed this slot yet: the ring is full
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		} else {
+			position = writePosition.load(std::memory_order_relaxed);
+		}
+	}
+
+	LogSlot& slot = slots[position % LOG_RING_RECORDS];
+	slot.millis = millis();
+	slot.format = format;
+	slot.level = level;
+	slot.argCount = argCount;
+	for (uint8_t i = 0; i < argCount; i++) {
+		slot.args[i] = args[i];
+	}
+	storeSequence(position, position + 1);
+}
+
+// Helper function to expand a record's format string with its stored arguments
+static void formatRecord(const LogSlot& slot, char* line, size_t size) {
+	int length = snprintf(line, size, "%c (%lu) ", levelLetters[slot.level < sizeof(levelLetters) ? slot.level : 0],
+	                      (unsigned long)slot.millis);
+	size_t used = length > 0 ? (size_t)length : 0;
+	uint8_t nextArg = 0;
+	const char* format = slot.format;
+
+	while (*format != '\0' && used < size - 1) {
+		if (*format != '%') {
+			line[used++] = *format++;
+			continue;
+		}
+		if (format[1] == '%') {
+			line[used++] = '%';
+			format += 2;
+			continue;
+		}
+
+		// Copy flags, width and precision; drop length modifiers
+		char spec[16];
+		size_t specLength = 0;
+		spec[specLength++] = *format++;
+		while (*format != '\0' && strchr("-+ #0123456789.", *format) != nullptr && specLength < sizeof(spec) - 2) {
+			spec[specLength++] = *format++;
+		}
+		while (*format != '\0' && strchr("hljzt", *format) != nullptr) {
+			format++;
+		}
+		char conversion = *format;
+		if (conversion == '\0') {
+			break;
+		}
+		format++;
+		spec[specLength++] = conversion;
+		spec[specLength] = '\0';
+
+		LogArg arg = LogArg();
+		if (nextArg < slot.argCount) {
+			arg = slot.args[nextArg++];
+		}
+		int written = 0;
+		switch (conversion) {
+			case 'd': case 'i': case 'c':
+				written = snprintf(line + used, size - used, spec, (int)arg.i);
+				break;
+			case 'u': case 'x': case 'X': case 'o':
+				written = snprintf(line + used, size - used, spec, (unsigned int)arg.u);
+				break;
+			case 'f': case 'e': case 'g': case 'E': case 'G':
+				written = snprintf(line + used, size - used, spec, (double)arg.f);
+				break;
+			case 's':
+				written = snprintf(line + used, size - used, spec, arg.s != nullptr ? arg.s : "(null)");
+				break;
+			default:
+				break;
+		}
+		if (written > 0) {
+			used += (size_t)written < size - used ? (size_t)written : size - 1 - used;
+		}
+	}
+	line[used] = '\0';
+}
+
+uint16_t WeatherAnimationsLib::logDrain(Print& out, uint16_t maxRecords) {
+	// One reader at a time; a second caller finds the ring busy and comes back later
+	if (draining.exchange(true, std::memory_order_acquire)) {
+		return 0;
+	}
+
+	uint16_t written = 0;
+	char line[LOG_LINE_LENGTH];
+	static uint32_t reportedDrops = 0;
+	uint32_t drops = dropped.load(std::memory_order_relaxed);
+	if (drops != reportedDrops && maxRecords > 0) {
+		snprintf(line, sizeof(line), "W (%lu) %lu log records dropped", (unsigned long)millis(),
+		         (unsigned long)(drops - reportedDrops));
+		out.println(line);
+		reportedDrops = drops;
+	}
+
+	uint32_t position = readPosition.load(std::memory_order_relaxed);
+	while (written < maxRecords) {
+		if (loadSequence(position) != position + 1) {
+			break;
+		}
+		formatRecord(slots[position % LOG_RING_RECORDS], line, sizeof(line));
+		storeSequence(position, position + LOG_RING_RECORDS);
+		position++;
+		readPosition.store(position, std::memory_order_relaxed);
+		out.println(line);
+		written++;
+	}
+
+	draining.store(false, std::memory_order_release);
+	return written;
+}
+
+void WeatherAnimationsLib::setLogOutput(Print* out) {
+	output = out;
+}
+
+Print* WeatherAnimationsLib::logOutput() {
+	return output;
+}
+
+uint16_t WeatherAnimationsLib::logPending() {
+	uint32_t pending = writePosition.load(std::memory_order_relaxed) - readPosition.load(std::memory_order_relaxed);
+	return pending < LOG_RING_RECORDS ? pending : LOG_RING_RECORDS;
+}
+
+uint32_t WeatherAnimationsLib::logDropped() {
+	return dropped.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,121 @@
+#ifndef WEATHER_ANIMATIONS_LOG_H
+#define WEATHER_ANIMATIONS_LOG_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Log levels. WA_LOG_LEVEL (a build flag) sets the most detailed level that
+// is compiled in; calls above it expand to nothing and their arguments are
+// never evaluated.
+#define WA_LOG_LEVEL_NONE 0
+#define WA_LOG_LEVEL_ERROR 1   // something failed and a feature is lost
+#define WA_LOG_LEVEL_WARN 2    // a request or download failed, the library carries on
+#define WA_LOG_LEVEL_INFO 3    // startup and state changes
+#define WA_LOG_LEVEL_DEBUG 4   // every poll and download
+#define WA_LOG_LEVEL_VERBOSE 5 // every frame
+
+#ifndef WA_LOG_LEVEL
+	#ifdef WA_DISABLE_SERIAL
+		#define WA_LOG_LEVEL WA_LOG_LEVEL_NONE
+	#else
+		#define WA_LOG_LEVEL WA_LOG_LEVEL_INFO
+	#endif
+#endif
+
+// Records the log ring holds until they are drained (a power of two)
+#ifndef LOG_RING_RECORDS
+#define LOG_RING_RECORDS 32
+#endif
+
+// Most arguments one log call can carry
+#define LOG_MAX_ARGS 4
+
+// Longest line logDrain() writes; longer ones are cut
+#define LOG_LINE_LENGTH 128
+
+// Records tick() and update() write per drain, and how often tick() drains, in milliseconds
+#define LOG_DRAIN_BATCH 4
+#define LOG_DRAIN_INTERVAL 20
+
+namespace WeatherAnimationsLib {
+
+// One stored argument. Strings are kept as pointers, so %s arguments must
+// be string literals (or otherwise outlive the drain).
+union LogArg {
+	int32_t i;
+	uint32_t u;
+	float f;
+	const char* s;
+};
+
+inline LogArg logArg(int value) { LogArg arg; arg.i = value; return arg; }
+inline LogArg logArg(long value) { LogArg arg; arg.i = (int32_t)value; return arg; }
+inline LogArg logArg(unsigned int value) { LogArg arg; arg.u = value; return arg; }
+inline LogArg logArg(unsigned long value) { LogArg arg; arg.u = (uint32_t)value; return arg; }
+inline LogArg logArg(double value) { LogArg arg; arg.f = (float)value; return arg; }
+inline LogArg logArg(const char* value) { LogArg arg; arg.s = value; return arg; }
+
+// Deferred logging.
+//
+// A log call stores its level, the address of its format string and up to
+// LOG_MAX_ARGS arguments in a fixed ring: no formatting and no Serial
+// writes, so logging from the render path costs a few hundred nanoseconds.
+// logDrain() formats the records later, when there is time; tick() and
+// update() drain to the log output a few records at a time. When the ring
+// is full, new records are dropped and counted.
+//
+// Format strings take %d, %i, %u, %x, %X, %o, %c, %s and %f/%e/%g with flags,
+// width and precision. Length modifiers are accepted and ignored: every
+// argument is stored as 32 bits.
+
+// Store one record; use the WA_LOG_* macros rather than calling this
+void logRecord(uint8_t level, const char* format, const LogArg* args, uint8_t argCount);
+
+template <typename... Args>
+inline void logWrite(uint8_t level, const char* format, Args... args) {
+	static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "too many log arguments");
+	LogArg packed[sizeof...(Args) + 1] = {logArg(args)...};
+	logRecord(level, format, packed, sizeof...(Args));
+}
+
+// Format and write up to maxRecords waiting records, one line each.
+// Returns how many were written.
+uint16_t logDrain(Print& out, uint16_t maxRecords = 0xFFFF);
+
+// Where tick() and update() drain the ring to (Serial by default, nullptr to keep the records)
+void setLogOutput(Print* out);
+Print* logOutput();
+
+// Records waiting to be drained, and records dropped because the ring was full
+uint16_t logPending();
+uint32_t logDropped();
+
+}
+
+#if WA_LOG_LEVEL >= WA_LOG_LEVEL_ERROR
+	#define WA_LOG_ERROR(...) WeatherAnimationsLib::logWrite(WA_LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+	#define WA_LOG_ERROR(...) ((void)0)
+#endif
+#if WA_LOG_LEVEL >= WA_LOG_LEVEL_WARN
+	#define WA_LOG_WARN(...) WeatherAnimationsLib::logWrite(WA_LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+	#define WA_LOG_WARN(...) ((void)0)
+#endif
+#if WA_LOG_LEVEL >= WA_LOG_LEVEL_INFO
+	#define WA_LOG_INFO(...) WeatherAnimationsLib::logWrite(WA_LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+	#define WA_LOG_INFO(...) ((void)0)
+#endif
+#if WA_LOG_LEVEL >= WA_LOG_LEVEL_DEBUG
+	#define WA_LOG_DEBUG(...) WeatherAnimationsLib::logWrite(WA_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+	#define WA_LOG_DEBUG(...) ((void)0)
+#endif
+#if WA_LOG_LEVEL >= WA_LOG_LEVEL_VERBOSE
+	#define WA_LOG_VERBOSE(...) WeatherAnimationsLib::logWrite(WA_LOG_LEVEL_VERBOSE, __VA_ARGS__)
+#else
+	#define WA_LOG_VERBOSE(...) ((void)0)
+#endif
+
+#endif // WEATHER_ANIMATIONS_LOG_H
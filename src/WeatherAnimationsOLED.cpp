@@ -0,0 +1,567 @@
+#include "WeatherAnimationsOLED.h"
+#include "WeatherAnimations.h"
+#include "WeatherAnimationsPerf.h"
+
+#if WA_OLED_HAS_DMA
+	#include <driver/gpio.h>
+	#include <esp_heap_caps.h>
+#endif
+
+// Largest I2C write the Wire library will accept in one transaction,
+// minus the control byte that starts every SSD1306 transfer
+#if defined(I2C_BUFFER_LENGTH)
+	#define OLED_I2C_CHUNK (I2C_BUFFER_LENGTH - 1)
+#else
+	#define OLED_I2C_CHUNK 31
+#endif
+
+// Approximate cost in bytes of starting a new transfer window
+// (addressing commands plus transaction framing)
+#define OLED_REGION_OVERHEAD 8
+
+// SSD1306 control bytes (I2C) and addressing commands
+#define OLED_CONTROL_COMMAND 0x00
+#define OLED_CONTROL_DATA 0x40
+
+using namespace WeatherAnimationsLib;
+
+OLEDBusConfig WeatherAnimationsLib::oledI2CConfig(uint8_t i2cAddr) {
+	OLEDBusConfig config;
+	config.bus = OLED_BUS_I2C;
+	config.i2cAddr = i2cAddr;
+	config.dcPin = -1;
+	config.csPin = -1;
+	config.rstPin = -1;
+	config.sclkPin = -1;
+	config.mosiPin = -1;
+	config.frequency = OLED_I2C_DEFAULT_FREQUENCY;
+	config.useDMA = false;
+	return config;
+}
+
+OLEDBusConfig WeatherAnimationsLib::oledSPIConfig(int8_t dcPin, int8_t csPin, int8_t rstPin, uint32_t frequency, bool useDMA) {
+	OLEDBusConfig config;
+	config.bus = OLED_BUS_SPI;
+	config.i2cAddr = 0;
+	config.dcPin = dcPin;
+	config.csPin = csPin;
+	config.rstPin = rstPin;
+	config.sclkPin = -1;
+	config.mosiPin = -1;
+	config.frequency = frequency;
+	config.useDMA = useDMA;
+	return config;
+}
+
+OLEDPanel::OLEDPanel()
+	: _display(nullptr), _canvas(nullptr), _config(oledI2CConfig(0x3C)), _rotation(OLED_ROTATE_0),
+	  _mirror(OLED_MIRROR_NONE), _width(0), _pages(0), _shadow(nullptr),
+	  _shadowValid(false), _pendingCount(0), _pendingIndex(0), _useDMA(false), _bytesSent(0), _flushCount(0) {
+#if WA_OLED_HAS_DMA
+	_dmaDevice = nullptr;
+	_dmaBusOwned = false;
+	_dmaData = nullptr;
+	_dmaCommands = nullptr;
+	_dmaPending = 0;
+#endif
+}
+
+OLEDPanel::~OLEDPanel() {
+	end();
+}
+
+OLEDCanvas* OLEDPanel::begin(uint8_t width, uint8_t height, const OLEDBusConfig& config,
+                             uint8_t rotation, uint8_t mirror) {
+	end();
+
+	if (height > OLED_MAX_PAGES * 8) {
+		WA_LOG_ERROR("OLED panel taller than 64 rows is not supported.");
+		return nullptr;
+	}
+
+	_config = config;
+	_rotation = rotation & 3;
+	_mirror = mirror & (OLED_MIRROR_X | OLED_MIRROR_Y);
+	_width = width;
+	_pages = (height + 7) / 8;
+
+	// Create the driver object on the requested bus
+	bool ok = false;
+	if (_config.bus == OLED_BUS_SPI) {
+		_display = new Adafruit_SSD1306(width, height, &SPI, _config.dcPin, _config.rstPin, _config.csPin, _config.frequency);
+		ok = _display->begin(SSD1306_SWITCHCAPVCC, 0, true, true);
+	} else {
+		_display = new Adafruit_SSD1306(width, height, &Wire, _config.rstPin);
+		ok = _display->begin(SSD1306_SWITCHCAPVCC, _config.i2cAddr);
+		if (ok) {
+			Wire.setClock(_config.frequency);
+		}
+	}
+
+	if (!ok) {
+		delete _display;
+		_display = nullptr;
+		return nullptr;
+	}
+
+	_shadow = (uint8_t*)malloc(_width * _pages);
+	if (_shadow == nullptr) {
+		WA_LOG_ERROR("Failed to allocate OLED shadow buffer.");
+		end();
+		return nullptr;
+	}
+
+	// Without a transform the canvas draws straight into the panel framebuffer
+	if (_rotation == OLED_ROTATE_0 && _mirror == OLED_MIRROR_NONE) {
+		_canvas = new OLEDCanvas(width, height, _display->getBuffer());
+	} else if ((width % 8) != 0 || (height % 8) != 0) {
+		WA_LOG_ERROR("OLED rotation needs panel dimensions that are multiples of 8.");
+		end();
+		return nullptr;
+	} else if (_rotation & 1) {
+		_canvas = new OLEDCanvas(height, width);
+	} else {
+		_canvas = new OLEDCanvas(width, height);
+	}
+	if (!_canvas->valid()) {
+		WA_LOG_ERROR("Failed to allocate OLED canvas.");
+		end();
+		return nullptr;
+	}
+
+#if WA_OLED_HAS_DMA
+	// Hand the SPI pins over to the ESP-IDF driver so flushes can run in the background
+	if (_config.bus == OLED_BUS_SPI && _config.useDMA) {
+		_useDMA = beginDMA();
+		if (!_useDMA) {
+			WA_LOG_WARN("SPI DMA unavailable, flushing OLED with blocking writes.");
+			SPI.begin();
+		}
+	}
+#endif
+
+	_bytesSent = 0;
+	_flushCount = 0;
+	invalidate();
+	return _canvas;
+}
+
+void OLEDPanel::end() {
+#if WA_OLED_HAS_DMA
+	if (_useDMA) {
+		endDMA();
+	}
+#endif
+	_useDMA = false;
+
+	if (_canvas != nullptr) {
+		delete _canvas;
+		_canvas = nullptr;
+	}
+	if (_display != nullptr) {
+		delete _display;
+		_display = nullptr;
+	}
+	if (_shadow != nullptr) {
+		free(_shadow);
+		_shadow = nullptr;
+	}
+	invalidate();
+}
+
+OLEDCanvas* OLEDPanel::display() const {
+	return _canvas;
+}
+
+void OLEDPanel::invalidate() {
+	_shadowValid = false;
+	_pendingCount = 0;
+	_pendingIndex = 0;
+}
+
+uint32_t OLEDPanel::bytesSent() const {
+	return _bytesSent;
+}
+
+uint32_t OLEDPanel::flushCount() const {
+	return _flushCount;
+}
+
+const OLEDBusConfig& OLEDPanel::busConfig() const {
+	return _config;
+}
+
+uint8_t OLEDPanel::collectDirtyRegions(DirtyRegion* regions) {
+	const uint8_t* buffer = _display->getBuffer();
+
+	// Nothing is known about the panel contents yet, so send everything
+	if (!_shadowValid) {
+		regions[0].firstPage = 0;
+		regions[0].lastPage = _pages - 1;
+		regions[0].firstColumn = 0;
+		regions[0].lastColumn = _width - 1;
+		return 1;
+	}
+
+	uint8_t count = 0;
+	for (uint8_t page = 0; page < _pages; page++) {
+		const uint8_t* row = buffer + page * _width;
+		const uint8_t* shown = _shadow + page * _width;
+		if (memcmp(row, shown, _width) == 0) {
+			continue;
+		}
+
+		// Narrow the page down to the span of columns that changed
+		uint8_t first = 0;
+		while (row[first] == shown[first]) {
+			first++;
+		}
+		uint8_t last = _width - 1;
+		while (row[last] == shown[last]) {
+			last--;
+		}
+
+		// Grow the previous window when that is cheaper than opening a new one
+		if (count > 0) {
+			DirtyRegion& previous = regions[count - 1];
+			uint8_t mergedFirst = min(previous.firstColumn, first);
+			uint8_t mergedLast = max(previous.lastColumn, last);
+			uint16_t mergedCost = (mergedLast - mergedFirst + 1) * (page - previous.firstPage + 1);
+			uint16_t separateCost = (previous.lastColumn - previous.firstColumn + 1) * (previous.lastPage - previous.firstPage + 1)
+				+ (last - first + 1) + OLED_REGION_OVERHEAD;
+			if (mergedCost <= separateCost) {
+				previous.lastPage = page;
+				previous.firstColumn = mergedFirst;
+				previous.lastColumn = mergedLast;
+				continue;
+			}
+		}
+
+		regions[count].firstPage = page;
+		regions[count].lastPage = page;
+		regions[count].firstColumn = first;
+		regions[count].lastColumn = last;
+		count++;
+	}
+
+	return count;
+}
+
+uint16_t OLEDPanel::flush() {
+	WA_ALLOC_SCOPE(PERF_FLUSH);
+	uint32_t started = perfTicks();
+	if (!beginFlush()) {
+		return 0;
+	}
+
+	uint16_t bytes = 0;
+#if WA_OLED_HAS_DMA
+	if (_useDMA) {
+		// Queue every remaining region at once and let the transfer run in the background
+		queueDMARegions(_pendingRegions + _pendingIndex, _pendingCount - _pendingIndex);
+		while (_pendingIndex < _pendingCount) {
+			bytes += commitRegion(_pendingRegions[_pendingIndex++]);
+		}
+		finishFlush();
+		perfRecord(PERF_FLUSH, started, "bytes", bytes);
+		return bytes;
+	}
+#endif
+
+	while (flushInProgress()) {
+		bytes += sendNextRegion();
+	}
+	perfRecord(PERF_FLUSH, started, "bytes", bytes);
+	return bytes;
+}
+
+bool OLEDPanel::beginFlush() {
+	if (flushInProgress()) {
+		return true;
+	}
+	if (_display == nullptr || _shadow == nullptr) {
+		return false;
+	}
+
+	// Apply the panel orientation in one pass over the whole frame
+	if (_canvas->getBuffer() != _display->getBuffer()) {
+		blitPageBuffer(_canvas->getBuffer(), _canvas->bufferWidth(), _canvas->bufferHeight(), _display->getBuffer(), _rotation, _mirror);
+	}
+
+	_pendingCount = collectDirtyRegions(_pendingRegions);
+	_pendingIndex = 0;
+	return _pendingCount > 0;
+}
+
+uint16_t OLEDPanel::flushStep() {
+	if (!flushInProgress()) {
+		return 0;
+	}
+	WA_ALLOC_SCOPE(PERF_FLUSH);
+	uint32_t started = perfTicks();
+	uint16_t bytes = sendNextRegion();
+	perfRecord(PERF_FLUSH, started, "bytes", bytes);
+	return bytes;
+}
+
+// Helper function to send the next dirty region of a flush in progress
+uint16_t OLEDPanel::sendNextRegion() {
+
+	const DirtyRegion& region = _pendingRegions[_pendingIndex++];
+#if WA_OLED_HAS_DMA
+	if (_useDMA) {
+		queueDMARegions(&region, 1);
+	} else
+#endif
+	{
+		sendRegion(region);
+	}
+
+	uint16_t bytes = commitRegion(region);
+	if (_pendingIndex >= _pendingCount) {
+		finishFlush();
+	}
+	return bytes;
+}
+
+bool OLEDPanel::flushInProgress() const {
+	return _pendingIndex < _pendingCount;
+}
+
+// Helper function to record a sent region in the shadow buffer
+uint16_t OLEDPanel::commitRegion(const DirtyRegion& region) {
+	const uint8_t* buffer = _display->getBuffer();
+	uint8_t span = region.lastColumn - region.firstColumn + 1;
+	uint16_t bytes = 0;
+	for (uint8_t page = region.firstPage; page <= region.lastPage; page++) {
+		uint16_t offset = page * _width + region.firstColumn;
+		memcpy(_shadow + offset, buffer + offset, span);
+		bytes += span;
+	}
+	_bytesSent += bytes;
+	return bytes;
+}
+
+void OLEDPanel::finishFlush() {
+	_pendingCount = 0;
+	_pendingIndex = 0;
+	_shadowValid = true;
+	_flushCount++;
+}
+
+void OLEDPanel::command(uint8_t c) {
+	sendCommands(&c, 1);
+}
+
+void OLEDPanel::sendRegion(const DirtyRegion& region) {
+	const uint8_t window[] = {
+		SSD1306_COLUMNADDR, region.firstColumn, region.lastColumn,
+		SSD1306_PAGEADDR, region.firstPage, region.lastPage
+	};
+	sendCommands(window, sizeof(window));
+
+	// Horizontal addressing mode walks the window page by page
+	const uint8_t* buffer = _display->getBuffer();
+	uint8_t span = region.lastColumn - region.firstColumn + 1;
+	for (uint8_t page = region.firstPage; page <= region.lastPage; page++) {
+		sendData(buffer + page * _width + region.firstColumn, span);
+	}
+}
+
+void OLEDPanel::beginSPITransfer(bool isData) {
+	SPI.beginTransaction(SPISettings(_config.frequency, MSBFIRST, SPI_MODE0));
+	digitalWrite(_config.dcPin, isData ? HIGH : LOW);
+	if (_config.csPin >= 0) {
+		digitalWrite(_config.csPin, LOW);
+	}
+}
+
+void OLEDPanel::endSPITransfer() {
+	if (_config.csPin >= 0) {
+		digitalWrite(_config.csPin, HIGH);
+	}
+	SPI.endTransaction();
+}
+
+void OLEDPanel::sendCommands(const uint8_t* commands, uint8_t count) {
+#if WA_OLED_HAS_DMA
+	if (_useDMA) {
+		// Commands must not overtake queued framebuffer data
+		waitForFlush();
+		memcpy(_dmaCommands, commands, count);
+		spi_transaction_t transaction;
+		memset(&transaction, 0, sizeof(transaction));
+		transaction.length = count * 8;
+		transaction.tx_buffer = _dmaCommands;
+		transaction.user = &_dmaCommandTag;
+		spi_device_polling_transmit(_dmaDevice, &transaction);
+		return;
+	}
+#endif
+
+	if (_config.bus == OLED_BUS_SPI) {
+		beginSPITransfer(false);
+		SPI.writeBytes(commands, count);
+		endSPITransfer();
+		return;
+	}
+
+	Wire.beginTransmission(_config.i2cAddr);
+	Wire.write((uint8_t)OLED_CONTROL_COMMAND);
+	Wire.write(commands, count);
+	Wire.endTransmission();
+}
+
+void OLEDPanel::sendData(const uint8_t* data, uint16_t count) {
+	if (_config.bus == OLED_BUS_SPI) {
+		beginSPITransfer(true);
+		SPI.writeBytes(data, count);
+		endSPITransfer();
+		return;
+	}
+
+	// Split into chunks that fit the Wire buffer, each with its own control byte
+	while (count > 0) {
+		uint16_t chunk = min((uint16_t)OLED_I2C_CHUNK, count);
+		Wire.beginTransmission(_config.i2cAddr);
+		Wire.write((uint8_t)OLED_CONTROL_DATA);
+		Wire.write(data, chunk);
+		Wire.endTransmission();
+		data += chunk;
+		count -= chunk;
+	}
+}
+
+void OLEDPanel::waitForFlush() {
+#if WA_OLED_HAS_DMA
+	while (_dmaPending > 0) {
+		spi_transaction_t* done = nullptr;
+		spi_device_get_trans_result(_dmaDevice, &done, portMAX_DELAY);
+		_dmaPending--;
+	}
+#endif
+}
+
+#if WA_OLED_HAS_DMA
+void IRAM_ATTR OLEDPanel::dmaPreTransfer(spi_transaction_t* transaction) {
+	const DMATag* tag = (const DMATag*)transaction->user;
+	gpio_set_level((gpio_num_t)tag->dcPin, tag->level);
+}
+
+bool OLEDPanel::beginDMA() {
+	uint16_t bufferSize = _width * _pages;
+
+	// Release the Arduino SPI driver of the same peripheral; the panel is already initialised
+	SPI.end();
+
+	spi_bus_config_t bus;
+	memset(&bus, 0, sizeof(bus));
+	bus.mosi_io_num = _config.mosiPin >= 0 ? _config.mosiPin : MOSI;
+	bus.miso_io_num = -1;
+	bus.sclk_io_num = _config.sclkPin >= 0 ? _config.sclkPin : SCK;
+	bus.quadwp_io_num = -1;
+	bus.quadhd_io_num = -1;
+	bus.max_transfer_sz = bufferSize;
+
+	// ESP_ERR_INVALID_STATE means another device already set the bus up
+	esp_err_t err = spi_bus_initialize(OLED_DMA_SPI_HOST, &bus, SPI_DMA_CH_AUTO);
+	if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+		return false;
+	}
+	_dmaBusOwned = (err == ESP_OK);
+
+	spi_device_interface_config_t device;
+	memset(&device, 0, sizeof(device));
+	device.clock_speed_hz = _config.frequency;
+	device.mode = 0;
+	device.spics_io_num = _config.csPin;
+	device.queue_size = sizeof(_dmaTransactions) / sizeof(_dmaTransactions[0]);
+	device.pre_cb = dmaPreTransfer;
+	if (spi_bus_add_device(OLED_DMA_SPI_HOST, &device, &_dmaDevice) != ESP_OK) {
+		if (_dmaBusOwned) {
+			spi_bus_free(OLED_DMA_SPI_HOST);
+			_dmaBusOwned = false;
+		}
+		return false;
+	}
+
+	// DMA reads from its own staging copy so drawing can continue during a flush
+	_dmaData = (uint8_t*)heap_caps_malloc(bufferSize, MALLOC_CAP_DMA);
+	_dmaCommands = (uint8_t*)heap_caps_malloc(OLED_MAX_PAGES * 6, MALLOC_CAP_DMA);
+	if (_dmaData == nullptr || _dmaCommands == nullptr) {
+		endDMA();
+		return false;
+	}
+
+	_dmaCommandTag.dcPin = _config.dcPin;
+	_dmaCommandTag.level = 0;
+	_dmaDataTag.dcPin = _config.dcPin;
+	_dmaDataTag.level = 1;
+	_dmaPending = 0;
+	return true;
+}
+
+void OLEDPanel::endDMA() {
+	if (_dmaDevice != nullptr) {
+		waitForFlush();
+		spi_bus_remove_device(_dmaDevice);
+		_dmaDevice = nullptr;
+	}
+	if (_dmaBusOwned) {
+		spi_bus_free(OLED_DMA_SPI_HOST);
+		_dmaBusOwned = false;
+	}
+	if (_dmaData != nullptr) {
+		heap_caps_free(_dmaData);
+		_dmaData = nullptr;
+	}
+	if (_dmaCommands != nullptr) {
+		heap_caps_free(_dmaCommands);
+		_dmaCommands = nullptr;
+	}
+}
+
+void OLEDPanel::queueDMARegions(const DirtyRegion* regions, uint8_t regionCount) {
+	// The staging buffers are reused, so the previous flush must be finished
+	waitForFlush();
+
+	const uint8_t* buffer = _display->getBuffer();
+	uint16_t dataOffset = 0;
+	for (uint8_t i = 0; i < regionCount; i++) {
+		const DirtyRegion& region = regions[i];
+		uint8_t* window = _dmaCommands + i * 6;
+		window[0] = SSD1306_COLUMNADDR;
+		window[1] = region.firstColumn;
+		window[2] = region.lastColumn;
+		window[3] = SSD1306_PAGEADDR;
+		window[4] = region.firstPage;
+		window[5] = region.lastPage;
+
+		uint8_t span = region.lastColumn - region.firstColumn + 1;
+		uint16_t regionStart = dataOffset;
+		for (uint8_t page = region.firstPage; page <= region.lastPage; page++) {
+			memcpy(_dmaData + dataOffset, buffer + page * _width + region.firstColumn, span);
+			dataOffset += span;
+		}
+
+		spi_transaction_t* commandTransaction = &_dmaTransactions[i * 2];
+		memset(commandTransaction, 0, sizeof(spi_transaction_t));
+		commandTransaction->length = 6 * 8;
+		commandTransaction->tx_buffer = window;
+		commandTransaction->user = &_dmaCommandTag;
+
+		spi_transaction_t* dataTransaction = &_dmaTransactions[i * 2 + 1];
+		memset(dataTransaction, 0, sizeof(spi_transaction_t));
+		dataTransaction->length = (dataOffset - regionStart) * 8;
+		dataTransaction->tx_buffer = _dmaData + regionStart;
+		dataTransaction->user = &_dmaDataTag;
+
+		if (spi_device_queue_trans(_dmaDevice, commandTransaction, portMAX_DELAY) == ESP_OK) {
+			_dmaPending++;
+		}
+		if (spi_device_queue_trans(_dmaDevice, dataTransaction, portMAX_DELAY) == ESP_OK) {
+			_dmaPending++;
+		}
+	}
+}
+#endif
@@ -0,0 +1,172 @@
+#ifndef WEATHER_ANIMATIONS_OLED_H
+#define WEATHER_ANIMATIONS_OLED_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <SPI.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>
+#include "WeatherAnimationsCanvas.h"
+
+// DMA flushing is only available with the ESP-IDF SPI master driver
+#if defined(ARDUINO_ARCH_ESP32)
+	#include <driver/spi_master.h>
+	#define WA_OLED_HAS_DMA 1
+	// SPI peripheral behind the Arduino SPI object, which DMA flushes take
+	// over: VSPI on the ESP32, FSPI on the S2, S3, C3, C6 and H2 (which have
+	// no SPI3_HOST)
+	#ifndef OLED_DMA_SPI_HOST
+		#if defined(CONFIG_IDF_TARGET_ESP32)
+			#define OLED_DMA_SPI_HOST SPI3_HOST
+		#else
+			#define OLED_DMA_SPI_HOST SPI2_HOST
+		#endif
+	#endif
+#else
+	#define WA_OLED_HAS_DMA 0
+#endif
+
+// Bus used to talk to an SSD1306 panel
+#define OLED_BUS_I2C 0
+#define OLED_BUS_SPI 1
+
+// Tallest supported panel, in 8-row pages
+#define OLED_MAX_PAGES 8
+
+// Default bus clocks
+#define OLED_I2C_DEFAULT_FREQUENCY 400000UL
+#define OLED_SPI_DEFAULT_FREQUENCY 10000000UL
+
+namespace WeatherAnimationsLib {
+
+// Transport settings for one panel
+struct OLEDBusConfig {
+	uint8_t bus;          // OLED_BUS_I2C or OLED_BUS_SPI
+	uint8_t i2cAddr;      // I2C only
+	int8_t dcPin;         // SPI only: data/command select
+	int8_t csPin;         // SPI only: chip select
+	int8_t rstPin;        // Reset pin, -1 if tied to the board reset
+	int8_t sclkPin;       // SPI only: -1 for the board default
+	int8_t mosiPin;       // SPI only: -1 for the board default
+	uint32_t frequency;   // Bus clock in Hz
+	bool useDMA;          // SPI only: queue flushes through DMA where supported
+};
+
+// Returns an I2C configuration with the library defaults
+OLEDBusConfig oledI2CConfig(uint8_t i2cAddr);
+
+// Returns an SPI configuration with the library defaults
+OLEDBusConfig oledSPIConfig(int8_t dcPin, int8_t csPin, int8_t rstPin = -1,
+                            uint32_t frequency = OLED_SPI_DEFAULT_FREQUENCY, bool useDMA = true);
+
+// An SSD1306 panel together with its transport.
+//
+// Drawing goes through the OLEDCanvas returned by begin(). flush() replaces
+// Adafruit_SSD1306::display(): it keeps a copy of what the panel currently
+// shows and only sends the column span of each page that changed since the
+// previous flush.
+//
+// Rotation and mirroring are applied once per flush when the canvas is copied
+// into the panel framebuffer, so drawing itself runs at full speed in any
+// orientation. With OLED_ROTATE_90/270 the canvas is height x width.
+class OLEDPanel {
+public:
+	OLEDPanel();
+	~OLEDPanel();
+
+	// Create and initialise the panel. Returns nullptr if the panel does not respond.
+	OLEDCanvas* begin(uint8_t width, uint8_t height, const OLEDBusConfig& config,
+	                  uint8_t rotation = OLED_ROTATE_0, uint8_t mirror = OLED_MIRROR_NONE);
+
+	// Release the panel and all transport resources
+	void end();
+
+	// Drawing surface for this panel (nullptr before begin())
+	OLEDCanvas* display() const;
+
+	// Send the changed regions of the framebuffer to the panel.
+	// Returns the number of framebuffer bytes transferred.
+	uint16_t flush();
+
+	// Incremental flush, used when several panels share a bus.
+	// beginFlush() snapshots the dirty regions and returns false if there are none;
+	// each flushStep() then sends one region and returns its size in bytes.
+	bool beginFlush();
+	uint16_t flushStep();
+	bool flushInProgress() const;
+
+	// Force the next flush to resend the whole framebuffer
+	void invalidate();
+
+	// Send a single command byte over the panel's transport
+	void command(uint8_t c);
+
+	// Block until any queued DMA transfer has completed
+	void waitForFlush();
+
+	// Transfer statistics
+	uint32_t bytesSent() const;
+	uint32_t flushCount() const;
+	const OLEDBusConfig& busConfig() const;
+
+private:
+	// One rectangular window of pages/columns to transfer
+	struct DirtyRegion {
+		uint8_t firstPage;
+		uint8_t lastPage;
+		uint8_t firstColumn;
+		uint8_t lastColumn;
+	};
+
+	uint8_t collectDirtyRegions(DirtyRegion* regions);
+	uint16_t sendNextRegion();
+	uint16_t commitRegion(const DirtyRegion& region);
+	void finishFlush();
+	void sendCommands(const uint8_t* commands, uint8_t count);
+	void sendRegion(const DirtyRegion& region);
+	void sendData(const uint8_t* data, uint16_t count);
+	void beginSPITransfer(bool isData);
+	void endSPITransfer();
+
+#if WA_OLED_HAS_DMA
+	// Per-transaction tag telling the pre-transfer callback how to drive D/C
+	struct DMATag {
+		int8_t dcPin;
+		uint8_t level;
+	};
+
+	bool beginDMA();
+	void endDMA();
+	void queueDMARegions(const DirtyRegion* regions, uint8_t regionCount);
+	static void IRAM_ATTR dmaPreTransfer(spi_transaction_t* transaction);
+
+	spi_device_handle_t _dmaDevice;
+	bool _dmaBusOwned;
+	uint8_t* _dmaData;
+	uint8_t* _dmaCommands;
+	spi_transaction_t _dmaTransactions[16];
+	uint8_t _dmaPending;
+	DMATag _dmaCommandTag;
+	DMATag _dmaDataTag;
+#endif
+
+	Adafruit_SSD1306* _display;
+	OLEDCanvas* _canvas;
+	OLEDBusConfig _config;
+	uint8_t _rotation;
+	uint8_t _mirror;
+	uint8_t _width;
+	uint8_t _pages;
+	uint8_t* _shadow;
+	bool _shadowValid;
+	DirtyRegion _pendingRegions[OLED_MAX_PAGES];
+	uint8_t _pendingCount;
+	uint8_t _pendingIndex;
+	bool _useDMA;
+	uint32_t _bytesSent;
+	uint32_t _flushCount;
+};
+
+}
+
+#endif // WEATHER_ANIMATIONS_OLED_H
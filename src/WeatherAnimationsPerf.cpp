@@ -0,0 +1,203 @@
+#include "WeatherAnimationsPerf.h"
+#include "WeatherAnimationsTrace.h"
+
+using namespace WeatherAnimationsLib;
+
+static const char* const stageNames[PERF_STAGE_COUNT] = {
+	"wifi", "http", "parse", "asset_load", "decode", "render", "flush"
+};
+
+PerfHistogram::PerfHistogram() {
+	reset();
+}
+
+uint8_t PerfHistogram::bucketOf(uint32_t micros) {
+	if (micros < PERF_SUB_BUCKETS) {
+		return micros;
+	}
+	uint8_t octave = 31 - __builtin_clz(micros);
+	if (octave >= PERF_MAX_OCTAVE) {
+		return PERF_BUCKETS - 1;
+	}
+	return (octave - 1) * PERF_SUB_BUCKETS + ((micros >> (octave - 2)) & (PERF_SUB_BUCKETS - 1));
+}
+
+uint32_t PerfHistogram::bucketLimit(uint8_t bucket) {
+	if (bucket < PERF_SUB_BUCKETS) {
+		return bucket;
+	}
+	uint8_t octave = bucket / PERF_SUB_BUCKETS + 1;
+	uint32_t width = 1UL << (octave - 2);
+	return (PERF_SUB_BUCKETS + bucket % PERF_SUB_BUCKETS) * width + width - 1;
+}
+
+void PerfHistogram::record(uint32_t micros) {
+	_buckets[bucketOf(micros)].fetch_add(1, std::memory_order_relaxed);
+	_count.fetch_add(1, std::memory_order_relaxed);
+
+	uint32_t current = _min.load(std::memory_order_relaxed);
+	while (micros < current && !_min.compare_exchange_weak(current, micros, std::memory_order_relaxed)) {
+	}
+	current = _max.load(std::memory_order_relaxed);
+	while (micros > current && !_max.compare_exchange_weak(current, micros, std::memory_order_relaxed)) {
+	}
+}
+
+void PerfHistogram::reset() {
+	for (uint8_t i = 0; i < PERF_BUCKETS; i++) {
+		_buckets[i].store(0, std::memory_order_relaxed);
+	}
+	_count.store(0, std::memory_order_relaxed);
+	_min.store(UINT32_MAX, std::memory_order_relaxed);
+	_max.store(0, std::memory_order_relaxed);
+}
+
+uint32_t PerfHistogram::count() const {
+	return _count.load(std::memory_order_relaxed);
+}
+
+uint32_t PerfHistogram::min() const {
+	uint32_t value = _min.load(std::memory_order_relaxed);
+	return value == UINT32_MAX ? 0 : value;
+}
+
+uint32_t PerfHistogram::max() const {
+	return _max.load(std::memory_order_relaxed);
+}
+
+uint32_t PerfHistogram::percentile(uint16_t perMille) const {
+	// Count from the buckets themselves, so a record() running meanwhile
+	// cannot push the rank past the last bucket
+	uint32_t counts[PERF_BUCKETS];
+	uint32_t total = 0;
+	for (uint8_t i = 0; i < PERF_BUCKETS; i++) {
+		counts[i] = _buckets[i].load(std::memory_order_relaxed);
+		total += counts[i];
+	}
+	if (total == 0) {
+		return 0;
+	}
+
+	uint32_t rank = (uint32_t)(((uint64_t)total * perMille + 999) / 1000);
+	if (rank == 0) {
+		rank = 1;
+	}
+	uint32_t seen = 0;
+	uint8_t bucket = 0;
+	for (; bucket < PERF_BUCKETS - 1; bucket++) {
+		seen += counts[bucket];
+		if (seen >= rank) {
+			break;
+		}
+	}
+
+	// The bucket bound can lie outside what was actually recorded
+	uint32_t value = bucketLimit(bucket);
+	if (value > max()) {
+		value = max();
+	}
+	if (value < min()) {
+		value = min();
+	}
+	return value;
+}
+
+void PerfHistogram::stats(PerfStageStats* stats) const {
+	stats->count = count();
+	stats->minMicros = min();
+	stats->p50Micros = percentile(500);
+	stats->p99Micros = percentile(990);
+	stats->maxMicros = max();
+}
+
+const char* WeatherAnimationsLib::perfStageName(uint8_t stage) {
+	return stage < PERF_STAGE_COUNT ? stageNames[stage] : "unknown";
+}
+
+#ifndef WA_DISABLE_PERF
+
+static PerfHistogram histograms[PERF_STAGE_COUNT];
+
+// Helper function to convert perfTicks() differences to microseconds
+static uint32_t ticksToMicros(uint32_t ticks) {
+#if defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_ESP8266)
+	// Read the clock speed once; asking for it costs more than the rest of a record
+	static std::atomic<uint32_t> ticksPerMicro(0);
+	uint32_t perMicro = ticksPerMicro.load(std::memory_order_relaxed);
+	if (perMicro == 0) {
+		perMicro = ESP.getCpuFreqMHz();
+		ticksPerMicro.store(perMicro, std::memory_order_relaxed);
+	}
+	return ticks / perMicro;
+#else
+	return ticks;
+#endif
+}
+
+void WeatherAnimationsLib::perfRecord(uint8_t stage, uint32_t startTicks, const char* argName, uint32_t arg) {
+	if (stage >= PERF_STAGE_COUNT) {
+		return;
+	}
+	uint32_t duration = ticksToMicros(perfTicks() - startTicks);
+	histograms[stage].record(duration);
+	if (traceActive()) {
+		traceComplete(stageNames[stage], micros() - duration, duration, argName, arg);
+	}
+}
+
+void WeatherAnimationsLib::perfRecordMicros(uint8_t stage, uint32_t duration) {
+	if (stage >= PERF_STAGE_COUNT) {
+		return;
+	}
+	histograms[stage].record(duration);
+	if (traceActive()) {
+		traceComplete(stageNames[stage], micros() - duration, duration);
+	}
+}
+
+PerfStats WeatherAnimationsLib::getPerfStats() {
+	PerfStats stats;
+	for (uint8_t i = 0; i < PERF_STAGE_COUNT; i++) {
+		histograms[i].stats(&stats.stages[i]);
+	}
+	return stats;
+}
+
+void WeatherAnimationsLib::resetPerfStats() {
+	for (uint8_t i = 0; i < PERF_STAGE_COUNT; i++) {
+		histograms[i].reset();
+	}
+}
+
+#else
+
+PerfStats WeatherAnimationsLib::getPerfStats() {
+	PerfStats stats;
+	memset(&stats, 0, sizeof(stats));
+	return stats;
+}
+
+void WeatherAnimationsLib::resetPerfStats() {
+}
+
+#endif
+
+void WeatherAnimationsLib::dumpPerfStats(Print& out) {
+#ifdef WA_DISABLE_PERF
+	out.println("Perf stats disabled (WA_DISABLE_PERF)");
+#else
+	PerfStats stats = getPerfStats();
+	out.println("stage        count      min      p50      p99      max (us)");
+	for (uint8_t i = 0; i < PERF_STAGE_COUNT; i++) {
+		const PerfStageStats& stage = stats.stages[i];
+		if (stage.count == 0) {
+			continue;
+		}
+		char line[80];
+		snprintf(line, sizeof(line), "%-10s %7lu %8lu %8lu %8lu %8lu", stageNames[i], (unsigned long)stage.count,
+		         (unsigned long)stage.minMicros, (unsigned long)stage.p50Micros, (unsigned long)stage.p99Micros,
+		         (unsigned long)stage.maxMicros);
+		out.println(line);
+	}
+#endif
+}
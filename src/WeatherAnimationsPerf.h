@@ -0,0 +1,158 @@
+#ifndef WEATHER_ANIMATIONS_PERF_H
+#define WEATHER_ANIMATIONS_PERF_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Stages timed by the library. Define WA_DISABLE_PERF to compile the timing
+// out; the functions below then report empty statistics.
+#define PERF_WIFI 0       // Wi-Fi connection attempts
+#define PERF_HTTP 1       // One Home Assistant request, connect to last byte
+#define PERF_PARSE 2      // Parsing a Home Assistant response
+#define PERF_ASSET_LOAD 3 // Downloading an animation frame, icon or GIF
+#define PERF_DECODE 4     // PNG to bitmap
+#define PERF_RENDER 5     // Drawing one frame
+#define PERF_FLUSH 6      // Sending a frame (or one flush step) to an OLED
+#define PERF_STAGE_COUNT 7
+
+// Histogram layout: every power of two of microseconds is split into
+// PERF_SUB_BUCKETS buckets, up to 2^PERF_MAX_OCTAVE us (about 16.7 s).
+// Longer durations land in the last bucket; the exact maximum is kept apart.
+#define PERF_SUB_BUCKETS 4
+#define PERF_MAX_OCTAVE 24
+#define PERF_BUCKETS ((PERF_MAX_OCTAVE - 1) * PERF_SUB_BUCKETS)
+
+namespace WeatherAnimationsLib {
+
+// Latency of one stage, in microseconds. The percentiles are the upper
+// bound of the bucket they fall in, so at most 25% above the real value.
+struct PerfStageStats {
+	uint32_t count;
+	uint32_t minMicros;
+	uint32_t p50Micros;
+	uint32_t p99Micros;
+	uint32_t maxMicros;
+};
+
+struct PerfStats {
+	PerfStageStats stages[PERF_STAGE_COUNT];
+};
+
+// Fixed-size log-scale histogram of durations in microseconds. record() is a
+// few relaxed atomic operations, so tasks on both cores can feed it and
+// another task can read it without locks.
+class PerfHistogram {
+public:
+	PerfHistogram();
+
+	void record(uint32_t micros);
+	void reset();
+
+	// Current statistics; percentiles are given in parts per thousand
+	uint32_t count() const;
+	uint32_t min() const;
+	uint32_t max() const;
+	uint32_t percentile(uint16_t perMille) const;
+	void stats(PerfStageStats* stats) const;
+
+	// Bucket a duration falls in, and the largest duration a bucket holds
+	static uint8_t bucketOf(uint32_t micros);
+	static uint32_t bucketLimit(uint8_t bucket);
+
+private:
+	PerfHistogram(const PerfHistogram&);
+	PerfHistogram& operator=(const PerfHistogram&);
+
+	std::atomic<uint32_t> _buckets[PERF_BUCKETS];
+	std::atomic<uint32_t> _count;
+	std::atomic<uint32_t> _min;
+	std::atomic<uint32_t> _max;
+};
+
+// Cheapest clock available: the CPU cycle counter on the boards, micros() elsewhere.
+// The cycle counter wraps after 2^32 cycles (about 17 s at 240 MHz) and is
+// per core, so a timed span must stay on one task.
+#if defined(WA_DISABLE_PERF)
+inline uint32_t perfTicks() {
+	return 0;
+}
+#elif defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_ESP8266)
+inline uint32_t perfTicks() {
+	return ESP.getCycleCount();
+}
+#else
+inline uint32_t perfTicks() {
+	return micros();
+}
+#endif
+
+#ifndef WA_DISABLE_PERF
+// Record the time since startTicks (a perfTicks() value) for a stage. While
+// a trace runs, the span also goes to the trace ring, with the optional
+// argument (such as a byte count) attached.
+void perfRecord(uint8_t stage, uint32_t startTicks, const char* argName = nullptr, uint32_t arg = 0);
+
+// Record a duration measured some other way, e.g. with millis() across tasks
+void perfRecordMicros(uint8_t stage, uint32_t micros);
+#else
+inline void perfRecord(uint8_t stage, uint32_t startTicks, const char* argName = nullptr, uint32_t arg = 0) {
+	(void)stage;
+	(void)startTicks;
+	(void)argName;
+	(void)arg;
+}
+
+inline void perfRecordMicros(uint8_t stage, uint32_t micros) {
+	(void)stage;
+	(void)micros;
+}
+#endif
+
+// Times the enclosing block. Use WA_PERF_SCOPE() or WA_PERF_SCOPE_ARG() so
+// it disappears with WA_DISABLE_PERF.
+class PerfScope {
+public:
+	explicit PerfScope(uint8_t stage, const char* argName = nullptr, uint32_t arg = 0)
+		: _stage(stage), _start(perfTicks()), _argName(argName), _arg(arg) {}
+	~PerfScope() { perfRecord(_stage, _start, _argName, _arg); }
+
+private:
+	uint8_t _stage;
+	uint32_t _start;
+	const char* _argName;
+	uint32_t _arg;
+};
+
+// Statistics of every stage, shared by all WeatherAnimations instances
+PerfStats getPerfStats();
+
+// One line per stage that has been timed: count, min, p50, p99 and max
+void dumpPerfStats(Print& out);
+
+// Forget everything recorded so far
+void resetPerfStats();
+
+// Short name of a stage, e.g. "render"
+const char* perfStageName(uint8_t stage);
+
+}
+
+#define WA_PERF_CONCAT_(a, b) a##b
+#define WA_PERF_CONCAT(a, b) WA_PERF_CONCAT_(a, b)
+
+// Timed stages are also allocation scopes (WA_TRACK_ALLOCATIONS)
+#include "WeatherAnimationsAlloc.h"
+
+#ifndef WA_DISABLE_PERF
+#define WA_PERF_SCOPE(stage) \
+	WA_ALLOC_SCOPE(stage); \
+	WeatherAnimationsLib::PerfScope WA_PERF_CONCAT(perfScope, __LINE__)(stage)
+#define WA_PERF_SCOPE_ARG(stage, argName, arg) \
+	WA_ALLOC_SCOPE(stage); \
+	WeatherAnimationsLib::PerfScope WA_PERF_CONCAT(perfScope, __LINE__)(stage, argName, arg)
+#else
+#define WA_PERF_SCOPE(stage) WA_ALLOC_SCOPE(stage)
+#define WA_PERF_SCOPE_ARG(stage, argName, arg) WA_ALLOC_SCOPE(stage)
+#endif
+
+#endif // WEATHER_ANIMATIONS_PERF_H
@@ -0,0 +1,91 @@
+#include "WeatherAnimationsPipeline.h"
+
+#if WA_PIPELINE_THREADS && !WA_PIPELINE_FREERTOS
+#include <chrono>
+#endif
+
+using namespace WeatherAnimationsLib;
+
+PipelineWorker::PipelineWorker()
+	: _body(nullptr), _context(nullptr), _started(false), _finished(false)
+#if WA_PIPELINE_FREERTOS
+	, _handle(nullptr)
+#endif
+{
+}
+
+PipelineWorker::~PipelineWorker() {
+	join();
+}
+
+// Entry point of the worker thread
+void PipelineWorker::run(void* worker) {
+	PipelineWorker* self = static_cast<PipelineWorker*>(worker);
+	self->_body(self->_context);
+	self->_finished.store(true, std::memory_order_release);
+#if WA_PIPELINE_FREERTOS
+	// FreeRTOS tasks must not return
+	vTaskDelete(nullptr);
+#endif
+}
+
+bool PipelineWorker::start(const char* name, Body body, void* context, uint8_t core) {
+	if (_started || body == nullptr) {
+		return false;
+	}
+	_body = body;
+	_context = context;
+	_finished.store(false, std::memory_order_relaxed);
+
+#if WA_PIPELINE_FREERTOS
+	if (xTaskCreatePinnedToCore(run, name, PIPELINE_STACK_SIZE, this, PIPELINE_PRIORITY, &_handle, core) != pdPASS) {
+		return false;
+	}
+	_started = true;
+	return true;
+#elif WA_PIPELINE_THREADS
+	(void)name;
+	(void)core;
+	_thread = std::thread(run, this);
+	_started = true;
+	return true;
+#else
+	(void)name;
+	(void)core;
+	return false;
+#endif
+}
+
+void PipelineWorker::join() {
+	if (!_started) {
+		return;
+	}
+#if WA_PIPELINE_FREERTOS
+	// The task deletes itself once the body returns
+	while (!_finished.load(std::memory_order_acquire)) {
+		pipelineSleep(1);
+	}
+	_handle = nullptr;
+#elif WA_PIPELINE_THREADS
+	_thread.join();
+#endif
+	_started = false;
+}
+
+bool PipelineWorker::started() const {
+	return _started;
+}
+
+void WeatherAnimationsLib::pipelineSleep(uint32_t ms) {
+	if (ms == 0) {
+		ms = 1;
+	}
+#if WA_PIPELINE_FREERTOS
+	TickType_t ticks = pdMS_TO_TICKS(ms);
+	vTaskDelay(ticks > 0 ? ticks : 1);
+#elif WA_PIPELINE_THREADS
+	std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+#else
+	delay(ms);
+#endif
+}
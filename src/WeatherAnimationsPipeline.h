@@ -0,0 +1,220 @@
+#ifndef WEATHER_ANIMATIONS_PIPELINE_H
+#define WEATHER_ANIMATIONS_PIPELINE_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <string.h>
+#include "WeatherAnimationsAnimations.h"
+#include "WeatherAnimationsHub.h"
+
+// Worker threads: FreeRTOS tasks pinned to a core on ESP32, std::thread on
+// host builds. ESP8266 has a single core and no threads, so no pipeline.
+#if defined(ARDUINO_ARCH_ESP32)
+	#include <freertos/FreeRTOS.h>
+	#include <freertos/task.h>
+	#define WA_PIPELINE_FREERTOS 1
+	#define WA_PIPELINE_THREADS 1
+#elif defined(ARDUINO_ARCH_ESP8266) || defined(ESP8266)
+	#define WA_PIPELINE_FREERTOS 0
+	#define WA_PIPELINE_THREADS 0
+#else
+	#include <thread>
+	#define WA_PIPELINE_FREERTOS 0
+	#define WA_PIPELINE_THREADS 1
+#endif
+
+// ThreadSanitizer does not model std::atomic_thread_fence, see SeqLock
+#if defined(__SANITIZE_THREAD__)
+	#define WA_TSAN 1
+#elif defined(__has_feature)
+	#if __has_feature(thread_sanitizer)
+		#define WA_TSAN 1
+	#endif
+#endif
+#ifndef WA_TSAN
+	#define WA_TSAN 0
+#endif
+
+// Cores for the two halves of the pipeline (ESP32 only)
+#define PIPELINE_NETWORK_CORE 0
+#define PIPELINE_RENDER_CORE 1
+
+// Stack size and priority of each pipeline task (ESP32 only)
+#define PIPELINE_STACK_SIZE 8192
+#define PIPELINE_PRIORITY 1
+
+// Slots in each pipeline queue (one is always kept free)
+#define PIPELINE_QUEUE_SIZE 4
+
+// Longest a worker sleeps before looking at its queue again, in milliseconds
+#define PIPELINE_MAX_SLEEP 10
+
+// Message types
+#define PIPELINE_WEATHER_STATE 1 // network -> render: a new snapshot
+#define PIPELINE_FRAMES_READY 2  // network -> render: new frames for a condition were published
+#define PIPELINE_FETCH_FRAMES 3  // render -> network: download the frames at url
+#define PIPELINE_FETCH_ICON 4    // render -> network: download an icon
+
+namespace WeatherAnimationsLib {
+
+// One message between the network and render halves of the pipeline
+struct PipelineMessage {
+	uint8_t type;
+	uint8_t weatherCondition;
+	const IconMapping* icon;  // PIPELINE_FETCH_ICON
+	WeatherSnapshot snapshot; // PIPELINE_WEATHER_STATE
+	char url[ONLINE_ANIMATION_URL_LENGTH]; // PIPELINE_FETCH_FRAMES
+};
+
+// Lock-free queue between exactly one producer and one consumer.
+//
+// push() is only ever called from one task and pop() from one other task;
+// the head and tail indices are each written by one side only, so no lock
+// is needed. Holds Size - 1 items.
+template <typename T, uint8_t Size>
+class SPSCQueue {
+public:
+	SPSCQueue() : _head(0), _tail(0) {}
+
+	// Producer side. Returns false if the queue is full. Always inlined, so
+	// an IRAM_ATTR interrupt handler that pushes runs no code from flash.
+	__attribute__((always_inline)) bool push(const T& item) {
+		uint8_t head = _head.load(std::memory_order_relaxed);
+		uint8_t next = (head + 1) % Size;
+		if (next == _tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+		_items[head] = item;
+		_head.store(next, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer side. Returns false if the queue is empty.
+	bool pop(T* item) {
+		uint8_t tail = _tail.load(std::memory_order_relaxed);
+		if (tail == _head.load(std::memory_order_acquire)) {
+			return false;
+		}
+		*item = _items[tail];
+		_tail.store((tail + 1) % Size, std::memory_order_release);
+		return true;
+	}
+
+	bool empty() const {
+		return _tail.load(std::memory_order_acquire) == _head.load(std::memory_order_acquire);
+	}
+
+private:
+	T _items[Size];
+	std::atomic<uint8_t> _head; // next slot to write, owned by the producer
+	std::atomic<uint8_t> _tail; // next slot to read, owned by the consumer
+};
+
+// A value with one writer and any number of lock-free readers.
+//
+// The writer makes the sequence odd, stores the value and makes it even
+// again; a reader retries if the sequence was odd or changed while it was
+// copying. The value is kept in atomic words so that a copy racing with a
+// write is retried rather than being undefined behaviour.
+//
+// Fences order the relaxed word accesses against the sequence. Under
+// ThreadSanitizer, which cannot see fences, each word is stored with
+// release and loaded with acquire instead: slower, but the same ordering.
+template <typename T>
+class SeqLock {
+public:
+	SeqLock() : _sequence(0) {
+		for (size_t i = 0; i < WORDS; i++) {
+			_words[i].store(0, std::memory_order_relaxed);
+		}
+	}
+
+	// Writer side, one task only
+	void write(const T& value) {
+		uint32_t words[WORDS];
+		words[WORDS - 1] = 0;
+		memcpy(words, &value, sizeof(T));
+
+		uint32_t sequence = _sequence.load(std::memory_order_relaxed);
+		_sequence.store(sequence + 1, std::memory_order_relaxed);
+#if !WA_TSAN
+		std::atomic_thread_fence(std::memory_order_release);
+#endif
+		for (size_t i = 0; i < WORDS; i++) {
+			_words[i].store(words[i], WORD_STORE);
+		}
+		_sequence.store(sequence + 2, std::memory_order_release);
+	}
+
+	// Reader side, any task. Returns false if nothing was written yet.
+	bool read(T* value) const {
+		uint32_t words[WORDS];
+		uint32_t before;
+		uint32_t after;
+		do {
+			before = _sequence.load(std::memory_order_acquire);
+			for (size_t i = 0; i < WORDS; i++) {
+				words[i] = _words[i].load(WORD_LOAD);
+			}
+#if !WA_TSAN
+			std::atomic_thread_fence(std::memory_order_acquire);
+#endif
+			after = _sequence.load(std::memory_order_relaxed);
+		} while ((before & 1) != 0 || before != after);
+
+		memcpy(value, words, sizeof(T));
+		return before != 0;
+	}
+
+	// Number of completed writes
+	uint32_t version() const {
+		return _sequence.load(std::memory_order_acquire) / 2;
+	}
+
+private:
+	static const size_t WORDS = (sizeof(T) + 3) / 4;
+#if WA_TSAN
+	static constexpr std::memory_order WORD_STORE = std::memory_order_release;
+	static constexpr std::memory_order WORD_LOAD = std::memory_order_acquire;
+#else
+	static constexpr std::memory_order WORD_STORE = std::memory_order_relaxed;
+	static constexpr std::memory_order WORD_LOAD = std::memory_order_relaxed;
+#endif
+
+	std::atomic<uint32_t> _sequence;
+	std::atomic<uint32_t> _words[WORDS];
+};
+
+// A pipeline thread: a FreeRTOS task pinned to a core, or a std::thread.
+// The body runs until it returns; join() waits for that.
+class PipelineWorker {
+public:
+	typedef void (*Body)(void* context);
+
+	PipelineWorker();
+	~PipelineWorker();
+
+	bool start(const char* name, Body body, void* context, uint8_t core);
+	void join();
+	bool started() const;
+
+private:
+	static void run(void* worker);
+
+	Body _body;
+	void* _context;
+	bool _started;
+	std::atomic<bool> _finished;
+#if WA_PIPELINE_FREERTOS
+	TaskHandle_t _handle;
+#elif WA_PIPELINE_THREADS
+	std::thread _thread;
+#endif
+};
+
+// Sleep the calling worker for at least one tick of the platform scheduler
+void pipelineSleep(uint32_t ms);
+
+}
+
+#endif // WEATHER_ANIMATIONS_PIPELINE_H
@@ -0,0 +1,129 @@
+#include "WeatherAnimationsPool.h"
+
+using namespace WeatherAnimationsLib;
+
+SlabPool::SlabPool(size_t blockSize, uint16_t blockCount)
+	: _buffer(nullptr), _free(nullptr),
+	  _blockSize((blockSize + SLAB_POOL_ALIGN - 1) & ~(size_t)(SLAB_POOL_ALIGN - 1)),
+	  _blockCount(blockCount), _inUse(0), _highWater(0), _failures(0), _locked(false) {
+}
+
+SlabPool::~SlabPool() {
+	free(_buffer);
+}
+
+void SlabPool::lock() const {
+	while (_locked.exchange(true, std::memory_order_acquire)) {
+	}
+}
+
+void SlabPool::unlock() const {
+	_locked.store(false, std::memory_order_release);
+}
+
+// Helper function to allocate the blocks and chain them into the free list
+bool SlabPool::reserveLocked() {
+	if (_buffer != nullptr) {
+		return true;
+	}
+	if (_blockCount == 0) {
+		return false;
+	}
+	_buffer = (uint8_t*)malloc(_blockSize * _blockCount);
+	if (_buffer == nullptr) {
+		return false;
+	}
+	_free = nullptr;
+	for (uint16_t i = _blockCount; i > 0; i--) {
+		void* block = _buffer + (size_t)(i - 1) * _blockSize;
+		*(void**)block = _free;
+		_free = block;
+	}
+	return true;
+}
+
+bool SlabPool::reserve() {
+	lock();
+	bool reserved = reserveLocked();
+	unlock();
+	return reserved;
+}
+
+void* SlabPool::acquire() {
+	lock();
+	void* block = nullptr;
+	if (reserveLocked() && _free != nullptr) {
+		block = _free;
+		_free = *(void**)block;
+		_inUse++;
+		if (_inUse > _highWater) {
+			_highWater = _inUse;
+		}
+	} else {
+		_failures++;
+	}
+	unlock();
+	return block;
+}
+
+bool SlabPool::release(void* block) {
+	lock();
+	bool owned = contains(block);
+	if (owned) {
+		*(void**)block = _free;
+		_free = block;
+		_inUse--;
+	}
+	unlock();
+	return owned;
+}
+
+// Helper function to check that a pointer is the start of one of the blocks
+bool SlabPool::contains(const void* block) const {
+	const uint8_t* pointer = (const uint8_t*)block;
+	return _buffer != nullptr && pointer >= _buffer && pointer < _buffer + _blockSize * _blockCount &&
+	       (size_t)(pointer - _buffer) % _blockSize == 0;
+}
+
+bool SlabPool::owns(const void* block) const {
+	lock();
+	bool owned = contains(block);
+	unlock();
+	return owned;
+}
+
+size_t SlabPool::blockSize() const {
+	return _blockSize;
+}
+
+uint16_t SlabPool::blockCount() const {
+	return _blockCount;
+}
+
+bool SlabPool::reserved() const {
+	lock();
+	bool reserved = _buffer != nullptr;
+	unlock();
+	return reserved;
+}
+
+uint16_t SlabPool::inUse() const {
+	lock();
+	uint16_t inUse = _inUse;
+	unlock();
+	return inUse;
+}
+
+uint16_t SlabPool::highWater() const {
+	lock();
+	uint16_t highWater = _highWater;
+	unlock();
+	return highWater;
+}
+
+uint32_t SlabPool::failures() const {
+	lock();
+	uint32_t failures = _failures;
+	unlock();
+	return failures;
+}
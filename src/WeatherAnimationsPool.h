@@ -0,0 +1,65 @@
+#ifndef WEATHER_ANIMATIONS_POOL_H
+#define WEATHER_ANIMATIONS_POOL_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Block sizes are rounded up to this, so a free block can hold the free-list link
+#define SLAB_POOL_ALIGN sizeof(void*)
+
+namespace WeatherAnimationsLib {
+
+// Fixed-size blocks carved from one allocation.
+//
+// All blocks of a pool are reserved together, on reserve() or on the first
+// acquire(). Free blocks form a singly linked list through their own first
+// bytes, so acquire() and release() are a couple of pointer moves and the
+// general heap only ever sees the one large block. A short spinlock lets
+// tasks on both cores share a pool.
+class SlabPool {
+public:
+	SlabPool(size_t blockSize, uint16_t blockCount);
+	~SlabPool();
+
+	// Allocate the blocks now; does nothing once they are reserved
+	bool reserve();
+
+	// A free block, or nullptr if all are in use
+	void* acquire();
+
+	// Give a block back. Returns false (and does nothing) for a pointer that is not one of this pool's blocks.
+	bool release(void* block);
+
+	bool owns(const void* block) const;
+
+	size_t blockSize() const;
+	uint16_t blockCount() const;
+	bool reserved() const;
+
+	// Blocks in use now and at most so far, and acquire() calls that found none free
+	uint16_t inUse() const;
+	uint16_t highWater() const;
+	uint32_t failures() const;
+
+private:
+	SlabPool(const SlabPool&);
+	SlabPool& operator=(const SlabPool&);
+
+	void lock() const;
+	void unlock() const;
+	bool reserveLocked();
+	bool contains(const void* block) const;
+
+	uint8_t* _buffer;
+	void* _free;          // first free block; each free block starts with a pointer to the next
+	size_t _blockSize;
+	uint16_t _blockCount;
+	uint16_t _inUse;
+	uint16_t _highWater;
+	uint32_t _failures;
+	mutable std::atomic<bool> _locked;
+};
+
+}
+
+#endif // WEATHER_ANIMATIONS_POOL_H
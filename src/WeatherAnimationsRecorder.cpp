@@ -0,0 +1,386 @@
+#include "WeatherAnimationsRecorder.h"
+
+#include <stdio.h>
+
+using namespace WeatherAnimationsLib;
+
+#ifndef WA_DISABLE_RECORD
+
+// Bytes kept free for the end record, so a full buffer still ends properly
+#define RECORD_END_BYTES 6
+
+// Longest DATA record before another one is started
+#define RECORD_DATA_MAX 0xFFFF
+
+static uint8_t* buffer = nullptr;
+static size_t capacity = 0;
+static size_t length = 0;
+static std::atomic<Clock*> source(nullptr);
+static std::atomic<bool> recording(false);
+static std::atomic<bool> locked(false);   // held while a record is appended, so any task can record
+static bool overflowed = false;
+static bool ended = false;
+static uint32_t lastTime = 0;
+static uint32_t connections = 0;          // connections recorded since recordStart()
+static size_t lastData = 0;               // length field of the last record if it is DATA, else 0
+static uint32_t lastDataConnection = 0;
+static uint32_t lastDataTime = 0;
+
+static void lock() {
+	while (locked.exchange(true, std::memory_order_acquire)) {
+	}
+}
+
+static void unlock() {
+	locked.store(false, std::memory_order_release);
+}
+
+// Helper function to make room for a record; a recording that runs out of
+// room stops there
+static bool reserve(size_t bytes) {
+	if (length + bytes + RECORD_END_BYTES <= capacity) {
+		return true;
+	}
+	overflowed = true;
+	recording.store(false);
+	return false;
+}
+
+static void putByte(uint8_t value) {
+	buffer[length++] = value;
+}
+
+static void putVarint(uint32_t value) {
+	while (value >= 0x80) {
+		putByte((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	putByte((uint8_t)value);
+}
+
+// Signed values go in as zigzag varints, so -1 is one byte
+static void putSigned(int32_t value) {
+	putVarint(((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+}
+
+// Helper function to start a record at now
+static void putHeader(uint8_t type, uint32_t now) {
+	uint32_t elapsed = now - lastTime;
+	putByte(type);
+	putVarint((int32_t)elapsed > 0 ? elapsed : 0);
+	if ((int32_t)elapsed > 0) {
+		lastTime = now;
+	}
+	lastData = 0;
+}
+
+// Helper function to stop new records; returns whether recording was running
+static bool pauseRecording() {
+	bool wasRecording = recording.exchange(false);
+	lock();
+	unlock();
+	return wasRecording;
+}
+
+bool WeatherAnimationsLib::recordStart(Clock* clock, size_t bytes) {
+	if (bytes < 64) {
+		return false;
+	}
+	pauseRecording();
+	lock();
+	if (buffer == nullptr || capacity != bytes) {
+		free(buffer);
+		buffer = (uint8_t*)malloc(bytes);
+		capacity = buffer != nullptr ? bytes : 0;
+		if (buffer == nullptr) {
+			unlock();
+			return false;
+		}
+	}
+	source.store(clock != nullptr ? clock : systemClock());
+	length = 0;
+	overflowed = false;
+	ended = false;
+	connections = 0;
+	lastData = 0;
+	lastTime = source.load()->millis();
+	memcpy(buffer, RECORD_MAGIC, 4);
+	length = 4;
+	putByte(RECORD_VERSION);
+	for (uint8_t i = 0; i < 4; i++) {
+		putByte((uint8_t)(lastTime >> (8 * i)));
+	}
+	recording.store(true);
+	unlock();
+	return true;
+}
+
+void WeatherAnimationsLib::recordStop() {
+	recording.store(false);
+	lock();
+	if (buffer != nullptr && !ended) {
+		putHeader(RECORD_END, source.load()->millis());
+		ended = true;
+	}
+	unlock();
+}
+
+void WeatherAnimationsLib::recordRelease() {
+	pauseRecording();
+	lock();
+	free(buffer);
+	buffer = nullptr;
+	capacity = 0;
+	length = 0;
+	unlock();
+}
+
+bool WeatherAnimationsLib::recordActive() {
+	return recording.load(std::memory_order_relaxed);
+}
+
+const uint8_t* WeatherAnimationsLib::recordBuffer() {
+	return buffer;
+}
+
+size_t WeatherAnimationsLib::recordLength() {
+	return length;
+}
+
+bool WeatherAnimationsLib::recordOverflowed() {
+	return overflowed;
+}
+
+size_t WeatherAnimationsLib::recordWrite(Print& out) {
+	bool wasRecording = pauseRecording();
+	size_t written = length > 0 ? out.write(buffer, length) : 0;
+	if (wasRecording && !ended) {
+		recording.store(true);
+	}
+	return written;
+}
+
+#if !defined(ARDUINO_ARCH_ESP32) && !defined(ARDUINO_ARCH_ESP8266)
+bool WeatherAnimationsLib::recordWriteFile(const char* path) {
+	FILE* file = fopen(path, "wb");
+	if (file == nullptr) {
+		return false;
+	}
+	bool wasRecording = pauseRecording();
+	bool written = fwrite(buffer, 1, length, file) == length;
+	if (wasRecording && !ended) {
+		recording.store(true);
+	}
+	return fclose(file) == 0 && written;
+}
+#endif
+
+uint32_t WeatherAnimationsLib::recordMillis() {
+	Clock* clock = source.load();
+	return clock != nullptr ? clock->millis() : millis();
+}
+
+void WeatherAnimationsLib::recordBegin(uint8_t displayType, uint8_t mode, uint8_t animationMode, bool hub,
+                                       uint32_t pollInterval) {
+	if (!recording.load(std::memory_order_relaxed)) {
+		return;
+	}
+	lock();
+	// Checked again now that recordStop() has to wait for this record
+	if (recording.load() && reserve(15)) {
+		putHeader(RECORD_BEGIN, source.load()->millis());
+		putByte(displayType);
+		putByte(mode);
+		putByte(animationMode);
+		putByte(hub ? 1 : 0);
+		putVarint(pollInterval);
+	}
+	unlock();
+}
+
+uint32_t WeatherAnimationsLib::recordConnect(bool connected, uint32_t blockedMs) {
+	if (!recording.load(std::memory_order_relaxed)) {
+		return 0;
+	}
+	uint32_t connection = 0;
+	lock();
+	if (recording.load() && reserve(12)) {
+		putHeader(RECORD_CONNECT, source.load()->millis());
+		putByte(connected ? 1 : 0);
+		putVarint(blockedMs);
+		connection = connections++;
+	}
+	unlock();
+	return connection;
+}
+
+void WeatherAnimationsLib::recordReceived(uint32_t connection, const uint8_t* data, size_t size) {
+	if (!recording.load(std::memory_order_relaxed)) {
+		return;
+	}
+	lock();
+	uint32_t now = source.load()->millis();
+	while (size > 0 && recording.load()) {
+		// Bytes read in the same millisecond go into one record
+		if (lastData != 0 && lastDataConnection == connection && lastDataTime == now) {
+			size_t held = buffer[lastData] | (buffer[lastData + 1] << 8);
+			size_t count = size < RECORD_DATA_MAX - held ? size : RECORD_DATA_MAX - held;
+			if (count > 0 && reserve(count)) {
+				memcpy(buffer + length, data, count);
+				length += count;
+				held += count;
+				buffer[lastData] = (uint8_t)held;
+				buffer[lastData + 1] = (uint8_t)(held >> 8);
+				data += count;
+				size -= count;
+				continue;
+			}
+			if (count > 0) {
+				break;
+			}
+		}
+		if (!reserve(13 + (size < RECORD_DATA_MAX ? size : RECORD_DATA_MAX))) {
+			break;
+		}
+		// Connections are numbered back from the latest, so the open one is 0
+		putHeader(RECORD_DATA, now);
+		putVarint(connections - 1 - connection);
+		lastData = length;
+		lastDataConnection = connection;
+		lastDataTime = now;
+		putByte(0);
+		putByte(0);
+	}
+	unlock();
+}
+
+void WeatherAnimationsLib::recordClosed(uint32_t connection) {
+	if (!recording.load(std::memory_order_relaxed)) {
+		return;
+	}
+	lock();
+	if (recording.load() && reserve(11)) {
+		putHeader(RECORD_CLOSE, source.load()->millis());
+		putVarint(connections - 1 - connection);
+	}
+	unlock();
+}
+
+void WeatherAnimationsLib::recordFetch(uint32_t startMs, int status, long contentLength, const uint8_t* body,
+                                       size_t size) {
+	if (!recording.load(std::memory_order_relaxed)) {
+		return;
+	}
+	lock();
+	if (recording.load() && reserve(26 + size)) {
+		uint32_t now = source.load()->millis();
+		putHeader(RECORD_FETCH, now);
+		putSigned(status);
+		putVarint(now - startMs);
+		putSigned((int32_t)contentLength);
+		putVarint((uint32_t)size);
+		if (size > 0) {
+			memcpy(buffer + length, body, size);
+			length += size;
+		}
+	}
+	unlock();
+}
+
+void WeatherAnimationsLib::recordInput(const InputEvent& event, uint32_t now) {
+	if (!recording.load(std::memory_order_relaxed)) {
+		return;
+	}
+	lock();
+	if (recording.load() && reserve(14)) {
+		putHeader(RECORD_INPUT, source.load()->millis());
+		putByte(event.type);
+		putByte(event.id);
+		putByte((uint8_t)event.steps);
+		putVarint(now - event.time);
+	}
+	unlock();
+}
+
+#else
+
+bool WeatherAnimationsLib::recordStart(Clock* clock, size_t bytes) {
+	(void)clock;
+	(void)bytes;
+	return false;
+}
+
+void WeatherAnimationsLib::recordStop() {
+}
+
+void WeatherAnimationsLib::recordRelease() {
+}
+
+const uint8_t* WeatherAnimationsLib::recordBuffer() {
+	return nullptr;
+}
+
+size_t WeatherAnimationsLib::recordLength() {
+	return 0;
+}
+
+bool WeatherAnimationsLib::recordOverflowed() {
+	return false;
+}
+
+size_t WeatherAnimationsLib::recordWrite(Print& out) {
+	(void)out;
+	return 0;
+}
+
+#if !defined(ARDUINO_ARCH_ESP32) && !defined(ARDUINO_ARCH_ESP8266)
+bool WeatherAnimationsLib::recordWriteFile(const char* path) {
+	(void)path;
+	return false;
+}
+#endif
+
+uint32_t WeatherAnimationsLib::recordMillis() {
+	return 0;
+}
+
+void WeatherAnimationsLib::recordBegin(uint8_t displayType, uint8_t mode, uint8_t animationMode, bool hub,
+                                       uint32_t pollInterval) {
+	(void)displayType;
+	(void)mode;
+	(void)animationMode;
+	(void)hub;
+	(void)pollInterval;
+}
+
+uint32_t WeatherAnimationsLib::recordConnect(bool connected, uint32_t blockedMs) {
+	(void)connected;
+	(void)blockedMs;
+	return 0;
+}
+
+void WeatherAnimationsLib::recordReceived(uint32_t connection, const uint8_t* data, size_t size) {
+	(void)connection;
+	(void)data;
+	(void)size;
+}
+
+void WeatherAnimationsLib::recordClosed(uint32_t connection) {
+	(void)connection;
+}
+
+void WeatherAnimationsLib::recordFetch(uint32_t startMs, int status, long contentLength, const uint8_t* body,
+                                       size_t size) {
+	(void)startMs;
+	(void)status;
+	(void)contentLength;
+	(void)body;
+	(void)size;
+}
+
+void WeatherAnimationsLib::recordInput(const InputEvent& event, uint32_t now) {
+	(void)event;
+	(void)now;
+}
+
+#endif
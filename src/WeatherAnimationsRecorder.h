@@ -0,0 +1,98 @@
+#ifndef WEATHER_ANIMATIONS_RECORDER_H
+#define WEATHER_ANIMATIONS_RECORDER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "WeatherAnimationsClock.h"
+#include "WeatherAnimationsInput.h"
+
+// Bytes the recording buffer holds when recordStart() is given no size
+#ifndef RECORD_DEFAULT_BYTES
+#define RECORD_DEFAULT_BYTES 32768
+#endif
+
+// Start of every recording: "WARC", then the format version
+#define RECORD_MAGIC "WARC"
+#define RECORD_VERSION 1
+
+// Record types. Each record is the type byte, the milliseconds since the
+// previous record (varint), then its fields.
+#define RECORD_BEGIN 1    // display type, mode, animation mode, hub (bytes), poll interval (varint)
+#define RECORD_CONNECT 2  // Home Assistant connection: connected (byte), ms connect() blocked (varint)
+#define RECORD_DATA 3     // bytes read from a connection: connection (varint), length (16 bits), bytes
+#define RECORD_CLOSE 4    // the server closed a connection: connection (varint)
+#define RECORD_FETCH 5    // HTTPClient download: status, ms it blocked, Content-Length, body length (varints), body
+#define RECORD_INPUT 6    // input event: type, id, steps (bytes), ms since its edge (varint)
+#define RECORD_END 7      // recordStop()
+
+namespace WeatherAnimationsLib {
+
+// Session recording.
+//
+// While a recording runs, what the library receives from outside is
+// appended to one buffer: the bytes of every Home Assistant response as
+// they are read, connections opened and closed by the server, each
+// animation or icon download, and the input events handed to the sketch,
+// each with the milliseconds since the one before. That is everything a
+// session depends on, so the host build replays it (host/SessionReplay.h)
+// on a VirtualClock with the same timing and compares the frames it draws
+// between versions of the library.
+//
+// Records are a few bytes plus the data itself; a poll of the three
+// entities takes about 800 bytes. Once the buffer is full, recording stops
+// and the recording ends there. A stopped recording costs one relaxed
+// atomic load per hook. Define WA_DISABLE_RECORD to compile recording out.
+
+// Allocate the buffer (once) and start recording, timed by clock (nullptr
+// for the board's millis()). Returns false if there is no memory for it.
+bool recordStart(Clock* clock = nullptr, size_t bytes = RECORD_DEFAULT_BYTES);
+
+// Stop recording and keep the recording for writing
+void recordStop();
+
+// Stop recording and free the buffer
+void recordRelease();
+
+#ifndef WA_DISABLE_RECORD
+bool recordActive();
+#else
+inline bool recordActive() {
+	return false;
+}
+#endif
+
+// The recording so far, and whether it stopped early because the buffer was full
+const uint8_t* recordBuffer();
+size_t recordLength();
+bool recordOverflowed();
+
+// Write the recording, e.g. to an SD card file or a network client.
+// Recording pauses while it is written.
+size_t recordWrite(Print& out);
+
+#if !defined(ARDUINO_ARCH_ESP32) && !defined(ARDUINO_ARCH_ESP8266)
+// Host builds: write the recording to a file
+bool recordWriteFile(const char* path);
+#endif
+
+// Hooks called by the library
+
+// Time on the recording's clock
+uint32_t recordMillis();
+
+void recordBegin(uint8_t displayType, uint8_t mode, uint8_t animationMode, bool hub, uint32_t pollInterval);
+
+// Returns the connection's number, for recordReceived() and recordClosed()
+uint32_t recordConnect(bool connected, uint32_t blockedMs);
+void recordReceived(uint32_t connection, const uint8_t* data, size_t size);
+void recordClosed(uint32_t connection);
+
+// A download that started at startMs (a recordMillis() value); contentLength
+// is -1 if the server sent none, body what was read of it
+void recordFetch(uint32_t startMs, int status, long contentLength, const uint8_t* body, size_t size);
+
+void recordInput(const InputEvent& event, uint32_t now);
+
+}
+
+#endif // WEATHER_ANIMATIONS_RECORDER_H
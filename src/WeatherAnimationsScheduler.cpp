@@ -0,0 +1,158 @@
+#include "WeatherAnimationsScheduler.h"
+#include "WeatherAnimationsTrace.h"
+
+using namespace WeatherAnimationsLib;
+
+// Helper function to compare millis() values across the 49-day wrap
+static bool reached(uint32_t now, uint32_t deadline) {
+	return (int32_t)(now - deadline) >= 0;
+}
+
+TickScheduler::TickScheduler()
+	: _taskCount(0), _now(0), _started(false), _budget(TICK_DEFAULT_BUDGET_US), _overruns(0), _longestStep(0),
+	  _longestStepName(nullptr), _stepCount(0), _isrWakes(0) {
+}
+
+int8_t TickScheduler::addTask(const char* name, TickTask task, void* context, uint32_t firstDelay) {
+	if (task == nullptr || _taskCount >= TICK_MAX_TASKS) {
+		return -1;
+	}
+	Task& slot = _tasks[_taskCount];
+	slot.name = name;
+	slot.run = task;
+	slot.context = context;
+	slot.nextRun = _now + firstDelay;
+	slot.lastStep = 0;
+	slot.idle = false;
+	return _taskCount++;
+}
+
+void TickScheduler::wake(int8_t id) {
+	if (id < 0 || id >= _taskCount) {
+		return;
+	}
+	_tasks[id].idle = false;
+	_tasks[id].nextRun = _now;
+}
+
+void IRAM_ATTR TickScheduler::wakeFromISR(int8_t id) {
+	if (id >= 0 && id < TICK_MAX_TASKS) {
+		_isrWakes.fetch_or(1UL << id, std::memory_order_release);
+	}
+}
+
+// Helper function to pick the due task with the oldest deadline.
+// Ties go to the task that ran least recently.
+int8_t TickScheduler::nextDue(uint32_t now) const {
+	int8_t best = -1;
+	for (uint8_t i = 0; i < _taskCount; i++) {
+		const Task& task = _tasks[i];
+		if (task.idle || !reached(now, task.nextRun)) {
+			continue;
+		}
+		if (best < 0) {
+			best = i;
+			continue;
+		}
+		const Task& current = _tasks[best];
+		if (task.nextRun != current.nextRun ? reached(current.nextRun, task.nextRun + 1)
+		                                    : task.lastStep < current.lastStep) {
+			best = i;
+		}
+	}
+	return best;
+}
+
+uint32_t TickScheduler::tick(uint32_t now) {
+	uint32_t start = micros();
+	uint32_t elapsed = 0;
+	if (!_started) {
+		// Tasks added or woken before the first tick() were timed from 0,
+		// which is in the past only during the first half of the millis() range
+		for (uint8_t i = 0; i < _taskCount; i++) {
+			_tasks[i].nextRun += now;
+		}
+		_started = true;
+	}
+	_now = now;
+
+	// Tasks woken by interrupts since the last tick
+	uint32_t woken = _isrWakes.exchange(0, std::memory_order_acquire);
+	for (uint8_t i = 0; woken != 0 && i < _taskCount; i++) {
+		if (woken & (1UL << i)) {
+			wake(i);
+		}
+	}
+
+	uint32_t steps = 0;
+	while (elapsed < _budget || (_budget == 0 && steps == 0)) {
+		int8_t id = nextDue(now);
+		if (id < 0) {
+			break;
+		}
+
+		Task& task = _tasks[id];
+		uint32_t late = now - task.nextRun; // how far past its deadline the step starts, in ms
+		uint32_t stepStart = micros();
+		uint32_t delayMs = task.run(task.context, now);
+		uint32_t stepTime = micros() - stepStart;
+		task.lastStep = ++_stepCount;
+		steps++;
+		if (traceActive()) {
+			traceComplete(task.name, stepStart, stepTime, "late_ms", late);
+		}
+		if (stepTime > _longestStep) {
+			_longestStep = stepTime;
+			_longestStepName = task.name;
+		}
+
+		if (delayMs == TICK_IDLE) {
+			task.idle = true;
+		} else {
+			task.nextRun = now + delayMs;
+		}
+		elapsed = micros() - start;
+	}
+
+	if (elapsed > _budget && _budget != 0) {
+		_overruns++;
+		traceInstant("overrun", "us", elapsed);
+	}
+
+	// Next wakeup is the earliest deadline of any task that is not idle
+	uint32_t wakeup = now + TICK_MAX_SLEEP;
+	for (uint8_t i = 0; i < _taskCount; i++) {
+		if (!_tasks[i].idle && reached(wakeup, _tasks[i].nextRun)) {
+			wakeup = reached(now, _tasks[i].nextRun) ? now : _tasks[i].nextRun;
+		}
+	}
+	return wakeup;
+}
+
+void TickScheduler::setBudget(uint32_t budgetMicros) {
+	_budget = budgetMicros;
+}
+
+uint32_t TickScheduler::budget() const {
+	return _budget;
+}
+
+uint32_t TickScheduler::overruns() const {
+	return _overruns;
+}
+
+uint32_t TickScheduler::longestStep() const {
+	return _longestStep;
+}
+
+const char* TickScheduler::longestStepName() const {
+	return _longestStepName;
+}
+
+uint32_t TickScheduler::stepCount() const {
+	return _stepCount;
+}
+
+uint8_t TickScheduler::taskCount() const {
+	return _taskCount;
+}
@@ -0,0 +1,88 @@
+#ifndef WEATHER_ANIMATIONS_SCHEDULER_H
+#define WEATHER_ANIMATIONS_SCHEDULER_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Most tasks one scheduler can run
+#define TICK_MAX_TASKS 8
+
+// Default time one tick() may spend running tasks, in microseconds
+#define TICK_DEFAULT_BUDGET_US 4000UL
+
+// Longest sleep tick() reports when every task is idle, in milliseconds
+#define TICK_MAX_SLEEP 1000UL
+
+// Returned by a task that has nothing to do until it is woken
+#define TICK_IDLE 0xFFFFFFFFUL
+
+namespace WeatherAnimationsLib {
+
+// One step of a task. It should do a small, bounded piece of work and
+// return how many milliseconds to wait before the next step: 0 to run
+// again as soon as there is budget, TICK_IDLE to sleep until wake().
+typedef uint32_t (*TickTask)(void* context, uint32_t now);
+
+// Cooperative scheduler for the library's background work.
+//
+// tick() runs due tasks one step at a time, oldest deadline first, until
+// nothing is due or the budget is used up, and returns the time at which
+// it next needs to be called. Steps are never interrupted, so the budget
+// holds as long as each step stays small; steps that ran over are counted.
+class TickScheduler {
+public:
+	TickScheduler();
+
+	// Add a task and return its id, or -1 if the table is full.
+	// firstDelay counts from the most recent tick(), or from the first one.
+	int8_t addTask(const char* name, TickTask task, void* context, uint32_t firstDelay = 0);
+
+	// Run the task on the next tick, whatever it asked for last time
+	void wake(int8_t id);
+
+	// Same as wake(), but safe to call from an interrupt or another task
+	void IRAM_ATTR wakeFromISR(int8_t id);
+
+	// Run due tasks. Returns the millis() value of the next wakeup.
+	uint32_t tick(uint32_t now);
+
+	// Microseconds one tick() may spend running steps. 0 runs exactly one
+	// step per tick(), so what runs does not depend on the machine's speed
+	// (replays of a recording).
+	void setBudget(uint32_t budgetMicros);
+	uint32_t budget() const;
+
+	// Statistics
+	uint32_t overruns() const;        // ticks that ran past the budget
+	uint32_t longestStep() const;     // longest single step, in microseconds
+	const char* longestStepName() const;
+	uint32_t stepCount() const;
+	uint8_t taskCount() const;
+
+private:
+	struct Task {
+		const char* name;
+		TickTask run;
+		void* context;
+		uint32_t nextRun;
+		uint32_t lastStep;   // _stepCount when the task last ran, for round-robin
+		bool idle;
+	};
+
+	int8_t nextDue(uint32_t now) const;
+
+	Task _tasks[TICK_MAX_TASKS];
+	uint8_t _taskCount;
+	uint32_t _now;
+	bool _started;       // tick() has run, so _now is a real time
+	uint32_t _budget;
+	uint32_t _overruns;
+	uint32_t _longestStep;
+	const char* _longestStepName;
+	uint32_t _stepCount;
+	std::atomic<uint32_t> _isrWakes; // bit per task, set by wakeFromISR()
+};
+
+}
+
+#endif // WEATHER_ANIMATIONS_SCHEDULER_H
@@ -0,0 +1,279 @@
+#include "WeatherAnimationsText.h"
+
+using namespace WeatherAnimationsLib;
+
+TextCache::TextCache(uint8_t maxEntries, size_t maxBytes)
+	: _entries(nullptr), _maxEntries(maxEntries), _entryCount(0), _maxBytes(maxBytes), _bytesUsed(0),
+	  _useCounter(0), _hits(0), _misses(0), _evictions(0) {
+	_entries = (Entry*)malloc(sizeof(Entry) * _maxEntries);
+	if (_entries == nullptr) {
+		_maxEntries = 0;
+	}
+}
+
+TextCache::~TextCache() {
+	clear();
+	if (_entries != nullptr) {
+		free(_entries);
+	}
+}
+
+void TextCache::clear() {
+	for (uint8_t i = 0; i < _entryCount; i++) {
+		release(_entries[i]);
+	}
+	_entryCount = 0;
+	_bytesUsed = 0;
+}
+
+uint32_t TextCache::hits() const {
+	return _hits;
+}
+
+uint32_t TextCache::misses() const {
+	return _misses;
+}
+
+uint32_t TextCache::evictions() const {
+	return _evictions;
+}
+
+size_t TextCache::bytesUsed() const {
+	return _bytesUsed;
+}
+
+uint8_t TextCache::entryCount() const {
+	return _entryCount;
+}
+
+int16_t TextCache::draw(OLEDCanvas* canvas, int16_t x, int16_t y, const char* text, uint8_t size,
+                        uint16_t color, const GFXfont* font) {
+	if (canvas == nullptr || text == nullptr) {
+		return 0;
+	}
+
+	Entry* entry = lookup(text, size, font, TEXT_FORMAT_MONO, 0, 0);
+	if (entry == nullptr) {
+		entry = render(text, size, font, TEXT_FORMAT_MONO, 0, 0);
+	}
+
+	// Not cacheable, draw it the slow way
+	if (entry == nullptr) {
+		canvas->setFont(font);
+		canvas->setTextSize(size);
+		canvas->setTextColor(color);
+		canvas->setTextWrap(false);
+		canvas->setCursor(x, y);
+		canvas->print(text);
+		return canvas->getCursorX() - x;
+	}
+
+	blitMono(canvas, *entry, x + entry->offsetX, y + entry->offsetY, color);
+	return entry->advance;
+}
+
+#if defined(ESP32) || defined(ESP8266)
+int16_t TextCache::draw(TFT_eSPI* tft, int16_t x, int16_t y, const char* text, uint8_t size,
+                        uint16_t fgColor, uint16_t bgColor, const GFXfont* font) {
+	if (tft == nullptr || text == nullptr) {
+		return 0;
+	}
+
+	Entry* entry = lookup(text, size, font, TEXT_FORMAT_RGB565, fgColor, bgColor);
+	if (entry == nullptr) {
+		entry = render(text, size, font, TEXT_FORMAT_RGB565, fgColor, bgColor);
+	}
+
+	if (entry == nullptr) {
+		tft->setTextSize(size);
+		tft->setTextColor(fgColor, bgColor);
+		tft->setCursor(x, y);
+		tft->print(text);
+		return tft->getCursorX() - x;
+	}
+
+	if (entry->bitmap != nullptr) {
+		// Bitmaps hold native-endian colours, so let the driver swap them
+		bool swapBytes = tft->getSwapBytes();
+		tft->setSwapBytes(true);
+		tft->pushImage(x + entry->offsetX, y + entry->offsetY, entry->width, entry->height, (const uint16_t*)entry->bitmap);
+		tft->setSwapBytes(swapBytes);
+	}
+	return entry->advance;
+}
+#endif
+
+TextCache::Entry* TextCache::lookup(const char* text, uint8_t size, const GFXfont* font, uint8_t format,
+                                    uint16_t fgColor, uint16_t bgColor) {
+	for (uint8_t i = 0; i < _entryCount; i++) {
+		Entry& entry = _entries[i];
+		if (entry.font == font && entry.size == size && entry.format == format &&
+		    entry.fgColor == fgColor && entry.bgColor == bgColor && strcmp(entry.text, text) == 0) {
+			entry.lastUsed = ++_useCounter;
+			_hits++;
+			return &entry;
+		}
+	}
+	return nullptr;
+}
+
+TextCache::Entry* TextCache::render(const char* text, uint8_t size, const GFXfont* font, uint8_t format,
+                                    uint16_t fgColor, uint16_t bgColor) {
+	if (_maxEntries == 0 || strlen(text) > TEXT_CACHE_MAX_LENGTH) {
+		return nullptr;
+	}
+	_misses++;
+
+	// Measure the text as if the cursor were at the origin
+	OLEDCanvas measure(8, 8);
+	measure.setFont(font);
+	measure.setTextSize(size);
+	measure.setTextWrap(false);
+	int16_t boundsX, boundsY;
+	uint16_t width, height;
+	measure.getTextBounds(text, 0, 0, &boundsX, &boundsY, &width, &height);
+	measure.setCursor(0, 0);
+	measure.print(text);
+	int16_t advance = measure.getCursorX();
+
+	size_t bytes = 0;
+	if (width > 0 && height > 0) {
+		bytes = (format == TEXT_FORMAT_MONO) ? width * ((height + 7) / 8) : width * height * 2;
+	}
+	if (bytes > _maxBytes) {
+		return nullptr;
+	}
+
+	// Rasterise once into a cropped page-format bitmap
+	uint8_t* bitmap = nullptr;
+	if (bytes > 0) {
+		OLEDCanvas raster(width, height);
+		bitmap = (uint8_t*)malloc(bytes);
+		if (!raster.valid() || bitmap == nullptr) {
+			free(bitmap);
+			return nullptr;
+		}
+		raster.setFont(font);
+		raster.setTextSize(size);
+		raster.setTextWrap(false);
+		raster.setTextColor(SSD1306_WHITE);
+		raster.setCursor(-boundsX, -boundsY);
+		raster.print(text);
+
+		if (format == TEXT_FORMAT_MONO) {
+			memcpy(bitmap, raster.getBuffer(), bytes);
+		} else {
+			uint16_t* pixels = (uint16_t*)bitmap;
+			for (uint16_t row = 0; row < height; row++) {
+				for (uint16_t column = 0; column < width; column++) {
+					*pixels++ = raster.getPixel(column, row) ? fgColor : bgColor;
+				}
+			}
+		}
+	}
+
+	makeRoom(bytes);
+
+	Entry& entry = _entries[_entryCount++];
+	entry.font = font;
+	entry.size = size;
+	entry.format = format;
+	entry.fgColor = fgColor;
+	entry.bgColor = bgColor;
+	strcpy(entry.text, text);
+	entry.offsetX = boundsX;
+	entry.offsetY = boundsY;
+	entry.advance = advance;
+	entry.width = width;
+	entry.height = height;
+	entry.bitmap = bitmap;
+	entry.bytes = bytes;
+	entry.lastUsed = ++_useCounter;
+	_bytesUsed += bytes;
+	return &entry;
+}
+
+void TextCache::release(Entry& entry) {
+	if (entry.bitmap != nullptr) {
+		free(entry.bitmap);
+		entry.bitmap = nullptr;
+	}
+	_bytesUsed -= entry.bytes;
+	entry.bytes = 0;
+}
+
+// Helper function to evict least recently used entries until a new one fits
+void TextCache::makeRoom(size_t bytes) {
+	while (_entryCount > 0 && (_entryCount >= _maxEntries || _bytesUsed + bytes > _maxBytes)) {
+		uint8_t oldest = 0;
+		for (uint8_t i = 1; i < _entryCount; i++) {
+			if (_entries[i].lastUsed < _entries[oldest].lastUsed) {
+				oldest = i;
+			}
+		}
+		release(_entries[oldest]);
+		_entries[oldest] = _entries[--_entryCount];
+		_evictions++;
+	}
+}
+
+// Helper function to set, clear or toggle bits of one page byte
+static inline void applyBits(uint8_t* target, uint8_t bits, uint16_t color) {
+	switch (color) {
+		case SSD1306_WHITE:   *target |= bits; break;
+		case SSD1306_BLACK:   *target &= ~bits; break;
+		case SSD1306_INVERSE: *target ^= bits; break;
+	}
+}
+
+// Helper function to copy a page-format bitmap into the canvas at any pixel row
+void TextCache::blitMono(OLEDCanvas* canvas, const Entry& entry, int16_t x, int16_t y, uint16_t color) {
+	if (entry.bitmap == nullptr) {
+		return;
+	}
+
+	// Rotated canvases go through drawPixel so the GFX rotation is honoured
+	if (canvas->getRotation() != 0) {
+		for (uint16_t row = 0; row < entry.height; row++) {
+			for (uint16_t column = 0; column < entry.width; column++) {
+				if ((entry.bitmap[(row / 8) * entry.width + column] >> (row & 7)) & 1) {
+					canvas->drawPixel(x + column, y + row, color);
+				}
+			}
+		}
+		return;
+	}
+
+	uint8_t* buffer = canvas->getBuffer();
+	int16_t bufferWidth = canvas->bufferWidth();
+	int16_t bufferPages = (canvas->bufferHeight() + 7) / 8;
+	uint8_t shift = y & 7;
+	int16_t firstPage = (y - shift) / 8;
+	uint16_t sourcePages = (entry.height + 7) / 8;
+
+	for (uint16_t sourcePage = 0; sourcePage < sourcePages; sourcePage++) {
+		// Each source byte lands across at most two destination pages
+		int16_t page = firstPage + sourcePage;
+		bool lowVisible = page >= 0 && page < bufferPages;
+		bool highVisible = shift != 0 && page + 1 >= 0 && page + 1 < bufferPages;
+		if (!lowVisible && !highVisible) {
+			continue;
+		}
+
+		const uint8_t* source = entry.bitmap + sourcePage * entry.width;
+		for (uint16_t column = 0; column < entry.width; column++) {
+			int16_t dx = x + column;
+			if (dx < 0 || dx >= bufferWidth || source[column] == 0) {
+				continue;
+			}
+			uint16_t bits = (uint16_t)source[column] << shift;
+			uint8_t* target = buffer + page * bufferWidth + dx;
+			if (lowVisible) {
+				applyBits(target, (uint8_t)bits, color);
+			}
+			if (highVisible) {
+				applyBits(target + bufferWidth, (uint8_t)(bits >> 8), color);
+			}
+		}
+	}
+}
@@ -0,0 +1,96 @@
+#ifndef WEATHER_ANIMATIONS_TEXT_H
+#define WEATHER_ANIMATIONS_TEXT_H
+
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+#include "WeatherAnimationsCanvas.h"
+
+#if defined(ESP32) || defined(ESP8266)
+#include <TFT_eSPI.h>
+#endif
+
+// Default cache limits
+#define TEXT_CACHE_DEFAULT_ENTRIES 16
+#define TEXT_CACHE_DEFAULT_BYTES 8192
+
+// Longest string that is cached; longer strings are drawn directly
+#define TEXT_CACHE_MAX_LENGTH 39
+
+// Storage format of a cached bitmap
+#define TEXT_FORMAT_MONO 0    // 1bpp, SSD1306 page format
+#define TEXT_FORMAT_RGB565 1  // 16bpp with the colours baked in
+
+namespace WeatherAnimationsLib {
+
+// Cache of rendered text.
+//
+// The first time a (font, size, string) combination is drawn it is
+// rasterised once through Adafruit GFX into a bitmap cropped to the text
+// bounds; later draws are a bitmap copy. Entries are evicted least recently
+// used first when either the entry or byte limit is reached.
+//
+// draw() positions text exactly like setCursor(x, y) followed by print(text)
+// and returns the horizontal advance. Strings must be a single line.
+class TextCache {
+public:
+	TextCache(uint8_t maxEntries = TEXT_CACHE_DEFAULT_ENTRIES, size_t maxBytes = TEXT_CACHE_DEFAULT_BYTES);
+	~TextCache();
+
+	// Draw onto a page-format canvas (color is SSD1306_WHITE, SSD1306_BLACK or SSD1306_INVERSE)
+	int16_t draw(OLEDCanvas* canvas, int16_t x, int16_t y, const char* text, uint8_t size,
+	             uint16_t color = SSD1306_WHITE, const GFXfont* font = nullptr);
+
+#if defined(ESP32) || defined(ESP8266)
+	// Draw onto a TFT with an opaque background
+	int16_t draw(TFT_eSPI* tft, int16_t x, int16_t y, const char* text, uint8_t size,
+	             uint16_t fgColor, uint16_t bgColor, const GFXfont* font = nullptr);
+#endif
+
+	// Drop every cached bitmap
+	void clear();
+
+	// Statistics
+	uint32_t hits() const;
+	uint32_t misses() const;
+	uint32_t evictions() const;
+	size_t bytesUsed() const;
+	uint8_t entryCount() const;
+
+private:
+	struct Entry {
+		const GFXfont* font;
+		uint8_t size;
+		uint8_t format;
+		uint16_t fgColor;
+		uint16_t bgColor;
+		char text[TEXT_CACHE_MAX_LENGTH + 1];
+		int16_t offsetX;      // Bitmap position relative to the cursor
+		int16_t offsetY;
+		int16_t advance;      // Cursor movement after the text
+		uint16_t width;
+		uint16_t height;
+		uint8_t* bitmap;
+		size_t bytes;
+		uint32_t lastUsed;
+	};
+
+	Entry* lookup(const char* text, uint8_t size, const GFXfont* font, uint8_t format, uint16_t fgColor, uint16_t bgColor);
+	Entry* render(const char* text, uint8_t size, const GFXfont* font, uint8_t format, uint16_t fgColor, uint16_t bgColor);
+	void release(Entry& entry);
+	void makeRoom(size_t bytes);
+	void blitMono(OLEDCanvas* canvas, const Entry& entry, int16_t x, int16_t y, uint16_t color);
+
+	Entry* _entries;
+	uint8_t _maxEntries;
+	uint8_t _entryCount;
+	size_t _maxBytes;
+	size_t _bytesUsed;
+	uint32_t _useCounter;
+	uint32_t _hits;
+	uint32_t _misses;
+	uint32_t _evictions;
+};
+
+}
+
+#endif // WEATHER_ANIMATIONS_TEXT_H
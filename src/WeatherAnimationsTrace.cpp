@@ -0,0 +1,247 @@
+#include "WeatherAnimationsTrace.h"
+
+#include <stdio.h>
+
+using namespace WeatherAnimationsLib;
+
+#ifndef WA_DISABLE_TRACE
+
+static TraceEvent* ring = nullptr;
+static uint16_t ringCapacity = 0;
+static std::atomic<uint32_t> recorded(0);  // events ever claimed since traceStart()
+static std::atomic<bool> recording(false);
+static std::atomic<uint32_t> writers(0);   // records in progress, so the ring can be read or freed safely
+
+// Helper function to tell the cores (or host threads) apart
+static uint8_t currentTrack() {
+#if defined(ARDUINO_ARCH_ESP32)
+	return xPortGetCoreID();
+#elif defined(ARDUINO_ARCH_ESP8266)
+	return 0;
+#else
+	static std::atomic<uint8_t> nextTrack(0);
+	static thread_local uint8_t track = nextTrack.fetch_add(1, std::memory_order_relaxed);
+	return track;
+#endif
+}
+
+// Helper function to stop new records and wait for those already writing
+static bool pauseRecording() {
+	bool wasRecording = recording.exchange(false);
+	while (writers.load() != 0) {
+	}
+	return wasRecording;
+}
+
+// Helper function to claim the next slot and fill it
+static void record(uint8_t phase, const char* name, uint32_t startMicros, uint32_t durationMicros,
+                   const char* argName, uint32_t arg) {
+	writers.fetch_add(1);
+	// Checked again now that traceStop() has to wait for this record
+	if (recording.load()) {
+		uint32_t index = recorded.fetch_add(1, std::memory_order_relaxed);
+		TraceEvent& event = ring[index % ringCapacity];
+		event.startMicros = startMicros;
+		event.durationMicros = durationMicros;
+		event.name = name;
+		event.argName = argName;
+		event.arg = arg;
+		event.phase = phase;
+		event.track = currentTrack();
+	}
+	writers.fetch_sub(1);
+}
+
+bool WeatherAnimationsLib::traceStart(uint16_t eventCount) {
+	if (eventCount == 0) {
+		return false;
+	}
+	pauseRecording();
+	if (ring == nullptr || ringCapacity != eventCount) {
+		free(ring);
+		ring = (TraceEvent*)malloc(sizeof(TraceEvent) * eventCount);
+		ringCapacity = ring != nullptr ? eventCount : 0;
+		if (ring == nullptr) {
+			return false;
+		}
+	}
+	recorded.store(0);
+	recording.store(true);
+	return true;
+}
+
+void WeatherAnimationsLib::traceStop() {
+	pauseRecording();
+}
+
+void WeatherAnimationsLib::traceRelease() {
+	pauseRecording();
+	free(ring);
+	ring = nullptr;
+	ringCapacity = 0;
+	recorded.store(0);
+}
+
+bool WeatherAnimationsLib::traceActive() {
+	return recording.load(std::memory_order_relaxed);
+}
+
+uint32_t WeatherAnimationsLib::traceEventCount() {
+	uint32_t count = recorded.load();
+	return count < ringCapacity ? count : ringCapacity;
+}
+
+uint32_t WeatherAnimationsLib::traceDropped() {
+	return recorded.load() - traceEventCount();
+}
+
+void WeatherAnimationsLib::traceComplete(const char* name, uint32_t startMicros, uint32_t durationMicros,
+                                         const char* argName, uint32_t arg) {
+	if (recording.load(std::memory_order_relaxed)) {
+		record(TRACE_PHASE_COMPLETE, name, startMicros, durationMicros, argName, arg);
+	}
+}
+
+void WeatherAnimationsLib::traceInstant(const char* name, const char* argName, uint32_t arg) {
+	if (recording.load(std::memory_order_relaxed)) {
+		record(TRACE_PHASE_INSTANT, name, micros(), 0, argName, arg);
+	}
+}
+
+void WeatherAnimationsLib::traceExportJSON(Print& out) {
+	bool wasRecording = pauseRecording();
+	uint32_t total = recorded.load();
+	uint32_t count = traceEventCount();
+	uint32_t first = total - count;
+
+	// Timestamps are written relative to the oldest event, which also
+	// hides a micros() wrap in the middle of the capture
+	uint32_t base = count > 0 ? ring[first % ringCapacity].startMicros : 0;
+	for (uint32_t i = first; i < total; i++) {
+		uint32_t start = ring[i % ringCapacity].startMicros;
+		if ((int32_t)(start - base) < 0) {
+			base = start;
+		}
+	}
+
+	out.print("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	char line[200];
+	bool tracks[256] = {false};
+	bool firstLine = true;
+	for (uint32_t i = first; i < total; i++) {
+		const TraceEvent& event = ring[i % ringCapacity];
+		int length = snprintf(line, sizeof(line), "%s\n{\"name\":\"%s\",\"cat\":\"wa\",\"ph\":\"%c\",\"ts\":%lu,",
+		                      firstLine ? "" : ",", event.name, event.phase,
+		                      (unsigned long)(event.startMicros - base));
+		if (event.phase == TRACE_PHASE_COMPLETE) {
+			length += snprintf(line + length, sizeof(line) - length, "\"dur\":%lu,", (unsigned long)event.durationMicros);
+		} else {
+			length += snprintf(line + length, sizeof(line) - length, "\"s\":\"t\",");
+		}
+		length += snprintf(line + length, sizeof(line) - length, "\"pid\":1,\"tid\":%u", event.track);
+		if (event.argName != nullptr) {
+			snprintf(line + length, sizeof(line) - length, ",\"args\":{\"%s\":%lu}}", event.argName,
+			         (unsigned long)event.arg);
+		} else {
+			snprintf(line + length, sizeof(line) - length, "}");
+		}
+		out.print(line);
+		tracks[event.track] = true;
+		firstLine = false;
+	}
+
+	// Name the tracks after the cores (or threads) that recorded them
+	for (uint16_t track = 0; track < 256; track++) {
+		if (!tracks[track]) {
+			continue;
+		}
+#if defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_ESP8266)
+		const char* kind = "core";
+#else
+		const char* kind = "thread";
+#endif
+		snprintf(line, sizeof(line), "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}",
+		         firstLine ? "" : ",", track, kind, track);
+		out.print(line);
+		firstLine = false;
+	}
+	snprintf(line, sizeof(line), "\n],\"otherData\":{\"dropped\":%lu}}\n", (unsigned long)(total - count));
+	out.print(line);
+
+	if (wasRecording) {
+		recording.store(true);
+	}
+}
+
+#if !defined(ARDUINO_ARCH_ESP32) && !defined(ARDUINO_ARCH_ESP8266)
+// Print that writes to a stdio file
+class FilePrint : public Print {
+public:
+	explicit FilePrint(FILE* file) : _file(file) {}
+	size_t write(uint8_t c) override { return fputc(c, _file) == EOF ? 0 : 1; }
+	size_t write(const uint8_t* buffer, size_t size) override { return fwrite(buffer, 1, size, _file); }
+	using Print::write;
+
+private:
+	FILE* _file;
+};
+
+bool WeatherAnimationsLib::traceWriteFile(const char* path) {
+	FILE* file = fopen(path, "w");
+	if (file == nullptr) {
+		return false;
+	}
+	FilePrint out(file);
+	traceExportJSON(out);
+	return fclose(file) == 0;
+}
+#endif
+
+#else
+
+bool WeatherAnimationsLib::traceStart(uint16_t eventCount) {
+	(void)eventCount;
+	return false;
+}
+
+void WeatherAnimationsLib::traceStop() {
+}
+
+void WeatherAnimationsLib::traceRelease() {
+}
+
+uint32_t WeatherAnimationsLib::traceEventCount() {
+	return 0;
+}
+
+uint32_t WeatherAnimationsLib::traceDropped() {
+	return 0;
+}
+
+void WeatherAnimationsLib::traceComplete(const char* name, uint32_t startMicros, uint32_t durationMicros,
+                                         const char* argName, uint32_t arg) {
+	(void)name;
+	(void)startMicros;
+	(void)durationMicros;
+	(void)argName;
+	(void)arg;
+}
+
+void WeatherAnimationsLib::traceInstant(const char* name, const char* argName, uint32_t arg) {
+	(void)name;
+	(void)argName;
+	(void)arg;
+}
+
+void WeatherAnimationsLib::traceExportJSON(Print& out) {
+	out.println("{\"traceEvents\":[]}");
+}
+
+#if !defined(ARDUINO_ARCH_ESP32) && !defined(ARDUINO_ARCH_ESP8266)
+bool WeatherAnimationsLib::traceWriteFile(const char* path) {
+	(void)path;
+	return false;
+}
+#endif
+
+#endif
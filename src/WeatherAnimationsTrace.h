@@ -0,0 +1,78 @@
+#ifndef WEATHER_ANIMATIONS_TRACE_H
+#define WEATHER_ANIMATIONS_TRACE_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Events the trace ring holds when traceStart() is given no size
+// (24 bytes each on the boards)
+#ifndef TRACE_DEFAULT_EVENTS
+#define TRACE_DEFAULT_EVENTS 2048
+#endif
+
+#define TRACE_PHASE_COMPLETE 'X' // span with a start and a duration
+#define TRACE_PHASE_INSTANT 'i'  // single point in time
+
+namespace WeatherAnimationsLib {
+
+// One entry of the trace ring. Names point at string literals, so an event
+// is a fixed 24 bytes on the boards no matter what it describes.
+struct TraceEvent {
+	uint32_t startMicros;
+	uint32_t durationMicros;
+	const char* name;
+	const char* argName;     // nullptr if the event has no argument
+	uint32_t arg;
+	uint8_t phase;           // TRACE_PHASE_*
+	uint8_t track;           // core (boards) or thread (host) that recorded it
+};
+
+// Timeline tracing.
+//
+// While a trace runs, the perf scopes (Wi-Fi, HTTP, parse, asset load,
+// decode, render, flush) and every tick() step are written to a fixed ring
+// as begin/duration events with micros() timestamps; once the ring is full
+// the oldest events are overwritten. The export is Chrome Trace Event JSON,
+// which Perfetto (ui.perfetto.dev) and chrome://tracing open directly.
+//
+// A stopped trace costs one relaxed atomic load per instrumented point.
+// Define WA_DISABLE_TRACE to compile tracing out.
+
+// Allocate the ring (once) and start recording. Returns false if there is no memory for it.
+bool traceStart(uint16_t eventCount = TRACE_DEFAULT_EVENTS);
+
+// Stop recording and keep the events for export
+void traceStop();
+
+// Stop recording and free the ring
+void traceRelease();
+
+#ifndef WA_DISABLE_TRACE
+bool traceActive();
+#else
+inline bool traceActive() {
+	return false;
+}
+#endif
+
+// Events held now, and events overwritten because the ring was full
+uint32_t traceEventCount();
+uint32_t traceDropped();
+
+// Record a span that started at startMicros (a micros() value), or a single point
+void traceComplete(const char* name, uint32_t startMicros, uint32_t durationMicros,
+                   const char* argName = nullptr, uint32_t arg = 0);
+void traceInstant(const char* name, const char* argName = nullptr, uint32_t arg = 0);
+
+// Write the events as Chrome Trace Event JSON. Recording pauses while the
+// events are written and resumes afterwards if it was running.
+void traceExportJSON(Print& out);
+
+#if !defined(ARDUINO_ARCH_ESP32) && !defined(ARDUINO_ARCH_ESP8266)
+// Host builds: write the JSON to a file
+bool traceWriteFile(const char* path);
+#endif
+
+}
+
+#endif // WEATHER_ANIMATIONS_TRACE_H
@@ -0,0 +1,74 @@
+#include "WeatherAnimationsWarmBoot.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+	#include <esp_attr.h>
+#endif
+
+using namespace WeatherAnimationsLib;
+
+// RTC slow memory is kept through deep sleep and software resets; the CRC
+// rejects whatever it holds after power-on
+#if defined(ARDUINO_ARCH_ESP32)
+	RTC_NOINIT_ATTR static WarmBootState rtcState;
+#elif !defined(ESP8266)
+	static WarmBootState rtcState;
+#endif
+
+static_assert(sizeof(WarmBootState) % 4 == 0, "RTC memory is written in 4-byte blocks");
+
+uint32_t WeatherAnimationsLib::warmBootCRC(const uint8_t* data, size_t length) {
+	uint32_t crc = 0xFFFFFFFF;
+	for (size_t i = 0; i < length; i++) {
+		crc ^= data[i];
+		for (uint8_t bit = 0; bit < 8; bit++) {
+			crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+		}
+	}
+	return ~crc;
+}
+
+// Helper function for the CRC of a state, without its crc field
+static uint32_t stateCRC(const WarmBootState& state) {
+	return warmBootCRC((const uint8_t*)&state, offsetof(WarmBootState, crc));
+}
+
+void WeatherAnimationsLib::saveWarmBootState(WarmBootState* state) {
+	state->magic = WARM_BOOT_MAGIC;
+	state->size = sizeof(WarmBootState);
+	state->condition[WEATHER_CONDITION_LENGTH - 1] = '\0';
+	memset(state->reserved, 0, sizeof(state->reserved));
+	state->crc = stateCRC(*state);
+#if defined(ESP8266)
+	ESP.rtcUserMemoryWrite(WARM_BOOT_RTC_OFFSET, (uint32_t*)state, sizeof(WarmBootState));
+#else
+	rtcState = *state;
+#endif
+}
+
+bool WeatherAnimationsLib::loadWarmBootState(WarmBootState* state) {
+#if defined(ESP8266)
+	if (!ESP.rtcUserMemoryRead(WARM_BOOT_RTC_OFFSET, (uint32_t*)state, sizeof(WarmBootState))) {
+		return false;
+	}
+#else
+	*state = rtcState;
+#endif
+	return state->magic == WARM_BOOT_MAGIC && state->size == sizeof(WarmBootState) &&
+	       state->crc == stateCRC(*state) && state->condition[WEATHER_CONDITION_LENGTH - 1] == '\0';
+}
+
+void WeatherAnimationsLib::clearWarmBootState() {
+	WarmBootState state;
+	memset(&state, 0, sizeof(state));
+#if defined(ESP8266)
+	ESP.rtcUserMemoryWrite(WARM_BOOT_RTC_OFFSET, (uint32_t*)&state, sizeof(WarmBootState));
+#else
+	rtcState = state;
+#endif
+}
+
+#if !defined(ARDUINO_ARCH_ESP32) && !defined(ARDUINO_ARCH_ESP8266)
+WarmBootState* WeatherAnimationsLib::warmBootMemory() {
+	return &rtcState;
+}
+#endif
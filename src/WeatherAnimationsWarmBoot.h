@@ -0,0 +1,52 @@
+#ifndef WEATHER_ANIMATIONS_WARM_BOOT_H
+#define WEATHER_ANIMATIONS_WARM_BOOT_H
+
+#include <Arduino.h>
+#include "WeatherAnimationsHub.h"
+
+// Marks a saved warm boot state; change it when WarmBootState changes
+#define WARM_BOOT_MAGIC 0x57414231UL // "WAB1"
+
+// ESP8266 only: first 4-byte block of RTC user memory used for the state
+#ifndef WARM_BOOT_RTC_OFFSET
+#define WARM_BOOT_RTC_OFFSET 0
+#endif
+
+namespace WeatherAnimationsLib {
+
+// The scene on screen, kept in RTC memory across resets and deep sleep
+struct WarmBootState {
+	uint32_t magic;
+	uint16_t size;
+	uint8_t weatherCondition;                 // WEATHER_* being shown
+	bool isDaytime;
+	char condition[WEATHER_CONDITION_LENGTH]; // Home Assistant condition, selects the icon
+	float minForecastTemp;
+	float maxForecastTemp;
+	float indoorTemp;
+	float outdoorTemp;
+	bool hasTemperatureData;
+	uint8_t reserved[3];
+	uint32_t crc;                             // CRC-32 of everything above
+};
+
+// Store a state; magic, size and crc are filled in
+void saveWarmBootState(WarmBootState* state);
+
+// Read the stored state. Returns false if there is none, e.g. after power-on.
+bool loadWarmBootState(WarmBootState* state);
+
+// Forget the stored state
+void clearWarmBootState();
+
+// CRC-32 (IEEE 802.3)
+uint32_t warmBootCRC(const uint8_t* data, size_t length);
+
+#if !defined(ARDUINO_ARCH_ESP32) && !defined(ARDUINO_ARCH_ESP8266)
+// Host builds: the memory standing in for RTC memory, as a reset leaves it
+WarmBootState* warmBootMemory();
+#endif
+
+}
+
+#endif // WEATHER_ANIMATIONS_WARM_BOOT_H
@@ -0,0 +1,48 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+// Helpers shared by the host tests, the renderer and the benchmarks: each
+// test prints the checks that fail and exits non-zero if there were any.
+
+#include "WeatherAnimations.h"
+
+#include <stdio.h>
+
+// Checks failed so far
+inline int failures = 0;
+
+inline void check(bool condition, const char* what) {
+	if (!condition) {
+		printf("FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+// Hash of what the OLED shows (FNV-1a)
+inline uint32_t frameHash() {
+	const uint8_t* buffer = Adafruit_SSD1306::lastInstance()->getBuffer();
+	uint32_t hash = 2166136261UL;
+	for (size_t i = 0; i < 128 * 64 / 8; i++) {
+		hash = (hash ^ buffer[i]) * 16777619UL;
+	}
+	return hash;
+}
+
+// Helper function to show a condition as the data hub would, in daylight,
+// with 21.5 indoors, 8.0 outdoors and a 4 to 11 forecast unless
+// temperatures is false
+inline void applyCondition(WeatherAnimations& animations, const char* condition, bool temperatures = true) {
+	WeatherSnapshot snapshot;
+	clearWeatherSnapshot(&snapshot);
+	snprintf(snapshot.condition, sizeof(snapshot.condition), "%s", condition);
+	snapshot.isDaytime = true;
+	snapshot.hasCondition = true;
+	snapshot.minForecastTemp = 4.0f;
+	snapshot.maxForecastTemp = 11.0f;
+	snapshot.indoorTemp = 21.5f;
+	snapshot.outdoorTemp = 8.0f;
+	snapshot.hasTemperatureData = temperatures;
+	animations.applyWeatherSnapshot(snapshot);
+}
+
+#endif // HOST_TEST_H
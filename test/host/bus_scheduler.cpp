@@ -0,0 +1,174 @@
+// Checks OLEDBusScheduler with two panels on one bus: a cycle never sends
+// much past its byte budget, the panels take turns so a large flush cannot
+// starve a small one, repeated requests collapse into one flush, and each
+// panel's frame rate follows the scheduler's clock:
+//
+//   cmake -S . -B build && cmake --build build
+//   ctest --test-dir build -R bus_scheduler
+//
+// Exits non-zero on the first inconsistency.
+
+#include "WeatherAnimations.h"
+#include "HostTest.h"
+
+#include <stdio.h>
+
+using namespace WeatherAnimationsLib;
+
+#define PANEL_WIDTH 128
+#define PANEL_HEIGHT 64
+
+// Bytes in one of the regions drawRegions() dirties
+#define REGION_BYTES 16
+
+// Helper function to dirty count pages with 16 columns each, alternating
+// sides so no two pages merge into one region
+static void drawRegions(OLEDPanel& panel, uint8_t count, uint16_t color) {
+	OLEDCanvas* canvas = panel.display();
+	for (uint8_t page = 0; page < count; page++) {
+		int16_t x = (page & 1) ? PANEL_WIDTH - REGION_BYTES : 0;
+		canvas->fillRect(x, page * 8, REGION_BYTES, 8, color);
+	}
+}
+
+// Helper function to start a panel and send its first, full frame
+static bool startPanel(OLEDPanel& panel, OLEDBusScheduler& bus, uint8_t i2cAddr) {
+	if (panel.begin(PANEL_WIDTH, PANEL_HEIGHT, oledI2CConfig(i2cAddr)) == nullptr || !bus.addPanel(&panel)) {
+		return false;
+	}
+	panel.display()->clearDisplay();
+	return panel.flush() == PANEL_WIDTH * PANEL_HEIGHT / 8;
+}
+
+// One region per panel per round, first panel alternating between cycles
+static void testInterleaving() {
+	OLEDBusScheduler bus(REGION_BYTES);
+	OLEDPanel large;
+	OLEDPanel small;
+	check(startPanel(large, bus, 0x3C) && startPanel(small, bus, 0x3D), "two panels on one bus");
+
+	drawRegions(large, 8, SSD1306_WHITE);
+	drawRegions(small, 2, SSD1306_WHITE);
+	bus.requestFlush(&large);
+	bus.requestFlush(&small);
+
+	uint32_t largeStart = large.bytesSent();
+	uint32_t smallStart = small.bytesSent();
+	bool withinBudget = true;
+	bool alternating = true;
+	uint8_t cycles = 0;
+	uint8_t smallDoneAfter = 0;
+	while (large.flushInProgress() || small.flushInProgress() || cycles == 0) {
+		uint32_t largeBefore = large.bytesSent();
+		uint32_t smallBefore = small.bytesSent();
+		uint16_t sent = bus.service();
+		cycles++;
+		withinBudget = withinBudget && sent == REGION_BYTES;
+
+		// While both have regions left, cycles go to the panels in turn
+		uint32_t largeSent = large.bytesSent() - largeBefore;
+		uint32_t smallSent = small.bytesSent() - smallBefore;
+		if (cycles <= 4) {
+			bool largeTurn = (cycles & 1) != 0;
+			alternating = alternating && largeSent == (largeTurn ? REGION_BYTES : 0u) &&
+			              smallSent == (largeTurn ? 0u : REGION_BYTES);
+		}
+		if (smallDoneAfter == 0 && !small.flushInProgress()) {
+			smallDoneAfter = cycles;
+		}
+		if (cycles > 20) {
+			break;
+		}
+	}
+	check(withinBudget, "every cycle sends one region's worth of bytes");
+	check(alternating, "panels take turns while both have regions");
+	check(smallDoneAfter == 4, "the small flush is not held up by the large one");
+	check(cycles == 10, "ten regions, one per cycle");
+	check(large.bytesSent() - largeStart == 8 * REGION_BYTES && small.bytesSent() - smallStart == 2 * REGION_BYTES,
+	      "each panel sent only its changed regions");
+
+	// A larger budget sends regions of both panels in one cycle
+	bus.setBytesPerCycle(4 * REGION_BYTES);
+	drawRegions(large, 8, SSD1306_BLACK);
+	drawRegions(small, 2, SSD1306_BLACK);
+	bus.requestFlush(&large);
+	bus.requestFlush(&small);
+	uint16_t sent = bus.service();
+	check(sent == 4 * REGION_BYTES && small.bytesSent() - smallStart == 4 * REGION_BYTES,
+	      "one cycle fills its budget across both panels");
+	check(bus.service() == 4 * REGION_BYTES && bus.service() == 2 * REGION_BYTES && bus.service() == 0,
+	      "the rest goes in the next cycles");
+}
+
+// Requests made before a flush starts collapse into that flush
+static void testCoalescing() {
+	OLEDBusScheduler bus;
+	OLEDPanel first;
+	OLEDPanel second;
+	check(startPanel(first, bus, 0x3C) && startPanel(second, bus, 0x3D), "two panels on one bus");
+
+	uint32_t flushes = first.flushCount();
+	for (uint8_t i = 0; i < 3; i++) {
+		drawRegions(first, i + 1, SSD1306_WHITE);
+		bus.requestFlush(&first);
+	}
+	bus.requestFlush(&second);
+	check(bus.coalescedFlushes(&first) == 2 && bus.coalescedFlushes(&second) == 0, "repeated requests coalesced");
+	check(bus.service() == 3 * REGION_BYTES, "one flush sends the latest drawing");
+	check(first.flushCount() == flushes + 1, "three requests, one flush");
+	check(!first.flushInProgress() && bus.service() == 0, "nothing left to send");
+
+	// A request made while a flush is running waits for the next one
+	bus.setBytesPerCycle(REGION_BYTES);
+	drawRegions(first, 3, SSD1306_BLACK);
+	bus.requestFlush(&first);
+	bus.service();
+	drawRegions(first, 4, SSD1306_WHITE);
+	bus.requestFlush(&first);
+	check(bus.coalescedFlushes(&first) == 2, "a request during a flush is not merged into it");
+	while (bus.service() > 0) {
+	}
+	check(first.flushCount() == flushes + 3, "and gets a flush of its own");
+}
+
+// Frame rates are counted on the scheduler's clock
+static void testFrameRate() {
+	VirtualClock clock(5000);
+	OLEDBusScheduler bus;
+	bus.setClock(&clock);
+	OLEDPanel fast;
+	OLEDPanel slow;
+	check(startPanel(fast, bus, 0x3C) && startPanel(slow, bus, 0x3D), "two panels on one bus");
+
+	// 100 frames a second on one panel and 20 on the other, for 2 s of virtual time
+	for (uint32_t t = 0; t <= 2000; t += 10) {
+		drawRegions(fast, 1, (t / 10) & 1 ? SSD1306_WHITE : SSD1306_BLACK);
+		bus.requestFlush(&fast);
+		if (t % 50 == 0) {
+			drawRegions(slow, 1, (t / 50) & 1 ? SSD1306_WHITE : SSD1306_BLACK);
+			bus.requestFlush(&slow);
+		}
+		bus.service();
+		clock.advance(10);
+	}
+
+	char what[64];
+	snprintf(what, sizeof(what), "fast panel at 100 fps (%.1f)", bus.frameRate(&fast));
+	check(bus.frameRate(&fast) > 99 && bus.frameRate(&fast) < 101.5f, what);
+	snprintf(what, sizeof(what), "slow panel at 20 fps (%.1f)", bus.frameRate(&slow));
+	check(bus.frameRate(&slow) > 19.5f && bus.frameRate(&slow) < 21.5f, what);
+}
+
+int main() {
+	printf("bus_scheduler: start\n");
+	testInterleaving();
+	testCoalescing();
+	testFrameRate();
+
+	if (failures != 0) {
+		printf("bus_scheduler: %d failures\n", failures);
+		return 1;
+	}
+	printf("bus_scheduler: OK\n");
+	return 0;
+}
@@ -0,0 +1,148 @@
+// Checks that a running display draws its frames without touching the heap:
+// once warmed up, tick() renders and flushes OLED and TFT frames, and
+// switches between weather conditions, with zero allocations. Counted by
+// the library's allocation hooks (WA_TRACK_ALLOCATIONS):
+//
+//   cmake -S . -B build && cmake --build build
+//   ctest --test-dir build -R frame_allocations
+//
+// Exits non-zero on any steady-state allocation, and with 77 (skipped) when
+// the hooks are not built in.
+
+#include "WeatherAnimations.h"
+#include "HostTest.h"
+
+#include <stdio.h>
+
+using namespace WeatherAnimationsLib;
+
+// Collects what dumpAllocStats() prints
+class StringPrint : public Print {
+public:
+	StringPrint() : length(0) {
+		text[0] = '\0';
+	}
+	size_t write(uint8_t c) override {
+		if (length < sizeof(text) - 1) {
+			text[length++] = c;
+			text[length] = '\0';
+		}
+		return 1;
+	}
+	using Print::write;
+
+	char text[512];
+	size_t length;
+};
+
+// Helper function to run tick() until a number of frames have been rendered
+static void runFrames(WeatherAnimations& animations, uint8_t displayType, uint32_t* now, uint32_t frames) {
+	uint32_t target = getPerfStats().stages[PERF_RENDER].count + frames;
+	while (getPerfStats().stages[PERF_RENDER].count < target) {
+		if (displayType == TFT_DISPLAY) {
+			animations.requestRedraw();
+		}
+		uint32_t next;
+		do {
+			next = animations.tick(*now);
+		} while (next == *now);
+		*now = next;
+	}
+}
+
+static void testFrames(const char* name, uint8_t displayType) {
+	static const char* const conditions[] = {"sunny", "cloudy", "rainy", "snowy", "lightning"};
+	const uint32_t framesPerCondition = 40;
+
+	// Only the warm-up polls; the next poll is due long after the run ends
+	WeatherDataHub hub("127.0.0.1", "token");
+	hub.setFetchInterval(0x7FFFFFFFUL);
+	WeatherAnimations animations("host", "host", "127.0.0.1", "token");
+	animations.setMode(CONTINUOUS_WEATHER);
+	animations.setAnimationMode(ANIMATION_EMBEDDED);
+	animations.begin(displayType, 0x3C, false);
+	animations.setDataHub(&hub);
+
+	// Frames right after a condition change may try to download its icon
+	// (and fail on the host); the frames after that are the steady state
+	uint32_t now = 0;
+	uint32_t allocations = 0;
+	uint32_t bytes = 0;
+	uint32_t drawing = 0;
+	for (const char* condition : conditions) {
+		applyCondition(animations, condition);
+		runFrames(animations, displayType, &now, 4);
+
+		AllocStats before = getAllocStats();
+		runFrames(animations, displayType, &now, framesPerCondition);
+		AllocStats after = getAllocStats();
+		allocations += after.count - before.count;
+		bytes += after.bytes - before.bytes;
+		drawing += (after.scopes[PERF_RENDER].count - before.scopes[PERF_RENDER].count) +
+		           (after.scopes[PERF_FLUSH].count - before.scopes[PERF_FLUSH].count);
+	}
+
+	char what[96];
+	snprintf(what, sizeof(what), "%s steady-state frames do not allocate", name);
+	check(allocations == 0, what);
+	snprintf(what, sizeof(what), "%s render and flush scopes do not allocate", name);
+	check(drawing == 0, what);
+	printf("%s: %u frames, %u allocations, %u bytes\n", name, (unsigned)(5 * framesPerCondition),
+	       (unsigned)allocations, (unsigned)bytes);
+	if (allocations != 0) {
+		StringPrint out;
+		dumpAllocStats(out);
+		printf("%s", out.text);
+	}
+	animations.setDataHub(nullptr);
+}
+
+// Called through a volatile pointer so the compiler cannot drop a malloc()/free() pair
+static void* (*volatile allocate)(size_t) = malloc;
+
+// Allocations land in the scope that made them
+static void testScopes() {
+	resetAllocStats();
+	void* outside = allocate(24);
+	{
+		WA_ALLOC_SCOPE(PERF_DECODE);
+		void* inside = allocate(100);
+		{
+			WA_ALLOC_SCOPE(PERF_RENDER);
+			free(allocate(8));
+		}
+		free(inside);
+	}
+	free(outside);
+
+	AllocStats stats = getAllocStats();
+	check(stats.scopes[ALLOC_UNSCOPED].count == 1 && stats.scopes[ALLOC_UNSCOPED].bytes == 24, "unscoped allocation");
+	check(stats.scopes[PERF_DECODE].count == 1 && stats.scopes[PERF_DECODE].bytes == 100, "outer scope allocation");
+	check(stats.scopes[PERF_RENDER].count == 1 && stats.scopes[PERF_RENDER].bytes == 8, "nested scope allocation");
+	check(stats.count == 3 && stats.bytes == 132, "totals add up");
+
+	StringPrint out;
+	dumpAllocStats(out);
+	check(strstr(out.text, "decode") != nullptr && strstr(out.text, "other") != nullptr, "dump lists the scopes");
+	check(strstr(out.text, "flush") == nullptr, "dump skips empty scopes");
+	resetAllocStats();
+	check(getAllocStats().count == 0, "reset clears the counts");
+}
+
+int main() {
+	printf("frame_allocations: start\n");
+	if (!allocTracking()) {
+		printf("frame_allocations: skipped, built without WA_TRACK_ALLOCATIONS\n");
+		return 77;
+	}
+	testScopes();
+	testFrames("oled", OLED_SSD1306);
+	testFrames("tft", TFT_DISPLAY);
+
+	if (failures != 0) {
+		printf("frame_allocations: %d failures\n", failures);
+		return 1;
+	}
+	printf("frame_allocations: OK\n");
+	return 0;
+}
@@ -0,0 +1,156 @@
+// Checks the deferred log ring: formatting at drain time, a full ring,
+// concurrent writers against a draining reader, and compiled-out levels:
+//
+//   cmake -S . -B build && cmake --build build
+//   ctest --test-dir build -R log_ring
+//
+// Exits non-zero on the first inconsistency.
+
+#include "WeatherAnimations.h"
+#include "HostTest.h"
+
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <atomic>
+
+using namespace WeatherAnimationsLib;
+
+// Collects what logDrain() prints
+class StringPrint : public Print {
+public:
+	size_t write(uint8_t c) override {
+		text += (char)c;
+		return 1;
+	}
+	using Print::write;
+
+	std::string text;
+};
+
+// Helper function to count the lines printed so far
+static size_t lines(const std::string& text) {
+	size_t count = 0;
+	for (char c : text) {
+		count += c == '\n';
+	}
+	return count;
+}
+
+// Records keep their arguments and are formatted only when drained
+static void testFormat() {
+	logWrite(WA_LOG_LEVEL_WARN, "code %d, %u bytes, %.1f C, %s", -3, 512u, 21.5f, "literal");
+	logWrite(WA_LOG_LEVEL_VERBOSE, "%04X, %-3c|%%", 0xab, 'x');
+	logWrite(WA_LOG_LEVEL_INFO, "First frame %lu ms after begin()", (unsigned long)1234);
+	logWrite(WA_LOG_LEVEL_ERROR, "no arguments");
+	logWrite(WA_LOG_LEVEL_DEBUG, "missing %d and %s");
+	check(logPending() == 5, "five records waiting");
+
+	StringPrint out;
+	check(logDrain(out, 1) == 1, "drain stops at maxRecords");
+	check(out.text.compare(0, 3, "W (") == 0, "level letter and time first");
+	check(out.text.find("code -3, 512 bytes, 21.5 C, literal\r\n") != std::string::npos, "arguments formatted");
+	check(logDrain(out) == 4, "rest drained");
+	check(out.text.find("00AB, x  |%\r\n") != std::string::npos, "flags, width and percent signs");
+	check(out.text.find("I (") != std::string::npos && out.text.find("First frame 1234 ms after begin()") != std::string::npos,
+	      "length modifiers ignored");
+	check(out.text.find("E (") != std::string::npos && out.text.find("no arguments") != std::string::npos,
+	      "records without arguments");
+	check(out.text.find("missing 0 and (null)") != std::string::npos, "missing arguments read as empty");
+	check(logPending() == 0 && logDrain(out) == 0, "ring empty after the drain");
+	printf("%s", out.text.c_str());
+}
+
+// A full ring drops new records, counts them and says so on the next drain
+static void testFull() {
+	uint32_t droppedBefore = logDropped();
+	for (uint32_t i = 0; i < LOG_RING_RECORDS + 5; i++) {
+		logWrite(WA_LOG_LEVEL_DEBUG, "record %u", i);
+	}
+	check(logPending() == LOG_RING_RECORDS, "ring holds its capacity");
+	check(logDropped() - droppedBefore == 5, "newest records dropped");
+
+	StringPrint out;
+	check(logDrain(out) == LOG_RING_RECORDS, "every held record drained");
+	check(lines(out.text) == LOG_RING_RECORDS + 1, "one line per record plus the drop notice");
+	check(out.text.find("5 log records dropped") != std::string::npos, "drop notice");
+	check(out.text.find("record 0\r\n") < out.text.find("record 31\r\n"), "records drained in order");
+	check(out.text.find("record 32") == std::string::npos, "dropped records not drained");
+}
+
+// Two writers race a reader; every record is drained whole, in order, or counted as dropped
+static void testThreads() {
+	const uint32_t perThread = 20000;
+	uint32_t droppedBefore = logDropped();
+	std::atomic<int> running(2);
+	auto writer = [&running](uint32_t thread) {
+		for (uint32_t i = 0; i < perThread; i++) {
+			logWrite(WA_LOG_LEVEL_DEBUG, "writer %u record %u", thread, i);
+			if (i % 16 == 0) {
+				std::this_thread::yield(); // give the reader a chance
+			}
+		}
+		running--;
+	};
+	std::thread first(writer, 0);
+	std::thread second(writer, 1);
+
+	StringPrint out;
+	uint32_t drained = 0;
+	while (running.load() > 0 || logPending() > 0) {
+		drained += logDrain(out, LOG_DRAIN_BATCH);
+	}
+	first.join();
+	second.join();
+	drained += logDrain(out);
+
+	check(drained + (logDropped() - droppedBefore) == perThread * 2, "every record drained or dropped");
+	bool ordered = true;
+	bool whole = true;
+	long last[2] = {-1, -1};
+	size_t at = 0;
+	while ((at = out.text.find("writer ", at)) != std::string::npos) {
+		unsigned thread;
+		unsigned index;
+		if (sscanf(out.text.c_str() + at, "writer %u record %u", &thread, &index) != 2 || thread > 1) {
+			whole = false;
+			break;
+		}
+		if ((long)index <= last[thread]) {
+			ordered = false;
+		}
+		last[thread] = index;
+		at++;
+	}
+	check(whole, "records drained whole");
+	check(ordered, "each writer's records stay in order");
+	printf("log: %u of %u records drained while writing\n", (unsigned)drained, (unsigned)(perThread * 2));
+}
+
+// Levels above WA_LOG_LEVEL cost nothing, not even their arguments
+static void testCompiledOut() {
+	int evaluated = 0;
+	WA_LOG_VERBOSE("evaluated %d", ++evaluated);
+#if WA_LOG_LEVEL < WA_LOG_LEVEL_VERBOSE
+	check(evaluated == 0 && logPending() == 0, "compiled-out call does nothing");
+#else
+	check(evaluated == 1 && logPending() == 1, "compiled-in call records");
+	StringPrint out;
+	logDrain(out);
+#endif
+}
+
+int main() {
+	printf("log_ring: start\n");
+	testFormat();
+	testFull();
+	testThreads();
+	testCompiledOut();
+
+	if (failures != 0) {
+		printf("log_ring: %d failures\n", failures);
+		return 1;
+	}
+	printf("log_ring: OK\n");
+	return 0;
+}
@@ -0,0 +1,238 @@
+// Measures how long a change in Home Assistant takes to reach the pixels,
+// and how many bytes each poll moves, through the library's own polling
+// code against MockHomeAssistant on 127.0.0.1:8123. The weather is
+// changed at different points of the poll cycle on a clean link, with
+// added latency and jitter, and on a slow link; then the weather entity
+// fails with error codes, a truncated body and a slow-loris stall, and
+// the display must keep the last good weather, stay responsive, and pick
+// up the change once the server recovers:
+//
+//   cmake -S . -B build && cmake --build build
+//   ctest --test-dir build -R network_latency
+//
+// Exits non-zero on the first inconsistency. Takes 15 to 20 seconds of
+// real time, as the faults are real waits.
+
+#include "WeatherAnimations.h"
+#include "HostTest.h"
+#include "MockHomeAssistant.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace WeatherAnimationsLib;
+
+// Poll interval of the runs, in ms
+#define LATENCY_POLL_INTERVAL 200
+
+// Weather changes per profile
+#define LATENCY_CHANGES 6
+
+// Beyond the poll interval and twice the poll time, for rendering and
+// scheduling on a loaded machine
+#define LATENCY_SLACK 250
+
+// Longest tick() allowed while the server misbehaves, in ms
+#define LATENCY_MAX_TICK 100
+
+// Bytes a poll of the three entities may move each way
+#define LATENCY_POLL_BYTES_IN 1536
+#define LATENCY_POLL_BYTES_OUT 768
+
+// Helper function to run tick() for a while in real time, or until the
+// pixels differ from before; returns the ms it ran
+static uint32_t runFor(WeatherAnimations& animations, uint32_t duration, uint32_t before, uint32_t* longestTick) {
+	uint32_t start = millis();
+	while (millis() - start < duration) {
+		uint32_t now = millis();
+		uint32_t tickStart = millis();
+		uint32_t next = animations.tick(now);
+		uint32_t took = millis() - tickStart;
+		if (longestTick != nullptr && took > *longestTick) {
+			*longestTick = took;
+		}
+		if (before != 0 && frameHash() != before) {
+			break;
+		}
+		// Sleep to the next wakeup, in 1 ms steps so the change is seen when it lands
+		if ((int32_t)(next - now) > 0) {
+			usleep(1000);
+		}
+	}
+	return millis() - start;
+}
+
+struct Profile {
+	uint32_t minLatency;
+	uint32_t maxLatency;
+	uint32_t totalLatency;
+	uint32_t seen;
+	uint32_t bytesIn;   // per poll
+	uint32_t bytesOut;  // per poll
+};
+
+// Helper function to change the weather at different points of the poll
+// cycle and time each change until it is on the panel
+static Profile measure(const char* name, MockHomeAssistant& server, WeatherAnimations& animations,
+                       WeatherDataHub& hub, const MockHAFaults& faults, uint32_t pollCeiling) {
+	server.setFaults(faults);
+	// Let a poll started before the faults finish
+	runFor(animations, LATENCY_POLL_INTERVAL + pollCeiling, 0, nullptr);
+
+	Profile profile;
+	memset(&profile, 0, sizeof(profile));
+	profile.minLatency = 0xFFFFFFFFUL;
+	uint32_t polls = hub.fetchCount();
+	uint64_t bytesIn = server.bytesSent();
+	uint64_t bytesOut = server.bytesReceived();
+	uint32_t timeout = LATENCY_POLL_INTERVAL + 2 * pollCeiling + LATENCY_SLACK;
+	for (uint32_t i = 0; i < LATENCY_CHANGES; i++) {
+		runFor(animations, (i * 89) % LATENCY_POLL_INTERVAL, 0, nullptr);
+		uint32_t before = frameHash();
+		server.toggleWeather();
+		uint32_t latency = runFor(animations, timeout, before, nullptr);
+		if (frameHash() != before) {
+			profile.seen++;
+			profile.totalLatency += latency;
+			profile.minLatency = latency < profile.minLatency ? latency : profile.minLatency;
+			profile.maxLatency = latency > profile.maxLatency ? latency : profile.maxLatency;
+		}
+	}
+	polls = hub.fetchCount() - polls;
+	if (polls > 0) {
+		profile.bytesIn = (uint32_t)((server.bytesSent() - bytesIn) / polls);
+		profile.bytesOut = (uint32_t)((server.bytesReceived() - bytesOut) / polls);
+	}
+	server.clearFaults();
+
+	char what[96];
+	snprintf(what, sizeof(what), "%s: every change reaches the panel within %u ms", name, (unsigned)timeout);
+	check(profile.seen == LATENCY_CHANGES, what);
+	printf("%-10s latency min %4u mean %4u max %4u ms, %u polls, %u bytes in and %u out per poll\n", name,
+	       (unsigned)profile.minLatency, (unsigned)(profile.seen > 0 ? profile.totalLatency / profile.seen : 0),
+	       (unsigned)profile.maxLatency, (unsigned)polls, (unsigned)profile.bytesIn, (unsigned)profile.bytesOut);
+	return profile;
+}
+
+// Helper function to break the weather entity, check the panel keeps the
+// last good weather, then heal it and time the change. A request still
+// stalled when the server recovers holds the poll up to its timeout.
+static void survive(const char* name, MockHomeAssistant& server, WeatherAnimations& animations,
+                    const MockHAFaults& faults, uint32_t duration) {
+	uint32_t recovery = 2 * LATENCY_POLL_INTERVAL + LATENCY_SLACK + (faults.stall > 0 ? HA_REQUEST_TIMEOUT : 0);
+	server.setFaults(faults);
+	uint32_t before = frameHash();
+	uint32_t polls = server.stateRequests();
+	server.toggleWeather();
+	uint32_t longestTick = 0;
+	runFor(animations, duration, before, &longestTick);
+	bool kept = frameHash() == before;
+	bool polled = server.stateRequests() > polls;
+
+	server.clearFaults();
+	uint32_t latency = runFor(animations, recovery, before, nullptr);
+	bool recovered = frameHash() != before;
+
+	char what[96];
+	snprintf(what, sizeof(what), "%s: the panel keeps the last good weather", name);
+	check(kept, what);
+	snprintf(what, sizeof(what), "%s: the other entities are still polled", name);
+	check(polled, what);
+	snprintf(what, sizeof(what), "%s: tick() stays under %u ms", name, (unsigned)LATENCY_MAX_TICK);
+	check(longestTick <= LATENCY_MAX_TICK, what);
+	snprintf(what, sizeof(what), "%s: the change shows once the server recovers", name);
+	check(recovered, what);
+	printf("%-10s kept %s, longest tick %u ms, recovered in %u ms\n", name, kept ? "yes" : "no",
+	       (unsigned)longestTick, (unsigned)latency);
+}
+
+// /api/template renders states, and the API wants a token
+static void testServer(MockHomeAssistant& server) {
+	HTTPClient http;
+	http.begin("http://127.0.0.1:8123/api/template");
+	http.addHeader("Authorization", "Bearer token");
+	int code = http.POST("{\"template\": \"{{ states('weather.forecast') }} at "
+	                     "{{ states('sensor.t_h_sensor_temperature') }}\"}");
+	String body = http.getString();
+	http.end();
+	check(code == 200 && body == "sunny at 21.5", "template rendered");
+
+	http.begin("http://127.0.0.1:8123/api/states/weather.forecast");
+	code = http.GET();
+	http.end();
+	check(code == 401, "states need a token");
+	check(server.templateRequests() == 1, "template request counted");
+}
+
+static void testLatency() {
+	MockHomeAssistant server;
+	check(server.start(8123), "mock Home Assistant listening on 127.0.0.1:8123");
+	if (failures != 0) {
+		return;
+	}
+	server.setDefaultEntities();
+	testServer(server);
+	WiFi.hostSetStatus(WL_CONNECTED);
+
+	// Static icons, so the pixels only change when the weather does
+	WeatherDataHub hub("127.0.0.1", "token");
+	hub.setFetchInterval(LATENCY_POLL_INTERVAL);
+	WeatherAnimations animations("host", "host", "127.0.0.1", "token");
+	animations.setMode(CONTINUOUS_WEATHER);
+	animations.setAnimationMode(ANIMATION_STATIC);
+	animations.setDataHub(&hub);
+	animations.begin(OLED_SSD1306, 0x3C, false);
+	runFor(animations, 2 * LATENCY_POLL_INTERVAL, 0, nullptr);
+	check(hub.fetchCount() > 0 && hub.snapshot().hasCondition, "first poll done");
+
+	MockHAFaults faults;
+	clearMockHAFaults(&faults);
+	Profile clean = measure("clean", server, animations, hub, faults, 20);
+	check(clean.bytesIn > 0 && clean.bytesIn <= LATENCY_POLL_BYTES_IN, "response bytes per poll within budget");
+	check(clean.bytesOut > 0 && clean.bytesOut <= LATENCY_POLL_BYTES_OUT, "request bytes per poll within budget");
+
+	// Three requests a poll, each 40-60 ms late: a change caught at the
+	// start of a poll still waits for all three
+	faults.latency = 40;
+	faults.jitter = 20;
+	Profile late = measure("latency", server, animations, hub, faults, 3 * 60);
+	check(late.minLatency >= 3 * 40, "latency: every request of the poll waits");
+
+	// 8 kB/s: each poll's responses take their size over the bandwidth
+	clearMockHAFaults(&faults);
+	faults.bytesPerSecond = 8000;
+	uint32_t transfer = clean.bytesIn * 1000 / faults.bytesPerSecond;
+	Profile slow = measure("bandwidth", server, animations, hub, faults, transfer + 60);
+	check(slow.minLatency + 30 >= transfer, "bandwidth: the poll takes as long as its bytes");
+
+	// Failures of the weather entity only; the sensors keep answering
+	clearMockHAFaults(&faults);
+	faults.pathPrefix = "/api/states/weather.";
+	faults.status = 500;
+	survive("error 500", server, animations, faults, 3 * LATENCY_POLL_INTERVAL);
+	faults.status = 401;
+	survive("error 401", server, animations, faults, 3 * LATENCY_POLL_INTERVAL);
+	faults.status = 0;
+	faults.truncateAfter = 40;
+	survive("truncated", server, animations, faults, 3 * LATENCY_POLL_INTERVAL);
+	faults.truncateAfter = -1;
+	faults.stallAfter = 40;
+	faults.stall = HA_REQUEST_TIMEOUT + 1000;
+	survive("stalled", server, animations, faults, HA_REQUEST_TIMEOUT + 2 * LATENCY_POLL_INTERVAL);
+
+	hub.removeDisplay(&animations);
+	WiFi.hostSetStatus(WL_DISCONNECTED);
+	server.stop();
+}
+
+int main() {
+	printf("network_latency: start\n");
+	testLatency();
+
+	if (failures != 0) {
+		printf("network_latency: %d failures\n", failures);
+		return 1;
+	}
+	printf("network_latency: OK\n");
+	return 0;
+}
@@ -0,0 +1,113 @@
+// Checks panel orientation: blitPageBuffer() matches, pixel for pixel, a
+// canvas drawn through Adafruit_GFX setRotation() with the image mirrored
+// first, for every rotation and mirror, and WeatherAnimations refuses the
+// quarter turns its landscape layouts cannot fill:
+//
+//   cmake -S . -B build && cmake --build build
+//   ctest --test-dir build -R orientation
+//
+// Exits non-zero on the first inconsistency.
+
+#include "WeatherAnimations.h"
+#include "HostTest.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace WeatherAnimationsLib;
+
+// Helper function to draw a pattern with no symmetry, so any wrong flip shows
+static void fillPattern(OLEDCanvas& canvas, uint32_t seed) {
+	canvas.clearDisplay();
+	for (int16_t y = 0; y < canvas.height(); y++) {
+		for (int16_t x = 0; x < canvas.width(); x++) {
+			seed = seed * 1103515245 + 12345;
+			if ((seed >> 16) & 1) {
+				canvas.drawPixel(x, y, SSD1306_WHITE);
+			}
+		}
+	}
+}
+
+// Every rotation and mirror of a width x height image
+static void testBlit(uint16_t width, uint16_t height) {
+	static const uint8_t mirrors[] = {OLED_MIRROR_NONE, OLED_MIRROR_X, OLED_MIRROR_Y, OLED_MIRROR_X | OLED_MIRROR_Y};
+	OLEDCanvas source(width, height);
+	fillPattern(source, width * 31 + height);
+
+	for (uint8_t rotation = OLED_ROTATE_0; rotation <= OLED_ROTATE_270; rotation++) {
+		bool swap = (rotation & 1) != 0;
+		uint16_t panelWidth = swap ? height : width;
+		uint16_t panelHeight = swap ? width : height;
+		for (uint8_t mirror : mirrors) {
+			// The reference draws each mirrored pixel on a canvas rotated like the panel
+			OLEDCanvas reference(panelWidth, panelHeight);
+			reference.setRotation(rotation);
+			for (int16_t y = 0; y < height; y++) {
+				for (int16_t x = 0; x < width; x++) {
+					int16_t mirroredX = (mirror & OLED_MIRROR_X) ? width - 1 - x : x;
+					int16_t mirroredY = (mirror & OLED_MIRROR_Y) ? height - 1 - y : y;
+					if (source.getPixel(x, y)) {
+						reference.drawPixel(mirroredX, mirroredY, SSD1306_WHITE);
+					}
+				}
+			}
+
+			OLEDCanvas panel(panelWidth, panelHeight);
+			blitPageBuffer(source.getBuffer(), width, height, panel.getBuffer(), rotation, mirror);
+
+			uint32_t wrong = 0;
+			for (int16_t y = 0; y < panelHeight; y++) {
+				for (int16_t x = 0; x < panelWidth; x++) {
+					wrong += panel.getPixel(x, y) != reference.getPixel(x, y);
+				}
+			}
+			char what[96];
+			snprintf(what, sizeof(what), "%ux%u rotation %u mirror %u matches GFX (%u pixels differ)",
+			         (unsigned)width, (unsigned)height, (unsigned)rotation, (unsigned)mirror, (unsigned)wrong);
+			check(wrong == 0, what);
+		}
+	}
+}
+
+// Helper function to render a few frames of sunny weather and keep what the panel shows
+static void renderScreen(uint8_t rotation, uint8_t refused, uint8_t* screen) {
+	VirtualClock clock(1000);
+	WeatherAnimations animations("host", "host", "127.0.0.1", "token");
+	animations.setClock(&clock);
+	animations.setMode(CONTINUOUS_WEATHER);
+	animations.setAnimationMode(ANIMATION_EMBEDDED);
+	check(animations.setOrientation(rotation), "half turns are accepted");
+	check(!animations.setOrientation(refused), "quarter turns are refused");
+	animations.begin(OLED_SSD1306, 0x3C, false);
+	applyCondition(animations, "sunny");
+	animations.fastForward(&clock, 600);
+	memcpy(screen, Adafruit_SSD1306::lastInstance()->getBuffer(), 128 * 64 / 8);
+}
+
+// Quarter turns would clip the 128x64 layouts, so they are refused and the
+// orientation set before stays
+static void testSetOrientation() {
+	uint8_t upright[128 * 64 / 8];
+	uint8_t upsideDown[128 * 64 / 8];
+	uint8_t expected[128 * 64 / 8];
+	renderScreen(OLED_ROTATE_0, OLED_ROTATE_90, upright);
+	renderScreen(OLED_ROTATE_180, OLED_ROTATE_270, upsideDown);
+	blitPageBuffer(upright, 128, 64, expected, OLED_ROTATE_180, OLED_MIRROR_NONE);
+	check(memcmp(upright, upsideDown, sizeof(upright)) != 0, "the screen is not symmetric");
+	check(memcmp(expected, upsideDown, sizeof(expected)) == 0, "a refused quarter turn keeps the half turn");
+}
+
+int main() {
+	printf("orientation: start\n");
+	testBlit(128, 64);
+	testBlit(24, 16);
+	testSetOrientation();
+
+	if (failures != 0) {
+		printf("orientation: %d failures\n", failures);
+		return 1;
+	}
+	printf("orientation: OK\n");
+	return 0;
+}
@@ -0,0 +1,126 @@
+// Checks the latency histograms behind getPerfStats(): bucket boundaries,
+// percentiles, the scopes in the library and dumpPerfStats():
+//
+//   cmake -S . -B build && cmake --build build
+//   ctest --test-dir build -R perf_stats
+//
+// Exits non-zero on the first wrong statistic.
+
+#include "WeatherAnimations.h"
+#include "HostTest.h"
+
+#include <stdio.h>
+
+using namespace WeatherAnimationsLib;
+
+// Collects what dumpPerfStats() prints
+class StringPrint : public Print {
+public:
+	StringPrint() : length(0) {
+		text[0] = '\0';
+	}
+	size_t write(uint8_t c) override {
+		if (length < sizeof(text) - 1) {
+			text[length++] = c;
+			text[length] = '\0';
+		}
+		return 1;
+	}
+	using Print::write;
+
+	char text[1024];
+	size_t length;
+};
+
+// Every duration falls in a bucket whose bound is at least the duration and
+// at most a quarter above it, and buckets never go backwards
+static void testBuckets() {
+	bool inside = true;
+	bool ordered = true;
+	uint8_t previous = 0;
+	for (uint32_t micros = 0; micros < (1UL << 24); micros += 1 + micros / 64) {
+		uint8_t bucket = PerfHistogram::bucketOf(micros);
+		uint32_t limit = PerfHistogram::bucketLimit(bucket);
+		if (limit < micros || limit - micros > micros / 4 + 1) {
+			inside = false;
+		}
+		if (bucket < previous) {
+			ordered = false;
+		}
+		previous = bucket;
+	}
+	check(inside, "bucket bounds within 25% of the duration");
+	check(ordered, "buckets grow with the duration");
+	check(PerfHistogram::bucketOf(0xFFFFFFFFUL) == PERF_BUCKETS - 1, "long durations land in the last bucket");
+}
+
+static void testPercentiles() {
+	PerfHistogram histogram;
+	check(histogram.count() == 0 && histogram.percentile(500) == 0, "empty histogram reports zeros");
+
+	// 1..1000 us once each
+	for (uint32_t i = 1; i <= 1000; i++) {
+		histogram.record(i);
+	}
+	PerfStageStats stats;
+	histogram.stats(&stats);
+	check(stats.count == 1000, "every record counted");
+	check(stats.minMicros == 1 && stats.maxMicros == 1000, "exact min and max");
+	check(stats.p50Micros >= 500 && stats.p50Micros <= 625, "p50 near 500 us");
+	check(stats.p99Micros >= 990 && stats.p99Micros <= 1000, "p99 near 990 us, capped at the max");
+
+	// One slow outlier does not move the median
+	histogram.reset();
+	for (int i = 0; i < 99; i++) {
+		histogram.record(40);
+	}
+	histogram.record(250000);
+	histogram.stats(&stats);
+	check(stats.p50Micros >= 40 && stats.p50Micros <= 47, "median ignores the outlier");
+	check(stats.maxMicros == 250000, "outlier kept as the max");
+	check(histogram.percentile(1000) == 250000, "p100 is the max");
+}
+
+// The library's own scopes feed the shared statistics
+static void testLibraryScopes() {
+	resetPerfStats();
+	WeatherSnapshot snapshot;
+	clearWeatherSnapshot(&snapshot);
+	parseWeatherState("{\"state\":\"rainy\",\"attributes\":{\"is_daytime\":true}}", &snapshot);
+	float temperature = 0;
+	parseTemperatureState("{\"state\":\"21.5\",\"attributes\":{}}", &temperature);
+	{
+		WA_PERF_SCOPE(PERF_RENDER);
+		delay(2);
+	}
+
+	PerfStats stats = getPerfStats();
+	check(stats.stages[PERF_PARSE].count == 2, "both parses timed");
+	check(stats.stages[PERF_RENDER].count == 1, "scope recorded once");
+	check(stats.stages[PERF_RENDER].minMicros >= 2000, "scope measured the delay");
+	check(stats.stages[PERF_FLUSH].count == 0, "untouched stages stay empty");
+
+	StringPrint out;
+	dumpPerfStats(out);
+	check(strstr(out.text, "parse") != nullptr && strstr(out.text, "render") != nullptr, "dump lists timed stages");
+	check(strstr(out.text, "flush") == nullptr, "dump skips empty stages");
+	printf("%s", out.text);
+
+	resetPerfStats();
+	check(getPerfStats().stages[PERF_PARSE].count == 0, "reset clears every stage");
+	check(strcmp(perfStageName(PERF_ASSET_LOAD), "asset_load") == 0, "stage names");
+}
+
+int main() {
+	printf("perf_stats: start\n");
+	testBuckets();
+	testPercentiles();
+	testLibraryScopes();
+
+	if (failures != 0) {
+		printf("perf_stats: %d failures\n", failures);
+		return 1;
+	}
+	printf("perf_stats: OK\n");
+	return 0;
+}
@@ -0,0 +1,240 @@
+// Stress test for the dual-core pipeline primitives: the SPSC queues, the
+// seqlocked state, the frame swap and the slab pools, hammered from
+// several threads:
+//
+//   cmake -S . -B build && cmake --build build
+//   ctest --test-dir build -R pipeline_stress
+//
+// Exits non-zero on the first inconsistency. Configure with
+// -DWA_HOST_TSAN=ON to run it under ThreadSanitizer, which reports races.
+
+#include "WeatherAnimations.h"
+#include "HostTest.h"
+#include "TestPNG.h"
+
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+using namespace WeatherAnimationsLib;
+
+// Every value pushed arrives exactly once and in order
+static void testQueue() {
+	const uint32_t count = 200000;
+	SPSCQueue<uint32_t, 8> queue;
+	uint32_t received = 0;
+	bool ordered = true;
+
+	std::thread producer([&]() {
+		for (uint32_t i = 1; i <= count; i++) {
+			while (!queue.push(i)) {
+				std::this_thread::yield();
+			}
+		}
+	});
+	std::thread consumer([&]() {
+		uint32_t value;
+		while (received < count) {
+			if (queue.pop(&value)) {
+				ordered &= (value == received + 1);
+				received++;
+			} else {
+				std::this_thread::yield();
+			}
+		}
+	});
+	producer.join();
+	consumer.join();
+
+	check(received == count, "queue delivered every item");
+	check(ordered, "queue kept the order");
+	check(queue.empty(), "queue drained");
+}
+
+// Readers never see a snapshot that is half old and half new
+static void testSeqLock() {
+	const uint32_t writes = 100000;
+	SeqLock<WeatherSnapshot> state;
+	std::atomic<bool> done(false);
+	std::atomic<uint32_t> torn(0);
+	std::atomic<uint32_t> reads(0);
+
+	std::thread writer([&]() {
+		WeatherSnapshot snapshot;
+		clearWeatherSnapshot(&snapshot);
+		for (uint32_t i = 1; i <= writes; i++) {
+			snprintf(snapshot.condition, sizeof(snapshot.condition), "state-%u", (unsigned)i);
+			snapshot.indoorTemp = (float)i;
+			snapshot.outdoorTemp = (float)i * 2;
+			snapshot.sequence = i;
+			state.write(snapshot);
+		}
+		done = true;
+	});
+
+	std::vector<std::thread> readers;
+	for (int r = 0; r < 3; r++) {
+		readers.push_back(std::thread([&]() {
+			WeatherSnapshot snapshot;
+			uint32_t last = 0;
+			while (!done) {
+				if (!state.read(&snapshot)) {
+					continue;
+				}
+				char expected[WEATHER_CONDITION_LENGTH];
+				snprintf(expected, sizeof(expected), "state-%u", (unsigned)snapshot.sequence);
+				if (strcmp(expected, snapshot.condition) != 0 ||
+				    snapshot.indoorTemp != (float)snapshot.sequence ||
+				    snapshot.outdoorTemp != (float)snapshot.sequence * 2 ||
+				    snapshot.sequence < last) {
+					torn++;
+				}
+				last = snapshot.sequence;
+				reads++;
+			}
+		}));
+	}
+
+	writer.join();
+	for (size_t i = 0; i < readers.size(); i++) {
+		readers[i].join();
+	}
+
+	WeatherSnapshot last;
+	check(state.read(&last) && last.sequence == writes, "seqlock holds the last write");
+	check(state.version() == writes, "seqlock counted every write");
+	check(torn == 0, "no torn seqlock reads");
+	printf("seqlock: %u reads\n", (unsigned)reads.load());
+}
+
+// The renderer only ever sees whole frame versions, and replaced ones are freed
+static void testFrameSwap() {
+	const uint32_t updates = 2000;
+	generateFallbackAnimations();
+	AnimationFrameStore store;
+	std::atomic<bool> done(false);
+	std::atomic<uint32_t> torn(0);
+	uint32_t published = 0;
+
+	static uint8_t black[2048];
+	static uint8_t white[2048];
+	size_t blackSize = makeTestPNG(black, sizeof(black), TEST_PNG_SOLID, 0x00);
+	size_t whiteSize = makeTestPNG(white, sizeof(white), TEST_PNG_SOLID, 0xFF);
+	check(blackSize > 0 && whiteSize > 0, "test frames encoded");
+
+	std::thread writer([&]() {
+		for (uint32_t i = 1; i <= updates; i++) {
+			if (!store.beginUpdate(WEATHER_RAIN)) {
+				continue;
+			}
+			// Every frame of one version gets the same shade
+			for (uint8_t frame = 0; frame < store.frameCount(WEATHER_RAIN); frame++) {
+				store.decodeFrame(frame, (i & 1) ? white : black, (i & 1) ? whiteSize : blackSize);
+			}
+			if (store.finishUpdate()) {
+				published++;
+			}
+		}
+		done = true;
+	});
+
+	std::thread renderer([&]() {
+		uint32_t frames = 0;
+		while (!done) {
+			const AnimationAsset* asset = store.current(WEATHER_RAIN);
+			if (asset->owned) {
+				uint8_t shade = asset->frames[0][0];
+				for (uint8_t i = 0; i < store.frameCount(WEATHER_RAIN); i++) {
+					const uint8_t* frame = asset->frames[i];
+					if (frame[0] != shade || frame[ANIMATION_FRAME_BYTES - 1] != shade) {
+						torn++;
+					}
+				}
+			}
+			store.quiescent();
+			frames++;
+		}
+		printf("frame swap: %u renderer frames\n", (unsigned)frames);
+	});
+
+	writer.join();
+	renderer.join();
+
+	check(published > 0, "frame versions were published");
+	check(torn == 0, "renderer saw only whole frame versions");
+	check(store.bytesAllocated() <= (1 + ANIMATION_RETIRED_MAX) * store.frameCount(WEATHER_RAIN) * ANIMATION_FRAME_BYTES,
+	      "replaced frame versions were freed");
+	check(store.pool().highWater() <= store.pool().blockCount(), "frame pool high-water within its blocks");
+	store.reset();
+	check(store.pool().inUse() == 0, "every frame block went back to the pool");
+	printf("frame swap: %u of %u updates published\n", (unsigned)published, (unsigned)updates);
+}
+
+// Two tasks sharing a pool never get the same block, and every block comes back
+static void testSlabPool() {
+	const uint32_t rounds = 50000;
+	SlabPool pool(ANIMATION_FRAME_BYTES, 4);
+	std::atomic<uint32_t> clashes(0);
+
+	auto worker = [&](uint8_t mark) {
+		for (uint32_t i = 0; i < rounds; i++) {
+			uint8_t* block = (uint8_t*)pool.acquire();
+			if (block == nullptr) {
+				continue;
+			}
+			memset(block + sizeof(void*), mark, 16);
+			std::this_thread::yield();
+			if (block[sizeof(void*)] != mark || block[sizeof(void*) + 15] != mark) {
+				clashes++;
+			}
+			pool.release(block);
+		}
+	};
+	std::thread first(worker, 0xAA);
+	std::thread second(worker, 0x55);
+	first.join();
+	second.join();
+
+	uint8_t outside[ANIMATION_FRAME_BYTES];
+	check(clashes == 0, "pool handed out each block once");
+	check(pool.inUse() == 0, "pool got every block back");
+	check(pool.highWater() >= 1 && pool.highWater() <= 2, "pool high-water matches the tasks");
+	check(!pool.release(outside), "pool refused a foreign pointer");
+}
+
+// Both halves of a real instance start, run and stop while another task reads the state
+static void testPipeline() {
+	WeatherAnimations display("ssid", "password", "127.0.0.1", "token");
+	display.setAnimationMode(ANIMATION_EMBEDDED);
+	display.begin(OLED_SSD1306, 0x3C, false);
+
+	for (int round = 0; round < 3; round++) {
+		check(display.startPipeline(), "pipeline started");
+		check(display.pipelineRunning(), "pipeline running");
+
+		WeatherSnapshot snapshot;
+		uint32_t start = millis();
+		while (millis() - start < 200) {
+			display.readWeatherState(&snapshot);
+			std::this_thread::yield();
+		}
+
+		display.stopPipeline();
+		check(!display.pipelineRunning(), "pipeline stopped");
+	}
+}
+
+int main() {
+	testQueue();
+	testSeqLock();
+	testFrameSwap();
+	testSlabPool();
+	testPipeline();
+
+	if (failures != 0) {
+		printf("pipeline_stress: %d failures\n", failures);
+		return 1;
+	}
+	printf("pipeline_stress: OK\n");
+	return 0;
+}
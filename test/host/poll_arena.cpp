@@ -0,0 +1,253 @@
+// Checks that steady-state Home Assistant polling does not touch the general
+// heap. The library's allocation hooks (WA_TRACK_ALLOCATIONS) count calls,
+// and MockHomeAssistant on 127.0.0.1:8123 answers the polls from stack
+// buffers:
+//
+//   cmake -S . -B build && cmake --build build
+//   ctest --test-dir build -R poll_arena
+//
+// Exits non-zero if a poll after the warm-up allocates more than allowed or
+// a poll fails, and with 77 (skipped) when the hooks are not built in.
+
+#include "WeatherAnimations.h"
+#include "MockHomeAssistant.h"
+#include "HostTest.h"
+
+#include <stdio.h>
+
+using namespace WeatherAnimationsLib;
+
+// Allocations a whole tick() poll may make once warmed up
+#define TICK_POLL_MAX_ALLOCATIONS 0
+
+static MockHomeAssistant server;
+
+// Helper function for the number of allocations so far
+static uint32_t allocations() {
+	return getAllocStats().count;
+}
+
+// Configuration strings, kept like a sketch keeps them: the same pointers every poll
+static const char* const haIP = "127.0.0.1";
+static const char* const haToken = "token";
+static const char* const weatherEntity = "weather.forecast_home";
+static const char* const indoorEntity = "sensor.indoor_temperature";
+static const char* const outdoorEntity = "sensor.outdoor_temperature";
+static const char* const hourlyEntity = "weather.forecast_hourly";
+
+// Hourly forecast entries of the large weather response, about 7 kB
+#define LARGE_FORECAST_HOURS 48
+
+// Helper function to run one poll to completion
+static uint8_t runPoll(HAPoller& poller, const WeatherSnapshot& previous) {
+	poller.start(haIP, haToken, weatherEntity,
+	             indoorEntity, outdoorEntity, previous);
+	uint8_t result = HA_POLL_BUSY;
+	while (result == HA_POLL_BUSY) {
+		result = poller.step(millis());
+	}
+	return result;
+}
+
+// The step-wise poller reuses one arena block for every request
+static void testPoller() {
+	const int polls = 50;
+	HAPoller poller;
+	WeatherSnapshot snapshot;
+	clearWeatherSnapshot(&snapshot);
+
+	// The first poll allocates the arena block itself, which also shows the
+	// malloc() wrapper is in place
+	uint32_t warmUp = allocations();
+	check(runPoll(poller, snapshot) == HA_POLL_DONE, "warm-up poll succeeded");
+	check(allocations() > warmUp, "warm-up poll allocated the arena");
+	snapshot = poller.result();
+
+	uint32_t before = allocations();
+	int done = 0;
+	for (int i = 0; i < polls; i++) {
+		if (runPoll(poller, snapshot) == HA_POLL_DONE) {
+			done++;
+		}
+		snapshot = poller.result();
+	}
+	uint32_t allocated = allocations() - before;
+
+	check(done == polls, "every poll succeeded");
+	check(strcmp(snapshot.condition, "rainy") == 0, "weather condition parsed");
+	check(snapshot.indoorTemp == 21.5f && snapshot.outdoorTemp == 21.5f, "temperatures parsed");
+	check(allocated == 0, "steady-state polls did not allocate");
+	check(poller.arena().failures() == 0, "every buffer fit in the arena");
+	check(poller.templates().builds() == 1, "requests were built once, not per poll");
+	check(poller.arena().highWater() <= poller.arena().capacity(), "high-water mark within capacity");
+	printf("poller: %d polls, %u allocations, arena high-water %u of %u bytes\n", polls, (unsigned)allocated,
+	       (unsigned)poller.arena().highWater(), (unsigned)poller.arena().capacity());
+}
+
+// The blocking fetch functions share one arena block and one set of requests too
+static void testBlocking() {
+	const int polls = 20;
+	WeatherSnapshot snapshot;
+	clearWeatherSnapshot(&snapshot);
+	float temperature = 0;
+	check(fetchWeatherState(haIP, haToken, weatherEntity, &snapshot) &&
+	      fetchTemperatureState(haIP, haToken, indoorEntity, &temperature),
+	      "warm-up fetches succeeded");
+
+	uint32_t before = allocations();
+	int done = 0;
+	for (int i = 0; i < polls; i++) {
+		if (fetchWeatherState(haIP, haToken, weatherEntity, &snapshot) &&
+		    fetchTemperatureState(haIP, haToken, indoorEntity, &temperature)) {
+			done++;
+		}
+	}
+	uint32_t allocated = allocations() - before;
+
+	check(done == polls, "every blocking fetch succeeded");
+	check(temperature == 21.5f, "blocking temperature parsed");
+	check(allocated == 0, "steady-state blocking fetches did not allocate");
+	printf("blocking: %d fetches, %u allocations\n", polls * 2, (unsigned)allocated);
+}
+
+// A weather entity with an hourly forecast ahead of the attributes the
+// library reads is parsed as it streams in, in the same arena block
+static void testLargeResponse() {
+	server.setWeather(hourlyEntity, "partlycloudy", -2.5f, 4.0f, false, LARGE_FORECAST_HOURS);
+	HAPoller poller;
+	WeatherSnapshot snapshot;
+	clearWeatherSnapshot(&snapshot);
+	uint64_t sent = server.bytesSent();
+	poller.start(haIP, haToken, hourlyEntity, nullptr, nullptr, snapshot);
+	uint8_t result = HA_POLL_BUSY;
+	while (result == HA_POLL_BUSY) {
+		result = poller.step(millis());
+	}
+	sent = server.bytesSent() - sent;
+	snapshot = poller.result();
+
+	check(result == HA_POLL_DONE, "large weather poll succeeded");
+	check(sent > 6144, "weather response was larger than 6 kB");
+	check(strcmp(snapshot.condition, "partlycloudy") == 0, "large weather condition parsed");
+	check(snapshot.minForecastTemp == -2.5f && snapshot.maxForecastTemp == 4.0f && !snapshot.isDaytime,
+	      "attributes after the forecast parsed");
+	check(poller.arena().failures() == 0, "large response fit in the arena");
+
+	// The first blocking fetch of a new entity builds its request
+	check(fetchWeatherState(haIP, haToken, hourlyEntity, &snapshot), "large blocking warm-up fetch succeeded");
+	uint32_t before = allocations();
+	check(fetchWeatherState(haIP, haToken, hourlyEntity, &snapshot) &&
+	      strcmp(snapshot.condition, "partlycloudy") == 0, "large blocking fetch parsed");
+	check(allocations() == before, "large blocking fetch did not allocate");
+	printf("large: %u byte response, arena high-water %u of %u bytes\n", (unsigned)sent,
+	       (unsigned)poller.arena().highWater(), (unsigned)poller.arena().capacity());
+}
+
+// The scanner finds the same fields wherever the body is split
+static void testScanner() {
+	const char* body = "{\"entity_id\":\"weather.home\",\"state\":\"snowy\",\"attributes\":{\"forecast\":"
+	                   "[{\"state\":\"x\"}],\"forecast_temp_min\":-3.5,\"forecast_temp_max\":1,"
+	                   "\"is_daytime\":true}}";
+	size_t length = strlen(body);
+	bool same = true;
+	for (size_t split = 0; split <= length && same; split++) {
+		HAStateScanner scanner;
+		scanner.scan(body, split);
+		scanner.scan(body + split, length - split);
+		same = strcmp(scanner.field(HA_FIELD_STATE), "snowy") == 0 &&
+		       strcmp(scanner.field(HA_FIELD_MIN_TEMP), "-3.5") == 0 &&
+		       strcmp(scanner.field(HA_FIELD_MAX_TEMP), "1") == 0 &&
+		       strcmp(scanner.field(HA_FIELD_DAYTIME), "true") == 0;
+	}
+	check(same, "fields found wherever the body is split");
+}
+
+// A display polling through a data hub in tick() mode: the whole poll, from
+// the network task to the published snapshot, stays within a fixed budget
+static void testTickPolls() {
+	const uint32_t polls = 20;
+	WeatherDataHub hub(haIP, haToken);
+	hub.setWeatherEntity(weatherEntity);
+	hub.setTemperatureEntities(indoorEntity, outdoorEntity);
+	hub.setFetchInterval(1);
+	WiFi.hostSetStatus(WL_CONNECTED);
+	WeatherAnimations animations("host", "host", haIP, haToken);
+	animations.setMode(CONTINUOUS_WEATHER);
+	animations.setAnimationMode(ANIMATION_EMBEDDED);
+	animations.setDataHub(&hub);
+	animations.begin(OLED_SSD1306, 0x3C, false);
+
+	// Helper lambda to tick until the hub has finished a number of polls
+	auto tickUntil = [&](uint32_t fetches) {
+		uint32_t start = millis();
+		while (hub.fetchCount() < fetches && millis() - start < 5000) {
+			animations.tick(millis());
+		}
+	};
+	tickUntil(2);
+
+	resetAllocStats();
+	uint32_t first = hub.fetchCount();
+	tickUntil(first + polls);
+	AllocStats stats = getAllocStats();
+	uint32_t done = hub.fetchCount() - first;
+
+	check(done >= polls, "tick polls completed");
+	check(strcmp(hub.snapshot().condition, "rainy") == 0, "tick poll parsed the weather");
+	check(stats.count <= done * TICK_POLL_MAX_ALLOCATIONS, "tick polls stay within their allocation budget");
+	check(stats.scopes[PERF_HTTP].count == 0 && stats.scopes[PERF_PARSE].count == 0, "requests and parsing do not allocate");
+	check(stats.scopes[PERF_RENDER].count == 0 && stats.scopes[PERF_FLUSH].count == 0, "frames between polls do not allocate");
+	printf("tick: %u polls, %u allocations\n", (unsigned)done, (unsigned)stats.count);
+	hub.removeDisplay(&animations);
+	animations.setDataHub(nullptr);
+	WiFi.hostSetStatus(WL_DISCONNECTED);
+}
+
+// Arena bookkeeping on its own
+static void testArena() {
+	PollArena arena(64);
+	check(arena.used() == 0 && arena.highWater() == 0, "arena starts empty");
+
+	uint8_t* first = (uint8_t*)arena.allocate(3);
+	uint8_t* second = (uint8_t*)arena.allocate(8);
+	check(first != nullptr && second != nullptr, "small allocations fit");
+	check(((uintptr_t)second % POLL_ARENA_ALIGN) == 0, "allocations are aligned");
+	check(second >= first + 3, "allocations do not overlap");
+	check(arena.allocate(64) == nullptr && arena.failures() == 1, "oversized allocation refused");
+
+	size_t high = arena.highWater();
+	arena.reset();
+	check(arena.used() == 0 && arena.highWater() == high, "reset keeps the high-water mark");
+	check(arena.allocate(3) == first, "reset reuses the same memory");
+}
+
+int main() {
+	printf("poll_arena: start\n");
+	if (!allocTracking()) {
+		printf("poll_arena: skipped, built without WA_TRACK_ALLOCATIONS\n");
+		return 77;
+	}
+	testArena();
+	testScanner();
+
+	if (!server.start(8123)) {
+		printf("poll_arena: cannot listen on 127.0.0.1:8123\n");
+		return 1;
+	}
+	server.setWeather(weatherEntity, "rainy", 3.5f, 9.0f, true);
+	server.setTemperature(indoorEntity, 21.5f);
+	server.setTemperature(outdoorEntity, 21.5f);
+
+	testPoller();
+	testBlocking();
+	testTickPolls();
+	testLargeResponse();
+	server.stop();
+
+	if (failures != 0) {
+		printf("poll_arena: %d failures\n", failures);
+		return 1;
+	}
+	printf("poll_arena: OK (%u requests served)\n", (unsigned)server.requests());
+	return 0;
+}
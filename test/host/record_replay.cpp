@@ -0,0 +1,256 @@
+// Records a session against MockHomeAssistant on 127.0.0.1:8123 in real
+// time: weather changes, a slow server, a stalled response and button and
+// encoder events. Then replays the recording twice on a VirtualClock with
+// the server stopped, and checks both replays draw the same screens at the
+// same virtual times, in the order the recording drew them and at about the
+// same times, and hand the sketch the same input events. Downloads are
+// recorded and answered the same way, and a full buffer ends the recording
+// cleanly:
+//
+//   cmake -S . -B build && cmake --build build
+//   ctest --test-dir build -R record_replay
+//
+// The recording is left at the path given as the first argument, for
+// build/replay_session. Exits non-zero on the first inconsistency. Takes
+// about 5 seconds of real time.
+
+#include "WeatherAnimations.h"
+#include "HostTest.h"
+#include "MockHomeAssistant.h"
+#include "SessionReplay.h"
+#include "TestPNG.h"
+
+#include <stdio.h>
+#include <string>
+#include <unistd.h>
+
+using namespace WeatherAnimationsLib;
+
+// Poll interval of the recording, in ms
+#define REPLAY_POLL_INTERVAL 200
+
+// How far a replayed screen may be from when it was recorded, in ms: the
+// recording's ticks run late on a loaded machine, the replay's never do
+#define REPLAY_SLACK 100
+
+// Recording buffer for the session
+#define REPLAY_RECORD_BYTES 65536
+
+// Events the sketch was handed, one "type id steps" entry each
+static void logInput(const InputEvent& event, void* context) {
+	char entry[32];
+	snprintf(entry, sizeof(entry), "%u %u %d;", (unsigned)event.type, (unsigned)event.id, (int)event.steps);
+	((std::string*)context)->append(entry);
+}
+
+// Helper function to run tick() for a while in real time, noting each new
+// screen in ms since the recording started
+static void runFor(WeatherAnimations& animations, uint32_t duration, uint32_t start,
+                   std::vector<SessionReplay::Screen>* screens) {
+	uint32_t begin = millis();
+	while (millis() - begin < duration) {
+		uint32_t now = millis();
+		uint32_t next = animations.tick(now);
+		uint32_t hash = frameHash();
+		if (hash != screens->back().hash) {
+			screens->push_back({now - start, hash});
+		}
+		if ((int32_t)(next - now) > 0) {
+			usleep(1000);
+		}
+	}
+}
+
+// Helper function to hand an event to the input manager as a pin would
+static void press(InputManager& input, uint8_t type, uint8_t id, int8_t steps) {
+	InputEvent event;
+	event.type = type;
+	event.id = id;
+	event.steps = steps;
+	event.time = millis();
+	input.inject(event);
+}
+
+// Helper function to tell whether two runs drew the same, timings aside
+static bool sameProfile(const ReplayProfile& a, const ReplayProfile& b) {
+	ReplayProfile first = a;
+	ReplayProfile second = b;
+	first.renderP99 = second.renderP99 = 0;
+	first.flushP99 = second.flushP99 = 0;
+	return memcmp(&first, &second, sizeof(first)) == 0;
+}
+
+static void testSession(const char* path) {
+	MockHomeAssistant server;
+	check(server.start(8123), "mock Home Assistant listening on 127.0.0.1:8123");
+	if (failures != 0) {
+		return;
+	}
+	server.setDefaultEntities();
+	WiFi.hostSetStatus(WL_CONNECTED);
+
+	check(recordStart(nullptr, REPLAY_RECORD_BYTES), "recording started");
+	const uint8_t* header = recordBuffer();
+	uint32_t start = header[5] | (header[6] << 8) | (header[7] << 16) | ((uint32_t)header[8] << 24);
+
+	// Static icons, so the pixels only change when the weather does
+	std::string recordedInput;
+	std::vector<SessionReplay::Screen> recorded;
+	{
+		WeatherDataHub hub("127.0.0.1", "token");
+		hub.setFetchInterval(REPLAY_POLL_INTERVAL);
+		InputManager input;
+		WeatherAnimations animations("host", "host", "127.0.0.1", "token");
+		animations.setMode(CONTINUOUS_WEATHER);
+		animations.setAnimationMode(ANIMATION_STATIC);
+		animations.setInput(&input, logInput, &recordedInput);
+		animations.setDataHub(&hub);
+		animations.begin(OLED_SSD1306, 0x3C, false);
+		recorded.push_back({(uint32_t)(millis() - start), frameHash()});
+
+		runFor(animations, 3 * REPLAY_POLL_INTERVAL, start, &recorded);
+		server.toggleWeather();
+		runFor(animations, 3 * REPLAY_POLL_INTERVAL, start, &recorded);
+		press(input, INPUT_PRESSED, 1, 0);
+		runFor(animations, 50, start, &recorded);
+		press(input, INPUT_RELEASED, 1, 0);
+
+		// A slow server, then a weather response that stalls part way
+		MockHAFaults faults;
+		clearMockHAFaults(&faults);
+		faults.latency = 40;
+		faults.jitter = 20;
+		server.setFaults(faults);
+		server.toggleWeather();
+		runFor(animations, 4 * REPLAY_POLL_INTERVAL, start, &recorded);
+		clearMockHAFaults(&faults);
+		faults.pathPrefix = "/api/states/weather.";
+		faults.stallAfter = 40;
+		faults.stall = 600;
+		server.setFaults(faults);
+		server.toggleWeather();
+		runFor(animations, 6 * REPLAY_POLL_INTERVAL, start, &recorded);
+		server.clearFaults();
+		press(input, INPUT_ROTATED, 2, -3);
+		runFor(animations, 3 * REPLAY_POLL_INTERVAL, start, &recorded);
+		recordStop();
+	}
+	WiFi.hostSetStatus(WL_DISCONNECTED);
+	server.stop();
+
+	check(!recordOverflowed(), "the session fits the buffer");
+	check(recordWriteFile(path), "recording written");
+	printf("recorded %u bytes, %u screens, input \"%s\"\n", (unsigned)recordLength(), (unsigned)recorded.size(),
+	       recordedInput.c_str());
+
+	// Replayed from the file, with nothing listening on the port
+	SessionReplay replay;
+	check(replay.loadFile(path), "recording read back");
+	const RecordedSession& session = replay.session();
+	check(session.hasBegin && session.hub && session.displayType == OLED_SSD1306, "begin() settings recorded");
+	check(session.pollInterval == REPLAY_POLL_INTERVAL, "poll interval recorded");
+	check(session.connections > 0 && session.inputs == 3, "connections and inputs recorded");
+
+	std::string firstInput;
+	std::string secondInput;
+	ReplayProfile first;
+	ReplayProfile second;
+	check(replay.run(&first, logInput, &firstInput), "first replay ran");
+	std::vector<SessionReplay::Screen> screens = replay.screens();
+	check(replay.run(&second, logInput, &secondInput), "second replay ran");
+	printReplayProfile(first);
+
+	check(sameProfile(first, second), "both replays draw the same frames at the same times");
+	check(screens.size() == replay.screens().size(), "both replays draw the same screens");
+	check(firstInput == recordedInput && secondInput == recordedInput, "replays hand over the recorded input");
+	check(first.unanswered == 0, "every connection answered from the recording");
+	check(first.connections == session.connections, "every recorded connection replayed");
+	check(first.inputs == 3, "every input replayed");
+
+	bool sameScreens = screens.size() == recorded.size();
+	for (size_t i = 0; sameScreens && i < screens.size(); i++) {
+		int32_t offset = (int32_t)(screens[i].time - recorded[i].time);
+		if (screens[i].hash != recorded[i].hash || offset > REPLAY_SLACK || offset < -REPLAY_SLACK) {
+			printf("screen %u: recorded at %u ms, replayed at %u ms\n", (unsigned)i, (unsigned)recorded[i].time,
+			       (unsigned)screens[i].time);
+			sameScreens = false;
+		}
+	}
+	check(sameScreens, "replays draw the recorded screens at about the recorded times");
+
+	// Profiles round-trip through their files and compare
+	std::string profilePath = std::string(path) + ".txt";
+	ReplayProfile loaded;
+	check(writeReplayProfile(profilePath.c_str(), first) && loadReplayProfile(profilePath.c_str(), &loaded),
+	      "profile written and read back");
+	check(memcmp(&loaded, &first, sizeof(loaded)) == 0, "profile read back unchanged");
+	check(compareReplayProfiles(first, second, 0) == 0, "replays do not regress against each other");
+	second.busBytes++;
+	check(compareReplayProfiles(first, second, 0) == 1, "more bus bytes are a regression");
+	remove(profilePath.c_str());
+}
+
+// Downloads are recorded with their status and body and answered from the
+// recording without a server
+static void testDownloads() {
+	static uint8_t png[4096];
+	size_t pngSize = makeTestPNG(png, sizeof(png), TEST_PNG_STRIPES, 7);
+	MockHomeAssistant server;
+	check(pngSize > 0 && server.start(8123), "mock Home Assistant serving a frame");
+	if (failures != 0) {
+		return;
+	}
+	server.setAsset("/frames/sunny/000.png", png, pngSize);
+	WiFi.hostSetStatus(WL_CONNECTED);
+
+	uint8_t* data;
+	size_t size;
+	check(recordStart(), "recording started");
+	bool served = fetchAnimationFrame("http://127.0.0.1:8123/frames/sunny/", 0, &data, &size);
+	check(served && size == pngSize && memcmp(data, png, size) == 0, "frame downloaded");
+	delete[] data;
+	check(!fetchAnimationFrame("http://127.0.0.1:8123/frames/missing/", 0, &data, &size), "missing frame fails");
+	recordStop();
+	std::vector<uint8_t> recording(recordBuffer(), recordBuffer() + recordLength());
+
+	// A buffer too small for the frame ends the recording before it
+	SessionReplay replay;
+	check(recordStart(nullptr, 64), "small recording started");
+	served = fetchAnimationFrame("http://127.0.0.1:8123/frames/sunny/", 0, &data, &size);
+	recordStop();
+	if (served) {
+		delete[] data;
+	}
+	check(recordOverflowed() && !recordActive(), "a full buffer stops the recording");
+	check(replay.load(recordBuffer(), recordLength()) && replay.session().fetches == 0,
+	      "a full recording still loads");
+	server.stop();
+
+	check(replay.load(recording.data(), recording.size()), "recording loaded");
+	check(replay.session().fetches == 2 && replay.session().bytes == pngSize, "both downloads recorded");
+	VirtualClock clock(1000);
+	replay.attach(&clock);
+	served = fetchAnimationFrame("http://127.0.0.1:8123/frames/sunny/", 0, &data, &size);
+	check(served && size == pngSize && memcmp(data, png, size) == 0, "frame answered from the recording");
+	if (served) {
+		delete[] data;
+	}
+	check(!fetchAnimationFrame("http://127.0.0.1:8123/frames/missing/", 0, &data, &size),
+	      "missing frame fails again");
+	replay.detach();
+	recordRelease();
+	WiFi.hostSetStatus(WL_DISCONNECTED);
+}
+
+int main(int argc, char** argv) {
+	printf("record_replay: start\n");
+	testSession(argc > 1 ? argv[1] : "record_replay.warc");
+	testDownloads();
+
+	if (failures != 0) {
+		printf("record_replay: %d failures\n", failures);
+		return 1;
+	}
+	printf("record_replay: OK\n");
+	return 0;
+}
@@ -0,0 +1,297 @@
+// Soak test: weeks of simulated operation on a VirtualClock, checking that
+// the heap neither grows nor fragments. A mock Home Assistant on
+// 127.0.0.1:8123 answers a poll every five minutes, with the weather
+// changing every hour and day turning to night. A TFT display downloads
+// every animation's PNG frames from it when begun, and an OLED display runs
+// a transition every three hours. Every day the server gets new frames for
+// one animation, the frame URLs are set again and both displays are begun
+// again; every week the TFT display is destroyed and made anew. The heap is
+// sampled every simulated hour:
+//
+//   cmake -S . -B build && cmake --build build
+//   ctest --test-dir build -R soak      (4 weeks)
+//   build/soak 52                       (a year)
+//
+// After eight days of warm-up, exits non-zero if used bytes trend upwards, the
+// last quarter of the run needs more heap or free blocks than the first,
+// the largest free block shrinks, or the frame and icon pools hold more
+// blocks than they did.
+
+#include "WeatherAnimations.h"
+#include "HostTest.h"
+#include "MockHomeAssistant.h"
+#include "TestPNG.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+using namespace WeatherAnimationsLib;
+
+#define MINUTE 60000UL
+#define HOUR (60 * MINUTE)
+#define DAY (24 * HOUR)
+
+// Weeks ctest runs; a different number can be given on the command line
+#define SOAK_DEFAULT_WEEKS 4
+
+// Hours of warm-up before the heap is expected to stay flat: up to a day
+// after the first time the TFT display is made anew, whose replacement
+// the allocator places elsewhere
+#define SOAK_WARMUP_HOURS (8 * 24)
+
+// Growth allowed over the whole run, in bytes: allocator rounding and the
+// host's own buffers, well under one leaked frame or response per day
+#define SOAK_GROWTH_LIMIT 4096
+
+static const char* const weatherEntity = MOCK_HA_WEATHER_ENTITY;
+static const char* const indoorEntity = MOCK_HA_INDOOR_ENTITY;
+static const char* const outdoorEntity = MOCK_HA_OUTDOOR_ENTITY;
+
+// Home Assistant conditions the hours cycle through, several per animation
+static const char* const haConditions[] = {"sunny", "partlycloudy", "cloudy", "rainy", "pouring", "fog",
+                                           "snowy", "snowy-rainy", "lightning", "lightning-rainy", "windy"};
+
+// Frame URLs by animation; the library fetches "<url>000.png" onwards. The
+// first poll replaces them with the icon URLs for the conditions it maps,
+// so they are set again before each begin()
+static const char* const frameURLs[] = {
+	"http://127.0.0.1:8123/local/frames/clear_", "http://127.0.0.1:8123/local/frames/cloudy_",
+	"http://127.0.0.1:8123/local/frames/rain_", "http://127.0.0.1:8123/local/frames/snow_",
+	"http://127.0.0.1:8123/local/frames/storm_"};
+
+// Three frames per animation, in two versions the server swaps between
+#define SOAK_FRAMES 3
+#define SOAK_PNG_BYTES 2048
+static uint8_t pngs[2][5][SOAK_FRAMES][SOAK_PNG_BYTES];
+static size_t pngSizes[2][5][SOAK_FRAMES];
+
+struct Sample {
+	HeapStats heap;
+	uint32_t allocations;
+	uint16_t framesInUse;
+	uint16_t iconsInUse;
+};
+
+// Helper function to serve one version of an animation's frames
+static void serveFrames(MockHomeAssistant& server, uint8_t condition, uint8_t version) {
+	for (uint8_t frame = 0; frame < SOAK_FRAMES; frame++) {
+		char path[MOCK_HA_PATH_LENGTH];
+		snprintf(path, sizeof(path), "%s%03d.png", frameURLs[condition] + strlen("http://127.0.0.1:8123"), frame);
+		server.setAsset(path, pngs[version][condition][frame], pngSizes[version][condition][frame]);
+	}
+}
+
+// Helper function for the weather Home Assistant reports in a given hour
+static void setWeather(MockHomeAssistant& server, uint32_t hour) {
+	uint32_t hourOfDay = hour % 24;
+	// Changes every hour, in an order that does not repeat daily
+	const char* condition = haConditions[(hour * 7 + hour / 24) % (sizeof(haConditions) / sizeof(haConditions[0]))];
+	float swing = (float)(hourOfDay < 12 ? hourOfDay : 24 - hourOfDay);
+	server.setWeather(weatherEntity, condition, 2.0f + swing / 4, 9.0f + swing / 2, hourOfDay >= 7 && hourOfDay < 19);
+	server.setTemperature(indoorEntity, 20.0f + (hour % 5) / 2.0f);
+	server.setTemperature(outdoorEntity, 3.0f + swing / 2);
+}
+
+// Helper function to (re)start the TFT display, which downloads every animation's frames
+static void beginTFT(WeatherAnimations* tft) {
+	for (uint8_t condition = 0; condition < 5; condition++) {
+		tft->setOnlineAnimationSource(condition, frameURLs[condition]);
+	}
+	tft->begin(TFT_DISPLAY, 0, false);
+}
+
+// Helper function to make and start the TFT display
+static WeatherAnimations* makeTFT(WeatherDataHub& hub, VirtualClock& clock) {
+	WeatherAnimations* tft = new WeatherAnimations("host", "host", "127.0.0.1", "token");
+	tft->setClock(&clock);
+	tft->setMode(CONTINUOUS_WEATHER);
+	tft->setAnimationMode(ANIMATION_ONLINE);
+	tft->setDataHub(&hub);
+	beginTFT(tft);
+	return tft;
+}
+
+// Helper function to run both displays' tick() loops for a while, moving
+// the clock to the earlier of their next wakeups
+static void runFor(VirtualClock& clock, WeatherAnimations* tft, WeatherAnimations* oled, uint32_t duration) {
+	uint32_t end = clock.millis() + duration;
+	while ((int32_t)(clock.millis() - end) < 0) {
+		uint32_t now = clock.millis();
+		uint32_t nextTFT = tft->tick(now);
+		uint32_t nextOLED = oled->tick(now);
+		uint32_t next = (int32_t)(nextTFT - nextOLED) < 0 ? nextTFT : nextOLED;
+		if ((int32_t)(next - now) > 0) {
+			clock.set((int32_t)(next - end) < 0 ? next : end);
+		}
+	}
+}
+
+// Helper function for the least-squares slope of used bytes, per sample
+static double usedSlope(const std::vector<Sample>& samples, size_t first) {
+	double n = (double)(samples.size() - first);
+	double sumX = 0, sumY = 0, sumXY = 0, sumXX = 0;
+	for (size_t i = first; i < samples.size(); i++) {
+		double x = (double)(i - first);
+		double y = (double)samples[i].heap.used;
+		sumX += x;
+		sumY += y;
+		sumXY += x * y;
+		sumXX += x * x;
+	}
+	double denominator = n * sumXX - sumX * sumX;
+	return denominator != 0 ? (n * sumXY - sumX * sumY) / denominator : 0;
+}
+
+// Highest and lowest values of one field over a range of samples
+struct Range {
+	uint32_t low;
+	uint32_t high;
+};
+
+static Range range(const std::vector<Sample>& samples, size_t first, size_t last, uint32_t (*field)(const Sample&)) {
+	Range result = {0xFFFFFFFFUL, 0};
+	for (size_t i = first; i < last; i++) {
+		uint32_t value = field(samples[i]);
+		result.low = value < result.low ? value : result.low;
+		result.high = value > result.high ? value : result.high;
+	}
+	return result;
+}
+
+static uint32_t usedOf(const Sample& sample) { return sample.heap.used; }
+static uint32_t freeOf(const Sample& sample) { return sample.heap.free; }
+static uint32_t largestOf(const Sample& sample) { return sample.heap.largestFree; }
+static uint32_t framesOf(const Sample& sample) { return sample.framesInUse; }
+static uint32_t iconsOf(const Sample& sample) { return sample.iconsInUse; }
+
+static void soak(uint32_t weeks) {
+	for (uint8_t version = 0; version < 2; version++) {
+		for (uint8_t condition = 0; condition < 5; condition++) {
+			for (uint8_t frame = 0; frame < SOAK_FRAMES; frame++) {
+				pngSizes[version][condition][frame] =
+					makeTestPNG(pngs[version][condition][frame], SOAK_PNG_BYTES, TEST_PNG_STRIPES,
+					            version * 16 + condition * 3 + frame);
+			}
+		}
+	}
+
+	MockHomeAssistant server;
+	check(server.start(8123), "mock Home Assistant listening on 127.0.0.1:8123");
+	if (failures != 0) {
+		return;
+	}
+	for (uint8_t condition = 0; condition < 5; condition++) {
+		serveFrames(server, condition, 0);
+	}
+	setWeather(server, 0);
+	WiFi.hostSetStatus(WL_CONNECTED);
+
+	// Sampled every hour; reserved now so the test itself adds nothing later
+	const uint32_t hours = weeks * 7 * 24;
+	std::vector<Sample> samples;
+	samples.reserve(hours);
+
+	VirtualClock clock(0);
+	WeatherDataHub hub("127.0.0.1", "token");
+	hub.setClock(&clock);
+	WeatherAnimations* tft = makeTFT(hub, clock);
+	WeatherAnimations oled("host", "host", "127.0.0.1", "token");
+	oled.setClock(&clock);
+	oled.setMode(CONTINUOUS_WEATHER);
+	oled.setAnimationMode(ANIMATION_STATIC);
+	oled.setDataHub(&hub);
+	oled.begin(OLED_SSD1306, 0x3C, false);
+
+	uint32_t wallStart = millis();
+	uint32_t dayAllocations = getAllocStats().count;
+	uint32_t dayPolls = hub.fetchCount();
+	printf("%5s %9s %9s %9s %9s %8s %6s\n", "day", "used", "peak", "free", "largest", "allocs", "polls");
+	for (uint32_t hour = 0; hour < hours; hour++) {
+		setWeather(server, hour);
+		if (hour % 3 == 0) {
+			oled.runTransition(hour % 5, hour % 4, 1000);
+		}
+		if (hour % 24 == 12) {
+			// New frames for one animation; every animation is fetched again
+			uint8_t condition = (hour / 24) % 5;
+			serveFrames(server, condition, (hour / 24 / 5 + 1) % 2);
+			beginTFT(tft);
+			oled.begin(OLED_SSD1306, 0x3C, false);
+		}
+		if (hour % (7 * 24) == 0 && hour > 0) {
+			delete tft;
+			tft = makeTFT(hub, clock);
+		}
+		runFor(clock, tft, &oled, HOUR);
+
+		Sample sample;
+		sample.heap = getHeapStats();
+		sample.allocations = getAllocStats().count;
+		sample.framesInUse = tft->framePool().inUse();
+		sample.iconsInUse = tft->iconPool().inUse();
+		samples.push_back(sample);
+
+		if (hour % 24 == 23) {
+			printf("%5u %9u %9u %9u %9u %8u %6u\n", (unsigned)(hour / 24 + 1), (unsigned)sample.heap.used,
+			       (unsigned)sample.heap.peak, (unsigned)sample.heap.free, (unsigned)sample.heap.largestFree,
+			       (unsigned)(sample.allocations - dayAllocations), (unsigned)(hub.fetchCount() - dayPolls));
+			dayAllocations = sample.allocations;
+			dayPolls = hub.fetchCount();
+		}
+	}
+	uint32_t wall = millis() - wallStart;
+
+	check(hub.fetchCount() >= hours * 12 && hub.fetchCount() <= hours * 12 + 1, "a poll every five minutes");
+	check(server.assetRequests() >= weeks * 7 * 5, "frames downloaded again every day");
+	check(hub.snapshot().hasCondition && hub.snapshot().hasTemperatureData, "live weather at the end");
+
+	// Compared after the warm-up: the first and last quarters of the rest
+	size_t first = SOAK_WARMUP_HOURS < hours / 2 ? SOAK_WARMUP_HOURS : hours / 2;
+	size_t quarter = (samples.size() - first) / 4;
+	size_t lastStart = samples.size() - quarter;
+	double growth = usedSlope(samples, first) * (double)(samples.size() - first);
+	Range usedFirst = range(samples, first, first + quarter, usedOf);
+	Range usedLast = range(samples, lastStart, samples.size(), usedOf);
+	Range freeFirst = range(samples, first, first + quarter, freeOf);
+	Range freeLast = range(samples, lastStart, samples.size(), freeOf);
+	Range largestFirst = range(samples, first, first + quarter, largestOf);
+	Range largestLast = range(samples, lastStart, samples.size(), largestOf);
+	check(growth <= SOAK_GROWTH_LIMIT, "used bytes do not trend upwards");
+	check(usedLast.high <= usedFirst.high + SOAK_GROWTH_LIMIT, "the last quarter needs no more heap than the first");
+	check(samples.back().heap.peak <= samples[first].heap.peak + SOAK_GROWTH_LIMIT, "peak heap settles after warm-up");
+	check(freeLast.high <= freeFirst.high + SOAK_GROWTH_LIMIT, "free blocks between allocations do not pile up");
+	check(largestLast.low + SOAK_GROWTH_LIMIT >= largestFirst.low, "the largest free block does not shrink");
+	check(range(samples, lastStart, samples.size(), framesOf).high <= range(samples, first, first + quarter, framesOf).high,
+	      "frame pool holds no more blocks than it did");
+	check(range(samples, lastStart, samples.size(), iconsOf).high <= range(samples, first, first + quarter, iconsOf).high,
+	      "icon pool holds no more blocks than it did");
+
+	printf("soak: %u weeks, %u polls, %u frame downloads, %llu bytes served in %u ms\n", (unsigned)weeks,
+	       (unsigned)hub.fetchCount(), (unsigned)server.assetRequests(), (unsigned long long)server.bytesSent(),
+	       (unsigned)wall);
+	printf("soak: used %+.0f bytes over the run by trend, first quarter %u..%u, last quarter %u..%u\n", growth,
+	       (unsigned)usedFirst.low, (unsigned)usedFirst.high, (unsigned)usedLast.low, (unsigned)usedLast.high);
+
+	delete tft;
+	hub.removeDisplay(&oled);
+	WiFi.hostSetStatus(WL_DISCONNECTED);
+	server.stop();
+}
+
+int main(int argc, char** argv) {
+	uint32_t weeks = argc > 1 ? (uint32_t)atoi(argv[1]) : SOAK_DEFAULT_WEEKS;
+	if (weeks == 0) {
+		printf("usage: soak [weeks]\n");
+		return 2;
+	}
+	printf("soak: start, %u weeks\n", (unsigned)weeks);
+	soak(weeks);
+
+	if (failures != 0) {
+		printf("soak: %d failures\n", failures);
+		return 1;
+	}
+	printf("soak: OK\n");
+	return 0;
+}
@@ -0,0 +1,190 @@
+// Checks the text the screens draw against Adafruit GFX print(): the text
+// cache draws what print() draws, at any row, whether the string was cached
+// or not, and evicts the least recently used string first. Digits from the
+// digit fonts leave the pixels around them alone, as print() without a
+// background colour does, and are only opaque when asked to be. Whole OLED
+// screens keep every pixel of the weather icon under the temperature lines:
+//
+//   cmake -S . -B build && cmake --build build
+//   ctest --test-dir build -R text_render
+//
+// Exits non-zero on the first inconsistency.
+
+#include "WeatherAnimations.h"
+#include "HostTest.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace WeatherAnimationsLib;
+
+#define CANVAS_WIDTH 128
+#define CANVAS_HEIGHT 64
+#define CANVAS_BYTES (CANVAS_WIDTH * CANVAS_HEIGHT / 8)
+
+static const char* const conditions[] = {"sunny", "cloudy", "rainy", "snowy", "lightning"};
+
+// Helper function to fill a canvas with a pattern that shows every pixel a draw touches
+static void fillPattern(OLEDCanvas& canvas) {
+	canvas.clearDisplay();
+	for (int16_t y = 0; y < CANVAS_HEIGHT; y++) {
+		for (int16_t x = 0; x < CANVAS_WIDTH; x++) {
+			if ((x * 7 + y * 3) % 5 == 0) {
+				canvas.drawPixel(x, y, SSD1306_WHITE);
+			}
+		}
+	}
+}
+
+// Helper function to draw text with print() at a text size, cut off at the
+// right edge as drawDigits() does instead of wrapped
+static void printText(OLEDCanvas& canvas, int16_t x, int16_t y, const char* text, uint8_t size, uint16_t color,
+                      uint16_t background) {
+	canvas.setTextWrap(false);
+	canvas.setTextSize(size);
+	canvas.setTextColor(color, background);
+	canvas.setCursor(x, y);
+	canvas.print(text);
+}
+
+// Helper function to draw a string through the cache and with print() over
+// the same background; true if both draw the same pixels and advance alike
+static bool drawsLikePrint(TextCache& cache, const char* text, int16_t x, int16_t y, uint8_t size,
+                           uint16_t color = SSD1306_WHITE) {
+	static OLEDCanvas cached(CANVAS_WIDTH, CANVAS_HEIGHT);
+	static OLEDCanvas printed(CANVAS_WIDTH, CANVAS_HEIGHT);
+	fillPattern(cached);
+	fillPattern(printed);
+	int16_t advance = cache.draw(&cached, x, y, text, size, color);
+	printText(printed, x, y, text, size, color, color);
+	return advance == printed.getCursorX() - x && memcmp(cached.getBuffer(), printed.getBuffer(), CANVAS_BYTES) == 0;
+}
+
+// Cached strings are reused, evicted least recently used first, and draw
+// the same pixels as print() on every row
+static void testTextCache() {
+	static const char* const strings[] = {"Weather:", "Sunny", "In:", "  Out:", "Min:", " Max:"};
+	TextCache cache(4);
+	bool same = true;
+	for (uint8_t i = 0; i < 4; i++) {
+		same = same && drawsLikePrint(cache, strings[i], 0, 0, 1);
+	}
+	check(cache.misses() == 4 && cache.hits() == 0 && cache.entryCount() == 4, "first draws rasterise");
+
+	// strings[0] is used again, so strings[1] is now the oldest
+	same = same && drawsLikePrint(cache, strings[0], 5, 13, 1);
+	check(cache.hits() == 1, "second draw is a hit");
+	same = same && drawsLikePrint(cache, strings[4], 7, 45, 1);
+	check(cache.evictions() == 1 && cache.entryCount() == 4, "a fifth string evicts one");
+	same = same && drawsLikePrint(cache, strings[0], 60, 21, 1);
+	same = same && drawsLikePrint(cache, strings[2], 100, 57, 1);
+	check(cache.hits() == 3 && cache.misses() == 5, "recent strings stay cached");
+	same = same && drawsLikePrint(cache, strings[1], 0, 8, 1);
+	check(cache.misses() == 6, "least recently used string was evicted");
+
+	// strings[3] was the oldest then, and strings[4] is now
+	same = same && drawsLikePrint(cache, strings[3], -5, 61, 1);
+	check(cache.misses() == 7 && cache.evictions() == 3, "oldest string evicted again");
+	same = same && drawsLikePrint(cache, strings[0], 3, 30, 2);
+	same = same && drawsLikePrint(cache, strings[1], 40, 19, 1, SSD1306_BLACK);
+	same = same && drawsLikePrint(cache, strings[1], 40, 19, 1, SSD1306_INVERSE);
+	same = same && drawsLikePrint(cache, strings[3], 11, 34, 1);
+	check(cache.hits() == 6 && cache.misses() == 8, "strings cached by size, not by colour");
+	same = same && drawsLikePrint(cache, strings[4], 0, 0, 1);
+	check(cache.misses() == 9, "oldest string went next");
+	check(same, "cached text draws like print() at aligned and unaligned rows");
+
+	// The byte limit evicts as well
+	TextCache small(16, 64);
+	for (const char* text : strings) {
+		same = drawsLikePrint(small, text, 1, 3, 1) && same;
+	}
+	check(small.bytesUsed() <= 64 && small.evictions() > 0, "byte limit evicts");
+	check(same, "text draws like print() under the byte limit");
+}
+
+// drawDigits() matches print() at the same positions, over a background
+static void testDigits() {
+	static const char* const texts[] = {"21.5C", "-4.0", "8.0C", "1234567890"};
+	static const int16_t positions[][2] = {{0, 0}, {3, 16}, {50, 45}, {90, 53}, {-4, 60}};
+	OLEDCanvas digits(CANVAS_WIDTH, CANVAS_HEIGHT);
+	OLEDCanvas printed(CANVAS_WIDTH, CANVAS_HEIGHT);
+	bool transparent = true;
+	bool black = true;
+	bool opaque = true;
+	for (uint8_t font = DIGIT_FONT_SMALL; font <= DIGIT_FONT_LARGE; font++) {
+		for (const char* text : texts) {
+			for (const auto& position : positions) {
+				int16_t x = position[0];
+				int16_t y = position[1];
+				fillPattern(digits);
+				fillPattern(printed);
+				drawDigits(&digits, x, y, text, font);
+				printText(printed, x, y, text, font + 1, SSD1306_WHITE, SSD1306_WHITE);
+				transparent = transparent && memcmp(digits.getBuffer(), printed.getBuffer(), CANVAS_BYTES) == 0;
+
+				fillPattern(digits);
+				fillPattern(printed);
+				drawDigits(&digits, x, y, text, font, SSD1306_BLACK);
+				printText(printed, x, y, text, font + 1, SSD1306_BLACK, SSD1306_BLACK);
+				black = black && memcmp(digits.getBuffer(), printed.getBuffer(), CANVAS_BYTES) == 0;
+
+				fillPattern(digits);
+				fillPattern(printed);
+				drawDigits(&digits, x, y, text, font, SSD1306_WHITE, DIGIT_OPAQUE);
+				printText(printed, x, y, text, font + 1, SSD1306_WHITE, SSD1306_BLACK);
+				opaque = opaque && memcmp(digits.getBuffer(), printed.getBuffer(), CANVAS_BYTES) == 0;
+			}
+		}
+	}
+	check(transparent, "transparent digits match print() without a background");
+	check(black, "black digits match print() without a background");
+	check(opaque, "opaque digits match print() with a black background");
+}
+
+// Helper function to render a condition for 600 ms of virtual time and
+// keep what the panel shows
+static void renderScreen(const char* condition, bool temperatures, uint8_t* screen) {
+	VirtualClock clock(1000);
+	WeatherAnimations animations("host", "host", "127.0.0.1", "token");
+	animations.setClock(&clock);
+	animations.setMode(CONTINUOUS_WEATHER);
+	animations.setAnimationMode(ANIMATION_EMBEDDED);
+	animations.begin(OLED_SSD1306, 0x3C, false);
+	applyCondition(animations, condition, temperatures);
+	animations.fastForward(&clock, 600);
+	memcpy(screen, Adafruit_SSD1306::lastInstance()->getBuffer(), CANVAS_BYTES);
+}
+
+// The temperature lines at y 45 and 56 run under the icon; they only add pixels
+static void testScreens() {
+	for (const char* condition : conditions) {
+		uint8_t without[CANVAS_BYTES];
+		uint8_t with[CANVAS_BYTES];
+		renderScreen(condition, false, without);
+		renderScreen(condition, true, with);
+
+		uint32_t lost = 0;
+		for (size_t i = 0; i < CANVAS_BYTES; i++) {
+			lost += __builtin_popcount(without[i] & ~with[i]);
+		}
+		char what[80];
+		snprintf(what, sizeof(what), "%s: temperatures keep every icon pixel (%u lost)", condition, (unsigned)lost);
+		check(lost == 0, what);
+		check(memcmp(without, with, CANVAS_BYTES) != 0, "temperatures drawn");
+	}
+}
+
+int main() {
+	printf("text_render: start\n");
+	testTextCache();
+	testDigits();
+	testScreens();
+
+	if (failures != 0) {
+		printf("text_render: %d failures\n", failures);
+		return 1;
+	}
+	printf("text_render: OK\n");
+	return 0;
+}
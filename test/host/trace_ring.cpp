@@ -0,0 +1,160 @@
+// Checks the trace ring and its Chrome Trace Event export: wrap-around,
+// concurrent writers, the library's own events and the JSON layout:
+//
+//   cmake -S . -B build && cmake --build build
+//   ctest --test-dir build -R trace_ring
+//
+// Exits non-zero on the first inconsistency.
+
+#include "WeatherAnimations.h"
+#include "HostTest.h"
+
+#include <stdio.h>
+#include <string>
+#include <thread>
+
+using namespace WeatherAnimationsLib;
+
+// Collects what traceExportJSON() prints
+class StringPrint : public Print {
+public:
+	size_t write(uint8_t c) override {
+		text += (char)c;
+		return 1;
+	}
+	size_t write(const uint8_t* buffer, size_t size) override {
+		text.append((const char*)buffer, size);
+		return size;
+	}
+	using Print::write;
+
+	std::string text;
+};
+
+// Helper function to count non-overlapping occurrences of a string
+static size_t occurrences(const std::string& text, const char* what) {
+	size_t count = 0;
+	for (size_t at = text.find(what); at != std::string::npos; at = text.find(what, at + 1)) {
+		count++;
+	}
+	return count;
+}
+
+// Helper function to check that brackets and braces outside strings balance
+static bool balanced(const std::string& text) {
+	int depth = 0;
+	bool inString = false;
+	for (size_t i = 0; i < text.size(); i++) {
+		char c = text[i];
+		if (inString) {
+			inString = c != '"';
+		} else if (c == '"') {
+			inString = true;
+		} else if (c == '{' || c == '[') {
+			depth++;
+		} else if (c == '}' || c == ']') {
+			if (--depth < 0) {
+				return false;
+			}
+		}
+	}
+	return depth == 0 && !inString;
+}
+
+// A full ring keeps the newest events and counts the rest as dropped
+static void testWrap() {
+	check(traceStart(16), "trace started");
+	check(traceActive(), "trace active");
+	for (uint32_t i = 0; i < 40; i++) {
+		traceComplete("step", 1000 + i * 10, 5, "index", i);
+	}
+	check(traceEventCount() == 16, "ring holds its capacity");
+	check(traceDropped() == 24, "older events dropped");
+
+	StringPrint out;
+	traceExportJSON(out);
+	check(traceActive(), "export resumes recording");
+	check(balanced(out.text), "export is balanced JSON");
+	check(occurrences(out.text, "\"ph\":\"X\"") == 16, "one complete event per held event");
+	check(out.text.find("\"index\":23") == std::string::npos, "dropped events not exported");
+	check(out.text.find("\"index\":24") != std::string::npos && out.text.find("\"index\":39") != std::string::npos,
+	      "newest events exported");
+	check(out.text.find("\"ts\":0,") != std::string::npos, "timestamps start at the oldest event");
+	check(out.text.find("\"dropped\":24") != std::string::npos, "dropped count exported");
+
+	traceStop();
+	traceInstant("ignored");
+	check(traceEventCount() == 16 && !traceActive(), "stopped trace records nothing");
+	traceRelease();
+	check(traceEventCount() == 0, "release empties the ring");
+}
+
+// Two threads record at once; every event lands whole on its own track
+static void testThreads() {
+	const uint32_t perThread = 20000;
+	check(traceStart(perThread * 2), "trace restarted");
+	auto writer = [](const char* name) {
+		for (uint32_t i = 0; i < perThread; i++) {
+			traceComplete(name, micros(), 1, "i", i);
+		}
+	};
+	std::thread first(writer, "first");
+	std::thread second(writer, "second");
+	first.join();
+	second.join();
+	check(traceEventCount() == perThread * 2 && traceDropped() == 0, "every record kept");
+
+	StringPrint out;
+	traceExportJSON(out);
+	check(balanced(out.text), "concurrent export is balanced JSON");
+	check(occurrences(out.text, "\"ph\":\"X\"") == perThread * 2, "every record exported");
+	check(occurrences(out.text, "\"thread_name\"") == 2, "one named track per thread");
+	traceRelease();
+}
+
+// The perf scopes and tick() steps of a running instance show up in the trace
+static void testLibraryEvents() {
+	WeatherDataHub hub("127.0.0.1", "token");
+	hub.setFetchInterval(0x7FFFFFFFUL);
+	WeatherAnimations animations("host", "host", "127.0.0.1", "token");
+	animations.setMode(CONTINUOUS_WEATHER);
+	animations.setAnimationMode(ANIMATION_EMBEDDED);
+	animations.begin(OLED_SSD1306, 0x3C, false);
+	animations.setDataHub(&hub);
+
+	check(traceStart(), "library trace started");
+	uint32_t now = millis();
+	for (int i = 0; i < 20; i++) {
+		uint32_t next;
+		do {
+			next = animations.tick(now);
+		} while (next == now);
+		now = next;
+	}
+	traceStop();
+
+	StringPrint out;
+	traceExportJSON(out);
+	check(balanced(out.text), "library export is balanced JSON");
+	check(out.text.find("\"name\":\"render\",\"cat\":\"wa\",\"ph\":\"X\"") != std::string::npos, "render steps traced");
+	check(out.text.find("\"condition\":") != std::string::npos, "render spans carry the condition");
+	check(out.text.find("\"name\":\"flush\"") != std::string::npos, "flushes traced");
+	check(out.text.find("\"late_ms\":") != std::string::npos, "tick steps carry their lateness");
+	printf("trace: %u events from 20 frames\n", (unsigned)traceEventCount());
+	traceRelease();
+	animations.setDataHub(nullptr);
+}
+
+int main() {
+	printf("trace_ring: start\n");
+	testWrap();
+	testThreads();
+	testLibraryEvents();
+
+	if (failures != 0) {
+		printf("trace_ring: %d failures\n", failures);
+		return 1;
+	}
+	printf("trace_ring: OK\n");
+	return 0;
+}
@@ -0,0 +1,207 @@
+// Runs the library on a VirtualClock: the same run gives the same frames,
+// update() waits without sleeping, button edges carry the clock's time,
+// and a simulated day of polling,
+// transitions and animation, across the 49.7-day millis() wrap, keeps its
+// poll interval and frame rate. MockHomeAssistant on 127.0.0.1:8123
+// answers the polls:
+//
+//   cmake -S . -B build && cmake --build build
+//   ctest --test-dir build -R virtual_clock
+//
+// Exits non-zero on the first inconsistency.
+
+#include "WeatherAnimations.h"
+#include "MockHomeAssistant.h"
+#include "HostTest.h"
+
+#include <stdio.h>
+
+using namespace WeatherAnimationsLib;
+
+#define MINUTE 60000UL
+#define HOUR (60 * MINUTE)
+#define DAY (24 * HOUR)
+
+static const char* const conditions[] = {"sunny", "cloudy", "rainy", "snowy", "lightning"};
+
+// Host pin of the button in testInput()
+#define BUTTON_PIN 27
+
+static void testClock() {
+	VirtualClock clock(0xFFFFFFF0UL);
+	check(clock.millis() == 0xFFFFFFF0UL, "clock starts where asked");
+	clock.advance(0x10);
+	check(clock.millis() == 0, "clock wraps like millis()");
+	clock.delay(250);
+	check(clock.millis() == 250, "delay() moves the clock");
+	clock.set(1234);
+	check(clock.millis() == 1234, "clock can be set");
+}
+
+// Helper function to animate ten simulated minutes and hash every sample
+static uint32_t recordRun(uint32_t start, uint32_t* distinctFrames) {
+	VirtualClock clock(start);
+	WeatherAnimations animations("host", "host", "127.0.0.1", "token");
+	animations.setClock(&clock);
+	animations.setMode(CONTINUOUS_WEATHER);
+	animations.setAnimationMode(ANIMATION_EMBEDDED);
+	animations.begin(OLED_SSD1306, 0x3C, false);
+
+	uint32_t run = 2166136261UL;
+	uint32_t last = 0;
+	*distinctFrames = 0;
+	for (uint32_t sample = 0; sample < 10 * MINUTE / 50; sample++) {
+		if (sample % 1200 == 0) {
+			applyCondition(animations, conditions[(sample / 1200) % 5]);
+		}
+		if (sample % 1200 == 600) {
+			animations.runTransition((sample / 1200 + 1) % 5, 0, 800);
+		}
+		animations.fastForward(&clock, 50);
+		uint32_t hash = frameHash();
+		*distinctFrames += hash != last;
+		last = hash;
+		run = (run ^ hash) * 16777619UL;
+	}
+	return run;
+}
+
+// The same start gives the same frames, whatever the host was doing meanwhile
+static void testDeterministic() {
+	uint32_t distinctFirst;
+	uint32_t distinctSecond;
+	uint32_t first = recordRun(1000, &distinctFirst);
+	uint32_t second = recordRun(1000, &distinctSecond);
+	check(first == second && distinctFirst == distinctSecond, "two runs draw the same frames");
+	check(distinctFirst > 1000, "frames keep changing");
+	printf("deterministic: %u distinct samples, run hash %08x\n", (unsigned)distinctFirst, (unsigned)first);
+}
+
+// update() waits on the clock too, so its loop runs at full speed
+static void testUpdate() {
+	VirtualClock clock(0);
+	WeatherAnimations animations("host", "host", "127.0.0.1", "token");
+	animations.setClock(&clock);
+	animations.setMode(CONTINUOUS_WEATHER);
+	animations.setAnimationMode(ANIMATION_EMBEDDED);
+	animations.begin(OLED_SSD1306, 0x3C, false);
+
+	uint32_t begun = clock.millis();
+	uint32_t start = millis();
+	for (int i = 0; i < 1000; i++) {
+		animations.update();
+	}
+	check(clock.millis() - begun == 1000 * 16, "update() waits 16 ms of clock time per frame");
+	check(millis() - start < 1000 * 16, "update() does not sleep");
+}
+
+// Helper function to keep the last input event
+static void keepInput(const InputEvent& event, void* context) {
+	*(InputEvent*)context = event;
+}
+
+// Button edges are stamped with the clock the library runs on, not the
+// board's millis(), and are debounced on it
+static void testInput() {
+	VirtualClock clock(7 * DAY);
+	HostArduino::setPinLevel(BUTTON_PIN, HIGH);
+	InputManager input;
+	check(input.addButton(BUTTON_PIN, 1), "button added");
+	InputEvent received;
+	memset(&received, 0, sizeof(received));
+	WeatherAnimations animations("host", "host", "127.0.0.1", "token");
+	animations.setClock(&clock);
+	animations.setMode(CONTINUOUS_WEATHER);
+	animations.setAnimationMode(ANIMATION_EMBEDDED);
+	animations.setInput(&input, keepInput, &received);
+	animations.begin(OLED_SSD1306, 0x3C, false);
+	animations.fastForward(&clock, 1000);
+
+	uint32_t pressedAt = clock.millis();
+	HostArduino::setPinLevel(BUTTON_PIN, LOW);
+	HostArduino::fireInterrupt(BUTTON_PIN);
+	animations.fastForward(&clock, INPUT_DEFAULT_DEBOUNCE - 1);
+	check(received.type == 0, "press held back for the debounce time");
+	animations.fastForward(&clock, 1000);
+	check(received.type == INPUT_PRESSED && received.id == 1, "press reported");
+	check(received.time == pressedAt, "press stamped with the clock's time");
+	HostArduino::setPinLevel(BUTTON_PIN, HIGH);
+}
+
+// A day of polling and animation, starting 12 hours before millis() wraps
+static void testDay() {
+	MockHomeAssistant server;
+	check(server.start(8123), "listening on 127.0.0.1:8123");
+	if (failures != 0) {
+		return;
+	}
+	server.setTemperature(MOCK_HA_INDOOR_ENTITY, 21.5f);
+	server.setTemperature(MOCK_HA_OUTDOOR_ENTITY, 21.5f);
+	WiFi.hostSetStatus(WL_CONNECTED);
+
+	VirtualClock clock(0xFFFFFFFFUL - 12 * HOUR);
+	WeatherDataHub hub("127.0.0.1", "token");
+	hub.setClock(&clock);
+	hub.setFetchInterval(MINUTE);
+	WeatherAnimations animations("host", "host", "127.0.0.1", "token");
+	animations.setClock(&clock);
+	animations.setMode(CONTINUOUS_WEATHER);
+	animations.setAnimationMode(ANIMATION_EMBEDDED);
+	animations.setDataHub(&hub);
+	animations.begin(OLED_SSD1306, 0x3C, false);
+
+	uint32_t begun = clock.millis();
+	uint32_t renders = getPerfStats().stages[PERF_RENDER].count;
+	uint32_t transitions = 0;
+	uint32_t ticks = 0;
+	uint32_t wallStart = millis();
+	for (uint32_t hour = 0; hour < 24; hour++) {
+		server.setWeather(MOCK_HA_WEATHER_ENTITY, conditions[hour % 5], 3.5f, 9.0f, true);
+
+		// A one-second transition every hour, one of them across the wrap: about
+		// 60 frames at 16 ms, then back to the frame delay
+		uint32_t before = getPerfStats().stages[PERF_RENDER].count;
+		animations.runTransition(hour % 5, hour % 4, 1000);
+		ticks += animations.fastForward(&clock, 2000);
+		uint32_t frames = getPerfStats().stages[PERF_RENDER].count - before;
+		transitions += frames >= 55 && frames <= 80;
+		ticks += animations.fastForward(&clock, HOUR - 2000);
+	}
+	uint32_t wall = millis() - wallStart;
+	renders = getPerfStats().stages[PERF_RENDER].count - renders;
+
+	check(clock.millis() - begun == DAY && clock.millis() < begun, "the clock ran for a day, across the wrap");
+	check(hub.fetchCount() == 24 * 60, "one poll a minute, across the wrap");
+	check(server.stateRequests() == 3 * 24 * 60, "three requests per poll");
+	check(transitions == 24, "every transition ran for its second");
+	check(animations.getCurrentWeather() < 5 && hub.snapshot().hasCondition, "live weather shown");
+	// An hour of each condition at its frame delay, plus the transitions and a frame after each poll
+	static const uint32_t frameDelays[] = {500, 500, 300, 300, 200};
+	uint32_t expected = 0;
+	for (uint32_t hour = 0; hour < 24; hour++) {
+		expected += HOUR / frameDelays[hour % 5];
+	}
+	check(renders >= expected && renders <= expected + 24 * 70 + 24 * 60, "frames at each condition's frame delay");
+	printf("day: %u polls, %u frames, %u ticks in %u ms\n", (unsigned)hub.fetchCount(), (unsigned)renders,
+	       (unsigned)ticks, (unsigned)wall);
+
+	hub.removeDisplay(&animations);
+	WiFi.hostSetStatus(WL_DISCONNECTED);
+	server.stop();
+}
+
+int main() {
+	printf("virtual_clock: start\n");
+	testClock();
+	testDeterministic();
+	testUpdate();
+	testInput();
+	testDay();
+
+	if (failures != 0) {
+		printf("virtual_clock: %d failures\n", failures);
+		return 1;
+	}
+	printf("virtual_clock: OK\n");
+	return 0;
+}
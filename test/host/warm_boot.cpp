@@ -0,0 +1,175 @@
+// Checks the warm boot record: a saved state loads back unchanged, a state
+// with a wrong CRC, magic, size or unterminated condition is refused, and
+// begin() with setWarmBoot(true) draws the saved scene before it opens a
+// single connection, polling only afterwards:
+//
+//   cmake -S . -B build && cmake --build build
+//   ctest --test-dir build -R warm_boot
+//
+// The host keeps the record in a static (warmBootMemory()) standing in for
+// RTC memory, so one process plays both sides of a reset. Exits non-zero on
+// the first inconsistency.
+
+#include "WeatherAnimations.h"
+#include "HostTest.h"
+
+#include <WiFi.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace WeatherAnimationsLib;
+
+#define SCREEN_BYTES (128 * 64 / 8)
+
+// A network that refuses every connection and counts the attempts
+class RefusingNetwork : public HostNetwork {
+public:
+	int opens = 0;
+
+	int open(const char* host, uint16_t port, bool http) override {
+		(void)host;
+		(void)port;
+		(void)http;
+		opens++;
+		return -1;
+	}
+	int available(int handle) override { (void)handle; return 0; }
+	int read(int handle, uint8_t* buf, size_t size) override { (void)handle; (void)buf; (void)size; return -1; }
+	bool closed(int handle) override { (void)handle; return true; }
+	void close(int handle) override { (void)handle; }
+};
+
+// Helper function to fill in a state as saveWarmBoot() would
+static void makeState(WarmBootState* state) {
+	memset(state, 0, sizeof(*state));
+	state->weatherCondition = WEATHER_SNOW;
+	state->isDaytime = false;
+	snprintf(state->condition, sizeof(state->condition), "snowy");
+	state->minForecastTemp = -6.5f;
+	state->maxForecastTemp = 1.0f;
+	state->indoorTemp = 19.0f;
+	state->outdoorTemp = -3.25f;
+	state->hasTemperatureData = true;
+}
+
+// Saving fills in the header and loading gives the same state back
+static void testRoundTrip() {
+	static const char digits[] = "123456789";
+	check(warmBootCRC((const uint8_t*)digits, 9) == 0xCBF43926UL, "CRC-32 check value");
+
+	clearWarmBootState();
+	WarmBootState loaded;
+	check(!loadWarmBootState(&loaded), "no state after a cold boot");
+
+	WarmBootState saved;
+	makeState(&saved);
+	saveWarmBootState(&saved);
+	check(saved.magic == WARM_BOOT_MAGIC && saved.size == sizeof(WarmBootState), "header filled in");
+	check(memcmp(warmBootMemory(), &saved, sizeof(saved)) == 0, "state stored as saved");
+	check(loadWarmBootState(&loaded) && memcmp(&loaded, &saved, sizeof(saved)) == 0, "state loads back unchanged");
+}
+
+// Any damage to the stored record makes it a cold boot
+static void testCorruption() {
+	WarmBootState saved;
+	makeState(&saved);
+	WarmBootState loaded;
+
+	// One flipped bit anywhere in the record
+	bool refused = true;
+	for (size_t bit = 0; bit < sizeof(WarmBootState) * 8; bit++) {
+		saveWarmBootState(&saved);
+		uint8_t* memory = (uint8_t*)warmBootMemory();
+		memory[bit / 8] ^= 1 << (bit % 8);
+		refused = refused && !loadWarmBootState(&loaded);
+	}
+	check(refused, "a flipped bit is refused");
+
+	// A record of another layout, with a CRC that matches it
+	saveWarmBootState(&saved);
+	WarmBootState* memory = warmBootMemory();
+	memory->size = sizeof(WarmBootState) - 4;
+	memory->crc = warmBootCRC((const uint8_t*)memory, offsetof(WarmBootState, crc));
+	check(!loadWarmBootState(&loaded), "a different size is refused");
+	saveWarmBootState(&saved);
+	memory->magic ^= 0x100;
+	memory->crc = warmBootCRC((const uint8_t*)memory, offsetof(WarmBootState, crc));
+	check(!loadWarmBootState(&loaded), "a different magic is refused");
+
+	// An unterminated condition, even with a valid CRC
+	saveWarmBootState(&saved);
+	memset(memory->condition, 'x', sizeof(memory->condition));
+	memory->crc = warmBootCRC((const uint8_t*)memory, offsetof(WarmBootState, crc));
+	check(!loadWarmBootState(&loaded), "an unterminated condition is refused");
+
+	clearWarmBootState();
+	check(!loadWarmBootState(&loaded), "a cleared state is refused");
+}
+
+// Helper function to begin a display behind network and keep its first screen
+static void beginDisplay(WeatherAnimations& animations, VirtualClock& clock, uint8_t* screen) {
+	animations.setClock(&clock);
+	animations.setMode(CONTINUOUS_WEATHER);
+	animations.setAnimationMode(ANIMATION_EMBEDDED);
+	animations.setWarmBoot(true);
+	WiFi.hostSetStatus(WL_DISCONNECTED);
+	animations.begin(OLED_SSD1306, 0x3C, true);
+	memcpy(screen, Adafruit_SSD1306::lastInstance()->getBuffer(), SCREEN_BYTES);
+}
+
+// begin() draws the saved scene first; the network only comes after
+static void testRestore() {
+	RefusingNetwork network;
+	WiFi.hostSetNetwork(&network);
+	uint8_t cold[SCREEN_BYTES];
+	uint8_t warm[SCREEN_BYTES];
+
+	// Before the reset: a cold boot, then weather that is saved as it is shown
+	clearWarmBootState();
+	{
+		VirtualClock clock(1000);
+		WeatherAnimations animations("host", "host", "127.0.0.1", "token");
+		beginDisplay(animations, clock, cold);
+		check(animations.getWarmBootTime() == 0, "cold boot has no warm boot time");
+		applyCondition(animations, "rainy");
+	}
+	WarmBootState state;
+	check(loadWarmBootState(&state) && strcmp(state.condition, "rainy") == 0 && state.weatherCondition == WEATHER_RAIN &&
+	      state.indoorTemp == 21.5f && state.outdoorTemp == 8.0f && state.hasTemperatureData,
+	      "shown weather saved for the next boot");
+
+	// After the reset: the scene is back before any connection is made
+	network.opens = 0;
+	VirtualClock clock(1000);
+	WeatherAnimations animations("host", "host", "127.0.0.1", "token");
+	beginDisplay(animations, clock, warm);
+	check(network.opens == 0, "nothing opened before the scene is drawn");
+	check(animations.getWarmBootTime() != 0 && animations.getTimeToFirstFrame() != 0, "warm boot time recorded");
+	check(memcmp(cold, warm, SCREEN_BYTES) != 0, "restored scene drawn instead of the generated one");
+	check(animations.getCurrentWeather() == WEATHER_RAIN, "restored weather shown");
+
+	WeatherSnapshot snapshot;
+	check(animations.readWeatherState(&snapshot) && strcmp(snapshot.condition, "rainy") == 0 &&
+	      snapshot.minForecastTemp == 4.0f && snapshot.maxForecastTemp == 11.0f,
+	      "restored weather published");
+
+	// The first poll follows, and a failed one keeps the restored scene
+	animations.fastForward(&clock, 100);
+	check(network.opens > 0, "polled after the scene was drawn");
+	check(animations.getCurrentWeather() == WEATHER_RAIN, "a failed poll keeps the restored scene");
+	WiFi.hostSetNetwork(nullptr);
+}
+
+int main() {
+	printf("warm_boot: start\n");
+	testRoundTrip();
+	testCorruption();
+	testRestore();
+
+	if (failures != 0) {
+		printf("warm_boot: %d failures\n", failures);
+		return 1;
+	}
+	printf("warm_boot: OK\n");
+	return 0;
+}